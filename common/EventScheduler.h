@@ -0,0 +1,193 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <algorithm>
+#include <array>
+
+// Min-heap of pending events keyed by the absolute cycle they're due on, so the next
+// deadline is always at the top and finding due events doesn't mean polling every slot.
+//
+// The scheduler doesn't own the event state. Callers keep their own pending mask and
+// deadlines (which is what gets saved in save states), and pass them in whenever the
+// queue is inspected. That lets entries be invalidated lazily: an event which was
+// cancelled by clearing its pending bit, or rescheduled, leaves a stale entry behind
+// which is dropped once it reaches the top. Deadlines may also be pushed back directly
+// by the owner, the entry is requeued when it's found to no longer match.
+//
+// Cycle counters wrap, so deadlines are compared relative to each other, and must be
+// within 2^31 cycles of the current time.
+template <u32 NumEvents>
+class EventScheduler
+{
+	static_assert(NumEvents > 0 && NumEvents <= 32, "Events are tracked in 32-bit masks");
+
+public:
+	EventScheduler() { Clear(); }
+
+	void Clear()
+	{
+		m_size = 0;
+		m_queued = 0;
+		m_due = 0;
+	}
+
+	/// Queues event id to be due on the given cycle, replacing any earlier deadline.
+	void Schedule(u32 id, u32 deadline)
+	{
+		const u32 bit = 1u << id;
+		m_latest[id] = deadline;
+		m_queued |= bit;
+		m_due &= ~bit;
+
+		if (m_size == Capacity)
+			Compact();
+
+		m_heap[m_size++] = {deadline, id};
+		std::push_heap(m_heap.begin(), m_heap.begin() + m_size, Later);
+	}
+
+	/// Moves every event whose deadline is at or before now to the due set.
+	template <typename DeadlineFn>
+	void CollectDue(u32 now, u32 pending, const DeadlineFn& deadline_of)
+	{
+		while (SettleTop(pending, deadline_of) && static_cast<s32>(now - m_heap[0].deadline) >= 0)
+		{
+			const u32 bit = 1u << m_heap[0].id;
+			Pop();
+			m_queued &= ~bit;
+			m_due |= bit;
+		}
+	}
+
+	/// Gets the deadline of the next pending event which isn't due yet. Returns false if there isn't one.
+	template <typename DeadlineFn>
+	bool PeekNext(u32 pending, const DeadlineFn& deadline_of, u32* deadline)
+	{
+		if (!SettleTop(pending, deadline_of))
+			return false;
+
+		*deadline = m_heap[0].deadline;
+		return true;
+	}
+
+	__fi u32 GetDueMask() const { return m_due; }
+	__fi bool IsDue(u32 id) const { return (m_due & (1u << id)) != 0; }
+	__fi void ClearDue(u32 id) { m_due &= ~(1u << id); }
+
+	/// Requeues every pending event from the owner's state, e.g. after loading a save state.
+	template <typename DeadlineFn>
+	void Rebuild(u32 pending, const DeadlineFn& deadline_of)
+	{
+		Clear();
+		for (u32 id = 0; id < NumEvents; id++)
+		{
+			if (pending & (1u << id))
+				Schedule(id, deadline_of(id));
+		}
+	}
+
+	u32 GetQueueSize() const { return m_size; }
+
+private:
+	struct Entry
+	{
+		u32 deadline;
+		u32 id;
+	};
+
+	// Stale entries are only dropped once they get to the top, so leave room for a few of them.
+	static constexpr u32 Capacity = NumEvents * 4;
+
+	// std heaps are max-heaps, so order by the later deadline to get the earliest at the top.
+	static bool Later(const Entry& lhs, const Entry& rhs)
+	{
+		return static_cast<s32>(lhs.deadline - rhs.deadline) > 0;
+	}
+
+	__fi bool IsCurrent(const Entry& entry) const
+	{
+		return (m_queued & (1u << entry.id)) && m_latest[entry.id] == entry.deadline;
+	}
+
+	void Pop()
+	{
+		std::pop_heap(m_heap.begin(), m_heap.begin() + m_size, Later);
+		m_size--;
+	}
+
+	// Throws away stale entries at the top of the heap. Returns false if the heap ran empty.
+	template <typename DeadlineFn>
+	bool SettleTop(u32 pending, const DeadlineFn& deadline_of)
+	{
+		while (m_size > 0)
+		{
+			const Entry top = m_heap[0];
+			const u32 bit = 1u << top.id;
+			if (!IsCurrent(top))
+			{
+				// Rescheduled since, or a duplicate of an entry which was already collected.
+				Pop();
+			}
+			else if (!(pending & bit))
+			{
+				// Cancelled by the owner.
+				Pop();
+				m_queued &= ~bit;
+			}
+			else if (const u32 deadline = deadline_of(top.id); deadline != top.deadline)
+			{
+				// The owner moved the deadline without telling us.
+				Pop();
+				Schedule(top.id, deadline);
+			}
+			else
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Keeps only the newest entry of each queued event. Leaves at most NumEvents entries.
+	void Compact()
+	{
+		u32 kept = 0;
+		u32 seen = 0;
+		for (u32 i = 0; i < m_size; i++)
+		{
+			const Entry& entry = m_heap[i];
+			const u32 bit = 1u << entry.id;
+			if (!IsCurrent(entry) || (seen & bit))
+				continue;
+
+			seen |= bit;
+			m_heap[kept++] = entry;
+		}
+
+		m_size = kept;
+		std::make_heap(m_heap.begin(), m_heap.begin() + m_size, Later);
+	}
+
+	std::array<Entry, Capacity> m_heap;
+	u32 m_size;
+	u32 m_latest[NumEvents];
+	u32 m_queued; // events with a live entry in the heap
+	u32 m_due; // events whose deadline has passed, waiting to be dispatched
+};
@@ -44,6 +44,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <limits.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -1432,6 +1433,53 @@ bool FileSystem::SetPathCompression(const char* path, bool enable)
 	return result;
 }
 
+FileSystem::MappedFile::MappedFile() = default;
+
+FileSystem::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool FileSystem::MappedFile::Open(const char* filename)
+{
+	Close();
+
+	const HANDLE file = CreateFileW(StringUtil::UTF8StringToWideString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// The view keeps the mapping (and file) alive, so the handles can go straight away.
+	const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view)
+		return false;
+
+	m_data = static_cast<const u8*>(view);
+	m_size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void FileSystem::MappedFile::Close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	m_data = nullptr;
+	m_size = 0;
+}
+
 #else
 
 static u32 RecursiveFindFiles(const char* OriginPath, const char* ParentPath, const char* Path, const char* Pattern,
@@ -1931,6 +1979,47 @@ bool FileSystem::SetPathCompression(const char* path, bool enable)
 	return false;
 }
 
+FileSystem::MappedFile::MappedFile() = default;
+
+FileSystem::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool FileSystem::MappedFile::Open(const char* filename)
+{
+	Close();
+
+	const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	// The mapping holds its own reference to the file.
+	void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<const u8*>(data);
+	m_size = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+void FileSystem::MappedFile::Close()
+{
+	if (m_data)
+		munmap(const_cast<u8*>(m_data), m_size);
+	m_data = nullptr;
+	m_size = 0;
+}
+
 FileSystem::POSIXLock::POSIXLock(int fd)
 {
 	if (lockf(fd, F_LOCK, 0) == 0)
@@ -164,6 +164,29 @@ namespace FileSystem
 	/// Does nothing and returns false on non-Windows platforms.
 	bool SetPathCompression(const char* path, bool enable);
 
+	/// Read-only memory mapping of an entire file.
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/// Maps the given file, replacing any existing mapping. Empty files can't be mapped.
+		bool Open(const char* filename);
+		void Close();
+
+		bool IsOpen() const { return (m_data != nullptr); }
+		const u8* GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		const u8* m_data = nullptr;
+		size_t m_size = 0;
+	};
+
 	/// Abstracts a POSIX file lock.
 #ifndef _WIN32
 	class POSIXLock
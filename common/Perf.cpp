@@ -18,14 +18,23 @@
 #ifdef __unix__
 #include <unistd.h>
 #endif
+#ifdef __linux__
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#endif
 #ifdef ENABLE_VTUNE
 #include "jitprofiling.h"
 
 #include <string> // std::string
-#include <cstring> // strncpy
-#include <algorithm> // std::remove_if
 #endif
 
+#include <algorithm> // std::remove_if
+#include <cstring> // strncpy
+
 //#define ProfileWithPerf
 #define MERGE_BLOCK_RESULT
 
@@ -35,6 +44,11 @@
 #endif
 #endif
 
+// Perf is only supported on linux
+#if defined(__linux__) && (defined(ProfileWithPerf) || defined(ENABLE_VTUNE))
+#define PERF_MAP_ENABLED
+#endif
+
 namespace Perf
 {
 	// Warning object aren't thread safe
@@ -44,8 +58,10 @@ namespace Perf
 	InfoVector vu("VU");
 	InfoVector vif("VIF");
 
-// Perf is only supported on linux
-#if defined(__linux__) && (defined(ProfileWithPerf) || defined(ENABLE_VTUNE))
+	// Zones bigger than this are address space reservations, rather than code.
+	static constexpr u32 JITDUMP_MAX_STATIC_SIZE = 16 * _1kb;
+
+	static void JitDumpCodeLoad(const char* name, uptr x86, u32 size);
 
 	////////////////////////////////////////////////////////////////////////////////
 	// Implementation of the Info object
@@ -54,9 +70,9 @@ namespace Perf
 	Info::Info(uptr x86, u32 size, const char* symbol)
 		: m_x86(x86)
 		, m_size(size)
+		, m_symbol(symbol)
 		, m_dynamic(false)
 	{
-		strncpy(m_symbol, symbol, sizeof(m_symbol));
 	}
 
 	Info::Info(uptr x86, u32 size, const char* symbol, u32 pc)
@@ -64,12 +80,14 @@ namespace Perf
 		, m_size(size)
 		, m_dynamic(true)
 	{
-		snprintf(m_symbol, sizeof(m_symbol), "%s_0x%08x", symbol, pc);
+		char name[64];
+		snprintf(name, sizeof(name), "%s_0x%08x", symbol, pc);
+		m_symbol = name;
 	}
 
 	void Info::Print(FILE* fp)
 	{
-		fprintf(fp, "%x %x %s\n", m_x86, m_size, m_symbol);
+		fprintf(fp, "%zx %x %s\n", m_x86, m_size, m_symbol.c_str());
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -78,7 +96,8 @@ namespace Perf
 
 	InfoVector::InfoVector(const char* prefix)
 	{
-		strncpy(m_prefix, prefix, sizeof(m_prefix));
+		strncpy(m_prefix, prefix, sizeof(m_prefix) - 1);
+		m_prefix[sizeof(m_prefix) - 1] = 0;
 #ifdef ENABLE_VTUNE
 		m_vtune_id = iJIT_GetNewMethodID();
 #else
@@ -104,6 +123,7 @@ namespace Perf
 		u32 max_code_size = _1gb;
 #endif
 
+		// Static zones are always kept, so they can go in a jitdump opened later.
 		if (size < max_code_size)
 		{
 			m_v.emplace_back(x86, size, symbol);
@@ -125,14 +145,24 @@ namespace Perf
 //fprintf(stderr, "mapF %s: %p size %dKB\n", ml.method_name, ml.method_load_address, ml.method_size / 1024u);
 #endif
 		}
+
+		if (size < JITDUMP_MAX_STATIC_SIZE)
+			JitDumpCodeLoad(symbol, x86, size);
 	}
 
 	void InfoVector::map(uptr x86, u32 size, u32 pc)
 	{
-#ifndef MERGE_BLOCK_RESULT
+#if defined(PERF_MAP_ENABLED) && !defined(MERGE_BLOCK_RESULT)
 		m_v.emplace_back(x86, size, m_prefix, pc);
 #endif
 
+		if (IsJitDumpOpen())
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "%s_0x%08x", m_prefix, pc);
+			JitDumpCodeLoad(name, x86, size);
+		}
+
 #ifdef ENABLE_VTUNE
 		iJIT_Method_Load_V2 ml;
 
@@ -157,27 +187,39 @@ namespace Perf
 
 	void InfoVector::reset()
 	{
-		auto dynamic = std::remove_if(m_v.begin(), m_v.end(), [](Info i) { return i.m_dynamic; });
+		auto dynamic = std::remove_if(m_v.begin(), m_v.end(), [](const Info& i) { return i.m_dynamic; });
 		m_v.erase(dynamic, m_v.end());
 	}
 
+	void InfoVector::dump_static_to_jitdump()
+	{
+		for (const Info& i : m_v)
+		{
+			if (!i.m_dynamic && i.m_size < JITDUMP_MAX_STATIC_SIZE)
+				JitDumpCodeLoad(i.m_symbol.c_str(), i.m_x86, i.m_size);
+		}
+	}
+
 	////////////////////////////////////////////////////////////////////////////////
 	// Global function
 	////////////////////////////////////////////////////////////////////////////////
 
+#ifdef PERF_MAP_ENABLED
+
 	void dump()
 	{
 		char file[256];
 		snprintf(file, 250, "/tmp/perf-%d.map", getpid());
 		FILE* fp = fopen(file, "w");
+		if (!fp)
+			return;
 
 		any.print(fp);
 		ee.print(fp);
 		iop.print(fp);
 		vu.print(fp);
 
-		if (fp)
-			fclose(fp);
+		fclose(fp);
 	}
 
 	void dump_and_reset()
@@ -192,20 +234,174 @@ namespace Perf
 
 #else
 
+	void dump() {}
+	void dump_and_reset() {}
+
+#endif
+
 	////////////////////////////////////////////////////////////////////////////////
-	// Dummy implementation
+	// perf jitdump, see tools/perf/Documentation/jitdump-specification.txt in the
+	// kernel tree.
 	////////////////////////////////////////////////////////////////////////////////
 
-	InfoVector::InfoVector(const char* prefix)
-		: m_vtune_id(0)
+#ifdef __linux__
+
+	namespace
+	{
+		struct JitHeader
+		{
+			u32 magic;
+			u32 version;
+			u32 total_size;
+			u32 elf_mach;
+			u32 pad1;
+			u32 pid;
+			u64 timestamp;
+			u64 flags;
+		};
+
+		struct JitRecordHeader
+		{
+			u32 id;
+			u32 total_size;
+			u64 timestamp;
+		};
+
+		struct JitCodeLoad
+		{
+			JitRecordHeader header;
+			u32 pid;
+			u32 tid;
+			u64 vma;
+			u64 code_addr;
+			u64 code_size;
+			u64 code_index;
+			// followed by the name, null terminated, then the code
+		};
+
+		static constexpr u32 JITDUMP_MAGIC = 0x4A695444;
+		static constexpr u32 JITDUMP_VERSION = 1;
+		static constexpr u32 JIT_CODE_LOAD = 0;
+		static constexpr u32 JIT_CODE_CLOSE = 3;
+	} // namespace
+
+	static std::mutex s_jitdump_mutex;
+	static std::atomic_bool s_jitdump_open{false};
+	static FILE* s_jitdump_fp = nullptr;
+	static void* s_jitdump_marker = nullptr;
+	static size_t s_jitdump_marker_size = 0;
+	static u64 s_jitdump_code_index = 0;
+
+	// Has to match the clock perf is recording with, hence -k mono.
+	static u64 JitDumpTimestamp()
 	{
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<u64>(ts.tv_sec) * 1000000000ULL + static_cast<u64>(ts.tv_nsec);
 	}
-	void InfoVector::map(uptr x86, u32 size, const char* symbol) {}
-	void InfoVector::map(uptr x86, u32 size, u32 pc) {}
-	void InfoVector::reset() {}
 
-	void dump() {}
-	void dump_and_reset() {}
+	static void JitDumpCodeLoad(const char* name, uptr x86, u32 size)
+	{
+		if (!s_jitdump_open.load(std::memory_order_relaxed) || size == 0)
+			return;
+
+		std::unique_lock lock(s_jitdump_mutex);
+		if (!s_jitdump_fp)
+			return;
+
+		const size_t name_size = std::strlen(name) + 1;
+
+		JitCodeLoad rec = {};
+		rec.header.id = JIT_CODE_LOAD;
+		rec.header.total_size = static_cast<u32>(sizeof(rec) + name_size + size);
+		rec.header.timestamp = JitDumpTimestamp();
+		rec.pid = static_cast<u32>(getpid());
+		rec.tid = static_cast<u32>(syscall(SYS_gettid));
+		rec.vma = x86;
+		rec.code_addr = x86;
+		rec.code_size = size;
+		rec.code_index = s_jitdump_code_index++;
+
+		fwrite(&rec, sizeof(rec), 1, s_jitdump_fp);
+		fwrite(name, name_size, 1, s_jitdump_fp);
+		fwrite(reinterpret_cast<const void*>(x86), size, 1, s_jitdump_fp);
+	}
+
+	bool OpenJitDump()
+	{
+		{
+			std::unique_lock lock(s_jitdump_mutex);
+			if (s_jitdump_fp)
+				return true;
+
+			char file[256];
+			snprintf(file, sizeof(file), "/tmp/jit-%d.dump", getpid());
+			FILE* fp = fopen(file, "w+");
+			if (!fp)
+				return false;
+
+			// perf finds the dump through this mapping, which has to be executable.
+			const size_t marker_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+			void* marker = mmap(nullptr, marker_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(fp), 0);
+			if (marker == MAP_FAILED)
+			{
+				fclose(fp);
+				return false;
+			}
+
+			JitHeader hdr = {};
+			hdr.magic = JITDUMP_MAGIC;
+			hdr.version = JITDUMP_VERSION;
+			hdr.total_size = sizeof(hdr);
+			hdr.elf_mach = EM_X86_64;
+			hdr.pid = static_cast<u32>(getpid());
+			hdr.timestamp = JitDumpTimestamp();
+			fwrite(&hdr, sizeof(hdr), 1, fp);
+
+			s_jitdump_fp = fp;
+			s_jitdump_marker = marker;
+			s_jitdump_marker_size = marker_size;
+			s_jitdump_open.store(true, std::memory_order_release);
+		}
+
+		any.dump_static_to_jitdump();
+		ee.dump_static_to_jitdump();
+		iop.dump_static_to_jitdump();
+		vu.dump_static_to_jitdump();
+		vif.dump_static_to_jitdump();
+		return true;
+	}
+
+	void CloseJitDump()
+	{
+		std::unique_lock lock(s_jitdump_mutex);
+		if (!s_jitdump_fp)
+			return;
+
+		JitRecordHeader rec = {};
+		rec.id = JIT_CODE_CLOSE;
+		rec.total_size = sizeof(rec);
+		rec.timestamp = JitDumpTimestamp();
+		fwrite(&rec, sizeof(rec), 1, s_jitdump_fp);
+
+		s_jitdump_open.store(false, std::memory_order_release);
+		munmap(s_jitdump_marker, s_jitdump_marker_size);
+		fclose(s_jitdump_fp);
+		s_jitdump_fp = nullptr;
+		s_jitdump_marker = nullptr;
+	}
+
+	bool IsJitDumpOpen()
+	{
+		return s_jitdump_open.load(std::memory_order_relaxed);
+	}
+
+#else
+
+	static void JitDumpCodeLoad(const char* name, uptr x86, u32 size) {}
+	bool OpenJitDump() { return false; }
+	void CloseJitDump() {}
+	bool IsJitDumpOpen() { return false; }
 
 #endif
 } // namespace Perf
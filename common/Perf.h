@@ -16,8 +16,8 @@
 #pragma once
 
 #include <cstdio>
+#include <string>
 #include <vector>
-#include <cstdio>
 #include "common/Pcsx2Types.h"
 
 namespace Perf
@@ -27,7 +27,7 @@ namespace Perf
 	{
 		uptr m_x86;
 		u32 m_size;
-		char m_symbol[20];
+		std::string m_symbol;
 		// The idea is to keep static zones that are set only
 		// once.
 		bool m_dynamic;
@@ -50,11 +50,22 @@ namespace Perf
 		void map(uptr x86, u32 size, const char* symbol);
 		void map(uptr x86, u32 size, u32 pc);
 		void reset();
+
+		/// Writes the static zones to the jitdump, for when it's opened after they were mapped.
+		void dump_static_to_jitdump();
 	};
 
 	void dump();
 	void dump_and_reset();
 
+	/// Starts writing everything mapped from now on, with its code, to /tmp/jit-<pid>.dump, in the
+	/// perf jitdump format. Static zones mapped earlier are written first. Record with
+	/// `perf record -k mono`, then `perf inject --jit` to get symbols and annotation for the
+	/// recompiled code. Returns false if the file couldn't be created, or on other platforms.
+	bool OpenJitDump();
+	void CloseJitDump();
+	bool IsJitDumpOpen();
+
 	extern InfoVector any;
 	extern InfoVector ee;
 	extern InfoVector iop;
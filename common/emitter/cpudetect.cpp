@@ -42,6 +42,19 @@ static __inline__ __attribute__((always_inline)) void cpuid(int CPUInfo[], const
 
 #endif
 
+// Only valid if CPUID reports OSXSAVE
+static u64 xgetbv(u32 index)
+{
+#if defined(_MSC_VER)
+	return _xgetbv(index);
+#else
+	// The intrinsic needs -mxsave, the instruction itself is fine everywhere OSXSAVE is set
+	u32 eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+	return (static_cast<u64>(edx) << 32) | eax;
+#endif
+}
+
 using namespace x86Emitter;
 
 alignas(16) x86capabilities x86caps;
@@ -296,6 +309,16 @@ void x86capabilities::Identify()
 		hasAVX = (Flags2 >> 28) & 1; //avx
 		hasFMA = (Flags2 >> 12) & 1; //fma
 		hasAVX2 = (SEFlag >> 5) & 1; //avx2
+
+		// Unlike AVX, plenty of OSes (and VMs) don't enable the opmask and zmm state, so ask
+		// XCR0 for SSE, AVX, opmask, ZMM_Hi256 and Hi16_ZMM before trusting the AVX-512 bits
+		if ((xgetbv(0) & 0xe6) == 0xe6)
+		{
+			hasAVX512F = (SEFlag >> 16) & 1; //avx512f
+			hasAVX512DQ = (SEFlag >> 17) & 1; //avx512dq
+			hasAVX512BW = (SEFlag >> 30) & 1; //avx512bw
+			hasAVX512VL = (SEFlag >> 31) & 1; //avx512vl
+		}
 	}
 
 	hasBMI1 = (SEFlag >> 3) & 1;
@@ -801,6 +801,8 @@ bool retro_serialize(void* data, size_t size)
 bool retro_unserialize(const void* data, size_t size)
 {
 	cpu_thread_pause();
+	if (THREAD_VU1)
+		vu1Thread.WaitVU();
 
 	VmStateBuffer buffer;
 	buffer.MakeRoomFor(size);
@@ -808,10 +810,11 @@ bool retro_unserialize(const void* data, size_t size)
 	memLoadingState loadme(buffer);
 	freezeData fP;
 
+	// Run-ahead and netplay load states every frame, so only throw out the code which changed.
+	SysBeginStateLoad();
 	loadme.FreezeBios();
 	loadme.FreezeInternals();
 
-	SysClearExecutionCache();
 	loadme.FreezeMem(eeMem->Main, sizeof(eeMem->Main));
 	loadme.FreezeMem(iopMem->Main, sizeof(iopMem->Main));
 	loadme.FreezeMem(eeHw, sizeof(eeHw));
@@ -821,6 +824,7 @@ bool retro_unserialize(const void* data, size_t size)
 	loadme.FreezeMem(vuRegs[1].Mem, VU1_MEMSIZE);
 	loadme.FreezeMem(vuRegs[0].Micro, VU0_PROGSIZE);
 	loadme.FreezeMem(vuRegs[1].Micro, VU1_PROGSIZE);
+	SysEndStateLoad();
 
 	fP.size = 0;
 	fP.data = nullptr;
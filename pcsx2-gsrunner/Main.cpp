@@ -13,6 +13,7 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <csignal>
 #include <cstdlib>
@@ -34,6 +35,7 @@
 #include "common/Path.h"
 #include "common/SettingsWrapper.h"
 #include "common/StringUtil.h"
+#include "common/Timer.h"
 
 #include "pcsx2/PrecompiledHeader.h"
 
@@ -44,6 +46,7 @@
 #include "pcsx2/Frontend/LogSink.h"
 #include "pcsx2/GS.h"
 #include "pcsx2/GS/GS.h"
+#include "pcsx2/GS/GSPerfMon.h"
 #include "pcsx2/GSDumpReplayer.h"
 #include "pcsx2/HostDisplay.h"
 #include "pcsx2/HostSettings.h"
@@ -63,6 +66,11 @@ namespace GSRunner
 	static void InitializeConsole();
 	static bool InitializeConfig();
 	static bool ParseCommandLineArgs(int argc, char* argv[], VMBootParameters& params);
+	static bool RunDump(const VMBootParameters& params);
+	static void RunSWScalingBenchmark(const VMBootParameters& params);
+	static void RunBenchmark(const VMBootParameters& params);
+	static void SampleBenchmarkFrame();
+	static bool WriteBenchmarkResults(const VMBootParameters& params);
 
 	static bool CreatePlatformWindow();
 	static void DestroyPlatformWindow();
@@ -80,11 +88,74 @@ static std::string s_output_prefix;
 static s32 s_loop_count = 1;
 static std::optional<bool> s_use_window;
 static bool s_no_console = false;
+static bool s_sw_scaling_benchmark = false;
+static u32 s_benchmark_runs = 0;
+static u32 s_benchmark_warmup = 1;
+static std::string s_benchmark_output;
+
+// Owned by the CPU thread.
+static u32 s_vsync_count = 0;
+static Common::Timer::Value s_first_vsync_time = 0;
+static Common::Timer::Value s_last_vsync_time = 0;
 
 // Owned by the GS thread.
 static u32 s_dump_frame_number = 0;
 static u32 s_loop_number = s_loop_count;
 
+namespace
+{
+	struct BenchmarkFrame
+	{
+		u32 run;
+		u32 frame;
+		double frame_ms; // wall time since the previous frame
+		double gs_ms; // GS thread CPU time
+		double sw_ms; // CPU time over all SW rasterizer threads
+		double sw_usage; // of the SW rasterizer threads, as a percentage of the frame time
+		double draws;
+		double prims;
+		double draw_calls;
+		double readbacks;
+		double swizzle;
+		double unswizzle;
+		double fillrate;
+	};
+
+	struct BenchmarkSample
+	{
+		Common::Timer::Value time;
+		u64 gs_time;
+		std::vector<u64> sw_times;
+		double counters[GSPerfMon::CounterLast];
+	};
+
+	struct BenchmarkMetric
+	{
+		const char* name;
+		double BenchmarkFrame::*value;
+	};
+
+	static constexpr BenchmarkMetric s_benchmark_metrics[] = {
+		{"frame_ms", &BenchmarkFrame::frame_ms},
+		{"gs_ms", &BenchmarkFrame::gs_ms},
+		{"sw_ms", &BenchmarkFrame::sw_ms},
+		{"sw_usage", &BenchmarkFrame::sw_usage},
+		{"draws", &BenchmarkFrame::draws},
+		{"prims", &BenchmarkFrame::prims},
+		{"draw_calls", &BenchmarkFrame::draw_calls},
+		{"readbacks", &BenchmarkFrame::readbacks},
+		{"swizzle", &BenchmarkFrame::swizzle},
+		{"unswizzle", &BenchmarkFrame::unswizzle},
+		{"fillrate", &BenchmarkFrame::fillrate},
+	};
+} // namespace
+
+// Owned by the GS thread while the dump is running.
+static std::vector<BenchmarkFrame> s_benchmark_frames;
+static std::optional<BenchmarkSample> s_benchmark_last_sample;
+static u32 s_benchmark_last_pass = 0;
+static u32 s_benchmark_pass_frame = 0;
+
 bool GSRunner::InitializeConfig()
 {
 	if (!CommonHost::InitializeCriticalFolders())
@@ -285,6 +356,9 @@ void Host::ReleaseHostDisplay(bool clear_state)
 
 HostDisplay::PresentResult Host::BeginPresentFrame(bool frame_skip)
 {
+	if (s_benchmark_runs > 0)
+		GSRunner::SampleBenchmarkFrame();
+
 	if (s_loop_number == 0 && !s_output_prefix.empty())
 	{
 		// when we wrap around, don't race other files
@@ -450,6 +524,10 @@ static void PrintCommandLineHelp(const char* progname)
 	std::fprintf(stderr, "  -surfaceless: Disables showing a window.\n");
 	std::fprintf(stderr, "  -logfile <filename>: Writes emu log to filename.\n");
 	std::fprintf(stderr, "  -noshadercache: Disables the shader cache (useful for parallel runs).\n");
+	std::fprintf(stderr, "  -swscaling: Replays the dump with the software renderer at 1 to 32 threads, and reports the speedup.\n");
+	std::fprintf(stderr, "  -benchmark <runs>: Replays the dump N times after warming up, and reports per-frame timings.\n");
+	std::fprintf(stderr, "  -warmup <runs>: Number of runs before the benchmark starts recording. Defaults to 1.\n");
+	std::fprintf(stderr, "  -benchmarkout <filename>: Writes benchmark results to a .json (summary and frames) or .csv (frames) file.\n");
 	std::fprintf(stderr, "  --: Signals that no more arguments will follow and the remaining\n"
 						 "    parameters make up the filename. Use when the filename contains\n"
 						 "    spaces or starts with a dash.\n");
@@ -534,6 +612,8 @@ bool GSRunner::ParseCommandLineArgs(int argc, char* argv[], VMBootParameters& pa
 #endif
 				else if (StringUtil::Strcasecmp(rname, "sw") == 0)
 					type = GSRendererType::SW;
+				else if (StringUtil::Strcasecmp(rname, "null") == 0)
+					type = GSRendererType::Null;
 				else
 				{
 					Console.Error("Unknown renderer '%s'", rname);
@@ -600,6 +680,41 @@ bool GSRunner::ParseCommandLineArgs(int argc, char* argv[], VMBootParameters& pa
 				s_settings_interface.SetBoolValue("EmuCore/GS", "disable_shader_cache", true);
 				continue;
 			}
+			else if (CHECK_ARG("-swscaling"))
+			{
+				Console.WriteLn("Running software renderer scaling benchmark");
+				s_sw_scaling_benchmark = true;
+				s_settings_interface.SetIntValue("EmuCore/GS", "Renderer", static_cast<int>(GSRendererType::SW));
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-benchmark"))
+			{
+				s_benchmark_runs = StringUtil::FromChars<u32>(argv[++i]).value_or(0);
+				if (s_benchmark_runs == 0)
+				{
+					Console.Error("Invalid benchmark run count.");
+					return false;
+				}
+
+				Console.WriteLn("Benchmarking %u runs.", s_benchmark_runs);
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-warmup"))
+			{
+				s_benchmark_warmup = StringUtil::FromChars<u32>(argv[++i]).value_or(0);
+				continue;
+			}
+			else if (CHECK_ARG_PARAM("-benchmarkout"))
+			{
+				s_benchmark_output = StringUtil::StripWhitespace(argv[++i]);
+				if (!StringUtil::EndsWithNoCase(s_benchmark_output, ".json") && !StringUtil::EndsWithNoCase(s_benchmark_output, ".csv"))
+				{
+					Console.Error("Benchmark output must be a .json or .csv file.");
+					return false;
+				}
+
+				continue;
+			}
 			else if (CHECK_ARG("-window"))
 			{
 				Console.WriteLn("Creating window");
@@ -690,15 +805,12 @@ int main(int argc, char* argv[])
 	VMManager::ApplySettings();
 	GSDumpReplayer::SetIsDumpRunner(true);
 
-	if (VMManager::Initialize(params))
-	{
-		// run until end
-		GSDumpReplayer::SetLoopCount(s_loop_count);
-		VMManager::SetState(VMState::Running);
-		while (VMManager::GetState() == VMState::Running)
-			VMManager::Execute();
-		VMManager::Shutdown(false);
-	}
+	if (s_sw_scaling_benchmark)
+		GSRunner::RunSWScalingBenchmark(params);
+	else if (s_benchmark_runs > 0)
+		GSRunner::RunBenchmark(params);
+	else
+		GSRunner::RunDump(params);
 
 	InputManager::CloseSources();
 	VMManager::Internal::ReleaseMemory();
@@ -709,8 +821,279 @@ int main(int argc, char* argv[])
 	return EXIT_SUCCESS;
 }
 
+bool GSRunner::RunDump(const VMBootParameters& params)
+{
+	s_vsync_count = 0;
+
+	// GS thread isn't running yet, the CPU thread keeps this up to date from the first vsync
+	s_loop_number = static_cast<u32>(s_loop_count - 1);
+
+	if (!VMManager::Initialize(params))
+		return false;
+
+	// run until end
+	GSDumpReplayer::SetLoopCount(s_loop_count);
+	VMManager::SetState(VMState::Running);
+	while (VMManager::GetState() == VMState::Running)
+		VMManager::Execute();
+	VMManager::Shutdown(false);
+	return true;
+}
+
+void GSRunner::RunSWScalingBenchmark(const VMBootParameters& params)
+{
+	struct Result
+	{
+		int threads;
+		u32 frames;
+		double seconds;
+	};
+
+	static constexpr int thread_counts[] = {1, 2, 4, 8, 16, 32};
+	std::vector<Result> results;
+
+	for (const int threads : thread_counts)
+	{
+		// This is the number of rasterizer workers; zero would draw on the GS thread instead.
+		s_settings_interface.SetIntValue("EmuCore/GS", "extrathreads", threads);
+		VMManager::ApplySettings();
+
+		Console.WriteLn("Replaying with %d software renderer threads...", threads);
+		if (!RunDump(params))
+		{
+			Console.Error("Failed to replay dump with %d threads.", threads);
+			return;
+		}
+
+		// Time from the first to the last vsync, so loading the dump isn't counted.
+		const u32 frames = (s_vsync_count > 0) ? (s_vsync_count - 1) : 0;
+		const double seconds = Common::Timer::ConvertValueToSeconds(s_last_vsync_time - s_first_vsync_time);
+		results.push_back({threads, frames, seconds});
+	}
+
+	const double base_fps = (results[0].seconds > 0.0) ? (results[0].frames / results[0].seconds) : 0.0;
+	std::fprintf(stdout, "threads  frames  seconds      fps  speedup\n");
+	for (const Result& res : results)
+	{
+		const double fps = (res.seconds > 0.0) ? (res.frames / res.seconds) : 0.0;
+		std::fprintf(stdout, "%7d  %6u  %7.3f  %7.2f  %6.2fx\n", res.threads, res.frames, res.seconds, fps,
+			(base_fps > 0.0) ? (fps / base_fps) : 0.0);
+	}
+	std::fflush(stdout);
+}
+
+void GSRunner::RunBenchmark(const VMBootParameters& params)
+{
+	// Every run is a loop of the same VM, so shaders and the SW JIT stay warm between them.
+	s_loop_count = static_cast<s32>(s_benchmark_warmup + s_benchmark_runs);
+	s_benchmark_frames.clear();
+	s_benchmark_last_sample.reset();
+	s_benchmark_last_pass = 0;
+	s_benchmark_pass_frame = 0;
+
+	if (!RunDump(params))
+	{
+		Console.Error("Failed to replay dump.");
+		return;
+	}
+
+	if (s_benchmark_frames.empty())
+	{
+		Console.Error("No frames were recorded.");
+		return;
+	}
+
+	WriteBenchmarkResults(params);
+}
+
+static double GetBenchmarkPercentile(const std::vector<double>& sorted, double percentile)
+{
+	// nearest rank
+	const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static std::string EscapeJSONString(const std::string_view& str)
+{
+	std::string ret;
+	ret.reserve(str.size());
+	for (const char ch : str)
+	{
+		if (ch == '"' || ch == '\\')
+			ret.push_back('\\');
+		if (static_cast<unsigned char>(ch) >= 0x20)
+			ret.push_back(ch);
+		else
+			fmt::format_to(std::back_inserter(ret), "\\u{:04x}", static_cast<unsigned>(ch));
+	}
+	return ret;
+}
+
+void GSRunner::SampleBenchmarkFrame()
+{
+	BenchmarkSample sample;
+	sample.time = Common::Timer::GetCurrentValue();
+	sample.gs_time = GetMTGS().GetThreadHandle().GetCPUTime();
+	sample.sw_times.resize(PerformanceMetrics::GetGSSWThreadCount());
+	for (u32 i = 0; i < static_cast<u32>(sample.sw_times.size()); i++)
+		sample.sw_times[i] = PerformanceMetrics::GetGSSWThreadCPUTime(i);
+	for (u32 i = 0; i < GSPerfMon::CounterLast; i++)
+		sample.counters[i] = g_perfmon.GetTotal(static_cast<GSPerfMon::counter_t>(i));
+
+	// Loops count down. The loop number lags a frame behind, as the CPU thread only updates it at
+	// vsync, but it lags the same way on every loop.
+	const u32 last_pass = s_benchmark_warmup + s_benchmark_runs - 1;
+	const u32 pass = last_pass - std::min(s_loop_number, last_pass);
+	if (pass != s_benchmark_last_pass)
+	{
+		s_benchmark_last_pass = pass;
+		s_benchmark_pass_frame = 0;
+	}
+
+	// the renderer resets the perfmon when it's recreated, and the SW thread count can change with it
+	const BenchmarkSample* last = s_benchmark_last_sample.has_value() ? &s_benchmark_last_sample.value() : nullptr;
+	if (pass >= s_benchmark_warmup && last && last->sw_times.size() == sample.sw_times.size() &&
+		sample.counters[GSPerfMon::Draw] >= last->counters[GSPerfMon::Draw])
+	{
+		const double ticks_to_ms = 1000.0 / static_cast<double>(Threading::GetThreadTicksPerSecond());
+		const double frame_ms = Common::Timer::ConvertValueToMilliseconds(sample.time - last->time);
+
+		u64 sw_time = 0;
+		for (size_t i = 0; i < sample.sw_times.size(); i++)
+			sw_time += sample.sw_times[i] - last->sw_times[i];
+
+		BenchmarkFrame frame;
+		frame.run = pass - s_benchmark_warmup;
+		frame.frame = s_benchmark_pass_frame;
+		frame.frame_ms = frame_ms;
+		frame.gs_ms = static_cast<double>(sample.gs_time - last->gs_time) * ticks_to_ms;
+		frame.sw_ms = static_cast<double>(sw_time) * ticks_to_ms;
+		frame.sw_usage = (frame_ms > 0.0 && !sample.sw_times.empty()) ?
+							 (frame.sw_ms * 100.0 / (frame_ms * static_cast<double>(sample.sw_times.size()))) :
+							 0.0;
+
+		const auto delta = [&sample, last](GSPerfMon::counter_t c) { return sample.counters[c] - last->counters[c]; };
+		frame.draws = delta(GSPerfMon::Draw);
+		frame.prims = delta(GSPerfMon::Prim);
+		frame.draw_calls = delta(GSPerfMon::DrawCalls);
+		frame.readbacks = delta(GSPerfMon::Readbacks);
+		frame.swizzle = delta(GSPerfMon::Swizzle);
+		frame.unswizzle = delta(GSPerfMon::Unswizzle);
+		frame.fillrate = delta(GSPerfMon::Fillrate);
+		s_benchmark_frames.push_back(frame);
+	}
+
+	s_benchmark_pass_frame++;
+	s_benchmark_last_sample = std::move(sample);
+}
+
+bool GSRunner::WriteBenchmarkResults(const VMBootParameters& params)
+{
+	static constexpr double summary_percentiles[] = {50.0, 90.0, 95.0, 99.0};
+
+	struct Summary
+	{
+		double mean;
+		double min;
+		double max;
+		double percentiles[std::size(summary_percentiles)];
+	};
+
+	std::vector<Summary> summaries;
+	std::vector<double> values;
+	values.reserve(s_benchmark_frames.size());
+	for (const BenchmarkMetric& metric : s_benchmark_metrics)
+	{
+		values.clear();
+		for (const BenchmarkFrame& frame : s_benchmark_frames)
+			values.push_back(frame.*metric.value);
+		std::sort(values.begin(), values.end());
+
+		Summary summary;
+		double sum = 0.0;
+		for (const double value : values)
+			sum += value;
+		summary.mean = sum / static_cast<double>(values.size());
+		summary.min = values.front();
+		summary.max = values.back();
+		for (size_t i = 0; i < std::size(summary_percentiles); i++)
+			summary.percentiles[i] = GetBenchmarkPercentile(values, summary_percentiles[i]);
+		summaries.push_back(summary);
+	}
+
+	const char* renderer = Pcsx2Config::GSOptions::GetRendererName(EmuConfig.GS.Renderer);
+	std::fprintf(stdout, "%s renderer, %u runs after %u warmup, %zu frames\n", renderer, s_benchmark_runs, s_benchmark_warmup,
+		s_benchmark_frames.size());
+	std::fprintf(stdout, "%-12s %12s %12s %12s %12s %12s %12s %12s\n", "metric", "mean", "min", "p50", "p90", "p95", "p99", "max");
+	for (size_t i = 0; i < std::size(s_benchmark_metrics); i++)
+	{
+		const Summary& sm = summaries[i];
+		std::fprintf(stdout, "%-12s %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f\n", s_benchmark_metrics[i].name, sm.mean,
+			sm.min, sm.percentiles[0], sm.percentiles[1], sm.percentiles[2], sm.percentiles[3], sm.max);
+	}
+	std::fflush(stdout);
+
+	if (s_benchmark_output.empty())
+		return true;
+
+	std::string out;
+	if (StringUtil::EndsWithNoCase(s_benchmark_output, ".csv"))
+	{
+		out += "run,frame";
+		for (const BenchmarkMetric& metric : s_benchmark_metrics)
+			fmt::format_to(std::back_inserter(out), ",{}", metric.name);
+		out += '\n';
+
+		for (const BenchmarkFrame& frame : s_benchmark_frames)
+		{
+			fmt::format_to(std::back_inserter(out), "{},{}", frame.run, frame.frame);
+			for (const BenchmarkMetric& metric : s_benchmark_metrics)
+				fmt::format_to(std::back_inserter(out), ",{}", frame.*metric.value);
+			out += '\n';
+		}
+	}
+	else
+	{
+		fmt::format_to(std::back_inserter(out), "{{\n  \"version\": \"{}\",\n  \"dump\": \"{}\",\n  \"renderer\": \"{}\",\n",
+			EscapeJSONString(GIT_REV), EscapeJSONString(params.filename), EscapeJSONString(renderer));
+		fmt::format_to(std::back_inserter(out), "  \"runs\": {},\n  \"warmup\": {},\n  \"frame_count\": {},\n  \"summary\": {{\n",
+			s_benchmark_runs, s_benchmark_warmup, s_benchmark_frames.size());
+		for (size_t i = 0; i < std::size(s_benchmark_metrics); i++)
+		{
+			const Summary& sm = summaries[i];
+			fmt::format_to(std::back_inserter(out),
+				"    \"{}\": {{\"mean\": {}, \"min\": {}, \"p50\": {}, \"p90\": {}, \"p95\": {}, \"p99\": {}, \"max\": {}}}{}\n",
+				s_benchmark_metrics[i].name, sm.mean, sm.min, sm.percentiles[0], sm.percentiles[1], sm.percentiles[2],
+				sm.percentiles[3], sm.max, (i + 1 < std::size(s_benchmark_metrics)) ? "," : "");
+		}
+		out += "  },\n  \"frames\": [\n";
+		for (size_t i = 0; i < s_benchmark_frames.size(); i++)
+		{
+			const BenchmarkFrame& frame = s_benchmark_frames[i];
+			fmt::format_to(std::back_inserter(out), "    {{\"run\": {}, \"frame\": {}", frame.run, frame.frame);
+			for (const BenchmarkMetric& metric : s_benchmark_metrics)
+				fmt::format_to(std::back_inserter(out), ", \"{}\": {}", metric.name, frame.*metric.value);
+			fmt::format_to(std::back_inserter(out), "}}{}\n", (i + 1 < s_benchmark_frames.size()) ? "," : "");
+		}
+		out += "  ]\n}\n";
+	}
+
+	if (!FileSystem::WriteStringToFile(s_benchmark_output.c_str(), out))
+	{
+		Console.Error("Failed to write benchmark results to '%s'.", s_benchmark_output.c_str());
+		return false;
+	}
+
+	Console.WriteLn("Wrote benchmark results to '%s'.", s_benchmark_output.c_str());
+	return true;
+}
+
 void Host::CPUThreadVSync()
 {
+	s_last_vsync_time = Common::Timer::GetCurrentValue();
+	if (s_vsync_count++ == 0)
+		s_first_vsync_time = s_last_vsync_time;
+
 	// update GS thread copy of frame number
 	GetMTGS().RunOnGSThread([frame_number = GSDumpReplayer::GetFrameNumber()]() { s_dump_frame_number = frame_number; });
 	GetMTGS().RunOnGSThread([loop_number = GSDumpReplayer::GetLoopCount()]() { s_loop_number = loop_number; });
@@ -87,6 +87,10 @@ EmulationSettingsWidget::EmulationSettingsWidget(SettingsDialog* dialog, QWidget
 	SettingWidgetBinder::BindWidgetToBoolSetting(sif, m_ui.cheats, "EmuCore", "EnableCheats", false);
 	SettingWidgetBinder::BindWidgetToBoolSetting(sif, m_ui.hostFilesystem, "EmuCore", "HostFs", false);
 
+	SettingWidgetBinder::BindWidgetToBoolSetting(sif, m_ui.enableRewind, "EmuCore", "EnableRewind", false);
+	SettingWidgetBinder::BindWidgetToIntSetting(sif, m_ui.rewindFrequency, "EmuCore", "RewindFrequency", 10);
+	SettingWidgetBinder::BindWidgetToIntSetting(sif, m_ui.rewindBufferSize, "EmuCore", "RewindBufferSizeMB", 512);
+
 	dialog->registerWidgetHelp(m_ui.normalSpeed, tr("Normal Speed"), "100%",
 		tr("Sets the target emulation speed. It is not guaranteed that this speed will be reached, "
 		   "and if not, the emulator will run as fast as it can manage."));
@@ -136,6 +140,14 @@ EmulationSettingsWidget::EmulationSettingsWidget(SettingsDialog* dialog, QWidget
 		   "the console's refresh rate is too far from the host's refresh rate. Users with variable refresh rate displays "
 		   "should disable this option."));
 
+	dialog->registerWidgetHelp(m_ui.enableRewind, tr("Enable Rewind"), tr("Unchecked"),
+		tr("Keeps recent snapshots of the game in memory, so it can be played backwards while the Rewind hotkey is held. "
+		   "Costs some CPU time and memory while playing."));
+	dialog->registerWidgetHelp(m_ui.rewindFrequency, tr("Snapshot Frequency"), tr("10 Frames"),
+		tr("Number of frames between rewind snapshots. Lower values make rewinding smoother, but use more CPU time and memory."));
+	dialog->registerWidgetHelp(m_ui.rewindBufferSize, tr("Memory Budget"), tr("512 MB"),
+		tr("Memory kept for rewind snapshots. The oldest snapshots are dropped once it's full, so larger budgets rewind further back."));
+
 	updateOptimalFramePacing();
 }
 
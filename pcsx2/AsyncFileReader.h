@@ -104,6 +104,77 @@ public:
 	virtual void SetDataOffset(int bytes) override { m_dataoffset = bytes; }
 };
 
+#ifdef __linux__
+// Flat file reader which keeps several reads in flight through io_uring.
+// The file is read in fixed size, aligned blocks into internal buffers, which lets it
+// use O_DIRECT, and lets it read ahead of the game when it's streaming sequentially.
+class UringFileReader : public AsyncFileReader
+{
+	DeclareNoncopyableObject(UringFileReader);
+
+	struct Ring;
+	struct Block
+	{
+		s64 index;    // block number in the file, -1 if unused
+		u8* data;     // BlockSize bytes, aligned for O_DIRECT
+		int result;   // bytes read, or negative errno
+		bool pending; // owned by the kernel until its completion is reaped
+		u64 lastUse;
+	};
+
+	std::unique_ptr<Ring> m_ring;
+	int m_fd;
+	bool m_direct;
+
+	std::unique_ptr<Block[]> m_blocks;
+	u8* m_blockData;
+	u32 m_numBlocks;
+	u32 m_readahead;
+	u64 m_useCounter;
+	u32 m_pending;
+	bool m_ringFailed; // io_uring_enter failed, blocks are read with pread instead
+
+	// Current request, done in FinishRead.
+	void* m_readBuffer;
+	s64 m_readOffset;
+	u32 m_readSize;
+	s64 m_lastReadEnd;
+
+	Block* FindBlock(s64 index);
+	Block* QueueBlock(s64 index);
+	bool Enter(u32 minComplete);
+	bool Submit();
+	bool Reap(bool wait);
+	bool WaitAll();
+	bool OpenFile(bool direct);
+
+public:
+	static constexpr u32 BlockSize = 128 * 1024;
+	static constexpr u32 Alignment = 4096;
+
+	UringFileReader();
+	virtual ~UringFileReader() override;
+
+	/// Returns a new reader if io_uring is usable on this system (it's often disabled in containers), otherwise null.
+	static AsyncFileReader* Create();
+
+	virtual bool Open(std::string fileName) override;
+
+	virtual int ReadSync(void* pBuffer, uint sector, uint count) override;
+
+	virtual void BeginRead(void* pBuffer, uint sector, uint count) override;
+	virtual int FinishRead(void) override;
+	virtual void CancelRead(void) override;
+
+	virtual void Close(void) override;
+
+	virtual uint GetBlockCount(void) const override;
+
+	virtual void SetBlockSize(uint bytes) override { m_blocksize = bytes; }
+	virtual void SetDataOffset(int bytes) override { m_dataoffset = bytes; }
+};
+#endif
+
 class MultipartFileReader : public AsyncFileReader
 {
 	DeclareNoncopyableObject( MultipartFileReader );
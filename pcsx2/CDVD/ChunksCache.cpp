@@ -16,43 +16,174 @@
 #include "PrecompiledHeader.h"
 #include "ChunksCache.h"
 
+// Chunk data is allocated in slabs of (roughly) this size
+static constexpr u32 SLAB_SIZE = 4 * 1024 * 1024;
+
+ChunksCache::ChunksCache(u32 chunkSize, uint limitMb)
+	: m_chunkSize(chunkSize)
+{
+	SetLimit(limitMb);
+}
+
+ChunksCache::~ChunksCache() = default;
+
+void ChunksCache::Configure(u32 chunkSize, uint limitMb)
+{
+	m_chunkSize = chunkSize;
+	SetLimit(limitMb);
+}
+
 void ChunksCache::SetLimit(uint megabytes)
 {
-	m_limit = (s64)megabytes * 1024 * 1024;
-	MatchLimit();
+	Clear();
+
+	const u64 limit = (u64)megabytes * 1024 * 1024;
+	m_capacity = m_chunkSize ? static_cast<u32>(std::min<u64>(limit / m_chunkSize, INVALID_INDEX - 1)) : 0;
+	m_entriesPerSlab = m_chunkSize ? std::max<u32>(SLAB_SIZE / m_chunkSize, 1) : 0;
+	m_entries.reserve(m_capacity);
+
+	// Keep the load factor at or below 0.5, chains will rarely be longer than one entry
+	u32 bits = 1;
+	while ((1ull << bits) < (u64)m_capacity * 2)
+		bits++;
+	m_bucketShift = 64 - bits;
+}
+
+void ChunksCache::Clear()
+{
+	m_entries.clear();
+	m_buckets.clear();
+	m_slabs.clear();
+	m_head = INVALID_INDEX;
+	m_tail = INVALID_INDEX;
+}
+
+u32 ChunksCache::BucketForOffset(s64 offset) const
+{
+	// Fibonacci hashing of the chunk number
+	const u64 key = static_cast<u64>(offset) / m_chunkSize;
+	return static_cast<u32>((key * 0x9E3779B97F4A7C15ull) >> m_bucketShift);
+}
+
+u8* ChunksCache::DataForEntry(u32 index) const
+{
+	return m_slabs[index / m_entriesPerSlab].get() + static_cast<size_t>(index % m_entriesPerSlab) * m_chunkSize;
 }
 
-void ChunksCache::MatchLimit(bool removeAll)
+u32 ChunksCache::FindEntry(s64 offset) const
 {
-	std::list<CacheEntry*>::reverse_iterator rit;
-	while (!m_entries.empty() && (removeAll || m_size > m_limit))
+	if (m_buckets.empty())
+		return INVALID_INDEX;
+
+	for (u32 index = m_buckets[BucketForOffset(offset)]; index != INVALID_INDEX; index = m_entries[index].hashNext)
 	{
-		rit = m_entries.rbegin();
-		m_size -= (*rit)->size;
-		delete (*rit);
-		m_entries.pop_back();
+		if (m_entries[index].offset == offset)
+			return index;
 	}
+	return INVALID_INDEX;
+}
+
+void ChunksCache::LinkFront(u32 index)
+{
+	Entry& e = m_entries[index];
+	e.prev = INVALID_INDEX;
+	e.next = m_head;
+	if (m_head != INVALID_INDEX)
+		m_entries[m_head].prev = index;
+	m_head = index;
+	if (m_tail == INVALID_INDEX)
+		m_tail = index;
 }
 
-void ChunksCache::Take(void* pMallocedSrc, s64 offset, int length, int coverage)
+void ChunksCache::Unlink(u32 index)
 {
-	m_entries.push_front(new CacheEntry(pMallocedSrc, offset, length, coverage));
-	m_size += length;
-	MatchLimit();
+	Entry& e = m_entries[index];
+	if (e.prev != INVALID_INDEX)
+		m_entries[e.prev].next = e.next;
+	else
+		m_head = e.next;
+	if (e.next != INVALID_INDEX)
+		m_entries[e.next].prev = e.prev;
+	else
+		m_tail = e.prev;
+}
+
+void ChunksCache::RemoveFromBucket(u32 index)
+{
+	u32* link = &m_buckets[BucketForOffset(m_entries[index].offset)];
+	while (*link != index)
+		link = &m_entries[*link].hashNext;
+	*link = m_entries[index].hashNext;
+}
+
+u32 ChunksCache::AllocateEntry()
+{
+	if (m_entries.size() < m_capacity)
+	{
+		const u32 index = static_cast<u32>(m_entries.size());
+		if (index % m_entriesPerSlab == 0)
+			m_slabs.emplace_back(new u8[static_cast<size_t>(m_entriesPerSlab) * m_chunkSize]);
+		m_entries.push_back({});
+		return index;
+	}
+
+	// Full, recycle the least recently used entry.
+	const u32 index = m_tail;
+	Unlink(index);
+	RemoveFromBucket(index);
+	return index;
+}
+
+void ChunksCache::Insert(const void* pSrc, s64 offset, int length, int coverage)
+{
+	if (m_capacity == 0 || offset < 0 || offset % m_chunkSize != 0 || length < 0 || static_cast<u32>(length) > m_chunkSize)
+		return;
+
+	if (m_buckets.empty())
+		m_buckets.resize(static_cast<size_t>(1) << (64 - m_bucketShift), INVALID_INDEX);
+
+	u32 index = FindEntry(offset);
+	if (index != INVALID_INDEX)
+	{
+		Unlink(index);
+	}
+	else
+	{
+		index = AllocateEntry();
+		u32& bucket = m_buckets[BucketForOffset(offset)];
+		m_entries[index].offset = offset;
+		m_entries[index].hashNext = bucket;
+		bucket = index;
+	}
+
+	Entry& e = m_entries[index];
+	e.size = static_cast<u32>(length);
+	e.coverage = static_cast<u32>(std::clamp(coverage, length, static_cast<int>(m_chunkSize)));
+	std::memcpy(DataForEntry(index), pSrc, length);
+	LinkFront(index);
 }
 
-// By design, succeed only if the entire request is in a single cached chunk
 int ChunksCache::Read(void* pDest, s64 offset, int length)
 {
-	for (auto it = m_entries.begin(); it != m_entries.end(); it++)
+	if (m_capacity == 0 || offset < 0)
+		return -1;
+
+	const s64 chunkOffset = offset - (offset % m_chunkSize);
+	const u32 index = FindEntry(chunkOffset);
+	if (index == INVALID_INDEX || (offset + length) > (chunkOffset + m_entries[index].coverage))
 	{
-		CacheEntry* e = *it;
-		if (e && offset >= e->offset && (offset + length) <= (e->offset + e->coverage))
-		{
-			if (it != m_entries.begin())
-				m_entries.splice(m_entries.begin(), m_entries, it); // Move to top (MRU)
-			return CopyAvailable(e->data, e->offset, e->size, pDest, offset, length);
-		}
+		m_misses.fetch_add(1, std::memory_order_relaxed);
+		return -1;
 	}
-	return -1;
+
+	if (index != m_head)
+	{
+		// Move to top (MRU)
+		Unlink(index);
+		LinkFront(index);
+	}
+
+	m_hits.fetch_add(1, std::memory_order_relaxed);
+	const Entry& e = m_entries[index];
+	return CopyAvailable(DataForEntry(index), e.offset, e.size, pDest, offset, length);
 }
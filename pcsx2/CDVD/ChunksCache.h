@@ -16,54 +16,84 @@
 #pragma once
 
 #include "common/Pcsx2Types.h"
-#include <list>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
 
+/// LRU cache of decompressed chunks, keyed by chunk offset
+/// All chunks are the same size and start at multiples of it, which lets lookups be a single hash probe
+/// Chunk data lives in large slabs which are allocated as the cache fills, never per entry
 class ChunksCache
 {
 public:
-	ChunksCache(uint initialLimitMb)
-		: m_entries(0)
-		, m_size(0)
-		, m_limit(initialLimitMb * 1024 * 1024){};
-	~ChunksCache() { Clear(); };
+	ChunksCache(u32 chunkSize = 0, uint limitMb = 0);
+	~ChunksCache();
+
+	/// Change the chunk size and memory budget, dropping everything in the cache
+	void Configure(u32 chunkSize, uint limitMb);
+	/// Change the memory budget, dropping everything in the cache
 	void SetLimit(uint megabytes);
-	void Clear() { MatchLimit(true); };
+	/// Drop all entries and release the slabs
+	void Clear();
+
+	u32 GetChunkSize() const { return m_chunkSize; }
+	/// Safe to call from other threads, the counts are only statistics
+	u64 GetHits() const { return m_hits.load(std::memory_order_relaxed); }
+	u64 GetMisses() const { return m_misses.load(std::memory_order_relaxed); }
 
-	void Take(void* pMallocedSrc, s64 offset, int length, int coverage);
+	/// Copy a chunk into the cache, evicting the least recently used chunk if it's full
+	/// `offset` must be a multiple of the chunk size and `length` must not be more than it
+	/// `coverage` is the amount of the file the chunk represents, which is more than `length` when it hits EOF
+	void Insert(const void* pSrc, s64 offset, int length, int coverage);
+	/// By design, succeed only if the entire request is in a single cached chunk
+	/// Returns the number of bytes copied, or -1 if the chunk isn't cached
 	int Read(void* pDest, s64 offset, int length);
 
-	static int CopyAvailable(void* pSrc, s64 srcOffset, int srcSize,
+	static int CopyAvailable(const void* pSrc, s64 srcOffset, int srcSize,
 							 void* pDst, s64 dstOffset, int maxCopySize)
 	{
 		int available = std::clamp(maxCopySize, 0, std::max((int)(srcOffset + srcSize - dstOffset), 0));
-		memcpy(pDst, (char*)pSrc + (dstOffset - srcOffset), available);
+		memcpy(pDst, (const char*)pSrc + (dstOffset - srcOffset), available);
 		return available;
 	};
 
 private:
-	class CacheEntry
-	{
-	public:
-		CacheEntry(void* pMallocedSrc, s64 offset, int length, int coverage)
-			: data(pMallocedSrc)
-			, offset(offset)
-			, coverage(coverage)
-			, size(length){};
-
-		~CacheEntry()
-		{
-			if (data)
-				free(data);
-		};
+	static constexpr u32 INVALID_INDEX = 0xFFFFFFFFu;
 
-		void* data;
+	struct Entry
+	{
 		s64 offset;
-		int coverage;
-		int size;
+		u32 size;
+		u32 coverage;
+		/// LRU list links, towards the most and least recently used entries
+		u32 prev;
+		u32 next;
+		/// Next entry in the same hash bucket
+		u32 hashNext;
 	};
 
-	std::list<CacheEntry*> m_entries;
-	void MatchLimit(bool removeAll = false);
-	s64 m_size;
-	s64 m_limit;
+	u32 BucketForOffset(s64 offset) const;
+	u8* DataForEntry(u32 index) const;
+	u32 FindEntry(s64 offset) const;
+	u32 AllocateEntry();
+	void LinkFront(u32 index);
+	void Unlink(u32 index);
+	void RemoveFromBucket(u32 index);
+
+	u32 m_chunkSize;
+	/// Maximum number of entries allowed by the memory budget
+	u32 m_capacity = 0;
+	u32 m_entriesPerSlab = 0;
+	u32 m_bucketShift = 0;
+
+	std::vector<Entry> m_entries;
+	std::vector<u32> m_buckets;
+	std::vector<std::unique_ptr<u8[]>> m_slabs;
+	u32 m_head = INVALID_INDEX;
+	u32 m_tail = INVALID_INDEX;
+
+	std::atomic<u64> m_hits{0};
+	std::atomic<u64> m_misses{0};
 };
@@ -143,14 +143,7 @@ bool CsoFileReader::InitializeBuffers()
 	u32 numFrames = (u32)((m_totalSize + m_frameSize - 1) / m_frameSize);
 
 	// We might read a bit of alignment too, so be prepared.
-	if (m_frameSize + (1 << m_indexShift) < CSO_READ_BUFFER_SIZE)
-	{
-		m_readBuffer = new u8[CSO_READ_BUFFER_SIZE];
-	}
-	else
-	{
-		m_readBuffer = new u8[m_frameSize + (1 << m_indexShift)];
-	}
+	m_readBufferSize = std::max<u32>(CSO_READ_BUFFER_SIZE, m_frameSize + (1 << m_indexShift));
 
 	const u32 indexSize = numFrames + 1;
 	m_index = new u32[indexSize];
@@ -160,17 +153,74 @@ bool CsoFileReader::InitializeBuffers()
 		return false;
 	}
 
-	m_z_stream = new z_stream;
-	m_z_stream->zalloc = Z_NULL;
-	m_z_stream->zfree = Z_NULL;
-	m_z_stream->opaque = Z_NULL;
-	if (inflateInit2(m_z_stream, -15) != Z_OK)
+	// The header handle becomes the first decompression context.
+	std::unique_ptr<Context> ctx = CreateContext(m_src);
+	m_src = nullptr;
+	if (!ctx)
+		return false;
+
+	ReleaseContext(std::move(ctx));
+	return true;
+}
+
+CsoFileReader::Context::~Context()
+{
+	if (stream)
+	{
+		inflateEnd(stream);
+		delete stream;
+	}
+	if (src)
+		fclose(src);
+}
+
+std::unique_ptr<CsoFileReader::Context> CsoFileReader::CreateContext(FILE* src)
+{
+	std::unique_ptr<Context> ctx = std::make_unique<Context>();
+	ctx->src = src ? src : FileSystem::OpenCFile(m_filename.c_str(), "rb");
+	if (!ctx->src)
+	{
+		Console.Error("Unable to open CSO file for decompression.");
+		return {};
+	}
+
+	ctx->readBuffer = std::make_unique<u8[]>(m_readBufferSize);
+
+	ctx->stream = new z_stream;
+	ctx->stream->zalloc = Z_NULL;
+	ctx->stream->zfree = Z_NULL;
+	ctx->stream->opaque = Z_NULL;
+	if (inflateInit2(ctx->stream, -15) != Z_OK)
 	{
 		Console.Error("Unable to initialize zlib for CSO decompression.");
-		return false;
+		delete ctx->stream;
+		ctx->stream = nullptr;
+		return {};
 	}
 
-	return true;
+	return ctx;
+}
+
+std::unique_ptr<CsoFileReader::Context> CsoFileReader::AcquireContext()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_contextMutex);
+		if (!m_freeContexts.empty())
+		{
+			std::unique_ptr<Context> ctx = std::move(m_freeContexts.back());
+			m_freeContexts.pop_back();
+			return ctx;
+		}
+	}
+
+	// All contexts are in use by other threads, make another one.
+	return CreateContext(nullptr);
+}
+
+void CsoFileReader::ReleaseContext(std::unique_ptr<Context> ctx)
+{
+	std::lock_guard<std::mutex> lock(m_contextMutex);
+	m_freeContexts.push_back(std::move(ctx));
 }
 
 void CsoFileReader::Close2()
@@ -182,17 +232,12 @@ void CsoFileReader::Close2()
 		fclose(m_src);
 		m_src = NULL;
 	}
-	if (m_z_stream)
-	{
-		inflateEnd(m_z_stream);
-		m_z_stream = NULL;
-	}
 
-	if (m_readBuffer)
 	{
-		delete[] m_readBuffer;
-		m_readBuffer = NULL;
+		std::lock_guard<std::mutex> lock(m_contextMutex);
+		m_freeContexts.clear();
 	}
+
 	if (m_index)
 	{
 		delete[] m_index;
@@ -232,39 +277,54 @@ int CsoFileReader::ReadChunk(void *dst, s64 chunkID)
 	const u64 frameRawPos = (u64)index0 << m_indexShift;
 	const u64 frameRawSize = (u64)(index1 - index0) << m_indexShift;
 
+	std::unique_ptr<Context> ctx = AcquireContext();
+	if (!ctx)
+		return 0;
+
+	int result;
 	if (!compressed)
 	{
 		// Just read directly, easy.
-		if (FileSystem::FSeek64(m_src, frameRawPos, SEEK_SET) != 0)
+		if (FileSystem::FSeek64(ctx->src, frameRawPos, SEEK_SET) != 0)
 		{
 			Console.Error("Unable to seek to uncompressed CSO data.");
-			return 0;
+			result = 0;
+		}
+		else
+		{
+			result = fread(dst, 1, m_frameSize, ctx->src);
 		}
-		return fread(dst, 1, m_frameSize, m_src);
 	}
 	else
 	{
-		if (FileSystem::FSeek64(m_src, frameRawPos, SEEK_SET) != 0)
+		if (FileSystem::FSeek64(ctx->src, frameRawPos, SEEK_SET) != 0)
 		{
 			Console.Error("Unable to seek to compressed CSO data.");
-			return 0;
+			result = 0;
 		}
-		// This might be less bytes than frameRawSize in case of padding on the last frame.
-		// This is because the index positions must be aligned.
-		const u32 readRawBytes = fread(m_readBuffer, 1, frameRawSize, m_src);
+		else
+		{
+			// This might be less bytes than frameRawSize in case of padding on the last frame.
+			// This is because the index positions must be aligned.
+			const u32 readRawBytes = fread(ctx->readBuffer.get(), 1, frameRawSize, ctx->src);
 
-		m_z_stream->next_in = m_readBuffer;
-		m_z_stream->avail_in = readRawBytes;
-		m_z_stream->next_out = static_cast<Bytef*>(dst);
-		m_z_stream->avail_out = m_frameSize;
+			z_stream* stream = ctx->stream;
+			stream->next_in = ctx->readBuffer.get();
+			stream->avail_in = readRawBytes;
+			stream->next_out = static_cast<Bytef*>(dst);
+			stream->avail_out = m_frameSize;
 
-		int status = inflate(m_z_stream, Z_FINISH);
-		bool success = status == Z_STREAM_END && m_z_stream->total_out == m_frameSize;
+			int status = inflate(stream, Z_FINISH);
+			bool success = status == Z_STREAM_END && stream->total_out == m_frameSize;
 
-		if (!success)
-			Console.Error("Unable to decompress CSO frame using zlib.");
-		inflateReset(m_z_stream);
+			if (!success)
+				Console.Error("Unable to decompress CSO frame using zlib.");
+			inflateReset(stream);
 
-		return success ? m_frameSize : 0;
+			result = success ? m_frameSize : 0;
+		}
 	}
+
+	ReleaseContext(std::move(ctx));
+	return result;
 }
@@ -15,24 +15,15 @@
 
 #pragma once
 
-// Based on testing, the overhead of using this cache is high.
-//
-// The test was done with CSO files using a block size of 16KB.
-// Cache hit rates were observed in the range of 25%.
-// Cache overhead added 35% to the overall read time.
-//
-// For this reason, it's currently disabled.
-#define CSO_USE_CHUNKSCACHE 0
-
 #include "ThreadedFileReader.h"
-#include "ChunksCache.h"
 #include <zlib.h>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 struct CsoHeader;
 typedef struct z_stream_s z_stream;
 
-static const uint CSO_CHUNKCACHE_SIZE_MB = 200;
-
 class CsoFileReader : public ThreadedFileReader
 {
 	DeclareNoncopyableObject(CsoFileReader);
@@ -42,11 +33,9 @@ public:
 		: m_frameSize(0)
 		, m_frameShift(0)
 		, m_indexShift(0)
-		, m_readBuffer(0)
 		, m_index(0)
 		, m_totalSize(0)
 		, m_src(0)
-		, m_z_stream(0)
 	{
 		m_blocksize = 2048;
 	};
@@ -58,6 +47,7 @@ public:
 
 	Chunk ChunkForOffset(u64 offset) override;
 	int ReadChunk(void *dst, s64 chunkID) override;
+	bool CanReadChunksConcurrently() const override { return true; }
 
 	void Close2(void) override;
 
@@ -67,20 +57,33 @@ public:
 	};
 
 private:
+	/// Per-thread decompression state, so frames can be read from several threads at once
+	struct Context
+	{
+		~Context();
+
+		// Source cso file handle, separate per context so seeks don't interfere.
+		FILE* src = nullptr;
+		std::unique_ptr<u8[]> readBuffer;
+		z_stream* stream = nullptr;
+	};
+
 	static bool ValidateHeader(const CsoHeader& hdr);
 	bool ReadFileHeader();
 	bool InitializeBuffers();
-	int ReadFromFrame(u8* dest, u64 pos, int maxBytes);
-	bool DecompressFrame(Bytef* dst, u32 frame, u32 readBufferSize);
-	bool DecompressFrame(u32 frame, u32 readBufferSize);
+	std::unique_ptr<Context> CreateContext(FILE* src);
+	std::unique_ptr<Context> AcquireContext();
+	void ReleaseContext(std::unique_ptr<Context> ctx);
 
 	u32 m_frameSize;
 	u8 m_frameShift;
 	u8 m_indexShift;
-	u8* m_readBuffer;;
+	u32 m_readBufferSize = 0;
 	u32* m_index;
 	u64 m_totalSize;
-	// The actual source cso file handle.
+	// The actual source cso file handle, handed to the first context after the header is read.
 	FILE* m_src;
-	z_stream* m_z_stream;
+
+	std::mutex m_contextMutex;
+	std::vector<std::unique_ptr<Context>> m_freeContexts;
 };
@@ -18,22 +18,52 @@
 #include "common/FileSystem.h"
 #include "common/Path.h"
 #include "common/StringUtil.h"
+#include "common/Threading.h"
+#include "common/Timer.h"
 #include "Config.h"
 #include "ChunksCache.h"
 #include "GzippedFileReader.h"
 #include "HostSettings.h"
 #include "zlib_indexed.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
 #define CLAMP(val, minval, maxval) (std::min(maxval, std::max(minval, val)))
 
 #define GZIP_ID "PCSX2.index.gzip.v1|"
 #define GZIP_ID_LEN (sizeof(GZIP_ID) - 1) /* sizeof includes the \0 terminator */
 
-// File format is:
+#define GZIP_INDEX_V2_ID "PCSX2.index.gzip.v2|"
+#define GZIP_INDEX_VERSION 2
+
+// Distance between the volume size in the primary volume descriptor and the gzip trailer size which we accept
+// when estimating the image size. Anything further apart could be a dual layer disc, so we wait for the index.
+#define GZIP_ESTIMATE_SLACK (16 * _1mb)
+
+// v2 file format (all little endian, no padding):
+// - [sizeof(GzipIndexHeader)] header, which identifies the compressed file the index was built from
+// - [have * sizeof(Point)] the indexed data points, which are used in place by mapping the file
+struct GzipIndexHeader
+{
+	char id[GZIP_ID_LEN];
+	u32 version;
+	s64 compressed_size;
+	s64 compressed_mtime;
+	s64 uncompressed_size;
+	u32 point_size;
+	s32 span;
+	s32 have;
+	u32 reserved;
+};
+static_assert(sizeof(GzipIndexHeader) == 64, "Index header should not be padded");
+
+// v1 file format is:
 // - [GZIP_ID_LEN] GZIP_ID (no \0)
 // - [sizeof(Access)] index (should be allocated, contains various sizes)
 // - [rest] the indexed data points (should be allocated, index->list should then point to it)
-static Access* ReadIndexFromFile(const char* filename)
+static Access* ReadLegacyIndexFromFile(const char* filename)
 {
 	auto fp = FileSystem::OpenManagedCFile(filename, "rb");
 	s64 size;
@@ -73,31 +103,98 @@ static Access* ReadIndexFromFile(const char* filename)
 	return index;
 }
 
-static void WriteIndexToFile(Access* index, const char* filename)
+// Reads a v2 index by mapping it, the returned index's list points into the mapping.
+// Falls back to the v1 reader for older files. Returns null if the index is missing, broken,
+// or was built from a different version of the compressed file.
+static Access* ReadIndexFromFile(const char* filename, std::FILE* src, FileSystem::MappedFile* mapping)
 {
-	if (FileSystem::FileExists(filename))
+	if (!mapping->Open(filename))
 	{
-		Console.Warning("WARNING: Won't write index - file name exists (please delete it manually): '%s'", filename);
-		return;
+		Console.Error("Error: Can't open index file: '%s'", filename);
+		return 0;
 	}
 
-	auto fp = FileSystem::OpenManagedCFile(filename, "wb");
-	if (!fp)
+	const u8* data = mapping->GetData();
+	const size_t size = mapping->GetSize();
+	if (size < sizeof(GzipIndexHeader) || std::memcmp(data, GZIP_INDEX_V2_ID, GZIP_ID_LEN) != 0)
+	{
+		mapping->Close();
+		return ReadLegacyIndexFromFile(filename);
+	}
+
+	GzipIndexHeader hdr;
+	std::memcpy(&hdr, data, sizeof(hdr));
+
+	FILESYSTEM_STAT_DATA sd;
+	if (hdr.version != GZIP_INDEX_VERSION || hdr.point_size != sizeof(Point) || hdr.have <= 0 ||
+		size != sizeof(GzipIndexHeader) + static_cast<size_t>(hdr.have) * sizeof(Point))
+	{
+		Console.Warning("Warning: Unexpected gzip index format, it will be rebuilt: '%s'", filename);
+		mapping->Close();
+		return 0;
+	}
+	if (!FileSystem::StatFile(src, &sd) || sd.Size != hdr.compressed_size ||
+		static_cast<s64>(sd.ModificationTime) != hdr.compressed_mtime)
+	{
+		Console.Warning("Warning: Gzip index is out of date, it will be rebuilt: '%s'", filename);
+		mapping->Close();
+		return 0;
+	}
+
+	Access* const index = (Access*)malloc(sizeof(Access));
+	index->have = hdr.have;
+	index->size = hdr.have;
+	index->span = hdr.span;
+	index->uncompressed_size = hdr.uncompressed_size;
+	index->list = (Point*)(data + sizeof(GzipIndexHeader)); // Point is packed, so any alignment is fine
+	return index;
+}
+
+static void WriteIndexToFile(Access* index, const char* filename, std::FILE* src)
+{
+	FILESYSTEM_STAT_DATA sd;
+	if (!FileSystem::StatFile(src, &sd))
 		return;
 
-	bool success = (std::fwrite(GZIP_ID, GZIP_ID_LEN, 1, fp.get()) == 1);
+	// Don't clobber something which isn't an index, but replace our own indexes (they're stale if we're here).
+	if (FileSystem::FileExists(filename))
+	{
+		auto existing = FileSystem::OpenManagedCFile(filename, "rb");
+		char fileId[GZIP_ID_LEN] = {};
+		if (!existing || std::fread(fileId, GZIP_ID_LEN, 1, existing.get()) != 1 ||
+			std::memcmp(fileId, GZIP_INDEX_V2_ID, GZIP_ID_LEN) != 0)
+		{
+			Console.Warning("WARNING: Won't write index - file name exists (please delete it manually): '%s'", filename);
+			return;
+		}
+	}
 
-	Point* tmp = index->list;
-	index->list = 0; // current pointer is useless on disk, normalize it as 0.
-	std::fwrite((char*)index, sizeof(Access), 1, fp.get());
-	index->list = tmp;
+	GzipIndexHeader hdr = {};
+	std::memcpy(hdr.id, GZIP_INDEX_V2_ID, GZIP_ID_LEN);
+	hdr.version = GZIP_INDEX_VERSION;
+	hdr.point_size = sizeof(Point);
+	hdr.compressed_size = sd.Size;
+	hdr.compressed_mtime = static_cast<s64>(sd.ModificationTime);
+	hdr.uncompressed_size = index->uncompressed_size;
+	hdr.span = index->span;
+	hdr.have = index->have;
+
+	// Write to a temporary file and swap it in, so a crash can't leave a truncated index behind.
+	const std::string temp_filename(StringUtil::StdStringFromFormat("%s.new", filename));
+	auto fp = FileSystem::OpenManagedCFile(temp_filename.c_str(), "wb");
+	if (!fp)
+		return;
 
+	bool success = (std::fwrite(&hdr, sizeof(hdr), 1, fp.get()) == 1);
 	success = success && (std::fwrite((char*)index->list, sizeof(Point) * index->have, 1, fp.get()) == 1);
+	success = success && (std::fflush(fp.get()) == 0);
+	fp.reset();
 
 	// Verify
-	if (!success)
+	if (!success || !FileSystem::RenamePath(temp_filename.c_str(), filename))
 	{
 		Console.Warning("Warning: Can't write index file to disk: '%s'", filename);
+		FileSystem::DeleteFilePath(temp_filename.c_str());
 	}
 	else
 	{
@@ -105,6 +202,14 @@ static void WriteIndexToFile(Access* index, const char* filename)
 	}
 }
 
+// Configured distance between access points, rounded to whole extraction chunks.
+static s32 GetIndexSpan()
+{
+	const uint span_kb = Host::GetBaseUIntSettingValue("EmuCore", "GzipIsoIndexSpanKB", GZFILE_SPAN_DEFAULT / 1024);
+	const s64 span = static_cast<s64>(span_kb) * 1024 / GZFILE_READ_CHUNK_SIZE * GZFILE_READ_CHUNK_SIZE;
+	return static_cast<s32>(CLAMP(span, static_cast<s64>(GZFILE_READ_CHUNK_SIZE), static_cast<s64>(256 * _1mb)));
+}
+
 static const char* INDEX_TEMPLATE_KEY = "$(f)";
 
 // template:
@@ -155,9 +260,15 @@ static std::string iso2indexname(const std::string& isoname)
 GzippedFileReader::GzippedFileReader(void)
 	: mBytesRead(0)
 	, m_pIndex(0)
+	, m_uncompressedSize(0)
 	, m_zstates(0)
+	, m_zstatesCount(0)
 	, m_src(0)
-	, m_cache(GZFILE_CACHE_SIZE_MB)
+	, m_indexProgress(0)
+	, m_indexPublished(0)
+	, m_indexBuilding(false)
+	, m_indexBuilt(false)
+	, m_cache(GZFILE_READ_CHUNK_SIZE, GZFILE_CACHE_SIZE_MB)
 {
 	m_blocksize = 2048;
 	AsyncPrefetchReset();
@@ -169,20 +280,37 @@ void GzippedFileReader::InitZstates()
 	{
 		delete[] m_zstates;
 		m_zstates = 0;
+		m_zstatesCount = 0;
 	}
 	if (!m_pIndex)
 		return;
 
 	// having another extra element helps avoiding logic for last (so 2+ instead of 1+)
-	int size = 2 + m_pIndex->uncompressed_size / m_pIndex->span;
-	m_zstates = new Czstate[size]();
+	m_zstatesCount = 2 + m_uncompressedSize / m_pIndex->span;
+	m_zstates = new Czstate[m_zstatesCount]();
 }
 
 #ifndef _WIN32
+// There's no overlapped I/O to abuse here, but we can get the same effect by advising the kernel
+// that we'll need the next chunk of the compressed file soon. It starts reading it into the page
+// cache in the background, and the call returns immediately, so there's nothing to cancel.
 void GzippedFileReader::AsyncPrefetchReset(){};
 void GzippedFileReader::AsyncPrefetchOpen(){};
 void GzippedFileReader::AsyncPrefetchClose(){};
-void GzippedFileReader::AsyncPrefetchChunk(s64 dummy){};
+void GzippedFileReader::AsyncPrefetchChunk(s64 start)
+{
+	if (!m_src)
+		return;
+
+#if defined(__APPLE__)
+	struct radvisory ra;
+	ra.ra_offset = start;
+	ra.ra_count = GZFILE_READ_CHUNK_SIZE;
+	fcntl(fileno(m_src), F_RDADVISE, &ra);
+#elif defined(POSIX_FADV_WILLNEED)
+	posix_fadvise(fileno(m_src), start, GZFILE_READ_CHUNK_SIZE, POSIX_FADV_WILLNEED);
+#endif
+};
 void GzippedFileReader::AsyncPrefetchCancel(){};
 #else
 // AsyncPrefetch works as follows:
@@ -275,44 +403,220 @@ bool GzippedFileReader::OkIndex()
 	if (indexfile.empty())
 		return false; // iso2indexname(...) will print errors if it can't apply the template
 
-	if (FileSystem::FileExists(indexfile.c_str()) && (m_pIndex = ReadIndexFromFile(indexfile.c_str())))
+	if (FileSystem::FileExists(indexfile.c_str()) && (m_pIndex = ReadIndexFromFile(indexfile.c_str(), m_src, &m_indexMapping)))
 	{
 		Console.WriteLn(Color_Green, "OK: Gzip quick access index read from disk: '%s'", indexfile.c_str());
-		if (m_pIndex->span != GZFILE_SPAN_DEFAULT)
+		const s32 span = GetIndexSpan();
+		if (m_pIndex->span != span)
 		{
-			Console.Warning("Note: This index has %1.1f MB intervals, while the current default for new indexes is %1.1f MB.",
-							(float)m_pIndex->span / 1024 / 1024, (float)GZFILE_SPAN_DEFAULT / 1024 / 1024);
-			Console.Warning("It will work fine, but if you want to generate a new index with default intervals, delete this index file.");
+			Console.Warning("Note: This index has %1.1f MB intervals, while the current setting for new indexes is %1.1f MB.",
+							(float)m_pIndex->span / 1024 / 1024, (float)span / 1024 / 1024);
+			Console.Warning("It will work fine, but if you want to generate a new index with these intervals, delete this index file.");
 			Console.Warning("(smaller intervals mean bigger index file and quicker but more frequent decompressions)");
 		}
+		m_uncompressedSize = m_pIndex->uncompressed_size;
 		InitZstates();
 		return true;
 	}
 
 	// No valid index file. Generate an index
+	return StartIndexBuild(indexfile);
+}
+
+// Works out the uncompressed size without decompressing the whole file, so the game can boot while
+// the index is built. The gzip trailer holds the size modulo 4GB, and the primary volume descriptor
+// holds the volume size, which is (at least) as large as the first layer of the disc. If the two agree
+// closely, it's a single layer disc, otherwise we can't tell how many 4GB wraps there were.
+bool GzippedFileReader::EstimateUncompressedSize(s64* size)
+{
+	const s64 compressed = FileSystem::FSize64(m_src);
+	u8 trailer[4];
+	if (compressed < 18 || FileSystem::FSeek64(m_src, compressed - 4, SEEK_SET) != 0 ||
+		std::fread(trailer, sizeof(trailer), 1, m_src) != 1)
+	{
+		return false;
+	}
+	const u32 isize = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (static_cast<u32>(trailer[3]) << 24);
+
+	// Inflate up to the end of the primary volume descriptor at sector 16.
+	static constexpr u32 PVD_OFFSET = 16 * 2048;
+	std::vector<u8> header(PVD_OFFSET + 2048);
+	std::vector<u8> input(CHUNK);
+	z_stream strm = {};
+	if (inflateInit2(&strm, 47) != Z_OK)
+		return false;
+
+	FileSystem::FSeek64(m_src, 0, SEEK_SET);
+	strm.next_out = header.data();
+	strm.avail_out = static_cast<uInt>(header.size());
+	int ret = Z_OK;
+	while (strm.avail_out > 0 && ret == Z_OK)
+	{
+		if (strm.avail_in == 0)
+		{
+			strm.avail_in = static_cast<uInt>(std::fread(input.data(), 1, input.size(), m_src));
+			strm.next_in = input.data();
+			if (strm.avail_in == 0)
+				break;
+		}
+		ret = inflate(&strm, Z_NO_FLUSH);
+	}
+	inflateEnd(&strm);
+	FileSystem::FSeek64(m_src, 0, SEEK_SET);
+
+	const u8* pvd = header.data() + PVD_OFFSET;
+	if (strm.avail_out != 0 || pvd[0] != 1 || std::memcmp(pvd + 1, "CD001", 5) != 0)
+		return false;
+
+	const s64 volume = static_cast<s64>(pvd[80] | (pvd[81] << 8) | (pvd[82] << 16) | (static_cast<u32>(pvd[83]) << 24)) * 2048;
+	s64 estimate = (volume & ~static_cast<s64>(0xFFFFFFFF)) | isize;
+	if (estimate < volume)
+		estimate += static_cast<s64>(1) << 32;
+	if (estimate - volume >= GZIP_ESTIMATE_SLACK)
+		return false;
+
+	*size = estimate;
+	return true;
+}
+
+bool GzippedFileReader::StartIndexBuild(const std::string& indexfile)
+{
+	s64 estimate = 0;
+	const bool background = EstimateUncompressedSize(&estimate);
+
+	// Reads are served from this copy of the index while it's being built.
+	m_pIndex = (Access*)calloc(1, sizeof(Access));
+	m_pIndex->span = GetIndexSpan();
+	m_pIndex->uncompressed_size = estimate;
+	m_uncompressedSize = estimate;
+	m_indexProgress = 0;
+	m_indexPublished = 0;
+	m_indexBuilding = true;
+	m_indexBuilt = false;
+	m_indexCancel.store(false, std::memory_order_relaxed);
+	InitZstates();
+
+	m_indexThread = std::thread(&GzippedFileReader::IndexBuildThread, this, indexfile);
+	if (background)
+	{
+		Console.WriteLn("Building gzip quick access index in the background (%1.1f MB intervals)...",
+			(float)m_pIndex->span / 1024 / 1024);
+		return true;
+	}
+
+	// Couldn't work out the size up front, so we need the whole index before we can boot.
 	Console.Warning("This may take a while (but only once). Scanning compressed file to generate a quick access index...");
+	m_indexThread.join();
+	if (!m_indexBuilt)
+	{
+		free_index(m_pIndex);
+		m_pIndex = 0;
+		m_uncompressedSize = 0;
+		InitZstates();
+		return false;
+	}
+
+	return true;
+}
 
-	const s64 prevoffset = FileSystem::FTell64(m_src);
+void GzippedFileReader::StopIndexBuild()
+{
+	if (!m_indexThread.joinable())
+		return;
+
+	m_indexCancel.store(true, std::memory_order_relaxed);
+	m_indexThread.join();
+}
+
+int GzippedFileReader::IndexBuildProgress(void* opaque, const Access* index, s64 totout)
+{
+	GzippedFileReader* reader = static_cast<GzippedFileReader*>(opaque);
+	if (reader->m_indexCancel.load(std::memory_order_relaxed))
+		return 1;
+
+	// Don't bother waking readers for every block of input.
+	if (!index || (index->have == reader->m_indexPublished &&
+					  totout - reader->m_indexProgress.load(std::memory_order_relaxed) < GZFILE_READ_CHUNK_SIZE))
+	{
+		return 0;
+	}
+
+	std::unique_lock<std::mutex> lock(reader->m_indexMutex);
+	Access* shared = reader->m_pIndex;
+	if (index->have > shared->have)
+	{
+		Point* list = (Point*)realloc(shared->list, sizeof(Point) * index->have);
+		if (!list)
+			return 1;
+		std::memcpy(list + shared->have, index->list + shared->have, sizeof(Point) * (index->have - shared->have));
+		shared->list = list;
+		shared->have = index->have;
+		shared->size = index->have;
+	}
+	reader->m_indexPublished = index->have;
+	reader->m_indexProgress = totout;
+	lock.unlock();
+
+	reader->m_indexCondition.notify_all();
+	return 0;
+}
+
+void GzippedFileReader::IndexBuildThread(std::string indexfile)
+{
+	Threading::SetNameOfCurrentThread("Gzip Indexer");
+
+	Common::Timer timer;
 	Access* index = nullptr;
-	int len = build_index(m_src, GZFILE_SPAN_DEFAULT, &index);
-	printf("\n"); // build_index prints progress without \n's
-	FileSystem::FSeek64(m_src, prevoffset, SEEK_SET);
+	int len = -1;
+	if (std::FILE* fp = FileSystem::OpenCFile(m_filename.c_str(), "rb"))
+	{
+		len = build_index(fp, m_pIndex->span, &index, &GzippedFileReader::IndexBuildProgress, this);
+		std::fclose(fp);
+	}
 
-	if (len >= 0)
+	std::unique_lock<std::mutex> lock(m_indexMutex);
+	if (len > 0)
 	{
+		// Reads past the real end fail from now on, see _ReadSync().
+		if (m_uncompressedSize != 0 && m_uncompressedSize != index->uncompressed_size)
+		{
+			Console.Error("ERROR: Gzip image is %lld bytes, but was estimated as %lld bytes. Please restart the game.",
+				index->uncompressed_size, m_uncompressedSize.load(std::memory_order_relaxed));
+		}
+
+		free_index(m_pIndex);
 		m_pIndex = index;
-		WriteIndexToFile((Access*)m_pIndex, indexfile.c_str());
+		if (m_zstatesCount < 2 + index->uncompressed_size / index->span)
+		{
+			m_uncompressedSize = index->uncompressed_size;
+			InitZstates();
+		}
+		m_uncompressedSize = index->uncompressed_size;
+		m_indexBuilt = true;
 	}
 	else
 	{
-		Console.Error("ERROR (%d): Index could not be generated for file '%s'", len, m_filename.c_str());
+		if (len != BUILD_INDEX_CANCELLED)
+			Console.Error("ERROR (%d): Index could not be generated for file '%s'", len, m_filename.c_str());
 		free_index(index);
-		InitZstates();
-		return false;
 	}
+	m_indexBuilding = false;
+	lock.unlock();
+	m_indexCondition.notify_all();
 
-	InitZstates();
-	return true;
+	if (m_indexBuilt)
+	{
+		Console.WriteLn("Gzip quick access index built in %.2f seconds.", timer.GetTimeSeconds());
+		WriteIndexToFile(m_pIndex, indexfile.c_str(), m_src);
+	}
+}
+
+bool GzippedFileReader::WaitForIndex(s64 offset, std::unique_lock<std::mutex>& lock)
+{
+	while (m_indexBuilding && (m_pIndex->have == 0 || m_indexProgress < offset))
+		m_indexCondition.wait(lock);
+
+	return m_pIndex->have > 0;
 }
 
 bool GzippedFileReader::Open(std::string fileName)
@@ -405,6 +709,21 @@ int GzippedFileReader::_ReadSync(void* pBuffer, s64 offset, uint bytesToRead)
 	// Not available from cache. Decompress from optimal starting
 	// point in GZFILE_READ_CHUNK_SIZE chunks and cache each chunk.
 	PTT s = NOW();
+
+	// The index (and zstates) can be replaced by the builder thread, so hang on to them until we're done.
+	std::unique_lock<std::mutex> lock(m_indexMutex);
+	if (!WaitForIndex(offset + maxInChunk, lock))
+		return -1;
+
+	// The index only knows the real size once it's complete. If the estimate was too large, the game can
+	// ask for sectors past the end, which would otherwise be extracted from whatever follows the stream.
+	if (!m_indexBuilding && offset >= m_pIndex->uncompressed_size)
+	{
+		Console.Error("Error: iso-gzip read at %lld is past the end of the image (%lld bytes).", offset,
+			m_pIndex->uncompressed_size);
+		return -1;
+	}
+
 	s64 extractOffset = GetOptimalExtractionStart(offset); // guaranteed in GZFILE_READ_CHUNK_SIZE boundaries
 	int size = offset + maxInChunk - extractOffset;
 	unsigned char* extracted = (unsigned char*)malloc(size);
@@ -436,21 +755,15 @@ int GzippedFileReader::_ReadSync(void* pBuffer, s64 offset, uint bytesToRead)
 
 		m_zstates[spanix].Kill();
 	}
+	lock.unlock();
 
-	if (size <= GZFILE_READ_CHUNK_SIZE)
-		m_cache.Take(extracted, extractOffset, res, size);
-	else
-	{ // split into cacheable chunks
-		for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE)
-		{
-			int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
-			void* chunk = available ? malloc(available) : 0;
-			if (available)
-				memcpy(chunk, extracted + i, available);
-			m_cache.Take(chunk, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
-		}
-		free(extracted);
+	// split into cacheable chunks
+	for (int i = 0; i < size; i += GZFILE_READ_CHUNK_SIZE)
+	{
+		int available = CLAMP(res - i, 0, GZFILE_READ_CHUNK_SIZE);
+		m_cache.Insert(extracted + i, extractOffset + i, available, std::min(size - i, GZFILE_READ_CHUNK_SIZE));
 	}
+	free(extracted);
 
 	int duration = NOW() - s;
 	if (duration > 10)
@@ -465,12 +778,24 @@ int GzippedFileReader::_ReadSync(void* pBuffer, s64 offset, uint bytesToRead)
 
 void GzippedFileReader::Close()
 {
+	StopIndexBuild();
+
 	m_filename.clear();
 	if (m_pIndex)
 	{
-		free_index((Access*)m_pIndex);
+		if (m_indexMapping.IsOpen())
+		{
+			// The list lives in the mapping.
+			free(m_pIndex);
+			m_indexMapping.Close();
+		}
+		else
+		{
+			free_index((Access*)m_pIndex);
+		}
 		m_pIndex = 0;
 	}
+	m_uncompressedSize = 0;
 
 	InitZstates(); // results in delete because no index
 	m_cache.Clear();
@@ -21,7 +21,14 @@ typedef struct zstate Zstate;
 #include "ChunksCache.h"
 #include "zlib_indexed.h"
 
-#define GZFILE_SPAN_DEFAULT (1048576L * 4)  /* distance between direct access points when creating a new index */
+#include "common/FileSystem.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define GZFILE_SPAN_DEFAULT (1048576L * 4)  /* distance between direct access points when creating a new index, overridable with GzipIsoIndexSpanKB */
 #define GZFILE_READ_CHUNK_SIZE (256 * 1024) /* zlib extraction chunks size (at 0-based boundaries) */
 #define GZFILE_CACHE_SIZE_MB 200            /* cache size for extracted data. must be at least GZFILE_READ_CHUNK_SIZE (in MB)*/
 
@@ -49,7 +56,7 @@ public:
 	{
 		// type and formula copied from FlatFileReader
 		// FIXME? : Shouldn't it be uint and (size - m_dataoffset) / m_blocksize ?
-		return (int)((m_pIndex ? m_pIndex->uncompressed_size : 0) / m_blocksize);
+		return (int)(m_uncompressedSize.load(std::memory_order_relaxed) / m_blocksize);
 	};
 
 	virtual void SetBlockSize(uint bytes) { m_blocksize = bytes; }
@@ -75,11 +82,34 @@ private:
 	int _ReadSync(void* pBuffer, s64 offset, uint bytesToRead);
 	void InitZstates();
 
+	// Background index building
+	bool StartIndexBuild(const std::string& indexfile);
+	void StopIndexBuild();
+	void IndexBuildThread(std::string indexfile);
+	static int IndexBuildProgress(void* opaque, const Access* index, s64 totout);
+	bool EstimateUncompressedSize(s64* size);
+	// Waits until the index being built covers the given offset, returns false if it never will
+	bool WaitForIndex(s64 offset, std::unique_lock<std::mutex>& lock);
+
 	int mBytesRead;   // Temp sync read result when simulating async read
-	Access* m_pIndex; // Quick access index
+	Access* m_pIndex; // Quick access index, only partially filled while it's being built
+	FileSystem::MappedFile m_indexMapping; // Holds m_pIndex->list when it was mapped from a v2 index file
+	// From the index, or estimated from the image while the index is being built. Set with m_indexMutex held,
+	// atomic because the CDVD code reads the block count without it.
+	std::atomic<s64> m_uncompressedSize;
 	Czstate* m_zstates;
+	int m_zstatesCount;
 	FILE* m_src;
 
+	std::thread m_indexThread;
+	std::mutex m_indexMutex; // Guards m_pIndex, m_zstates and the build state while the index is being built
+	std::condition_variable m_indexCondition;
+	std::atomic<s64> m_indexProgress; // Uncompressed offset the index builder has reached, set with m_indexMutex held
+	int m_indexPublished; // Index points copied to m_pIndex so far, only used by the builder thread
+	bool m_indexBuilding;
+	bool m_indexBuilt;
+	std::atomic<bool> m_indexCancel{false};
+
 	ChunksCache m_cache;
 
 #ifdef _WIN32
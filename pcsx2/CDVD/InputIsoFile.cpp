@@ -219,7 +219,11 @@ bool InputIsoFile::Open(std::string srcfile, bool testOnly)
 		// Allow write sharing of the iso based on the ini settings.
 		// Mostly useful for romhacking, where the disc is frequently
 		// changed and the emulator would block modifications
-		m_reader = new FlatFileReader(EmuConfig.CdvdShareWrite);
+#ifdef __linux__
+		m_reader = UringFileReader::Create();
+		if (!m_reader)
+#endif
+			m_reader = new FlatFileReader(EmuConfig.CdvdShareWrite);
 	}
 
 	if (!m_reader->Open(m_filename))
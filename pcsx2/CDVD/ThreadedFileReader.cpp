@@ -16,12 +16,24 @@
 #include "PrecompiledHeader.h"
 #include "ThreadedFileReader.h"
 
+#include "HostSettings.h"
+
+#include "common/AlignedMalloc.h"
 #include "common/Threading.h"
 
 // Make sure buffer size is bigger than the cutoff where PCSX2 emulates a seek
 // If buffers are smaller than that, we can't keep up with linear reads
 static constexpr u32 MINIMUM_SIZE = 128 * 1024;
 
+// Default amount of decompressed data to keep ahead of sequential reads
+static constexpr u32 DEFAULT_READAHEAD_MB = 8;
+// Default budget for recently read chunks
+static constexpr u32 DEFAULT_CHUNK_CACHE_MB = 32;
+// Upper bound on readahead workers, decompression is rarely worth more than this
+static constexpr u32 MAX_READAHEAD_WORKERS = 8;
+// Number of consecutive chunk reads before we consider access to be sequential
+static constexpr u32 SEQUENTIAL_THRESHOLD = 2;
+
 ThreadedFileReader::ThreadedFileReader()
 {
 	m_readThread = std::thread([](ThreadedFileReader* r){ r->Loop(); }, this);
@@ -33,6 +45,7 @@ ThreadedFileReader::~ThreadedFileReader()
 	(void)std::lock_guard<std::mutex>{m_mtx};
 	m_condition.notify_one();
 	m_readThread.join();
+	StopReadahead();
 	for (auto& buffer : m_buffer)
 		if (buffer.ptr)
 			free(buffer.ptr);
@@ -125,7 +138,7 @@ void ThreadedFileReader::Loop()
 					}
 					else
 					{
-						int amt = ReadChunk(static_cast<char*>(buf->ptr) + bufsize, chunk.chunkID);
+						int amt = ReadChunkCached(static_cast<char*>(buf->ptr) + bufsize, chunk);
 						if (amt <= 0)
 							break;
 						buf->size.store(bufsize + amt, std::memory_order_release);
@@ -175,7 +188,7 @@ ThreadedFileReader::Buffer* ThreadedFileReader::GetBlockPtr(const Chunk& block)
 		}
 		buf.size.store(0, std::memory_order_relaxed);
 	}
-	int size = ReadChunk(buf.ptr, block.chunkID);
+	int size = ReadChunkCached(buf.ptr, block);
 	if (size > 0)
 	{
 		buf.offset = block.offset;
@@ -186,6 +199,250 @@ ThreadedFileReader::Buffer* ThreadedFileReader::GetBlockPtr(const Chunk& block)
 	return nullptr;
 }
 
+void ThreadedFileReader::WorkerLoop()
+{
+	Threading::SetNameOfCurrentThread("ISO Readahead");
+
+	std::unique_lock<std::mutex> lock(m_ringMtx);
+	for (;;)
+	{
+		while (m_workQueue.empty() && !m_workersQuit)
+			m_workCondition.wait(lock);
+
+		if (m_workersQuit)
+			return;
+
+		const s64 chunkID = m_workQueue.front();
+		m_workQueue.pop_front();
+
+		// The slot may have been claimed by the reading thread or discarded by a seek since it was queued
+		RingSlot& slot = m_ring[chunkID % m_ring.size()];
+		if (slot.chunkID != chunkID || slot.state != ChunkState::Queued)
+			continue;
+
+		// Nobody else touches a slot in the Reading state, so we can fill it without the lock
+		slot.state = ChunkState::Reading;
+		u8* data = m_ringData + (chunkID % m_ring.size()) * m_ringChunkSize;
+		lock.unlock();
+
+		const int amt = CallReadChunk(data, chunkID);
+
+		lock.lock();
+		slot.size = (amt > 0) ? static_cast<u32>(amt) : 0;
+		slot.state = (amt > 0) ? ChunkState::Ready : ChunkState::Empty;
+		m_readyCondition.notify_all();
+	}
+}
+
+void ThreadedFileReader::StartReadahead()
+{
+	StopReadahead();
+
+	const u32 readaheadMB = Host::GetBaseUIntSettingValue("EmuCore", "CdvdReadaheadSizeMB", DEFAULT_READAHEAD_MB);
+	const Chunk first = ChunkForOffset(0);
+	if (readaheadMB == 0 || first.chunkID < 0 || first.length == 0)
+		return;
+
+	m_concurrentReads = CanReadChunksConcurrently();
+
+	u32 workers = Host::GetBaseUIntSettingValue("EmuCore", "CdvdReadaheadThreads", 0);
+	if (workers == 0)
+		workers = m_concurrentReads ? std::clamp(std::thread::hardware_concurrency() / 4u, 1u, 4u) : 1u;
+	workers = std::min(workers, m_concurrentReads ? MAX_READAHEAD_WORKERS : 1u);
+
+	// Chunks are direct-mapped, so keep one slot more than the readahead window for the chunk being read
+	const u32 slots = std::max<u32>(static_cast<u32>((static_cast<u64>(readaheadMB) * _1mb) / first.length), workers * 2) + 1;
+	m_ringData = static_cast<u8*>(_aligned_malloc(static_cast<size_t>(slots) * first.length, 64));
+	if (!m_ringData)
+	{
+		Console.Error("Failed to allocate %u MB ISO readahead buffer.", readaheadMB);
+		return;
+	}
+
+	m_ringChunkSize = first.length;
+	m_readaheadDepth = slots - 1;
+	m_ring.resize(slots);
+	m_lastChunkID = -1;
+	m_queuedUpTo = -1;
+	m_sequentialRun = 0;
+	m_workersQuit = false;
+
+	m_statHits.store(0, std::memory_order_relaxed);
+	m_statMisses.store(0, std::memory_order_relaxed);
+	m_statStalls.store(0, std::memory_order_relaxed);
+	m_statPrefetched.store(0, std::memory_order_relaxed);
+	m_statDiscarded.store(0, std::memory_order_relaxed);
+
+	for (u32 i = 0; i < workers; i++)
+		m_workers.emplace_back([](ThreadedFileReader* r) { r->WorkerLoop(); }, this);
+
+	DevCon.WriteLn("ISO readahead: %u workers, %u chunks of %u bytes", workers, slots, first.length);
+}
+
+void ThreadedFileReader::StopReadahead()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_ringMtx);
+		m_workersQuit = true;
+		m_workQueue.clear();
+	}
+	m_workCondition.notify_all();
+	for (std::thread& worker : m_workers)
+		worker.join();
+	m_workers.clear();
+
+	if (!m_ring.empty())
+	{
+		const ReadaheadStats stats = GetReadaheadStats();
+		DevCon.WriteLn("ISO readahead: %llu hits, %llu cache hits, %llu misses, %llu stalls, %llu prefetched, %llu discarded",
+			stats.hits, stats.cacheHits, stats.misses, stats.stalls, stats.prefetched, stats.discarded);
+	}
+
+	m_ring.clear();
+	if (m_ringData)
+	{
+		_aligned_free(m_ringData);
+		m_ringData = nullptr;
+	}
+	m_ringChunkSize = 0;
+	m_readaheadDepth = 0;
+}
+
+void ThreadedFileReader::DiscardQueuedReadahead()
+{
+	for (s64 chunkID : m_workQueue)
+	{
+		RingSlot& slot = m_ring[chunkID % m_ring.size()];
+		if (slot.chunkID == chunkID && slot.state == ChunkState::Queued)
+		{
+			slot.state = ChunkState::Empty;
+			m_statDiscarded.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	m_workQueue.clear();
+	m_queuedUpTo = -1;
+}
+
+void ThreadedFileReader::UpdateReadahead(s64 chunkID)
+{
+	if (chunkID == m_lastChunkID)
+		return;
+
+	if (chunkID == m_lastChunkID + 1)
+	{
+		m_sequentialRun++;
+	}
+	else
+	{
+		m_sequentialRun = 0;
+		DiscardQueuedReadahead();
+	}
+	m_lastChunkID = chunkID;
+
+	if (m_sequentialRun < SEQUENTIAL_THRESHOLD)
+		return;
+
+	const s64 end = chunkID + m_readaheadDepth;
+	bool queued = false;
+	for (s64 id = std::max(chunkID + 1, m_queuedUpTo + 1); id <= end; id++)
+	{
+		RingSlot& slot = m_ring[id % m_ring.size()];
+		if (slot.chunkID == id && slot.state != ChunkState::Empty)
+		{
+			m_queuedUpTo = id;
+			continue;
+		}
+
+		// A worker is still filling this slot with an old chunk, pick up from here next time
+		if (slot.state == ChunkState::Reading)
+			break;
+
+		const Chunk chunk = ChunkForOffset(static_cast<u64>(id) * m_ringChunkSize);
+		if (chunk.chunkID != id || chunk.length > m_ringChunkSize)
+			break;
+
+		slot.chunkID = id;
+		slot.size = 0;
+		slot.state = ChunkState::Queued;
+		m_workQueue.push_back(id);
+		m_queuedUpTo = id;
+		m_statPrefetched.fetch_add(1, std::memory_order_relaxed);
+		queued = true;
+	}
+
+	if (queued)
+		m_workCondition.notify_all();
+}
+
+int ThreadedFileReader::CallReadChunk(void* dst, s64 chunkID)
+{
+	if (m_concurrentReads)
+		return ReadChunk(dst, chunkID);
+
+	std::lock_guard<std::mutex> lock(m_chunkReadMtx);
+	return ReadChunk(dst, chunkID);
+}
+
+int ThreadedFileReader::ReadChunkCached(void* dst, const Chunk& chunk)
+{
+	if (chunk.chunkID < 0)
+		return ReadChunk(dst, chunk.chunkID);
+
+	if (!m_ring.empty())
+	{
+		std::unique_lock<std::mutex> lock(m_ringMtx);
+		UpdateReadahead(chunk.chunkID);
+
+		RingSlot& slot = m_ring[chunk.chunkID % m_ring.size()];
+		if (slot.chunkID == chunk.chunkID)
+		{
+			if (slot.state == ChunkState::Reading)
+			{
+				m_statStalls.fetch_add(1, std::memory_order_relaxed);
+				m_readyCondition.wait(lock, [&slot]() { return slot.state != ChunkState::Reading; });
+			}
+
+			if (slot.state == ChunkState::Ready)
+			{
+				// Only the reading thread (us) replaces Ready slots, so the data is safe to copy without the lock
+				const u32 size = slot.size;
+				const u8* data = m_ringData + (chunk.chunkID % m_ring.size()) * m_ringChunkSize;
+				lock.unlock();
+				m_statHits.fetch_add(1, std::memory_order_relaxed);
+				std::memcpy(dst, data, size);
+				m_chunkCache.Insert(dst, chunk.offset, size, chunk.length);
+				return static_cast<int>(size);
+			}
+
+			// Queued but not started, we'll do it ourselves rather than waiting for a worker
+			if (slot.state == ChunkState::Queued)
+				slot.state = ChunkState::Empty;
+		}
+	}
+
+	int amt = m_chunkCache.Read(dst, chunk.offset, chunk.length);
+	if (amt >= 0)
+		return amt;
+
+	m_statMisses.fetch_add(1, std::memory_order_relaxed);
+	amt = CallReadChunk(dst, chunk.chunkID);
+	if (amt > 0)
+		m_chunkCache.Insert(dst, chunk.offset, amt, chunk.length);
+	return amt;
+}
+
+ThreadedFileReader::ReadaheadStats ThreadedFileReader::GetReadaheadStats() const
+{
+	ReadaheadStats stats;
+	stats.hits = m_statHits.load(std::memory_order_relaxed);
+	stats.cacheHits = m_chunkCache.GetHits();
+	stats.misses = m_statMisses.load(std::memory_order_relaxed);
+	stats.stalls = m_statStalls.load(std::memory_order_relaxed);
+	stats.prefetched = m_statPrefetched.load(std::memory_order_relaxed);
+	stats.discarded = m_statDiscarded.load(std::memory_order_relaxed);
+	return stats;
+}
+
 bool ThreadedFileReader::Decompress(void* target, u64 begin, u32 size)
 {
 	char* write = static_cast<char*>(target);
@@ -213,7 +470,7 @@ bool ThreadedFileReader::Decompress(void* target, u64 begin, u32 size)
 		}
 		else
 		{
-			int amt = ReadChunk(write, chunk.chunkID);
+			int amt = ReadChunkCached(write, chunk);
 			if (amt < static_cast<int>(chunk.length))
 				return false;
 			write += chunk.length;
@@ -259,7 +516,16 @@ bool ThreadedFileReader::TryCachedRead(void*& buffer, u64& offset, u32& size, co
 bool ThreadedFileReader::Open(std::string fileName)
 {
 	CancelAndWaitUntilStopped();
-	return Open2(std::move(fileName));
+	StopReadahead();
+	if (!Open2(std::move(fileName)))
+		return false;
+
+	const Chunk first = ChunkForOffset(0);
+	m_chunkCache.Configure((first.chunkID >= 0) ? first.length : 0,
+		Host::GetBaseUIntSettingValue("EmuCore", "CdvdChunkCacheSizeMB", DEFAULT_CHUNK_CACHE_MB));
+
+	StartReadahead();
+	return true;
 }
 
 int ThreadedFileReader::ReadSync(void* pBuffer, uint sector, uint count)
@@ -366,6 +632,8 @@ void ThreadedFileReader::CancelRead(void)
 void ThreadedFileReader::Close(void)
 {
 	CancelAndWaitUntilStopped();
+	StopReadahead();
+	m_chunkCache.Clear();
 	for (auto& buf : m_buffer)
 		buf.size.store(0, std::memory_order_relaxed);
 	Close2();
@@ -16,11 +16,14 @@
 #pragma once
 
 #include "AsyncFileReader.h"
+#include "ChunksCache.h"
 
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <vector>
 
 /// A file reader for use with compressed formats
 /// Calls decompression code on a separate thread to make a synchronous decompression API async
@@ -45,6 +48,9 @@ protected:
 	virtual Chunk ChunkForOffset(u64 offset) = 0;
 	/// Synchronously read the given block into `dst`
 	virtual int ReadChunk(void* dst, s64 chunkID) = 0;
+	/// Return true if `ReadChunk` may be called from several threads at once
+	/// If false, the readahead workers are limited to one and calls are serialized
+	virtual bool CanReadChunksConcurrently() const { return false; }
 	/// AsyncFileReader open but ThreadedFileReader needs prep work first
 	virtual bool Open2(std::string fileName) = 0;
 	/// AsyncFileReader close but ThreadedFileReader needs prep work first
@@ -77,6 +83,56 @@ private:
 	Buffer m_buffer[2];
 	u32 m_nextBuffer = 0;
 
+	enum class ChunkState : u8
+	{
+		Empty,
+		Queued,
+		Reading,
+		Ready,
+	};
+	struct RingSlot
+	{
+		s64 chunkID = -1;
+		u32 size = 0;
+		ChunkState state = ChunkState::Empty;
+	};
+	/// Decompressed chunk ring, filled ahead of sequential reads by the readahead workers
+	/// Slots are direct-mapped by chunk ID, so a chunk can only live in `m_ring[chunkID % m_ring.size()]`
+	/// Guarded by `m_ringMtx`, except for the data of Ready slots, which is only replaced by the reading thread
+	std::vector<RingSlot> m_ring;
+	u8* m_ringData = nullptr;
+	u32 m_ringChunkSize = 0;
+	/// Number of chunks to keep decompressed ahead of the current one
+	u32 m_readaheadDepth = 0;
+	/// Chunk IDs waiting for a worker, in order of distance from the read position
+	std::deque<s64> m_workQueue;
+	/// Last chunk requested by the reading thread, used for sequential access detection
+	s64 m_lastChunkID = -1;
+	/// Highest chunk ID which has been queued for readahead
+	s64 m_queuedUpTo = -1;
+	/// Number of consecutive chunk requests which followed on from the previous one
+	u32 m_sequentialRun = 0;
+	std::vector<std::thread> m_workers;
+	std::mutex m_ringMtx;
+	/// Signalled when work is added to `m_workQueue`
+	std::condition_variable m_workCondition;
+	/// Signalled when a worker finishes with a slot
+	std::condition_variable m_readyCondition;
+	bool m_workersQuit = false;
+	/// Held around `ReadChunk` calls when the reader doesn't support concurrent reads
+	std::mutex m_chunkReadMtx;
+	bool m_concurrentReads = false;
+
+	/// Recently read chunks, for when games go back over data they've already read
+	/// Only touched by whichever thread is currently reading (see `m_running`)
+	ChunksCache m_chunkCache;
+
+	std::atomic<u64> m_statHits{0};
+	std::atomic<u64> m_statMisses{0};
+	std::atomic<u64> m_statStalls{0};
+	std::atomic<u64> m_statPrefetched{0};
+	std::atomic<u64> m_statDiscarded{0};
+
 	std::thread m_readThread;
 	std::mutex m_mtx;
 	std::condition_variable m_condition;
@@ -95,6 +151,23 @@ private:
 
 	/// Main loop of read thread
 	void Loop();
+	/// Main loop of readahead worker threads
+	void WorkerLoop();
+
+	/// Allocate the chunk ring and start the readahead workers, based on the current settings
+	void StartReadahead();
+	/// Stop the readahead workers and release the chunk ring
+	void StopReadahead();
+	/// Queue chunks after `chunkID` for decompression if reads look sequential
+	/// Call with `m_ringMtx` held
+	void UpdateReadahead(s64 chunkID);
+	/// Drop all queued (but not yet started) readahead work
+	/// Call with `m_ringMtx` held
+	void DiscardQueuedReadahead();
+	/// Call `ReadChunk`, serializing if the reader can't handle concurrent calls
+	int CallReadChunk(void* dst, s64 chunkID);
+	/// Read the given chunk into `dst`, from the readahead ring if it's already been decompressed
+	int ReadChunkCached(void* dst, const Chunk& chunk);
 
 	/// Load the given block into one of the `m_buffer` buffers if necessary and return a pointer to its contents if successful
 	Buffer* GetBlockPtr(const Chunk& block);
@@ -108,6 +181,25 @@ private:
 	bool TryCachedRead(void*& buffer, u64& offset, u32& size, const std::lock_guard<std::mutex>&);
 
 public:
+	struct ReadaheadStats
+	{
+		/// Chunks which were already decompressed when requested
+		u64 hits;
+		/// Chunks which were found in the recently used chunk cache
+		u64 cacheHits;
+		/// Chunks which had to be decompressed on request
+		u64 misses;
+		/// Requests which had to wait for a worker to finish decompressing the chunk
+		u64 stalls;
+		/// Chunks queued for readahead
+		u64 prefetched;
+		/// Queued chunks which were dropped because of a seek
+		u64 discarded;
+	};
+
+	/// Get the readahead counters since the file was opened
+	ReadaheadStats GetReadaheadStats() const;
+
 	bool Open(std::string fileName) final override;
 	int ReadSync(void* pBuffer, uint sector, uint count) final override;
 	void BeginRead(void* pBuffer, uint sector, uint count) final override;
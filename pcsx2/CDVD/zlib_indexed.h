@@ -49,6 +49,7 @@ Comments) 1950 to 1952 in the files http://tools.ietf.org/html/rfc1950
       (Thanks to Mark Adler for suggesting the approach)
   - build_index(...) - added progress prints
   - CHUNK changed from 16k to 512k
+  - build_index(...) - added optional progress callback, which can also cancel the build
  */
 
 /* Illustrate the use of Z_BLOCK, inflatePrime(), and inflateSetDictionary()
@@ -213,6 +214,13 @@ static inline struct access* addpoint(struct access* index, int bits,
 	return index;
 }
 
+/* Called by build_index() after each block of input, with the index built so far
+   (which may be NULL before the first access point) and the uncompressed offset
+   reached.  Return nonzero to stop building, build_index() then returns
+   BUILD_INDEX_CANCELLED. */
+typedef int (*build_index_progress)(void* opaque, const struct access* index, s64 totout);
+#define BUILD_INDEX_CANCELLED (-100)
+
 /* Make one entire pass through the compressed stream and build an index, with
    access points about every span bytes of uncompressed output -- span is
    chosen to balance the speed of random access against the memory requirements
@@ -221,7 +229,8 @@ static inline struct access* addpoint(struct access* index, int bits,
    returns the number of access points on success (>= 1), Z_MEM_ERROR for out
    of memory, Z_DATA_ERROR for an error in the input file, or Z_ERRNO for a
    file read error.  On success, *built points to the resulting index. */
-static inline int build_index(FILE* in, s64 span, struct access** built)
+static inline int build_index(FILE* in, s64 span, struct access** built,
+	build_index_progress progress = NULL, void* opaque = NULL)
 {
 	int ret;
 	s64 totin, totout, totPrinted; /* our own total counters to avoid 4GB limit */
@@ -309,7 +318,15 @@ static inline int build_index(FILE* in, s64 span, struct access** built)
 				last = totout;
 			}
 		} while (strm.avail_in != 0);
-		if (totin / (50 * 1024 * 1024) != totPrinted / (50 * 1024 * 1024))
+		if (progress)
+		{
+			if (progress(opaque, index, totout))
+			{
+				ret = BUILD_INDEX_CANCELLED;
+				goto build_index_error;
+			}
+		}
+		else if (totin / (50 * 1024 * 1024) != totPrinted / (50 * 1024 * 1024))
 		{
 			printf("%dMB ", (int)(totin / (1024 * 1024)));
 			totPrinted = totin;
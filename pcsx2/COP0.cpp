@@ -17,6 +17,7 @@
 #include "PrecompiledHeader.h"
 #include "Common.h"
 #include "COP0.h"
+#include "Cache.h"
 
 // Updates the CPU's mode of operation (either, Kernel, Supervisor, or User modes).
 // Currently the different modes are not implemented.
@@ -244,6 +245,8 @@ void MapTLB(const tlbs& t, int i)
 		i, t.VPN2, t.PFN0, t.PFN1, t.S >> 31, t.G, t.ASID,
 		t.Mask, t.EntryLo0 >> 6, (t.EntryLo0 & 0x38) >> 3, t.EntryLo1 >> 6, (t.EntryLo1 & 0x38) >> 3, t.VPN2);
 
+	cacheOnMapTLB(t);
+
 	if (t.S)
 	{
 		vtlb_VMapBuffer(t.VPN2, eeMem->Scratch, Ps2MemSize::Scratch);
@@ -283,6 +286,8 @@ void UnmapTLB(const tlbs& t, int i)
 	u32 mask, addr;
 	u32 saddr, eaddr;
 
+	cacheOnUnmapTLB(t);
+
 	if (t.S)
 	{
 		vtlb_VMapUnmap(t.VPN2,0x4000);
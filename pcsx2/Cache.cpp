@@ -138,15 +138,12 @@ namespace
 		}
 	};
 
-	struct CacheSet
-	{
-		CacheTag tags[2];
-		CacheData data[2];
-	};
-
 	struct Cache
 	{
-		CacheSet sets[64];
+		// Tags are kept apart from the line data, so the recompiler's inline tag check only
+		// touches this array. The data for tags[set][way] is data[set][way].
+		CacheTag tags[64][2];
+		CacheData data[64][2];
 
 		int setIdxFor(u32 vaddr) const
 		{
@@ -155,24 +152,80 @@ namespace
 
 		CacheLine lineAt(int idx, int way)
 		{
-			return { sets[idx].tags[way], sets[idx].data[way], idx };
+			return { tags[idx][way], data[idx][way], idx };
 		}
 	};
 
+	static_assert(sizeof(CacheTag) == sizeof(uptr), "Recompiler expects tags to be a bare address");
+	static_assert(CacheTag::DIRTY_FLAG == CACHE_TAG_DIRTY && CacheTag::VALID_FLAG == CACHE_TAG_VALID &&
+	              CacheTag::ALL_FLAGS == CACHE_TAG_FLAGS, "Tag flags don't match Cache.h");
+
 	static Cache cache;
 
+	// Set when an unmapped TLB entry covered cached pages, so the next map rebuilds the bitmap.
+	static bool s_cachedPagesStale = false;
 }
 
+alignas(64) u32 eeCachedPages[EE_CACHED_PAGES_WORDS];
+
 void resetCache()
 {
 	memzero(cache);
 }
 
-static bool findInCache(const CacheSet& set, uptr ppf, int* way)
+uptr* getCacheTags()
+{
+	return &cache.tags[0][0].rawValue;
+}
+
+u8* getCacheData()
+{
+	return cache.data[0][0].bytes;
+}
+
+static bool isCachedTLB(const tlbs& t)
+{
+	return ((t.EntryLo0 & 0x38) >> 3) == 0x3 || ((t.EntryLo1 & 0x38) >> 3) == 0x3;
+}
+
+void rebuildCachedPages()
+{
+	memzero(eeCachedPages);
+	s_cachedPagesStale = false;
+
+	auto mark = [](u32 pfn, u32 pages) {
+		for (u32 page = pfn >> 12; pages > 0 && page < (1u << 20); page++, pages--)
+			eeCachedPages[page / 32] |= 1u << (page % 32);
+	};
+
+	// As CheckCache always has, this matches addresses against the PFN rather than the VPN,
+	// and skips entry 0. Each half of an entry covers Mask + 1 4KB pages.
+	for (int i = 1; i < 48; i++)
+	{
+		if (((tlb[i].EntryLo0 & 0x38) >> 3) == 0x3)
+			mark(tlb[i].PFN0, tlb[i].Mask + 1);
+		if (((tlb[i].EntryLo1 & 0x38) >> 3) == 0x3)
+			mark(tlb[i].PFN1, tlb[i].Mask + 1);
+	}
+}
+
+void cacheOnMapTLB(const tlbs& t)
+{
+	if (s_cachedPagesStale || isCachedTLB(t))
+		rebuildCachedPages();
+}
+
+void cacheOnUnmapTLB(const tlbs& t)
+{
+	if (isCachedTLB(t))
+		s_cachedPagesStale = true;
+}
+
+static bool findInCache(const CacheTag (&tags)[2], uptr ppf, int* way)
 {
 	auto check = [&](int checkWay) -> bool
 	{
-		if (!set.tags[checkWay].matches(ppf))
+		if (!tags[checkWay].matches(ppf))
 			return false;
 
 		*way = checkWay;
@@ -185,7 +238,7 @@ static bool findInCache(const CacheSet& set, uptr ppf, int* way)
 static int getFreeCache(u32 mem, int* way)
 {
 	const int setIdx = cache.setIdxFor(mem);
-	CacheSet& set = cache.sets[setIdx];
+	CacheTag (&tags)[2] = cache.tags[setIdx];
 	VTLBVirtual vmv = vtlbdata.vmap[mem >> VTLB_PAGE_BITS];
 	pxAssertMsg(!vmv.isHandler(mem), "Cache currently only supports non-handler addresses!");
 	uptr ppf = vmv.assumePtr(mem);
@@ -193,14 +246,14 @@ static int getFreeCache(u32 mem, int* way)
 	if((cpuRegs.CP0.n.Config & 0x10000) == 0)
 		CACHE_LOG("Cache off!");
 
-	if (findInCache(set, ppf, way))
+	if (findInCache(tags, ppf, way))
 	{
-		if (set.tags[*way].isLocked())
+		if (tags[*way].isLocked())
 			CACHE_LOG("Index %x Way %x Locked!!", setIdx, *way);
 	}
 	else
 	{
-		int newWay = set.tags[0].lrf() ^ set.tags[1].lrf();
+		int newWay = tags[0].lrf() ^ tags[1].lrf();
 		*way = newWay;
 		CacheLine line = cache.lineAt(setIdx, newWay);
 
@@ -305,22 +358,38 @@ RETURNS_R128 readCache128(u32 mem)
 	return value;
 }
 
+void* readCacheLine(u32 mem)
+{
+	int way, idx;
+	void* addr = prepareCacheAccess<false, 1>(mem, &way, &idx);
+	CACHE_LOG("readCacheLine %8.8x from %d, way %d", mem, idx, way);
+	return addr;
+}
+
+void* writeCacheLine(u32 mem)
+{
+	int way, idx;
+	void* addr = prepareCacheAccess<true, 1>(mem, &way, &idx);
+	CACHE_LOG("writeCacheLine %8.8x to %d, way %d", mem, idx, way);
+	return addr;
+}
+
 template <typename Op>
 void doCacheHitOp(u32 addr, const char* name, Op op)
 {
 	const int index = cache.setIdxFor(addr);
-	CacheSet& set = cache.sets[index];
+	const CacheTag (&tags)[2] = cache.tags[index];
 	VTLBVirtual vmv = vtlbdata.vmap[addr >> VTLB_PAGE_BITS];
 	uptr ppf = vmv.assumePtr(addr);
 	int way;
 
-	if (!findInCache(set, ppf, &way))
+	if (!findInCache(tags, ppf, &way))
 	{
-		CACHE_LOG("CACHE %s NO HIT addr %x, index %d, tag0 %zx tag1 %zx", name, addr, index, set.tags[0].rawValue, set.tags[1].rawValue);
+		CACHE_LOG("CACHE %s NO HIT addr %x, index %d, tag0 %zx tag1 %zx", name, addr, index, tags[0].rawValue, tags[1].rawValue);
 		return;
 	}
 
-	CACHE_LOG("CACHE %s addr %x, index %d, way %d, flags %x OP %x", name, addr, index, way, set.tags[way].flags(), cpuRegs.code);
+	CACHE_LOG("CACHE %s addr %x, index %d, way %d, flags %x OP %x", name, addr, index, way, tags[way].flags(), cpuRegs.code);
 
 	op(cache.lineAt(index, way));
 }
@@ -29,3 +29,29 @@ u16 readCache16(u32 mem);
 u32 readCache32(u32 mem);
 u64 readCache64(u32 mem);
 RETURNS_R128 readCache128(u32 mem);
+
+// Recompiler fast path. Tags are laid out as tags[64 sets][2 ways], apart from the line data
+// data[64][2][64 bytes]. A tag holds the host address of its line's page, or'd with the flags.
+static constexpr uptr CACHE_TAG_DIRTY = 0x40;
+static constexpr uptr CACHE_TAG_VALID = 0x20;
+static constexpr uptr CACHE_TAG_FLAGS = 0xFFF;
+uptr* getCacheTags();
+u8* getCacheData();
+
+// Called on a tag miss. Fills the line for mem, writing back the one it replaces, and returns a
+// pointer to the byte at mem in the line. The write variant also marks the line dirty.
+void* readCacheLine(u32 mem);
+void* writeCacheLine(u32 mem);
+
+// One bit per 4KB page of the EE address space, set for the pages a TLB entry maps as cached.
+static constexpr u32 EE_CACHED_PAGES_WORDS = (1u << 20) / 32;
+alignas(64) extern u32 eeCachedPages[EE_CACHED_PAGES_WORDS];
+void rebuildCachedPages();
+void cacheOnMapTLB(const tlbs& t);
+void cacheOnUnmapTLB(const tlbs& t);
+
+static __fi bool isCachedPage(u32 addr)
+{
+	const u32 page = addr >> 12;
+	return (eeCachedPages[page / 32] >> (page % 32)) & 1;
+}
@@ -490,10 +490,11 @@ struct Pcsx2Config
 		BITFIELD32()
 		bool
 			Enabled : 1, // universal toggle for the profiler.
-			RecBlocks_EE : 1, // Enables per-block profiling for the EE recompiler [unimplemented]
-			RecBlocks_IOP : 1, // Enables per-block profiling for the IOP recompiler [unimplemented]
-			RecBlocks_VU0 : 1, // Enables per-block profiling for the VU0 recompiler [unimplemented]
-			RecBlocks_VU1 : 1; // Enables per-block profiling for the VU1 recompiler [unimplemented]
+			RecBlocks_EE : 1, // Enables per-block profiling for the EE recompiler
+			RecBlocks_IOP : 1, // Enables per-block profiling for the IOP recompiler
+			RecBlocks_VU0 : 1, // Enables per-block profiling for the VU0 recompiler
+			RecBlocks_VU1 : 1, // Enables per-block profiling for the VU1 recompiler
+			JitDump : 1; // Writes recompiled code to a perf jitdump file (Linux only)
 		BITFIELD_END
 
 		// Default is Disabled, with all recs enabled underneath.
@@ -547,6 +548,8 @@ struct Pcsx2Config
 			EnableFastmem : 1;
 		bool
 			PauseOnTLBMiss : 1;
+		bool
+			EnableTranslationCache : 1;
 		BITFIELD_END
 
 		RecompilerOptions();
@@ -1247,6 +1250,7 @@ struct Pcsx2Config
 		UseBOOT2Injection : 1,
 		BackupSavestate : 1,
 		SavestateZstdCompression : 1,
+		EnableRewind : 1, // keeps recent states in memory so the game can be rewound
 		// enables simulated ejection of memory cards when loading savestates
 		McdEnableEjection : 1,
 		McdFolderAutoManage : 1,
@@ -1291,6 +1295,9 @@ struct Pcsx2Config
 	McdOptions Mcd[8];
 	std::string GzipIsoIndexTemplate; // for quick-access index with gzipped ISO
 
+	u32 RewindFrequency = 10; // frames between rewind snapshots
+	u32 RewindBufferSizeMB = 512; // memory budget for rewind snapshots
+
 	// Set at runtime, not loaded from config.
 	std::string CurrentBlockdump;
 	std::string CurrentIRX;
@@ -20,11 +20,14 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <unordered_map>
+#include <vector>
 
 #include "common/RedtapeWindows.h"
 #include "common/Path.h"
 
 #include "DEV9/SimpleQueue.h"
+#include "DEV9/SlabPool.h"
 
 class ATA
 {
@@ -41,9 +44,14 @@ private:
 
 	bool hddSparse = false;
 	u64 hddSparseBlockSize;
-	u64 HddSparseStart;
+	//Scratch buffer for reading a block when building its mask
 	std::unique_ptr<u8[]> hddSparseBlock;
-	bool hddSparseBlockValid = false;
+	//One bit per sector of each sparse block, set if the sector is known to be zero
+	//Blocks not in the index haven't been looked at yet
+	static constexpr size_t MAX_SPARSE_MASKS = 256 * 1024;
+	std::unordered_map<u64, size_t> hddSparseMaskIndex;
+	std::vector<u64> hddSparseMasks;
+	u32 hddSparseMaskWords = 0;
 
 #ifdef _WIN32
 	HANDLE hddNativeHandle = INVALID_HANDLE_VALUE;
@@ -112,7 +120,7 @@ private:
 	//Transfer
 	//Write Buffer(s)
 	bool awaitFlush = false;
-	u8* currentWrite; //array
+	u8* currentWrite; //array, from SlabPool (freed by the IO thread once written)
 	u32 currentWriteLength;
 	u64 currentWriteSectors;
 
@@ -135,6 +143,11 @@ private:
 	std::atomic_bool ioClose{false};
 	bool ioWrite;
 	bool ioRead;
+	bool ioFlush;
+	//Set when writes haven't been flushed since
+	std::atomic_bool hddDirty{false};
+	//Queued writes to consecutive sectors, gathered to be written together
+	std::vector<u8> ioWriteRun;
 	void (ATA::*waitingCmd)() = nullptr;
 	//Write Buffer(s)
 
@@ -219,9 +232,15 @@ private:
 	void IO_Thread();
 	void IO_Read();
 	bool IO_Write();
-	bool IO_SparseZero(u64 byteOffset, u64 byteSize);
-	void IO_SparseCacheUpdateLocation(u64 Offset);
-	void IO_SparseCacheLoad();
+	void IO_Flush();
+	u32 IO_WriteQueued();
+	void IO_WriteRun(u64 imagePos, const u8* data, size_t length);
+	void IO_WriteData(u64 imagePos, const u8* data, size_t length);
+	bool IO_SparseWrite(u64 byteOffset, const u8* data, size_t byteSize);
+	u64* IO_SparseGetMask(u64 blockStart, bool wholeBlock);
+	void IO_SparseMaskLoad(u64 blockStart, u64* mask);
+	bool IO_SparseMaskIsZero(const u64* mask);
+	bool IO_SparsePunch(u64 blockStart);
 	bool IsAllZero(const void* data, size_t len);
 	void HDD_ReadAsync(void (ATA::*drqCMD)());
 	void HDD_ReadSync(void (ATA::*drqCMD)());
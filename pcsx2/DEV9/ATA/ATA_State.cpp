@@ -77,6 +77,7 @@ int ATA::Open(const std::string& hddPath)
 		std::lock_guard ioSignallock(ioMutex);
 		ioRead = false;
 		ioWrite = false;
+		ioFlush = false;
 	}
 
 	ioThread = std::thread(&ATA::IO_Thread, this);
@@ -214,8 +215,17 @@ void ATA::InitSparseSupport(const std::string& hddPath)
 	else
 		Console.Error("DEV9: ATA: Failed to open file for sparse");
 #endif
+	if (hddSparse && (hddSparseBlockSize == 0 || (hddSparseBlockSize % 512) != 0))
+	{
+		Console.Error("DEV9: ATA: Sparse block size %s isn't a multiple of the sector size", std::to_string(hddSparseBlockSize).c_str());
+		hddSparse = false;
+		return;
+	}
+
 	hddSparseBlock = std::make_unique<u8[]>(hddSparseBlockSize);
-	hddSparseBlockValid = false;
+	hddSparseMaskWords = static_cast<u32>((hddSparseBlockSize / 512 + 63) / 64);
+	hddSparseMaskIndex.clear();
+	hddSparseMasks.clear();
 }
 
 void ATA::Close()
@@ -251,7 +261,8 @@ void ATA::Close()
 
 		hddSparse = false;
 		hddSparseBlock = nullptr;
-		hddSparseBlockValid = false;
+		hddSparseMaskIndex.clear();
+		hddSparseMasks.clear();
 	}
 	if (hddImage)
 	{
@@ -458,7 +469,7 @@ void ATA::Async(uint cycles)
 	{
 		{
 			std::lock_guard ioSignallock(ioMutex);
-			if (ioRead || ioWrite)
+			if (ioRead || ioWrite || ioFlush)
 				//IO Running
 				return;
 		}
@@ -480,6 +491,14 @@ void ATA::Async(uint cycles)
 			}
 			ioReady.notify_all();
 		}
+		else if (awaitFlush && hddDirty.load()) //Flush writes to the image
+		{
+			{
+				std::lock_guard ioSignallock(ioMutex);
+				ioFlush = true;
+			}
+			ioReady.notify_all();
+		}
 		else if (awaitFlush) //Fire IRQ on flush completion?
 		{
 			//Log_Info("Flush done, raise IRQ");
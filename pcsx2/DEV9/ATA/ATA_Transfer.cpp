@@ -39,7 +39,7 @@ void ATA::IO_Thread()
 		ioThreadIdle_bool = true;
 		ioThreadIdle_cv.notify_all();
 
-		ioReady.wait(ioWaitHandle, [&] { return ioRead | ioWrite; });
+		ioReady.wait(ioWaitHandle, [&] { return ioRead | ioWrite | ioFlush; });
 		ioThreadIdle_bool = false;
 
 		int ioType = -1;
@@ -47,6 +47,8 @@ void ATA::IO_Thread()
 			ioType = 0;
 		else if (ioWrite)
 			ioType = 1;
+		else if (ioFlush)
+			ioType = 2;
 
 		ioWaitHandle.unlock();
 
@@ -67,6 +69,8 @@ void ATA::IO_Thread()
 				}
 			}
 		}
+		else if (ioType == 2)
+			IO_Flush();
 	}
 }
 
@@ -81,6 +85,9 @@ void ATA::IO_Read()
 		abort();
 	}
 
+	// Writes still in the cache may overlap the read.
+	IO_WriteQueued();
+
 	const u64 pos = lba * 512;
 	if (FileSystem::FSeek64(hddImage, pos, SEEK_SET) != 0 ||
 		std::fread(readBuffer,  512, nsector, hddImage) != static_cast<size_t>(nsector))
@@ -97,329 +104,303 @@ void ATA::IO_Read()
 
 bool ATA::IO_Write()
 {
-	WriteQueueEntry entry;
-	if (!writeQueue.Dequeue(&entry))
+	if (IO_WriteQueued() == 0)
 	{
 		std::lock_guard ioSignallock(ioMutex);
 		ioWrite = false;
 		return false;
 	}
+	return true;
+}
 
-	u64 imagePos = entry.sector * 512;
-	if (FileSystem::FSeek64(hddImage, imagePos, SEEK_SET) != 0)
+void ATA::IO_Flush()
+{
+	// Only flushes to the OS, as writes did before they were cached.
+	if (std::fflush(hddImage) != 0)
 	{
-		Console.Error("DEV9: ATA: File seek error");
+		Console.Error("DEV9: ATA: File flush error");
 		pxAssert(false);
 		abort();
 	}
-	if (hddSparse)
+	hddDirty.store(false);
+
+	{
+		std::lock_guard ioSignallock(ioMutex);
+		ioFlush = false;
+	}
+}
+
+// Writes everything queued so far, in order, merging entries for consecutive sectors
+// into a single write. Returns the number of entries written.
+u32 ATA::IO_WriteQueued()
+{
+	u32 count = 0;
+	u64 runPos = 0;
+	size_t runLength = 0;
+
+	WriteQueueEntry entry;
+	while (writeQueue.Dequeue(&entry))
 	{
-		u32 written = 0;
-		while (written != entry.length)
+		const u64 entryPos = entry.sector * 512;
+		if (runLength != 0 && entryPos != runPos + runLength)
 		{
-			IO_SparseCacheUpdateLocation(imagePos + written);
-			// Align to sparse block size.
-			u32 writeSize = hddSparseBlockSize - ((imagePos + written) % hddSparseBlockSize);
-			// Limit to size of write.
-			writeSize = std::min(writeSize, entry.length - written);
+			IO_WriteRun(runPos, ioWriteRun.data(), runLength);
+			runLength = 0;
+		}
+		if (runLength == 0)
+			runPos = entryPos;
 
-			pxAssert(writeSize > 0);
-			pxAssert(writeSize <= hddSparseBlockSize);
-			pxAssert((imagePos + written) >= HddSparseStart);
-			pxAssert((imagePos + written) - HddSparseStart + writeSize <= hddSparseBlockSize);
+		if (ioWriteRun.size() < runLength + entry.length)
+			ioWriteRun.resize(runLength + entry.length);
+		memcpy(&ioWriteRun[runLength], entry.data, entry.length);
+		runLength += entry.length;
 
-			bool sparseWrite = IsAllZero(&entry.data[written], writeSize);
+		SlabPool::Free(entry.data, entry.length);
+		count++;
+	}
 
-			if (sparseWrite)
-			{
-#if defined(PCSX2_DEBUG) || defined(PCSX2_DEVBUILD)
-				std::unique_ptr<u8[]> zeroBlock = std::make_unique<u8[]>(writeSize);
-				memset(zeroBlock.get(), 0, writeSize);
-				pxAssert(memcmp(&entry.data[written], zeroBlock.get(), writeSize) == 0);
-#endif
+	if (runLength != 0)
+		IO_WriteRun(runPos, ioWriteRun.data(), runLength);
+	if (count != 0)
+		hddDirty.store(true);
+	return count;
+}
 
-				if (!IO_SparseZero(imagePos + written, writeSize))
-				{
-					Console.Error("DEV9: ATA: File sparse write error");
+void ATA::IO_WriteRun(u64 imagePos, const u8* data, size_t length)
+{
+	if (!hddSparse)
+	{
+		IO_WriteData(imagePos, data, length);
+		return;
+	}
 
-					// hddNativeHandle is owned by hddImage.
-					// do not close it.
-					hddNativeHandle = INVALID_HANDLE_VALUE;
+	// Split into sparse blocks, blocks which end up all zero are punched out
+	// rather than written, and the rest are written together.
+	size_t pending = 0;
+	size_t pendingLength = 0;
+	size_t written = 0;
+	while (written != length)
+	{
+		const u64 offset = imagePos + written;
+		// Align to sparse block size, and limit to size of write.
+		const size_t writeSize = std::min<size_t>(hddSparseBlockSize - (offset % hddSparseBlockSize), length - written);
 
-					hddSparse = false;
-					hddSparseBlock = nullptr;
-					hddSparseBlockValid = false;
+		if (hddSparse && IO_SparseWrite(offset, &data[written], writeSize))
+		{
+			if (pendingLength != 0)
+				IO_WriteData(imagePos + pending, &data[pending], pendingLength);
+			pending = written + writeSize;
+			pendingLength = 0;
+		}
+		else
+			pendingLength += writeSize;
 
-					// Fallthough into other if statment.
-					sparseWrite = false;
-				}
-			}
+		written += writeSize;
+	}
 
-			// Also handles sparse write failures.
-			if (!sparseWrite)
-			{
-#if defined(PCSX2_DEBUG) || defined(PCSX2_DEVBUILD)
-				if (hddSparse)
-				{
-					std::unique_ptr<u8[]> zeroBlock = std::make_unique<u8[]>(writeSize);
-					memset(zeroBlock.get(), 0, writeSize);
-					pxAssert(memcmp(&entry.data[written], zeroBlock.get(), writeSize) != 0);
-				}
-#endif
-				// Update cache.
-				if (hddSparseBlockValid)
-					memcpy(&hddSparseBlock[(imagePos + written) - HddSparseStart], &entry.data[written], writeSize);
+	if (pendingLength != 0)
+		IO_WriteData(imagePos + pending, &data[pending], pendingLength);
+}
 
-				if (std::fwrite(&entry.data[written], writeSize, 1, hddImage) != 1 ||
-					std::fflush(hddImage) != 0)
-				{
-					Console.Error("DEV9: ATA: File write error");
-					pxAssert(false);
-					abort();
-				}
-			}
-			written += writeSize;
-			pxAssert(FileSystem::FTell64(hddImage) == (s64)(imagePos + written));
-		}
+void ATA::IO_WriteData(u64 imagePos, const u8* data, size_t length)
+{
+	if (FileSystem::FSeek64(hddImage, imagePos, SEEK_SET) != 0)
+	{
+		Console.Error("DEV9: ATA: File seek error");
+		pxAssert(false);
+		abort();
 	}
-	else
+	if (std::fwrite(data, length, 1, hddImage) != 1)
 	{
-		if (std::fwrite(entry.data, entry.length, 1, hddImage) != 1 || std::fflush(hddImage) != 0)
-		{
-			Console.Error("DEV9: ATA: File write error");
-			pxAssert(false);
-			abort();
-		}
+		Console.Error("DEV9: ATA: File write error");
+		pxAssert(false);
+		abort();
+	}
+}
+
+// Updates which sectors of the block are zero, and punches out the block if that
+// leaves it all zero. Returns true if the data doesn't need writing.
+bool ATA::IO_SparseWrite(u64 byteOffset, const u8* data, size_t byteSize)
+{
+	const u64 blockStart = byteOffset - (byteOffset % hddSparseBlockSize);
+	pxAssert(byteOffset - blockStart + byteSize <= hddSparseBlockSize);
+	pxAssert((byteOffset % 512) == 0 && (byteSize % 512) == 0);
+
+	u64* mask = IO_SparseGetMask(blockStart, byteSize == hddSparseBlockSize);
+	const bool wasZero = IO_SparseMaskIsZero(mask);
+
+	const u32 firstSector = static_cast<u32>((byteOffset - blockStart) / 512);
+	const u32 sectors = static_cast<u32>(byteSize / 512);
+	for (u32 i = 0; i < sectors; i++)
+	{
+		const u32 bit = firstSector + i;
+		if (IsAllZero(&data[i * 512], 512))
+			mask[bit / 64] |= 1ULL << (bit % 64);
+		else
+			mask[bit / 64] &= ~(1ULL << (bit % 64));
+	}
+
+	if (!IO_SparseMaskIsZero(mask))
+		return false;
+
+	// Already reads back as zeros, either a hole or zeros we wrote.
+	if (wasZero)
+		return true;
+
+	// Buffered writes to this block must land before the hole is punched.
+	std::fflush(hddImage);
+	if (!IO_SparsePunch(blockStart))
+	{
+		Console.Error("DEV9: ATA: File sparse write error");
+
+		// hddNativeHandle is owned by hddImage.
+		// do not close it.
+		hddNativeHandle = INVALID_HANDLE_VALUE;
+
+		hddSparse = false;
+		hddSparseMaskIndex.clear();
+		hddSparseMasks.clear();
+		return false;
 	}
-	delete[] entry.data;
 	return true;
 }
 
-void ATA::IO_SparseCacheLoad()
+u64* ATA::IO_SparseGetMask(u64 blockStart, bool wholeBlock)
 {
-	// Reads are bounds checked, but for the sectors read only.
-	// Need to bounds check for sparse block, to handle an edge case of a user providing a file with a size that dosn't align with the sparse block size.
-	// Normally that won't happen as we generate files of exact Gib size.
-	u64 readSize = hddSparseBlockSize;
-	const u64 posEnd = HddSparseStart + hddSparseBlockSize;
-	if (posEnd > hddImageSize)
+	const auto it = hddSparseMaskIndex.find(blockStart);
+	if (it != hddSparseMaskIndex.end())
+		return &hddSparseMasks[it->second * hddSparseMaskWords];
+
+	// Forget everything once too many blocks have been seen, they can be looked up again.
+	if (hddSparseMaskIndex.size() >= MAX_SPARSE_MASKS)
 	{
-		readSize = hddSparseBlockSize - (posEnd - hddImageSize);
-		// Zero cache for data beyond end of file.
-		memset(&hddSparseBlock[readSize], 0, hddSparseBlockSize - readSize);
+		hddSparseMaskIndex.clear();
+		hddSparseMasks.clear();
 	}
 
-	// Store file pointer.
-	const s64 orgPos = FileSystem::FTell64(hddImage);
+	const size_t index = hddSparseMaskIndex.size();
+	hddSparseMaskIndex.emplace(blockStart, index);
+	hddSparseMasks.resize((index + 1) * hddSparseMaskWords, 0);
+
+	u64* mask = &hddSparseMasks[index * hddSparseMaskWords];
+	// A write covering the whole block sets every bit itself.
+	if (!wholeBlock)
+		IO_SparseMaskLoad(blockStart, mask);
+	return mask;
+}
+
+void ATA::IO_SparseMaskLoad(u64 blockStart, u64* mask)
+{
+	const u32 sectors = static_cast<u32>(hddSparseBlockSize / 512);
 
 	// Flush so that we know what is allocated.
 	std::fflush(hddImage);
 
+	bool hole = false;
 #ifdef _WIN32
-	// FlushFileBuffers is required, hddSparseBlock differs from actual file without it.
+	// FlushFileBuffers is required, the allocated ranges differ from the actual file without it.
 	FlushFileBuffers(hddNativeHandle);
 	// Range to be examined (One Sparse block size).
 	FILE_ALLOCATED_RANGE_BUFFER queryRange;
-	queryRange.FileOffset.QuadPart = HddSparseStart;
+	queryRange.FileOffset.QuadPart = blockStart;
 	queryRange.Length.QuadPart = hddSparseBlockSize;
 
 	// Allocated areas info.
 	FILE_ALLOCATED_RANGE_BUFFER allocRange;
 	DWORD dwRetBytes;
 	const BOOL ret = DeviceIoControl(hddNativeHandle, FSCTL_QUERY_ALLOCATED_RANGES, &queryRange, sizeof(queryRange), &allocRange, sizeof(allocRange), &dwRetBytes, nullptr);
-
-	if (ret == TRUE && dwRetBytes == 0)
-	{
-		// We are sparse.
-		memset(hddSparseBlock.get(), 0, hddSparseBlockSize);
-		hddSparseBlockValid = true;
-#if defined(PCSX2_DEBUG) || defined(PCSX2_DEVBUILD)
-
-		// Store file pointer.
-		const s64 orgPos = FileSystem::FTell64(hddImage);
-		pxAssert(orgPos != -1);
-
-		//Load into check buffer.
-		FileSystem::FSeek64(hddImage, HddSparseStart, SEEK_SET);
-
-		std::unique_ptr<u8[]> temp = std::make_unique<u8[]>(hddSparseBlockSize);
-		memset(temp.get(), 0, hddSparseBlockSize);
-
-		if (FileSystem::FSeek64(hddImage, HddSparseStart, SEEK_SET) != 0 ||
-			std::fread((char*)hddSparseBlock.get(), readSize, 1, hddImage) != 1)
-			pxAssert(false);
-
-		// Restore file pointer.
-		if (FileSystem::FSeek64(hddImage, orgPos, SEEK_SET) != 0)
-			pxAssert(false);
-
-		// Check if file is actully zeros.
-		if (memcmp(hddSparseBlock.get(), temp.get(), hddSparseBlockSize) != 0)
-		{
-			Console.WriteLn("DEV9: ATA: Sparse area not sparse, BlockStart: %s, BlockEnd: %s",
-				std::to_string(HddSparseStart).c_str(), std::to_string(HddSparseStart + hddSparseBlockSize).c_str());
-		}
-		else
-			Console.WriteLn("DEV9: ATA: Sparse area is sparse (Yay), BlockStart: %s, BlockEnd: %s",
-				std::to_string(HddSparseStart).c_str(), std::to_string(HddSparseStart + hddSparseBlockSize).c_str());
-
-		pxAssert(memcmp(hddSparseBlock.get(), temp.get(), hddSparseBlockSize) == 0);
-#endif
-		return;
-	}
+	hole = (ret == TRUE && dwRetBytes == 0);
 #elif defined(__POSIX__)
 #ifdef SEEK_HOLE
 	// Are we in a hole?
-	off_t ret = lseek(hddNativeHandle, HddSparseStart, SEEK_HOLE);
-	if (ret == (off_t)HddSparseStart)
+	if (lseek(hddNativeHandle, blockStart, SEEK_HOLE) == (off_t)blockStart)
 	{
 		// Seek to data.
-		ret = lseek(hddNativeHandle, HddSparseStart, SEEK_DATA);
-		if (ret >= (off_t)(HddSparseStart + hddSparseBlockSize))
-		{
-			// We are sparse.
-			memset(hddSparseBlock.get(), 0, hddSparseBlockSize);
-			hddSparseBlockValid = true;
-#if defined(PCSX2_DEBUG) || defined(PCSX2_DEVBUILD)
-
-			// Store file pointer.
-			const s64 orgPos = FileSystem::FTell64(hddImage);
-			pxAssert(orgPos != -1);
-
-			// Load into check buffer.
-			FileSystem::FSeek64(hddImage, HddSparseStart, SEEK_SET);
-
-			std::unique_ptr<u8[]> temp = std::make_unique<u8[]>(hddSparseBlockSize);
-			memset(temp.get(), 0, hddSparseBlockSize);
-
-			if (FileSystem::FSeek64(hddImage, HddSparseStart, SEEK_SET) != 0 ||
-				std::fread((char*)hddSparseBlock.get(), readSize, 1, hddImage) != 1)
-				pxAssert(false);
-
-			// Restore file pointer.
-			if (FileSystem::FSeek64(hddImage, orgPos, SEEK_SET) != 0)
-				pxAssert(false);
-
-			// Check if file is actully zeros.
-			if (memcmp(hddSparseBlock.get(), temp.get(), hddSparseBlockSize) != 0)
-			{
-				Console.WriteLn("DEV9: ATA: Sparse area not sparse, BlockStart: %s, BlockEnd: %s",
-					std::to_string(HddSparseStart).c_str(), std::to_string(HddSparseStart + hddSparseBlockSize).c_str());
-			}
-			else
-				Console.WriteLn("DEV9: ATA: Sparse area is sparse (Yay), BlockStart: %s, BlockEnd: %s",
-					std::to_string(HddSparseStart).c_str(), std::to_string(HddSparseStart + hddSparseBlockSize).c_str());
-
-			pxAssert(memcmp(hddSparseBlock.get(), temp.get(), hddSparseBlockSize) == 0);
-#endif
-			return;
-		}
+		hole = lseek(hddNativeHandle, blockStart, SEEK_DATA) >= (off_t)(blockStart + hddSparseBlockSize);
 	}
 #endif
 #endif
 
-	// Load into cache.
-	if (orgPos == -1 ||
-		FileSystem::FSeek64(hddImage, HddSparseStart, SEEK_SET) != 0 ||
-		std::fread((char*)hddSparseBlock.get(), readSize, 1, hddImage) != 1 ||
-		FileSystem::FSeek64(hddImage, orgPos, SEEK_SET) != 0) // Restore file pointer.
+	if (hole)
+	{
+		for (u32 i = 0; i < sectors; i++)
+			mask[i / 64] |= 1ULL << (i % 64);
+		return;
+	}
+
+	// Reads are bounds checked, but for the sectors read only.
+	// Need to bounds check for sparse block, to handle an edge case of a user providing a file with a size that dosn't align with the sparse block size.
+	// Normally that won't happen as we generate files of exact Gib size.
+	u64 readSize = hddSparseBlockSize;
+	const u64 posEnd = blockStart + hddSparseBlockSize;
+	if (posEnd > hddImageSize)
+	{
+		readSize = hddSparseBlockSize - (posEnd - hddImageSize);
+		// Data beyond end of file reads as zero.
+		memset(&hddSparseBlock[readSize], 0, hddSparseBlockSize - readSize);
+	}
+
+	if (FileSystem::FSeek64(hddImage, blockStart, SEEK_SET) != 0 ||
+		std::fread((char*)hddSparseBlock.get(), readSize, 1, hddImage) != 1)
 	{
 		Console.Error("DEV9: ATA: File read error");
 		pxAssert(false);
 		abort();
 	}
 
-	hddSparseBlockValid = true;
-}
-
-void ATA::IO_SparseCacheUpdateLocation(u64 byteOffset)
-{
-	const u64 currentBlockStart = (byteOffset / hddSparseBlockSize) * hddSparseBlockSize;
-	if (currentBlockStart != HddSparseStart)
+	for (u32 i = 0; i < sectors; i++)
 	{
-		HddSparseStart = currentBlockStart;
-		hddSparseBlockValid = false;
-		// Only update cache when we perform a sparse write.
+		if (IsAllZero(&hddSparseBlock[i * 512], 512))
+			mask[i / 64] |= 1ULL << (i % 64);
 	}
 }
 
-// Also sets hddImage write ptr.
-bool ATA::IO_SparseZero(u64 byteOffset, u64 byteSize)
+bool ATA::IO_SparseMaskIsZero(const u64* mask)
 {
-	if (hddSparseBlockValid == false)
-		IO_SparseCacheLoad();
-
-	//Assert as range check
-	pxAssert(byteOffset >= HddSparseStart);
-	pxAssert(byteOffset - HddSparseStart + byteSize <= hddSparseBlockSize);
-
-	//Write to cache
-	memset(&hddSparseBlock[byteOffset - HddSparseStart], 0, byteSize);
-
-	//Is block non-zero?
-	if (!IsAllZero(hddSparseBlock.get(), hddSparseBlockSize))
+	const u32 sectors = static_cast<u32>(hddSparseBlockSize / 512);
+	for (u32 i = 0; i < sectors / 64; i++)
 	{
-#if defined(PCSX2_DEBUG) || defined(PCSX2_DEVBUILD)
-		std::unique_ptr<u8[]> zeroBlock = std::make_unique<u8[]>(hddSparseBlockSize);
-		memset(zeroBlock.get(), 0, hddSparseBlockSize);
-		pxAssert(memcmp(hddSparseBlock.get(), zeroBlock.get(), hddSparseBlockSize) != 0);
-#endif
-
-		//No, do normal write
-		if (std::fwrite((char*)&hddSparseBlock[byteOffset - HddSparseStart], byteSize, 1, hddImage) != 1 ||
-			std::fflush(hddImage) != 0)
-		{
-			Console.Error("DEV9: ATA: File write error");
-			pxAssert(false);
-			abort();
-		}
-		return true;
+		if (mask[i] != ~0ULL)
+			return false;
 	}
+	if ((sectors % 64) != 0)
+	{
+		const u64 tail = (1ULL << (sectors % 64)) - 1;
+		if ((mask[sectors / 64] & tail) != tail)
+			return false;
+	}
+	return true;
+}
 
-#if defined(PCSX2_DEBUG) || defined(PCSX2_DEVBUILD)
-	std::unique_ptr<u8[]> zeroBlock = std::make_unique<u8[]>(hddSparseBlockSize);
-	memset(zeroBlock.get(), 0, hddSparseBlockSize);
-	pxAssert(memcmp(hddSparseBlock.get(), zeroBlock.get(), hddSparseBlockSize) == 0);
-#endif
-
-	//Yes, try sparse write
+bool ATA::IO_SparsePunch(u64 blockStart)
+{
 #ifdef _WIN32
 	FILE_ZERO_DATA_INFORMATION sparseRange;
-	sparseRange.FileOffset.QuadPart = HddSparseStart;
-	sparseRange.BeyondFinalZero.QuadPart = HddSparseStart + hddSparseBlockSize;
+	sparseRange.FileOffset.QuadPart = blockStart;
+	sparseRange.BeyondFinalZero.QuadPart = blockStart + hddSparseBlockSize;
 	DWORD dwTemp;
 	const BOOL ret = DeviceIoControl(hddNativeHandle, FSCTL_SET_ZERO_DATA, &sparseRange, sizeof(sparseRange), nullptr, 0, &dwTemp, nullptr);
 
-	if (ret == FALSE)
-		return false;
+	return ret != FALSE;
 
 #elif defined(__linux__)
-	const int ret = fallocate(hddNativeHandle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, HddSparseStart, hddSparseBlockSize);
+	const int ret = fallocate(hddNativeHandle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, blockStart, hddSparseBlockSize);
 
-	if (ret == -1)
-		return false;
+	return ret != -1;
 
 #elif defined(__APPLE__)
 	fpunchhole_t sparseRange{0};
-	sparseRange.fp_offset = HddSparseStart;
+	sparseRange.fp_offset = blockStart;
 	sparseRange.fp_length = hddSparseBlockSize;
 
 	const int ret = fcntl(hddNativeHandle, F_PUNCHHOLE, &sparseRange);
 
-	if (ret == -1)
-		return false;
+	return ret != -1;
 
 #else
 	Console.Error("DEV9: ATA: Hole punching not supported on current OS");
 	return false;
 #endif
-	if (FileSystem::FSeek64(hddImage, byteOffset + byteSize, SEEK_SET) != 0)
-	{
-		Console.Error("DEV9: ATA: File seek error");
-		pxAssert(false);
-		abort();
-	}
-	return true;
 }
 
 bool ATA::IsAllZero(const void* data, size_t len)
@@ -49,7 +49,7 @@ void ATA::DRQCmdDMADataFromHost()
 		return;
 
 	nsectorLeft = nsector;
-	currentWrite = new u8[nsector * 512];
+	currentWrite = static_cast<u8*>(SlabPool::Allocate(nsector * 512));
 	currentWriteLength = nsector * 512;
 	currentWriteSectors = HDD_GetLBA();
 
@@ -58,4 +58,15 @@ namespace PacketReader
 		//
 		payload->WriteBytes((u8*)pkt->buffer, &counter);
 	}
+
+	void EthernetFrame::WritePacket(NetPacket* pkt, MAC_Address destinationMAC, MAC_Address sourceMAC, u16 protocol, Payload* payload)
+	{
+		int counter = 0;
+
+		pkt->size = 14 + payload->GetLength();
+		NetLib::WriteMACAddress((u8*)pkt->buffer, &counter, destinationMAC);
+		NetLib::WriteMACAddress((u8*)pkt->buffer, &counter, sourceMAC);
+		NetLib::WriteUInt16((u8*)pkt->buffer, &counter, protocol);
+		payload->WriteBytes((u8*)pkt->buffer, &counter);
+	}
 } // namespace PacketReader
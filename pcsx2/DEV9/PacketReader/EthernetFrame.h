@@ -52,5 +52,7 @@ namespace PacketReader
 		Payload* GetPayload();
 
 		void WritePacket(NetPacket* pkt);
+		//Writes an untagged frame around payload, without taking ownership of it
+		static void WritePacket(NetPacket* pkt, MAC_Address destinationMAC, MAC_Address sourceMAC, u16 protocol, Payload* payload);
 	};
 } // namespace PacketReader
@@ -86,7 +86,8 @@ namespace PacketReader::IP::ICMP
 			pHeaderLen += 1;
 		}
 
-		u8* segment = new u8[pHeaderLen];
+		SlabPool::Buffer segmentBuffer = SlabPool::MakeBuffer(pHeaderLen);
+		u8* segment = segmentBuffer.get();
 		int counter = 0;
 
 		checksum = 0;
@@ -97,7 +98,6 @@ namespace PacketReader::IP::ICMP
 			NetLib::WriteByte08(segment, &counter, 0);
 
 		checksum = IP_Packet::InternetChecksum(segment, pHeaderLen);
-		delete[] segment;
 	}
 	bool ICMP_Packet::VerifyChecksum(IP_Address srcIP, IP_Address dstIP)
 	{
@@ -107,7 +107,8 @@ namespace PacketReader::IP::ICMP
 			pHeaderLen += 1;
 		}
 
-		u8* segment = new u8[pHeaderLen];
+		SlabPool::Buffer segmentBuffer = SlabPool::MakeBuffer(pHeaderLen);
+		u8* segment = segmentBuffer.get();
 		int counter = 0;
 
 		WriteBytes(segment, &counter);
@@ -117,7 +118,6 @@ namespace PacketReader::IP::ICMP
 			NetLib::WriteByte08(segment, &counter, 0);
 
 		u16 csumCal = IP_Packet::InternetChecksum(segment, pHeaderLen);
-		delete[] segment;
 
 		return (csumCal == 0);
 	}
@@ -15,9 +15,11 @@
 
 #pragma once
 
+#include "DEV9/SlabPool.h"
+
 namespace PacketReader::IP
 {
-	class BaseOption
+	class BaseOption : public SlabPool::Pooled
 	{
 	public:
 		virtual u8 GetLength() = 0;
@@ -229,7 +229,8 @@ namespace PacketReader::IP
 	{
 		//if (!(i == 5)) //checksum field is 10-11th byte (5th short), which is skipped
 		ReComputeHeaderLen();
-		u8* headerSegment = new u8[headerLength];
+		SlabPool::Buffer headerSegmentBuffer = SlabPool::MakeBuffer(headerLength);
+		u8* headerSegment = headerSegmentBuffer.get();
 		int counter = 0;
 		NetLib::WriteByte08(headerSegment, &counter, (_verHi + (headerLength >> 2)));
 		NetLib::WriteByte08(headerSegment, &counter, dscp); //DSCP/ECN
@@ -257,12 +258,12 @@ namespace PacketReader::IP
 		counter = headerLength;
 
 		checksum = InternetChecksum(headerSegment, headerLength);
-		delete[] headerSegment;
 	}
 	bool IP_Packet::VerifyChecksum()
 	{
 		ReComputeHeaderLen();
-		u8* headerSegment = new u8[headerLength];
+		SlabPool::Buffer headerSegmentBuffer = SlabPool::MakeBuffer(headerLength);
+		u8* headerSegment = headerSegmentBuffer.get();
 		int counter = 0;
 		NetLib::WriteByte08(headerSegment, &counter, (_verHi + (headerLength >> 2)));
 		NetLib::WriteByte08(headerSegment, &counter, dscp); //DSCP/ECN
@@ -290,7 +291,6 @@ namespace PacketReader::IP
 		counter = headerLength;
 
 		u16 csumCal = InternetChecksum(headerSegment, headerLength);
-		delete[] headerSegment;
 
 		return (csumCal == 0);
 	}
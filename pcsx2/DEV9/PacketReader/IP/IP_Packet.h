@@ -57,7 +57,7 @@ namespace PacketReader::IP
 	public:
 		IP_Address sourceIP{};
 		IP_Address destinationIP{};
-		std::vector<IPOption*> options;
+		std::vector<IPOption*, SlabPool::Allocator<IPOption*>> options;
 
 	private:
 		std::unique_ptr<IP_Payload> payload;
@@ -41,7 +41,7 @@ namespace PacketReader::IP::TCP
 		u16 urgentPointer = 0;
 
 	public:
-		std::vector<BaseOption*> options;
+		std::vector<BaseOption*, SlabPool::Allocator<BaseOption*>> options;
 
 	private:
 		const static IP_Type protocol = IP_Type::TCP;
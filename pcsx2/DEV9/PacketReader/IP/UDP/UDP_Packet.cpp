@@ -90,7 +90,8 @@ namespace PacketReader::IP::UDP
 		if ((pHeaderLen & 1) != 0)
 			pHeaderLen += 1;
 
-		u8* headerSegment = new u8[pHeaderLen];
+		SlabPool::Buffer headerSegmentBuffer = SlabPool::MakeBuffer(pHeaderLen);
+		u8* headerSegment = headerSegmentBuffer.get();
 		int counter = 0;
 
 		NetLib::WriteIPAddress(headerSegment, &counter, srcIP);
@@ -109,7 +110,6 @@ namespace PacketReader::IP::UDP
 			NetLib::WriteByte08(headerSegment, &counter, 0);
 
 		checksum = IP_Packet::InternetChecksum(headerSegment, pHeaderLen);
-		delete[] headerSegment;
 	}
 	bool UDP_Packet::VerifyChecksum(IP_Address srcIP, IP_Address dstIP)
 	{
@@ -117,7 +117,8 @@ namespace PacketReader::IP::UDP
 		if ((pHeaderLen & 1) != 0)
 			pHeaderLen += 1;
 
-		u8* headerSegment = new u8[pHeaderLen];
+		SlabPool::Buffer headerSegmentBuffer = SlabPool::MakeBuffer(pHeaderLen);
+		u8* headerSegment = headerSegmentBuffer.get();
 		int counter = 0;
 
 		NetLib::WriteIPAddress(headerSegment, &counter, srcIP);
@@ -135,7 +136,6 @@ namespace PacketReader::IP::UDP
 			NetLib::WriteByte08(headerSegment, &counter, 0);
 
 		u16 csumCal = IP_Packet::InternetChecksum(headerSegment, pHeaderLen);
-		delete[] headerSegment;
 
 		return (csumCal == 0);
 	}
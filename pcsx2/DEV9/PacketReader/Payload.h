@@ -17,9 +17,12 @@
 
 #include <memory>
 
+#include "DEV9/SlabPool.h"
+
 namespace PacketReader
 {
-	class Payload
+	//Payloads are created and destroyed for every packet, so they come from the slab pool
+	class Payload : public SlabPool::Pooled
 	{
 	public:
 		virtual int GetLength() = 0;
@@ -32,7 +35,7 @@ namespace PacketReader
 	class PayloadData : public Payload
 	{
 	public:
-		std::unique_ptr<u8[]> data;
+		SlabPool::Buffer data;
 
 	private:
 		int length;
@@ -43,7 +46,10 @@ namespace PacketReader
 			length = len;
 
 			if (len != 0)
-				data = std::make_unique<u8[]>(len);
+			{
+				data = SlabPool::MakeBuffer(len);
+				memset(data.get(), 0, len);
+			}
 		}
 		PayloadData(const PayloadData& original)
 		{
@@ -51,7 +57,7 @@ namespace PacketReader
 
 			if (length != 0)
 			{
-				data = std::make_unique<u8[]>(length);
+				data = SlabPool::MakeBuffer(length);
 				memcpy(data.get(), original.data.get(), length);
 			}
 		}
@@ -42,6 +42,11 @@ namespace Sessions
 		connectionClosedHandlers.push_back(handler);
 	}
 
+	void BaseSession::AddSocketOpenedHandler(SocketOpenedEventHandler handler)
+	{
+		socketOpenedHandlers.push_back(handler);
+	}
+
 	void BaseSession::RaiseEventConnectionClosed()
 	{
 		std::vector<ConnectionClosedEventHandler> Handlers = connectionClosedHandlers;
@@ -50,4 +55,10 @@ namespace Sessions
 		for (size_t i = 0; i < Handlers.size(); i++)
 			Handlers[i](this);
 	}
+
+	void BaseSession::RaiseEventSocketOpened(uptr socket)
+	{
+		for (size_t i = 0; i < socketOpenedHandlers.size(); i++)
+			socketOpenedHandlers[i](this, socket);
+	}
 } // namespace Sessions
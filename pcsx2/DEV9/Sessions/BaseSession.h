@@ -24,6 +24,7 @@ namespace Sessions
 	class BaseSession; //Forward declare
 
 	typedef std::function<void(BaseSession*)> ConnectionClosedEventHandler;
+	typedef std::function<void(BaseSession*, uptr)> SocketOpenedEventHandler;
 
 	struct ConnectionKey
 	{
@@ -48,11 +49,15 @@ namespace Sessions
 
 	private:
 		std::vector<ConnectionClosedEventHandler> connectionClosedHandlers;
+		std::vector<SocketOpenedEventHandler> socketOpenedHandlers;
 
 	public:
 		BaseSession(ConnectionKey parKey, PacketReader::IP::IP_Address parAdapterIP);
 
 		void AddConnectionClosedHandler(ConnectionClosedEventHandler handler);
+		//Raised for each socket the session receives on, so the
+		//adapter can wait on them rather than polling Recv()
+		void AddSocketOpenedHandler(SocketOpenedEventHandler handler);
 
 		virtual PacketReader::IP::IP_Payload* Recv() = 0;
 		virtual bool Send(PacketReader::IP::IP_Payload* payload) = 0;
@@ -62,6 +67,7 @@ namespace Sessions
 
 	protected:
 		void RaiseEventConnectionClosed();
+		void RaiseEventSocketOpened(uptr socket);
 	};
 } // namespace Sessions
 
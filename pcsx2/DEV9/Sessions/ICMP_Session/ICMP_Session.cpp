@@ -873,10 +873,17 @@ namespace Sessions
 				//Need to copy IP_Packet, original is stack allocated
 				ping->originalPacket = std::make_unique<IP_Packet>(*packet);
 
+#ifdef __POSIX__
+				//Recv() may free the ping as soon as it's in the list
+				const int pingSocket = ping->GetSocket();
+#endif
 				{
 					std::scoped_lock lock(ping_mutex);
 					pings.push_back(ping);
 				}
+#ifdef __POSIX__
+				RaiseEventSocketOpened(pingSocket);
+#endif
 
 				break;
 			}
@@ -74,6 +74,9 @@ namespace Sessions
 		public:
 			Ping(int requestSize);
 			bool IsInitialised();
+#ifdef __POSIX__
+			int GetSocket() const { return icmpSocket; }
+#endif
 			PingResult* Recv();
 			bool Send(PacketReader::IP::IP_Address parAdapterIP, PacketReader::IP::IP_Address parDestIP, int parTimeToLive, PacketReader::PayloadPtr* parPayload);
 
@@ -85,6 +85,8 @@ namespace Sessions
 		std::vector<u32> _OldMyNumbers;
 		std::atomic<bool> myNumberACKed{true};
 
+		std::vector<u8> recvBuffer; //Accesed By In Thread Only
+
 	public:
 		TCP_Session(ConnectionKey parKey, PacketReader::IP::IP_Address parAdapterIP);
 
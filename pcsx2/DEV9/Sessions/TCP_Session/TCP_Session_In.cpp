@@ -90,7 +90,6 @@ namespace Sessions
 		if (maxSize != 0 &&
 			myNumberACKed.load())
 		{
-			std::unique_ptr<u8[]> buffer;
 			int err = 0;
 			int recived;
 
@@ -105,8 +104,9 @@ namespace Sessions
 				if (available > maxSize)
 					Console.WriteLn("DEV9: TCP: Got a lot of data: %d Using: %d", available, maxSize);
 
-				buffer = std::make_unique<u8[]>(maxSize);
-				recived = recv(client, (char*)buffer.get(), maxSize, 0);
+				if (recvBuffer.size() < maxSize)
+					recvBuffer.resize(maxSize);
+				recived = recv(client, (char*)recvBuffer.data(), maxSize, 0);
 				if (recived == -1)
 #ifdef _WIN32
 					err = WSAGetLastError();
@@ -171,7 +171,7 @@ namespace Sessions
 				DevCon.WriteLn("DEV9: TCP: [SRV] Sending %d bytes", recived);
 
 				PayloadData* recivedData = new PayloadData(recived);
-				memcpy(recivedData->data.get(), buffer.get(), recived);
+				memcpy(recivedData->data.get(), recvBuffer.data(), recived);
 
 				TCP_Packet* iRet = CreateBasePacket(recivedData);
 				IncrementMyNumber((u32)recived);
@@ -244,6 +244,7 @@ namespace Sessions
 			//Compleation of socket connection checked in recv
 		}
 
+		RaiseEventSocketOpened(client);
 		state = TCP_State::SendingSYN_ACK;
 		return true;
 	}
@@ -16,6 +16,7 @@
 #pragma once
 #include <atomic>
 #include <mutex>
+#include <vector>
 #ifdef _WIN32
 #include <winsock2.h>
 #elif defined(__POSIX__)
@@ -40,6 +41,8 @@ namespace Sessions
 		int client = INVALID_SOCKET;
 #endif
 
+		std::vector<u8> recvBuffer; //Accesed By In Thread Only
+
 	public:
 		const u16 port = 0;
 
@@ -16,6 +16,7 @@
 #pragma once
 #include <atomic>
 #include <chrono>
+#include <vector>
 #ifdef _WIN32
 #include <winsock2.h>
 #elif defined(__POSIX__)
@@ -49,6 +50,8 @@ namespace Sessions
 		std::atomic<std::chrono::steady_clock::time_point> deathClockStart;
 		const static std::chrono::duration<std::chrono::steady_clock::rep, std::chrono::steady_clock::period> MAX_IDLE;
 
+		std::vector<u8> recvBuffer; //Accesed By In Thread Only
+
 	public:
 		//Normal Port
 		UDP_Session(ConnectionKey parKey, PacketReader::IP::IP_Address parAdapterIP);
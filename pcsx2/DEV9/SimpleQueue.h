@@ -16,29 +16,44 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
 
 #include "common/Assertions.h"
 #include "common/Console.h"
 
-//Designed to allow one thread to queue data to another thread
-template <class T>
+//Designed to allow one or more threads to queue data to one other thread
+//Entries go into a fixed size ring, so queuing doesn't allocate
+//If the ring fills up, entries overflow into a locked list until the worker catches up
+template <class T, size_t Capacity = 128>
 class SimpleQueue
 {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
 private:
 	struct SimpleQueueEntry
 	{
-		std::atomic_bool ready{false};
-		SimpleQueueEntry* next;
+		//Equal to the enqueue position when free, one past it once filled
+		std::atomic<size_t> sequence;
 		T value;
 	};
 
-	std::atomic<SimpleQueueEntry*> head{nullptr};
-	SimpleQueueEntry* tail = nullptr;
+	SimpleQueueEntry ring[Capacity];
+	alignas(64) std::atomic<size_t> enqueuePos{0};
+	alignas(64) std::atomic<size_t> dequeuePos{0};
+
+	std::mutex overflowMutex;
+	std::deque<T> overflow;
+	std::atomic_bool overflowing{false};
+
+	bool TryEnqueueRing(const T& entry);
+	bool TryDequeueRing(T* entry);
 
 public:
 	SimpleQueue();
 
-	//Used by single queue thread (i.e. EE)
+	//Used by queue threads (i.e. EE)
 	void Enqueue(T entry);
 	//Used by single worker thread (i.e. IO)
 	bool Dequeue(T* entry);
@@ -49,67 +64,113 @@ public:
 	~SimpleQueue();
 };
 
-template <class T>
-SimpleQueue<T>::SimpleQueue()
+template <class T, size_t Capacity>
+SimpleQueue<T, Capacity>::SimpleQueue()
 {
-	tail = new SimpleQueueEntry();
-	head.store(tail);
+	for (size_t i = 0; i < Capacity; i++)
+		ring[i].sequence.store(i, std::memory_order_relaxed);
 }
 
-template <class T>
-void SimpleQueue<T>::Enqueue(T entry)
+template <class T, size_t Capacity>
+bool SimpleQueue<T, Capacity>::TryEnqueueRing(const T& entry)
 {
-	//Allocate Next entry, and assign to head
-	SimpleQueueEntry* newHead = new SimpleQueueEntry();
-	SimpleQueueEntry* newEntry = head.exchange(newHead);
-
-	//Fill in
-	newEntry->value = entry;
-	newEntry->next = newHead;
+	SimpleQueueEntry* slot;
+	size_t pos = enqueuePos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		slot = &ring[pos & (Capacity - 1)];
+		const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - pos);
+		if (diff == 0)
+		{
+			//Slot is free, claim it
+			if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			//Full, worker hasn't freed this slot yet
+			return false;
+		}
+		else
+		{
+			//Another thread claimed it first
+			pos = enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
 
+	slot->value = entry;
 	//Set ready (can be dequeued)
-	newEntry->ready.store(true);
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
 }
 
-template <class T>
-bool SimpleQueue<T>::Dequeue(T* entry)
+template <class T, size_t Capacity>
+bool SimpleQueue<T, Capacity>::TryDequeueRing(T* entry)
 {
-	if (!tail->ready.load())
+	const size_t pos = dequeuePos.load(std::memory_order_relaxed);
+	SimpleQueueEntry* slot = &ring[pos & (Capacity - 1)];
+	if (slot->sequence.load(std::memory_order_acquire) != pos + 1)
 		return false;
 
-	SimpleQueueEntry* retEntry = tail;
-	tail = retEntry->next;
+	*entry = slot->value;
+	//Free the slot for the next lap around the ring
+	slot->sequence.store(pos + Capacity, std::memory_order_release);
+	dequeuePos.store(pos + 1, std::memory_order_relaxed);
+	return true;
+}
 
-	*entry = retEntry->value;
-	delete retEntry;
+template <class T, size_t Capacity>
+void SimpleQueue<T, Capacity>::Enqueue(T entry)
+{
+	//Once overflowing, keep queuing to the overflow so entries stay in order
+	if (!overflowing.load(std::memory_order_acquire) && TryEnqueueRing(entry))
+		return;
+
+	std::lock_guard lock(overflowMutex);
+	overflow.push_back(entry);
+	overflowing.store(true, std::memory_order_release);
+}
+
+template <class T, size_t Capacity>
+bool SimpleQueue<T, Capacity>::Dequeue(T* entry)
+{
+	//Anything in the ring was queued before the overflow started
+	if (TryDequeueRing(entry))
+		return true;
+
+	if (!overflowing.load(std::memory_order_acquire))
+		return false;
+
+	//Entries still being written to the ring go first
+	if (enqueuePos.load(std::memory_order_acquire) != dequeuePos.load(std::memory_order_relaxed))
+		return false;
+
+	std::lock_guard lock(overflowMutex);
+	if (overflow.empty())
+		return false;
+
+	*entry = overflow.front();
+	overflow.pop_front();
+	if (overflow.empty())
+		overflowing.store(false, std::memory_order_release);
 	return true;
 }
 
 //Note, next entry may not be ready to dequeue
-template <class T>
-bool SimpleQueue<T>::IsQueueEmpty()
+template <class T, size_t Capacity>
+bool SimpleQueue<T, Capacity>::IsQueueEmpty()
 {
-	return head.load() == tail;
+	return enqueuePos.load(std::memory_order_acquire) == dequeuePos.load(std::memory_order_acquire) &&
+		   !overflowing.load(std::memory_order_acquire);
 }
 
-template <class T>
-SimpleQueue<T>::~SimpleQueue()
+template <class T, size_t Capacity>
+SimpleQueue<T, Capacity>::~SimpleQueue()
 {
-	if (head != nullptr)
+	if (!IsQueueEmpty())
 	{
-		if (!IsQueueEmpty())
-		{
-			Console.Error("DEV9: Queue not empty");
-			pxAssert(false);
-
-			//Empty Queue
-			T entry;
-			while (!IsQueueEmpty())
-				Dequeue(&entry);
-		}
-
-		delete head;
-		head = nullptr;
-		tail = nullptr;
+		Console.Error("DEV9: Queue not empty");
+		pxAssert(false);
 	}
 }
@@ -0,0 +1,98 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include <mutex>
+#include <new>
+
+#include "SlabPool.h"
+
+namespace SlabPool
+{
+	//Small blocks are carved out of slabs of this size, larger blocks get a slab each
+	static constexpr size_t SlabSize = 64 * 1024;
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct SizeClass
+	{
+		std::mutex lock;
+		FreeBlock* free = nullptr;
+	};
+
+	static constexpr size_t NumClasses = 12;
+	static_assert((MinBlockSize << (NumClasses - 1)) == MaxBlockSize);
+
+	static SizeClass sizeClasses[NumClasses];
+
+	static size_t GetClass(size_t size)
+	{
+		size_t index = 0;
+		while ((MinBlockSize << index) < size)
+			index++;
+		return index;
+	}
+
+	void* Allocate(size_t size)
+	{
+		if (size > MaxBlockSize)
+			return ::operator new(size);
+
+		const size_t index = GetClass(size);
+		const size_t blockSize = MinBlockSize << index;
+		SizeClass& sizeClass = sizeClasses[index];
+
+		std::lock_guard lock(sizeClass.lock);
+		if (sizeClass.free == nullptr)
+		{
+			//Never freed, blocks only ever move between the free list and their users
+			const size_t slabSize = std::max(SlabSize, blockSize);
+			u8* slab = static_cast<u8*>(::operator new(slabSize));
+			for (size_t offset = 0; offset < slabSize; offset += blockSize)
+			{
+				FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+				block->next = sizeClass.free;
+				sizeClass.free = block;
+			}
+		}
+
+		FreeBlock* block = sizeClass.free;
+		sizeClass.free = block->next;
+		return block;
+	}
+
+	void Free(void* ptr, size_t size)
+	{
+		if (ptr == nullptr)
+			return;
+
+		if (size > MaxBlockSize)
+		{
+			::operator delete(ptr);
+			return;
+		}
+
+		SizeClass& sizeClass = sizeClasses[GetClass(size)];
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+
+		std::lock_guard lock(sizeClass.lock);
+		block->next = sizeClass.free;
+		sizeClass.free = block;
+	}
+} // namespace SlabPool
@@ -0,0 +1,73 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+//Allocator for the objects and buffers DEV9 creates and frees for every packet or HDD write
+//Blocks are handed out from power of two size classes, and go back onto a free list for their class
+//Slabs are kept for the rest of the run, so once traffic reaches a steady state nothing hits the heap
+//Any thread may allocate or free, sizes above MaxBlockSize are passed through to the heap
+namespace SlabPool
+{
+	static constexpr size_t MinBlockSize = 64;
+	static constexpr size_t MaxBlockSize = 128 * 1024;
+
+	void* Allocate(size_t size);
+	//size must be the size given to Allocate
+	void Free(void* ptr, size_t size);
+
+	//Gives a class (and everything derived from it) pooled new/delete
+	//Deleting through a base needs a virtual destructor, that way delete gets the derived size
+	struct Pooled
+	{
+		static void* operator new(size_t size) { return Allocate(size); }
+		static void operator delete(void* ptr, size_t size) { Free(ptr, size); }
+	};
+
+	struct BufferDeleter
+	{
+		size_t size = 0;
+		void operator()(u8* ptr) const { Free(ptr, size); }
+	};
+	using Buffer = std::unique_ptr<u8[], BufferDeleter>;
+
+	//Uninitialised, like new u8[size]
+	inline Buffer MakeBuffer(size_t size)
+	{
+		return Buffer(static_cast<u8*>(Allocate(size)), BufferDeleter{size});
+	}
+
+	//For containers that are filled per packet (i.e. option lists)
+	template <class T>
+	struct Allocator
+	{
+		using value_type = T;
+
+		Allocator() = default;
+		template <class U>
+		Allocator(const Allocator<U>&) {}
+
+		T* allocate(size_t n) { return static_cast<T*>(SlabPool::Allocate(n * sizeof(T))); }
+		void deallocate(T* ptr, size_t n) { SlabPool::Free(ptr, n * sizeof(T)); }
+
+		template <class U>
+		bool operator==(const Allocator<U>&) const { return true; }
+		template <class U>
+		bool operator!=(const Allocator<U>&) const { return false; }
+	};
+} // namespace SlabPool
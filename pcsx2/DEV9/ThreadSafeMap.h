@@ -78,6 +78,20 @@ public:
 		return keys;
 	}
 
+	//Reuses the vector's storage, for callers which ask often
+	void GetKeys(std::vector<Key>* keys)
+	{
+#ifdef NO_SHARED_MUTEX
+		std::unique_lock readLock(accessMutex);
+#else
+		std::shared_lock readLock(accessMutex);
+#endif
+
+		keys->clear();
+		for (auto iter = map.begin(); iter != map.end(); ++iter)
+			keys->push_back(iter->first);
+	}
+
 	//Does not error or insert if no key is found
 	bool TryGetValue(Key key, T* value)
 	{
@@ -27,6 +27,11 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <net/if.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #endif
 
 #include "sockets.h"
@@ -154,6 +159,12 @@ AdapterOptions SocketAdapter::GetAdapterOptions()
 
 SocketAdapter::SocketAdapter()
 {
+#ifdef __linux__
+	//Needs to be set up before InitInternalServer(), which checks blocks()
+	if (!InitEpoll())
+		Console.Error("DEV9: Socket: Failed to set up epoll, falling back to polling. Error: %d", errno);
+#endif
+
 	bool foundAdapter;
 
 	AdapterUtils::Adapter adapter;
@@ -234,7 +245,12 @@ SocketAdapter::SocketAdapter()
 
 bool SocketAdapter::blocks()
 {
+#ifdef __linux__
+	//recv() waits for a session to have data
+	return epollFd != -1;
+#else
 	return false;
+#endif
 }
 
 bool SocketAdapter::isInitialised()
@@ -248,45 +264,263 @@ bool SocketAdapter::recv(NetPacket* pkt)
 		return true;
 
 	EthernetFrame* bFrame;
-	if (!vRecBuffer.Dequeue(&bFrame))
+	if (vRecBuffer.Dequeue(&bFrame))
 	{
-		std::vector<ConnectionKey> keys = connections.GetKeys();
-		for (size_t i = 0; i < keys.size(); i++)
-		{
-			const ConnectionKey key = keys[i];
+		bFrame->WritePacket(pkt);
+		InspectRecv(pkt);
 
-			BaseSession* session;
-			if (!connections.TryGetValue(key, &session))
-				continue;
+		delete bFrame;
+		return true;
+	}
 
-			IP_Payload* pl = session->Recv();
+#ifdef __linux__
+	if (epollFd != -1)
+		return RecvReady(pkt);
+#endif
 
-			if (pl != nullptr)
-			{
-				IP_Packet* ipPkt = new IP_Packet(pl);
-				ipPkt->destinationIP = session->sourceIP;
-				ipPkt->sourceIP = session->destIP;
+	connections.GetKeys(&recvKeys);
+	for (size_t i = 0; i < recvKeys.size(); i++)
+	{
+		BaseSession* session;
+		if (!connections.TryGetValue(recvKeys[i], &session))
+			continue;
+
+		if (RecvFromSession(session, pkt))
+			return true;
+	}
+	return false;
+}
+
+bool SocketAdapter::RecvFromSession(BaseSession* session, NetPacket* pkt)
+{
+	IP_Payload* pl = session->Recv();
+	if (pl == nullptr)
+		return false;
+
+	//Only needed long enough to write out, so keep it off the heap
+	IP_Packet ipPkt(pl);
+	ipPkt.destinationIP = session->sourceIP;
+	ipPkt.sourceIP = session->destIP;
+
+	EthernetFrame::WritePacket(pkt, ps2MAC, internalMAC, (u16)EtherType::IPv4, &ipPkt);
+	InspectRecv(pkt);
+	return true;
+}
 
-				EthernetFrame frame(ipPkt);
-				frame.sourceMAC = internalMAC;
-				frame.destinationMAC = ps2MAC;
-				frame.protocol = (u16)EtherType::IPv4;
+#ifdef __linux__
+bool SocketAdapter::InitEpoll()
+{
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd == -1)
+		return false;
 
-				frame.WritePacket(pkt);
-				InspectRecv(pkt);
+	wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = wakeFd;
+	if (wakeFd == -1 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0)
+	{
+		if (wakeFd != -1)
+			::close(wakeFd);
+		::close(epollFd);
+		wakeFd = -1;
+		epollFd = -1;
+		return false;
+	}
+
+	nextSweep = std::chrono::steady_clock::now();
+	return true;
+}
+
+bool SocketAdapter::RecvReady(NetPacket* pkt)
+{
+	//Serve whatever's ready, wait if nothing is, then try once more
+	for (int pass = 0; pass < 2; pass++)
+	{
+		TakeSignalledSessions();
+
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now >= nextSweep)
+		{
+			SweepSessions();
+			nextSweep = now + SWEEP_INTERVAL;
+		}
+
+		while (!readyQueue.empty())
+		{
+			const ConnectionKey key = readyQueue.front();
+			readyQueue.pop_front();
+
+			SessionStats& stats = sessionStats[key];
+			BaseSession* session;
+			if (connections.TryGetValue(key, &session) && RecvFromSession(session, pkt))
+			{
+				stats.depth++;
+				stats.packets++;
+				stats.maxDepth = std::max(stats.maxDepth, stats.depth);
+
+				//Requeue at the back, so busy sessions take turns
+				readyQueue.push_back(key);
 				return true;
 			}
+
+			//Drained, wait for the next event
+			stats.queued = false;
+			stats.depth = 0;
+		}
+
+		if (pass == 0)
+		{
+			const auto untilSweep = std::chrono::ceil<std::chrono::milliseconds>(nextSweep - std::chrono::steady_clock::now());
+			WaitForEvents(static_cast<int>(std::clamp<s64>(untilSweep.count(), 0, SWEEP_INTERVAL.count())));
 		}
 	}
-	else
+
+	return false;
+}
+
+void SocketAdapter::WaitForEvents(int timeoutMs)
+{
+	epoll_event events[64];
+	const int count = epoll_wait(epollFd, events, std::size(events), timeoutMs);
+	if (count == -1)
 	{
-		bFrame->WritePacket(pkt);
-		InspectRecv(pkt);
+		if (errno != EINTR)
+			Console.Error("DEV9: Socket: epoll_wait failed. Error: %d", errno);
+		return;
+	}
 
-		delete bFrame;
-		return true;
+	std::lock_guard lock(readyMutex);
+	for (int i = 0; i < count; i++)
+	{
+		const int fd = events[i].data.fd;
+		if (fd == wakeFd)
+		{
+			u64 value;
+			if (::read(wakeFd, &value, sizeof(value)) != sizeof(value) && errno != EAGAIN)
+				Console.Error("DEV9: Socket: Failed to read wake event. Error: %d", errno);
+			continue;
+		}
+
+		//Sockets are removed from epoll as they are closed, but an event
+		//may still be pending for a closed session. Harmless, as the key
+		//is checked against connections before use
+		const auto it = socketKeys.find(fd);
+		if (it != socketKeys.end())
+			QueueSession(it->second, true);
+	}
+}
+
+void SocketAdapter::QueueSession(ConnectionKey key, bool wakeup)
+{
+	SessionStats& stats = sessionStats[key];
+	if (wakeup)
+		stats.wakeups++;
+
+	if (!stats.queued)
+	{
+		stats.queued = true;
+		readyQueue.push_back(key);
+	}
+}
+
+void SocketAdapter::TakeSignalledSessions()
+{
+	std::lock_guard lock(readyMutex);
+	for (size_t i = 0; i < signalledKeys.size(); i++)
+		QueueSession(signalledKeys[i], true);
+	signalledKeys.clear();
+}
+
+void SocketAdapter::SweepSessions()
+{
+	connections.GetKeys(&recvKeys);
+	for (size_t i = 0; i < recvKeys.size(); i++)
+		QueueSession(recvKeys[i], false);
+
+	//Report and forget sessions which have since closed
+	for (auto it = sessionStats.begin(); it != sessionStats.end();)
+	{
+		if (!it->second.queued && !connections.ContainsKey(it->first))
+		{
+			LogSessionStats(it->first, it->second);
+			it = sessionStats.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void SocketAdapter::ForgetSessionSockets(ConnectionKey key)
+{
+	//The session closes its sockets, which also takes them out of epoll
+	std::lock_guard lock(readyMutex);
+	for (auto it = socketKeys.begin(); it != socketKeys.end();)
+	{
+		if (it->second == key)
+			it = socketKeys.erase(it);
+		else
+			++it;
 	}
-	return false;
+}
+
+void SocketAdapter::LogSessionStats(ConnectionKey key, const SessionStats& stats)
+{
+	if (stats.packets == 0)
+		return;
+
+	const char* protocol;
+	switch (key.protocol)
+	{
+		case (int)IP_Type::UDP:
+			protocol = "UDP";
+			break;
+		case (int)IP_Type::TCP:
+			protocol = "TCP";
+			break;
+		case (int)IP_Type::ICMP:
+			protocol = "ICMP";
+			break;
+		default:
+			protocol = "Unk";
+			break;
+	}
+
+	DevCon.WriteLn("DEV9: Socket: %s %d.%d.%d.%d:%d received %llu packets over %llu wakeups, max queue depth %u",
+		protocol, key.ip.bytes[0], key.ip.bytes[1], key.ip.bytes[2], key.ip.bytes[3], key.srvPort,
+		static_cast<unsigned long long>(stats.packets), static_cast<unsigned long long>(stats.wakeups), stats.maxDepth);
+}
+#endif
+
+void SocketAdapter::SignalSession(ConnectionKey key)
+{
+#ifdef __linux__
+	if (epollFd == -1)
+		return;
+
+	//No need to wake the rx thread again if it hasn't picked up the last one yet
+	bool wake;
+	{
+		std::lock_guard lock(readyMutex);
+		wake = signalledKeys.empty();
+		signalledKeys.push_back(key);
+	}
+
+	if (wake)
+		Wake();
+#endif
+}
+
+void SocketAdapter::Wake()
+{
+#ifdef __linux__
+	if (wakeFd == -1)
+		return;
+
+	const u64 value = 1;
+	if (::write(wakeFd, &value, sizeof(value)) != sizeof(value))
+		Console.Error("DEV9: Socket: Failed to signal wake event. Error: %d", errno);
+#endif
 }
 
 bool SocketAdapter::send(NetPacket* pkt)
@@ -340,6 +574,7 @@ bool SocketAdapter::send(NetPacket* pkt)
 						retARP->protocol = (u16)EtherType::ARP;
 
 						vRecBuffer.Enqueue(retARP);
+						Wake();
 					}
 				}
 			}
@@ -437,17 +672,22 @@ bool SocketAdapter::SendICMP(ConnectionKey Key, IP_Packet* ipPkt)
 	if (existingSession != nullptr)
 	{
 		s = static_cast<ICMP_Session*>(existingSession);
-		return s->Send(ipPkt->GetPayload(), ipPkt);
+		const bool result = s->Send(ipPkt->GetPayload(), ipPkt);
+		SignalSession(Key);
+		return result;
 	}
 
 	DevCon.WriteLn("DEV9: Socket: Creating New ICMP Connection");
 	s = new ICMP_Session(Key, adapterIP, &connections);
 
 	s->AddConnectionClosedHandler([&](BaseSession* session) { HandleConnectionClosed(session); });
+	s->AddSocketOpenedHandler([&](BaseSession* session, uptr socket) { HandleSocketOpened(session, socket); });
 	s->destIP = ipPkt->destinationIP;
 	s->sourceIP = dhcpServer.ps2IP;
 	connections.Add(Key, s);
-	return s->Send(ipPkt->GetPayload(), ipPkt);
+	const bool result = s->Send(ipPkt->GetPayload(), ipPkt);
+	SignalSession(Key);
+	return result;
 }
 
 bool SocketAdapter::SendIGMP(ConnectionKey Key, IP_Packet* ipPkt)
@@ -475,10 +715,13 @@ bool SocketAdapter::SendTCP(ConnectionKey Key, IP_Packet* ipPkt)
 		TCP_Session* s = new TCP_Session(Key, adapterIP);
 
 		s->AddConnectionClosedHandler([&](BaseSession* session) { HandleConnectionClosed(session); });
+		s->AddSocketOpenedHandler([&](BaseSession* session, uptr socket) { HandleSocketOpened(session, socket); });
 		s->destIP = ipPkt->destinationIP;
 		s->sourceIP = dhcpServer.ps2IP;
 		connections.Add(Key, s);
-		return s->Send(ipPkt->GetPayload());
+		const bool result = s->Send(ipPkt->GetPayload());
+		SignalSession(Key);
+		return result;
 	}
 }
 
@@ -522,6 +765,7 @@ bool SocketAdapter::SendUDP(ConnectionKey Key, IP_Packet* ipPkt)
 
 				fPort = new UDP_FixedPort(fKey, adapterIP, udp.sourcePort);
 				fPort->AddConnectionClosedHandler([&](BaseSession* session) { HandleFixedPortClosed(session); });
+				fPort->AddSocketOpenedHandler([&](BaseSession* session, uptr socket) { HandleSocketOpened(session, socket); });
 
 				fPort->destIP = {};
 				fPort->sourceIP = dhcpServer.ps2IP;
@@ -542,10 +786,13 @@ bool SocketAdapter::SendUDP(ConnectionKey Key, IP_Packet* ipPkt)
 		}
 
 		s->AddConnectionClosedHandler([&](BaseSession* session) { HandleConnectionClosed(session); });
+		s->AddSocketOpenedHandler([&](BaseSession* session, uptr socket) { HandleSocketOpened(session, socket); });
 		s->destIP = ipPkt->destinationIP;
 		s->sourceIP = dhcpServer.ps2IP;
 		connections.Add(Key, s);
-		return s->Send(ipPkt->GetPayload());
+		const bool result = s->Send(ipPkt->GetPayload());
+		SignalSession(Key);
+		return result;
 	}
 }
 
@@ -554,7 +801,12 @@ int SocketAdapter::SendFromConnection(ConnectionKey Key, IP_Packet* ipPkt)
 	BaseSession* s = nullptr;
 	connections.TryGetValue(Key, &s);
 	if (s != nullptr)
-		return s->Send(ipPkt->GetPayload()) ? 1 : 0;
+	{
+		const bool result = s->Send(ipPkt->GetPayload());
+		//Sending may have queued a reply, or unblocked receiving (ACKs, window updates)
+		SignalSession(Key);
+		return result ? 1 : 0;
+	}
 	else
 		return -1;
 }
@@ -563,6 +815,9 @@ void SocketAdapter::HandleConnectionClosed(BaseSession* sender)
 {
 	ConnectionKey key = sender->key;
 	connections.Remove(key);
+#ifdef __linux__
+	ForgetSessionSockets(key);
+#endif
 	//Note, we delete something that is calling us
 	//this is probably going to cause issues
 	delete sender;
@@ -592,6 +847,9 @@ void SocketAdapter::HandleFixedPortClosed(BaseSession* sender)
 	ConnectionKey key = sender->key;
 	connections.Remove(key);
 	fixedUDPPorts.Remove(key.ps2Port);
+#ifdef __linux__
+	ForgetSessionSockets(key);
+#endif
 	//Note, we delete something that is calling us
 	//this is probably going to cause issues
 	delete sender;
@@ -599,8 +857,37 @@ void SocketAdapter::HandleFixedPortClosed(BaseSession* sender)
 	Console.WriteLn("DEV9: Socket: Closed Dead UDP Fixed Port to %d", key.ps2Port);
 }
 
+void SocketAdapter::HandleSocketOpened(BaseSession* sender, uptr socket)
+{
+#ifdef __linux__
+	if (epollFd == -1)
+		return;
+
+	const int fd = static_cast<int>(socket);
+	{
+		std::lock_guard lock(readyMutex);
+		socketKeys[fd] = sender->key;
+	}
+
+	//Edge triggered, sessions are polled until Recv() returns nothing,
+	//and may leave data unread until the PS2 ACKs what it was sent
+	epoll_event event{};
+	event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	event.data.fd = fd;
+	int ret = epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+	//Fixed ports announce their socket for each new client
+	if (ret != 0 && errno == EEXIST)
+		ret = epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+
+	if (ret != 0)
+		Console.Error("DEV9: Socket: Failed to add socket to epoll. Error: %d", errno);
+#endif
+}
+
 void SocketAdapter::close()
 {
+	//Unblock the rx thread
+	Wake();
 }
 
 SocketAdapter::~SocketAdapter()
@@ -632,4 +919,14 @@ SocketAdapter::~SocketAdapter()
 
 		delete retPay;
 	}
+
+#ifdef __linux__
+	for (auto it = sessionStats.begin(); it != sessionStats.end(); ++it)
+		LogSessionStats(it->first, it->second);
+
+	if (wakeFd != -1)
+		::close(wakeFd);
+	if (epollFd != -1)
+		::close(epollFd);
+#endif
 }
@@ -14,6 +14,10 @@
  */
 
 #pragma once
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "net.h"
@@ -40,6 +44,38 @@ class SocketAdapter : public NetAdapter
 	ThreadSafeMap<Sessions::ConnectionKey, Sessions::BaseSession*> connections;
 	ThreadSafeMap<u16, Sessions::BaseSession*> fixedUDPPorts;
 
+	//Only accessed by the rx thread
+	std::vector<Sessions::ConnectionKey> recvKeys;
+
+#ifdef __linux__
+	//Sessions are only polled once epoll reports one of their sockets,
+	//or the PS2 sends to them. Everything is polled every SWEEP_INTERVAL
+	//regardless, for the timeouts handled in Recv()
+	static constexpr std::chrono::milliseconds SWEEP_INTERVAL{50};
+
+	struct SessionStats
+	{
+		bool queued = false;
+		//Packets received since the session last became ready
+		u32 depth = 0;
+		u32 maxDepth = 0;
+		u64 wakeups = 0;
+		u64 packets = 0;
+	};
+
+	int epollFd = -1;
+	int wakeFd = -1;
+
+	std::mutex readyMutex;
+	std::vector<Sessions::ConnectionKey> signalledKeys;
+	std::unordered_map<int, Sessions::ConnectionKey> socketKeys;
+
+	//Only accessed by the rx thread
+	std::deque<Sessions::ConnectionKey> readyQueue;
+	std::unordered_map<Sessions::ConnectionKey, SessionStats> sessionStats;
+	std::chrono::steady_clock::time_point nextSweep;
+#endif
+
 public:
 	SocketAdapter();
 	virtual bool blocks();
@@ -64,7 +100,26 @@ private:
 
 	int SendFromConnection(Sessions::ConnectionKey Key, PacketReader::IP::IP_Packet* ipPkt);
 
+	bool RecvFromSession(Sessions::BaseSession* session, NetPacket* pkt);
+	//Marks a session as having something to receive, called after the PS2 sends to it
+	void SignalSession(Sessions::ConnectionKey key);
+	//Wakes the rx thread if it's waiting in recv()
+	void Wake();
+
+#ifdef __linux__
+	bool InitEpoll();
+	bool RecvReady(NetPacket* pkt);
+	void WaitForEvents(int timeoutMs);
+	void QueueSession(Sessions::ConnectionKey key, bool wakeup);
+	void TakeSignalledSessions();
+	void SweepSessions();
+	//Called as a session closes, so socketKeys doesn't keep its sockets
+	void ForgetSessionSockets(Sessions::ConnectionKey key);
+	void LogSessionStats(Sessions::ConnectionKey key, const SessionStats& stats);
+#endif
+
 	//Event must only be raised once per connection
 	void HandleConnectionClosed(Sessions::BaseSession* sender);
 	void HandleFixedPortClosed(Sessions::BaseSession* sender);
+	void HandleSocketOpened(Sessions::BaseSession* sender, uptr socket);
 };
@@ -253,6 +253,10 @@ DEFINE_HOTKEY("SaveStateToSlot", "Save States", "Save State To Selected Slot", [
 	if (!pressed && VMManager::HasValidVM())
 		VMManager::SaveStateToSlot(s_current_save_slot);
 })
+DEFINE_HOTKEY("Rewind", "Save States", "Rewind (Hold)", [](s32 pressed) {
+	if (VMManager::HasValidVM())
+		VMManager::SetRewinding(pressed > 0);
+})
 DEFINE_HOTKEY("LoadStateFromSlot", "Save States", "Load State From Selected Slot", [](s32 pressed) {
 	if (!pressed && VMManager::HasValidVM())
 		HotkeyLoadStateSlot(s_current_save_slot);
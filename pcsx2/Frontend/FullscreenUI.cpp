@@ -2899,6 +2899,16 @@ void FullscreenUI::DrawEmulationSettingsPage()
 	DrawToggleSetting(bsi, "Adjust To Host Refresh Rate", "Speeds up emulation so that the guest refresh rate matches the host.",
 		"EmuCore/GS", "SyncToHostRefreshRate", false);
 
+	MenuHeading("Rewind");
+
+	const bool rewind_enabled = GetEffectiveBoolSetting(bsi, "EmuCore", "EnableRewind", false);
+	DrawToggleSetting(bsi, "Enable Rewind", "Keeps recent snapshots in memory, so the game can be rewound with the Rewind hotkey.",
+		"EmuCore", "EnableRewind", false);
+	DrawIntRangeSetting(bsi, "Snapshot Frequency", "Frames between rewind snapshots. Lower is smoother, but costs more.", "EmuCore",
+		"RewindFrequency", 10, 1, 600, "%d frames", rewind_enabled);
+	DrawIntRangeSetting(bsi, "Memory Budget", "Memory kept for rewind snapshots, the oldest are dropped once it's full.", "EmuCore",
+		"RewindBufferSizeMB", 512, 64, 8192, "%d MB", rewind_enabled);
+
 	EndMenuButtons();
 }
 
@@ -4179,6 +4189,9 @@ void FullscreenUI::DrawAdvancedSettingsPage()
 			"EmuCore/CPU/Recompiler", "EnableVU1", true);
 		DrawToggleSetting(bsi, "Enable VU Flag Optimization", "Good speedup and high compatibility, may cause graphical errors.",
 			"EmuCore/Speedhacks", "vuFlagHack", true);
+		DrawToggleSetting(bsi, "Enable VU Translation Cache",
+			"Remembers which VU programs and VIF unpacks a game uses, and compiles them when it next starts.", "EmuCore/CPU/Recompiler",
+			"EnableTranslationCache", false);
 
 		MenuHeading("I/O Processor");
 		DrawToggleSetting(bsi, "Enable IOP Recompiler",
@@ -25,16 +25,22 @@
 #include "common/Path.h"
 #include "common/ProgressCallback.h"
 #include "common/StringUtil.h"
+#include "common/ThreadPool.h"
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <string_view>
+#include <unordered_set>
 #include <utility>
 
 #include "CDVD/CDVD.h"
+#include "CDVD/IsoFS/IsoFS.h"
 #include "Elfheader.h"
 #include "VMManager.h"
 
@@ -42,13 +48,32 @@
 #include "common/RedtapeWindows.h"
 #endif
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <cerrno>
+#include <unistd.h>
+#endif
+
 namespace GameList
 {
 	enum : u32
 	{
 		GAME_LIST_CACHE_SIGNATURE = 0x45434C47,
-		GAME_LIST_CACHE_VERSION = 32,
+		GAME_LIST_CACHE_VERSION = 33,
+
+		// Threads listing directories and reading ahead of the prober, and how far ahead they read.
+		// Images which can't be walked (compressed ones) only have their first megabyte read, where
+		// the headers and block indices are.
+		SCAN_IO_THREADS = 4,
+		SCAN_PREFETCH_FILES = 8,
+		SCAN_PREFETCH_SIZE = 1024 * 1024,
+		SCAN_PREFETCH_CHUNK_SIZE = 64 * 1024,
 
+		// Records appended to the cache over older ones for the same path are only dropped once
+		// there are this many times more records than games, plus some slack for small lists.
+		CACHE_COMPACT_RATIO = 2,
+		CACHE_COMPACT_SLACK = 64,
 
 		PLAYED_TIME_SERIAL_LENGTH = 32,
 		PLAYED_TIME_LAST_TIME_LENGTH = 20, // uint64
@@ -73,20 +98,44 @@ namespace GameList
 	static bool GetIsoListEntry(const std::string& path, GameList::Entry* entry);
 
 	static bool GetGameListEntryFromCache(const std::string& path, GameList::Entry* entry);
-	static void ScanDirectory(const char* path, bool recursive, bool only_cache, const std::vector<std::string>& excluded_paths,
-		const PlayedTimeMap& played_time_map, ProgressCallback* progress);
-	static bool AddFileFromCache(const std::string& path, std::time_t timestamp, const PlayedTimeMap& played_time_map);
+	static FileSystem::FindResultsArray FindDirectoryFiles(const std::string& path, bool recursive);
+	static void PrefetchFile(const std::string& path);
+	static void ScanDirectory(const char* path, bool recursive, bool only_cache, FileSystem::FindResultsArray files,
+		const std::vector<std::string>& excluded_paths, const PlayedTimeMap& played_time_map, cb::ThreadPool& pool,
+		ProgressCallback* progress);
+	static bool AddFileFromCache(const std::string& path, u64 size, std::time_t timestamp, const PlayedTimeMap& played_time_map);
 	static bool ScanFile(
 		std::string path, std::time_t timestamp, std::unique_lock<std::recursive_mutex>& lock, const PlayedTimeMap& played_time_map);
+	static void FinishRefresh(bool only_cache);
 
 	static void LoadCache();
-	static bool LoadEntriesFromCache(std::FILE* stream);
+	static bool LoadEntriesFromCache(const u8* data, size_t size, size_t* valid_size);
+	static void AppendEntryToBuffer(std::vector<u8>& buffer, const GameList::Entry& entry);
 	static bool OpenCacheForWriting();
 	static bool WriteEntryToCache(const GameList::Entry* entry);
 	static void CloseCacheFileStream();
 	static void DeleteCacheFile();
 	static void RewriteCacheFile();
 
+#ifdef __linux__
+	// Watches added by one directory listing, they're only made visible once the scan is complete.
+	struct ListingWatches
+	{
+		std::vector<std::pair<int, std::string>> added;
+		bool failed = false;
+	};
+
+	static std::vector<std::string> GetWatchConfig(const std::vector<std::string>& dirs,
+		const std::vector<std::string>& recursive_dirs, const std::vector<std::string>& excluded_paths);
+	static bool IsNetworkFilesystem(const std::string& path);
+	static bool OpenWatches(const std::vector<std::string>& dirs, const std::vector<std::string>& recursive_dirs);
+	static FileSystem::FindResultsArray WatchAndFindDirectoryFiles(const std::string& path, bool recursive, ListingWatches* watches);
+	static void FinishWatches(size_t num_dirs, const std::vector<ListingWatches>& watches, std::vector<std::string> config);
+	static void CloseWatches();
+	static bool RefreshChangedDirectories(const std::vector<std::string>& config, const std::vector<std::string>& excluded_paths,
+		ProgressCallback* progress);
+#endif
+
 	static std::string GetPlayedTimeFile();
 	static bool ParsePlayedTimeLine(char* line, std::string& serial, PlayedTimeEntry& entry);
 	static std::string MakePlayedTimeLine(const std::string& serial, const PlayedTimeEntry& entry);
@@ -99,6 +148,20 @@ static std::vector<GameList::Entry> s_entries;
 static std::recursive_mutex s_mutex;
 static GameList::CacheMap s_cache_map;
 static std::FILE* s_cache_write_stream = nullptr;
+static size_t s_cache_record_count = 0;
+
+#ifdef __linux__
+// inotify watches on every directory of the last full scan, so the next refresh only has to look
+// through the directories which changed. Only touched by Refresh().
+struct WatchedDirectory
+{
+	std::string path;
+	bool recursive;
+};
+static int s_watch_fd = -1;
+static std::unordered_map<int, WatchedDirectory> s_watch_dirs;
+static std::vector<std::string> s_watch_config;
+#endif
 
 const char* GameList::EntryTypeToString(EntryType type)
 {
@@ -366,70 +429,99 @@ bool GameList::GetGameListEntryFromCache(const std::string& path, GameList::Entr
 	return true;
 }
 
-static bool ReadString(std::FILE* stream, std::string* dest)
+namespace
 {
-	u32 size;
-	if (std::fread(&size, sizeof(size), 1, stream) != 1)
-		return false;
+	// Reads fields out of one cache record, failing once it runs past the end.
+	class CacheReader
+	{
+	public:
+		CacheReader(const u8* data, size_t size)
+			: m_ptr(data)
+			, m_end(data + size)
+		{
+		}
 
-	dest->resize(size);
-	if (size > 0 && std::fread(dest->data(), size, 1, stream) != 1)
-		return false;
+		bool ReadString(std::string* dest)
+		{
+			u32 size;
+			if (!Read(&size, sizeof(size)) || static_cast<size_t>(m_end - m_ptr) < size)
+				return false;
 
-	return true;
-}
+			dest->assign(reinterpret_cast<const char*>(m_ptr), size);
+			m_ptr += size;
+			return true;
+		}
 
-static bool ReadU8(std::FILE* stream, u8* dest)
-{
-	return std::fread(dest, sizeof(u8), 1, stream) > 0;
-}
+		bool ReadU8(u8* dest) { return Read(dest, sizeof(u8)); }
+		bool ReadU32(u32* dest) { return Read(dest, sizeof(u32)); }
+		bool ReadU64(u64* dest) { return Read(dest, sizeof(u64)); }
 
-static bool ReadU32(std::FILE* stream, u32* dest)
-{
-	return std::fread(dest, sizeof(u32), 1, stream) > 0;
-}
+	private:
+		bool Read(void* dest, size_t size)
+		{
+			if (static_cast<size_t>(m_end - m_ptr) < size)
+				return false;
+
+			std::memcpy(dest, m_ptr, size);
+			m_ptr += size;
+			return true;
+		}
 
-static bool ReadU64(std::FILE* stream, u64* dest)
+		const u8* m_ptr;
+		const u8* m_end;
+	};
+} // namespace
+
+static void WriteBytes(std::vector<u8>& buffer, const void* data, size_t size)
 {
-	return std::fread(dest, sizeof(u64), 1, stream) > 0;
+	const u8* ptr = static_cast<const u8*>(data);
+	buffer.insert(buffer.end(), ptr, ptr + size);
 }
 
-static bool WriteString(std::FILE* stream, const std::string& str)
+static void WriteString(std::vector<u8>& buffer, const std::string& str)
 {
 	const u32 size = static_cast<u32>(str.size());
-	return (std::fwrite(&size, sizeof(size), 1, stream) > 0 && (size == 0 || std::fwrite(str.data(), size, 1, stream) > 0));
+	WriteBytes(buffer, &size, sizeof(size));
+	WriteBytes(buffer, str.data(), size);
 }
 
-static bool WriteU8(std::FILE* stream, u8 dest)
+static void WriteU8(std::vector<u8>& buffer, u8 value)
 {
-	return std::fwrite(&dest, sizeof(u8), 1, stream) > 0;
+	buffer.push_back(value);
 }
 
-static bool WriteU32(std::FILE* stream, u32 dest)
+static void WriteU32(std::vector<u8>& buffer, u32 value)
 {
-	return std::fwrite(&dest, sizeof(u32), 1, stream) > 0;
+	WriteBytes(buffer, &value, sizeof(value));
 }
 
-static bool WriteU64(std::FILE* stream, u64 dest)
+static void WriteU64(std::vector<u8>& buffer, u64 value)
 {
-	return std::fwrite(&dest, sizeof(u64), 1, stream) > 0;
+	WriteBytes(buffer, &value, sizeof(value));
 }
 
-bool GameList::LoadEntriesFromCache(std::FILE* stream)
+bool GameList::LoadEntriesFromCache(const u8* data, size_t size, size_t* valid_size)
 {
-	u32 file_signature, file_version;
-	s64 start_pos, file_size;
-	if (!ReadU32(stream, &file_signature) || !ReadU32(stream, &file_version) || file_signature != GAME_LIST_CACHE_SIGNATURE ||
-		file_version != GAME_LIST_CACHE_VERSION || (start_pos = FileSystem::FTell64(stream)) < 0 ||
-		FileSystem::FSeek64(stream, 0, SEEK_END) != 0 || (file_size = FileSystem::FTell64(stream)) < 0 ||
-		FileSystem::FSeek64(stream, start_pos, SEEK_SET) != 0)
+	u32 header[2] = {};
+	if (size >= sizeof(header))
+		std::memcpy(header, data, sizeof(header));
+	if (header[0] != GAME_LIST_CACHE_SIGNATURE || header[1] != GAME_LIST_CACHE_VERSION)
 	{
 		Console.Warning("Game list cache is corrupted");
 		return false;
 	}
 
-	while (FileSystem::FTell64(stream) != file_size)
+	// Each record is prefixed with its size, so one cut short by a crash while appending shows up
+	// as running past the end of the file, rather than as garbage.
+	size_t pos = sizeof(header);
+	while (size - pos >= sizeof(u32))
 	{
+		u32 record_size;
+		std::memcpy(&record_size, data + pos, sizeof(record_size));
+		if (size - pos - sizeof(u32) < record_size)
+			break;
+
+		CacheReader reader(data + pos + sizeof(u32), record_size);
 		std::string path;
 		GameList::Entry ge;
 
@@ -438,9 +530,9 @@ bool GameList::LoadEntriesFromCache(std::FILE* stream)
 		u8 compatibility_rating;
 		u64 last_modified_time;
 
-		if (!ReadString(stream, &path) || !ReadString(stream, &ge.serial) || !ReadString(stream, &ge.title) || !ReadU8(stream, &type) ||
-			!ReadU8(stream, &region) || !ReadU64(stream, &ge.total_size) || !ReadU64(stream, &last_modified_time) ||
-			!ReadU32(stream, &ge.crc) || !ReadU8(stream, &compatibility_rating) || region >= static_cast<u8>(Region::Count) ||
+		if (!reader.ReadString(&path) || !reader.ReadString(&ge.serial) || !reader.ReadString(&ge.title) || !reader.ReadU8(&type) ||
+			!reader.ReadU8(&region) || !reader.ReadU64(&ge.total_size) || !reader.ReadU64(&last_modified_time) ||
+			!reader.ReadU32(&ge.crc) || !reader.ReadU8(&compatibility_rating) || region >= static_cast<u8>(Region::Count) ||
 			type >= static_cast<u8>(EntryType::Count) || compatibility_rating > static_cast<u8>(CompatibilityRating::Perfect))
 		{
 			Console.Warning("Game list cache entry is corrupted");
@@ -458,8 +550,12 @@ bool GameList::LoadEntriesFromCache(std::FILE* stream)
 			iter->second = std::move(ge);
 		else
 			s_cache_map.emplace(std::move(path), std::move(ge));
+
+		pos += sizeof(u32) + record_size;
+		s_cache_record_count++;
 	}
 
+	*valid_size = pos;
 	return true;
 }
 
@@ -470,19 +566,51 @@ static std::string GetCacheFilename()
 
 void GameList::LoadCache()
 {
+	s_cache_record_count = 0;
+
 	const std::string cache_filename(GetCacheFilename());
-	auto stream = FileSystem::OpenManagedCFile(cache_filename.c_str(), "rb");
-	if (!stream)
+	std::optional<std::vector<u8>> data(FileSystem::ReadBinaryFile(cache_filename.c_str()));
+	if (!data.has_value())
 		return;
 
-	if (!LoadEntriesFromCache(stream.get()))
+	size_t valid_size = 0;
+	if (!LoadEntriesFromCache(data->data(), data->size(), &valid_size))
 	{
 		Console.Warning("Deleting corrupted cache file '%s'", cache_filename.c_str());
-		stream.reset();
 		s_cache_map.clear();
 		DeleteCacheFile();
 		return;
 	}
+
+	// Everything up to the record which was being written is fine, keep that.
+	if (valid_size != data->size())
+	{
+		Console.Warning("Dropping incomplete entry from the end of game list cache '%s'", cache_filename.c_str());
+		if (!FileSystem::WriteBinaryFile(cache_filename.c_str(), data->data(), valid_size))
+		{
+			s_cache_map.clear();
+			DeleteCacheFile();
+		}
+	}
+}
+
+void GameList::AppendEntryToBuffer(std::vector<u8>& buffer, const Entry& entry)
+{
+	const size_t size_pos = buffer.size();
+	WriteU32(buffer, 0);
+
+	WriteString(buffer, entry.path);
+	WriteString(buffer, entry.serial);
+	WriteString(buffer, entry.title);
+	WriteU8(buffer, static_cast<u8>(entry.type));
+	WriteU8(buffer, static_cast<u8>(entry.region));
+	WriteU64(buffer, entry.total_size);
+	WriteU64(buffer, static_cast<u64>(entry.last_modified_time));
+	WriteU32(buffer, entry.crc);
+	WriteU8(buffer, static_cast<u8>(entry.compatibility_rating));
+
+	const u32 record_size = static_cast<u32>(buffer.size() - size_pos - sizeof(u32));
+	std::memcpy(&buffer[size_pos], &record_size, sizeof(record_size));
 }
 
 bool GameList::OpenCacheForWriting()
@@ -496,10 +624,9 @@ bool GameList::OpenCacheForWriting()
 	if (s_cache_write_stream)
 	{
 		// check the header
-		u32 signature, version;
-		if (ReadU32(s_cache_write_stream, &signature) && signature == GAME_LIST_CACHE_SIGNATURE &&
-			ReadU32(s_cache_write_stream, &version) && version == GAME_LIST_CACHE_VERSION &&
-			FileSystem::FSeek64(s_cache_write_stream, 0, SEEK_END) == 0)
+		u32 header[2];
+		if (std::fread(header, sizeof(header), 1, s_cache_write_stream) == 1 && header[0] == GAME_LIST_CACHE_SIGNATURE &&
+			header[1] == GAME_LIST_CACHE_VERSION && FileSystem::FSeek64(s_cache_write_stream, 0, SEEK_END) == 0)
 		{
 			return true;
 		}
@@ -513,9 +640,11 @@ bool GameList::OpenCacheForWriting()
 	if (!s_cache_write_stream)
 		return false;
 
+	s_cache_record_count = 0;
 
 	// new cache file, write header
-	if (!WriteU32(s_cache_write_stream, GAME_LIST_CACHE_SIGNATURE) || !WriteU32(s_cache_write_stream, GAME_LIST_CACHE_VERSION))
+	const u32 header[2] = {GAME_LIST_CACHE_SIGNATURE, GAME_LIST_CACHE_VERSION};
+	if (std::fwrite(header, sizeof(header), 1, s_cache_write_stream) != 1)
 	{
 		Console.Error("Failed to write game list cache header");
 		std::fclose(s_cache_write_stream);
@@ -529,20 +658,13 @@ bool GameList::OpenCacheForWriting()
 
 bool GameList::WriteEntryToCache(const Entry* entry)
 {
-	bool result = true;
-	result &= WriteString(s_cache_write_stream, entry->path);
-	result &= WriteString(s_cache_write_stream, entry->serial);
-	result &= WriteString(s_cache_write_stream, entry->title);
-	result &= WriteU8(s_cache_write_stream, static_cast<u8>(entry->type));
-	result &= WriteU8(s_cache_write_stream, static_cast<u8>(entry->region));
-	result &= WriteU64(s_cache_write_stream, entry->total_size);
-	result &= WriteU64(s_cache_write_stream, static_cast<u64>(entry->last_modified_time));
-	result &= WriteU32(s_cache_write_stream, entry->crc);
-	result &= WriteU8(s_cache_write_stream, static_cast<u8>(entry->compatibility_rating));
+	std::vector<u8> record;
+	AppendEntryToBuffer(record, *entry);
 
 	// flush after each entry, that way we don't end up with a corrupted file if we crash scanning.
+	const bool result = (std::fwrite(record.data(), record.size(), 1, s_cache_write_stream) == 1 && std::fflush(s_cache_write_stream) == 0);
 	if (result)
-		result = (std::fflush(s_cache_write_stream) == 0);
+		s_cache_record_count++;
 
 	return result;
 }
@@ -559,6 +681,7 @@ void GameList::CloseCacheFileStream()
 void GameList::DeleteCacheFile()
 {
 	pxAssert(!s_cache_write_stream);
+	s_cache_record_count = 0;
 
 	const std::string cache_filename(GetCacheFilename());
 	if (cache_filename.empty() || !FileSystem::FileExists(cache_filename.c_str()))
@@ -573,15 +696,30 @@ void GameList::DeleteCacheFile()
 void GameList::RewriteCacheFile()
 {
 	CloseCacheFileStream();
-	DeleteCacheFile();
 
-	if (OpenCacheForWriting())
-	{
-		for (const GameList::Entry& entry : s_entries)
-			WriteEntryToCache(&entry);
+	const std::string cache_filename(GetCacheFilename());
+	if (cache_filename.empty())
+		return;
+
+	std::vector<u8> data;
+	WriteU32(data, GAME_LIST_CACHE_SIGNATURE);
+	WriteU32(data, GAME_LIST_CACHE_VERSION);
+	for (const GameList::Entry& entry : s_entries)
+		AppendEntryToBuffer(data, entry);
+
+	// Cache entries which weren't used this time around are still good, the files might just be on
+	// a drive which isn't connected right now.
+	for (const auto& it : s_cache_map)
+		AppendEntryToBuffer(data, it.second);
 
-		CloseCacheFileStream();
+	if (!FileSystem::WriteBinaryFile(cache_filename.c_str(), data.data(), data.size()))
+	{
+		Console.Warning("Failed to rewrite game list cache '%s'", cache_filename.c_str());
+		DeleteCacheFile();
+		return;
 	}
+
+	s_cache_record_count = s_entries.size() + s_cache_map.size();
 }
 
 static bool IsPathExcluded(const std::vector<std::string>& excluded_paths, const std::string& path)
@@ -589,52 +727,220 @@ static bool IsPathExcluded(const std::vector<std::string>& excluded_paths, const
 	return (std::find(excluded_paths.begin(), excluded_paths.end(), path) != excluded_paths.end());
 }
 
-void GameList::ScanDirectory(const char* path, bool recursive, bool only_cache, const std::vector<std::string>& excluded_paths,
-	const PlayedTimeMap& played_time_map, ProgressCallback* progress)
+FileSystem::FindResultsArray GameList::FindDirectoryFiles(const std::string& path, bool recursive)
+{
+	u32 flags = FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES;
+	if (recursive)
+		flags |= FILESYSTEM_FIND_RECURSIVE;
+
+	FileSystem::FindResultsArray files;
+	FileSystem::FindFiles(path.c_str(), "*", flags, &files);
+	return files;
+}
+
+namespace
+{
+	// Reads sectors straight from an uncompressed image, for the prefetcher. The layouts are the
+	// ones InputIsoFile::Detect() tries.
+	class PrefetchSectorSource final : public SectorSource
+	{
+	public:
+		explicit PrefetchSectorSource(std::FILE* fp)
+			: m_fp(fp)
+		{
+		}
+
+		bool Detect()
+		{
+			struct Layout
+			{
+				u32 blocksize;
+				s32 offset;
+				s32 blockofs;
+			};
+			static constexpr Layout layouts[] = {{2048, 0, 24}, {2336, 0, 16}, {2352, 0, 0}, {2448, 0, 0}, {2048, 150 * 2048, 24},
+				{2352, 150 * 2048, 0}, {2448, 150 * 2048, 0}, {2048, -8, 24}, {2352, -8, 0}, {2448, -8, 0}};
+
+			u8 pvd[IsoFile::sectorLength];
+			for (const Layout& layout : layouts)
+			{
+				// The ISO sector data starts 24 bytes into the block, less what the block is missing.
+				m_blocksize = layout.blocksize;
+				m_data_offset = layout.offset + (24 - layout.blockofs);
+				if (readSector(pvd, 16) && std::memcmp(pvd + 1, "CD001", 5) == 0)
+					return true;
+			}
+
+			return false;
+		}
+
+		int getNumSectors() override
+		{
+			return static_cast<int>(FileSystem::FSize64(m_fp) / m_blocksize);
+		}
+
+		bool readSector(unsigned char* buffer, int lba) override
+		{
+			// Seeking throws away what stdio has buffered, so skip it for the next sector of a 2048 byte image.
+			const s64 pos = m_data_offset + static_cast<s64>(lba) * m_blocksize;
+			if (pos != m_pos && FileSystem::FSeek64(m_fp, pos, SEEK_SET) != 0)
+			{
+				m_pos = -1;
+				return false;
+			}
+
+			if (std::fread(buffer, IsoFile::sectorLength, 1, m_fp) != 1)
+			{
+				m_pos = -1;
+				return false;
+			}
+
+			m_pos = pos + IsoFile::sectorLength;
+			return true;
+		}
+
+	private:
+		std::FILE* m_fp;
+		u32 m_blocksize = 0;
+		s64 m_data_offset = 0;
+		s64 m_pos = 0;
+	};
+} // namespace
+
+void GameList::PrefetchFile(const std::string& path)
+{
+	auto fp = FileSystem::OpenManagedCFile(path.c_str(), "rb");
+	if (!fp)
+		return;
+
+	// The data is thrown away, this is only to have it in the OS's cache by the time it's probed.
+	std::unique_ptr<u8[]> buffer = std::make_unique<u8[]>(SCAN_PREFETCH_CHUNK_SIZE);
+
+	// The probe walks the filesystem to SYSTEM.CNF, then reads the whole boot ELF for its CRC, which
+	// is usually far past the start of the disc. Do the same walk, so those reads are cached too.
+	PrefetchSectorSource source(fp.get());
+	if (source.Detect())
+	{
+		// Direct I/O reads don't go through the OS's cache, so they can't be helped.
+		if (Host::GetBaseBoolSettingValue("EmuCore", "CdvdDirectIO", false))
+			return;
+
+		try
+		{
+			IsoDirectory root(source);
+			IsoFile cnf(root, "SYSTEM.CNF;1");
+
+			std::string elf;
+			while (!cnf.eof())
+			{
+				const std::string line(cnf.readLine());
+				std::string_view key, value;
+				if (StringUtil::ParseAssignmentString(line, &key, &value) && key == "BOOT2")
+					elf = value;
+			}
+
+			// PS1 discs (BOOT) don't have their executable read.
+			if (elf.empty())
+				return;
+
+			// Same as loadElf(), the version on the BOOT2 line is ignored.
+			const std::string::size_type semi_pos = elf.rfind(';');
+			if (semi_pos != std::string::npos)
+				elf.erase(semi_pos);
+			elf += ";1";
+
+			IsoFile file(root, elf);
+			for (u32 remaining = file.getLength(); remaining > 0;)
+			{
+				const s32 read = file.read(buffer.get(), static_cast<s32>(std::min<u32>(remaining, SCAN_PREFETCH_CHUNK_SIZE)));
+				if (read <= 0)
+					break;
+				remaining -= static_cast<u32>(read);
+			}
+		}
+		catch (...)
+		{
+			// Not a game, or a broken image, the probe will find out.
+		}
+
+		return;
+	}
+
+	for (u32 offset = 0; offset < SCAN_PREFETCH_SIZE; offset += SCAN_PREFETCH_CHUNK_SIZE)
+	{
+		if (std::fread(buffer.get(), 1, SCAN_PREFETCH_CHUNK_SIZE, fp.get()) != SCAN_PREFETCH_CHUNK_SIZE)
+			break;
+	}
+}
+
+void GameList::ScanDirectory(const char* path, bool recursive, bool only_cache, FileSystem::FindResultsArray files,
+	const std::vector<std::string>& excluded_paths, const PlayedTimeMap& played_time_map, cb::ThreadPool& pool,
+	ProgressCallback* progress)
 {
 	Console.WriteLn("Scanning %s%s", path, recursive ? " (recursively)" : "");
 
 	progress->PushState();
 	progress->SetFormattedStatusText("Scanning directory '%s'%s...", path, recursive ? " (recursively)" : "");
 
-	FileSystem::FindResultsArray files;
-	FileSystem::FindFiles(path, "*",
-		recursive ? (FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES | FILESYSTEM_FIND_RECURSIVE) :
-                    (FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES),
-		&files);
-
 	u32 files_scanned = 0;
 	progress->SetProgressRange(static_cast<u32>(files.size()));
 	progress->SetProgressValue(0);
 
+	// Take everything unchanged from the cache first, leaving the files which have to be probed.
+	std::vector<FILESYSTEM_FIND_DATA*> to_scan;
 	for (FILESYSTEM_FIND_DATA& ffd : files)
 	{
-		files_scanned++;
-
 		if (progress->IsCancelled() || !GameList::IsScannableFilename(ffd.FileName) || IsPathExcluded(excluded_paths, ffd.FileName))
 		{
+			files_scanned++;
 			continue;
 		}
 
 		std::unique_lock lock(s_mutex);
-		if (GetEntryForPath(ffd.FileName.c_str()) || AddFileFromCache(ffd.FileName, ffd.ModificationTime, played_time_map) || only_cache)
+		if (GetEntryForPath(ffd.FileName.c_str()) || AddFileFromCache(ffd.FileName, ffd.Size, ffd.ModificationTime, played_time_map) ||
+			only_cache)
 		{
+			files_scanned++;
 			continue;
 		}
 
+		to_scan.push_back(&ffd);
+	}
+
+	progress->SetProgressValue(files_scanned);
+
+	// Probing goes through the global CDVD state, so it can only be done for one file at a time. The
+	// start of the next few files is read on the pool meanwhile, so on a slow drive or a network
+	// share the probe doesn't wait for every file's first read in turn.
+	std::deque<std::future<void>> prefetches;
+	size_t next_prefetch = 0;
+	for (size_t i = 0; i < to_scan.size(); i++)
+	{
+		if (progress->IsCancelled())
+			break;
+
+		for (; next_prefetch < to_scan.size() && next_prefetch < i + SCAN_PREFETCH_FILES; next_prefetch++)
+			prefetches.push_back(pool.ScheduleAndGetFuture([path = to_scan[next_prefetch]->FileName]() { PrefetchFile(path); }));
+
+		prefetches.front().wait();
+		prefetches.pop_front();
+
+		FILESYSTEM_FIND_DATA& ffd = *to_scan[i];
 		progress->SetFormattedStatusText("Scanning '%s'...", FileSystem::GetDisplayNameFromPath(ffd.FileName).c_str());
+
+		std::unique_lock lock(s_mutex);
 		ScanFile(std::move(ffd.FileName), ffd.ModificationTime, lock, played_time_map);
-		progress->SetProgressValue(files_scanned);
+		progress->SetProgressValue(++files_scanned);
 	}
 
-	progress->SetProgressValue(files_scanned);
+	progress->SetProgressValue(static_cast<u32>(files.size()));
 	progress->PopState();
 }
 
-bool GameList::AddFileFromCache(const std::string& path, std::time_t timestamp, const PlayedTimeMap& played_time_map)
+bool GameList::AddFileFromCache(const std::string& path, u64 size, std::time_t timestamp, const PlayedTimeMap& played_time_map)
 {
 	Entry entry;
-	if (!GetGameListEntryFromCache(path, &entry) || entry.last_modified_time != timestamp)
+	if (!GetGameListEntryFromCache(path, &entry) || entry.last_modified_time != timestamp || entry.total_size != size)
 		return false;
 
 	auto iter = UnorderedStringMapFind(played_time_map, entry.serial);
@@ -742,6 +1048,22 @@ void GameList::Refresh(bool invalidate_cache, bool only_cache, ProgressCallback*
 	if (!progress)
 		progress = ProgressCallback::NullProgressCallback;
 
+	const std::vector<std::string> excluded_paths(Host::GetBaseStringListSetting("GameList", "ExcludedPaths"));
+	const std::vector<std::string> dirs(Host::GetBaseStringListSetting("GameList", "Paths"));
+	const std::vector<std::string> recursive_dirs(Host::GetBaseStringListSetting("GameList", "RecursivePaths"));
+
+#ifdef __linux__
+	std::vector<std::string> watch_config(GetWatchConfig(dirs, recursive_dirs, excluded_paths));
+	if (!invalidate_cache && !only_cache && RefreshChangedDirectories(watch_config, excluded_paths, progress))
+		return;
+
+	// Every directory is watched before it's listed, so whatever changes while the scan is running either
+	// makes it into the listing, or shows up as an event for the next refresh.
+	CloseWatches();
+	const bool watch = !only_cache && OpenWatches(dirs, recursive_dirs);
+	std::vector<ListingWatches> watches(watch ? (dirs.size() + recursive_dirs.size()) : 0);
+#endif
+
 	if (invalidate_cache)
 		DeleteCacheFile();
 	else
@@ -754,9 +1076,6 @@ void GameList::Refresh(bool invalidate_cache, bool only_cache, ProgressCallback*
 		old_entries.swap(s_entries);
 	}
 
-	const std::vector<std::string> excluded_paths(Host::GetBaseStringListSetting("GameList", "ExcludedPaths"));
-	const std::vector<std::string> dirs(Host::GetBaseStringListSetting("GameList", "Paths"));
-	const std::vector<std::string> recursive_dirs(Host::GetBaseStringListSetting("GameList", "RecursivePaths"));
 	const PlayedTimeMap played_time(LoadPlayedTimeMap(GetPlayedTimeFile()));
 
 	if (!dirs.empty() || !recursive_dirs.empty())
@@ -764,31 +1083,304 @@ void GameList::Refresh(bool invalidate_cache, bool only_cache, ProgressCallback*
 		progress->SetProgressRange(static_cast<u32>(dirs.size() + recursive_dirs.size()));
 		progress->SetProgressValue(0);
 
+		// Listing is mostly waiting on the filesystem, so all the directories are listed at once,
+		// and scanned in order as their listings come in.
+		cb::ThreadPool pool(SCAN_IO_THREADS);
+		std::vector<std::future<FileSystem::FindResultsArray>> listings;
+		listings.reserve(dirs.size() + recursive_dirs.size());
+		for (size_t i = 0; i < dirs.size() + recursive_dirs.size(); i++)
+		{
+			const bool recursive = (i >= dirs.size());
+			const std::string& dir = recursive ? recursive_dirs[i - dirs.size()] : dirs[i];
+#ifdef __linux__
+			if (watch)
+			{
+				listings.push_back(pool.ScheduleAndGetFuture(
+					[&dir, recursive, dir_watches = &watches[i]]() { return WatchAndFindDirectoryFiles(dir, recursive, dir_watches); }));
+				continue;
+			}
+#endif
+			listings.push_back(pool.ScheduleAndGetFuture([&dir, recursive]() { return FindDirectoryFiles(dir, recursive); }));
+		}
+
 		// we manually count it here, because otherwise pop state updates it itself
 		int directory_counter = 0;
-		for (const std::string& dir : dirs)
+		for (size_t i = 0; i < listings.size(); i++)
 		{
 			if (progress->IsCancelled())
 				break;
 
-			ScanDirectory(dir.c_str(), false, only_cache, excluded_paths, played_time, progress);
+			const bool recursive = (i >= dirs.size());
+			const std::string& dir = recursive ? recursive_dirs[i - dirs.size()] : dirs[i];
+			ScanDirectory(dir.c_str(), recursive, only_cache, listings[i].get(), excluded_paths, played_time, pool, progress);
 			progress->SetProgressValue(++directory_counter);
 		}
-		for (const std::string& dir : recursive_dirs)
+	}
+
+#ifdef __linux__
+	// The directories which weren't scanned have changes which would otherwise be lost.
+	if (watch && progress->IsCancelled())
+		CloseWatches();
+	else if (watch)
+		FinishWatches(dirs.size(), watches, std::move(watch_config));
+#endif
+
+	FinishRefresh(only_cache);
+}
+
+void GameList::FinishRefresh(bool only_cache)
+{
+	CloseCacheFileStream();
+
+	// Rescans append over the old record, drop those once they outnumber the games.
+	if (!only_cache && s_cache_record_count > CACHE_COMPACT_RATIO * (s_entries.size() + s_cache_map.size()) + CACHE_COMPACT_SLACK)
+	{
+		Console.WriteLn("Compacting game list cache (%zu records, %zu games)", s_cache_record_count,
+			s_entries.size() + s_cache_map.size());
+		RewriteCacheFile();
+	}
+
+	// don't need unused cache entries
+	s_cache_map.clear();
+	s_cache_record_count = 0;
+}
+
+#ifdef __linux__
+
+std::vector<std::string> GameList::GetWatchConfig(
+	const std::vector<std::string>& dirs, const std::vector<std::string>& recursive_dirs, const std::vector<std::string>& excluded_paths)
+{
+	// Paths can't be empty, so the empty strings keep the three lists apart.
+	std::vector<std::string> config(dirs);
+	config.emplace_back();
+	config.insert(config.end(), recursive_dirs.begin(), recursive_dirs.end());
+	config.emplace_back();
+	config.insert(config.end(), excluded_paths.begin(), excluded_paths.end());
+	return config;
+}
+
+bool GameList::IsNetworkFilesystem(const std::string& path)
+{
+	struct statfs sfs;
+	if (statfs(path.c_str(), &sfs) != 0)
+		return true;
+
+	switch (static_cast<u32>(sfs.f_type))
+	{
+		case 0x6969: // NFS
+		case 0x517B: // SMB
+		case 0xFF534D42: // CIFS
+		case 0xFE534D42: // SMB2
+		case 0x65735546: // FUSE, sshfs and the like
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool GameList::OpenWatches(const std::vector<std::string>& dirs, const std::vector<std::string>& recursive_dirs)
+{
+	pxAssert(s_watch_fd < 0);
+
+	// inotify only hears about changes made by this machine, not ones made on the server, or by
+	// other clients of a network share.
+	for (const std::vector<std::string>* list : {&dirs, &recursive_dirs})
+	{
+		for (const std::string& dir : *list)
 		{
-			if (progress->IsCancelled())
+			if (IsNetworkFilesystem(dir))
+			{
+				Console.WriteLn("'%s' is on a network filesystem, game list refreshes will scan every directory.", dir.c_str());
+				return false;
+			}
+		}
+	}
+
+	s_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (s_watch_fd < 0)
+	{
+		Console.Warning("inotify_init1() failed: %d", errno);
+		return false;
+	}
+
+	return true;
+}
+
+FileSystem::FindResultsArray GameList::WatchAndFindDirectoryFiles(const std::string& path, bool recursive, ListingWatches* watches)
+{
+	// Subdirectories are walked here instead of by FindFiles(), so that each one is watched before
+	// it's read too. Runs on the listing pool, the watches are only added to s_watch_dirs afterwards.
+	FileSystem::FindResultsArray files;
+	std::vector<std::string> pending{path};
+	while (!pending.empty())
+	{
+		const std::string dir(std::move(pending.back()));
+		pending.pop_back();
+
+		if (!watches->failed)
+		{
+			const int wd = inotify_add_watch(s_watch_fd, dir.c_str(),
+				IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF);
+			if (wd >= 0)
+			{
+				watches->added.emplace_back(wd, dir);
+			}
+			else
+			{
+				// Most likely out of watches (fs.inotify.max_user_watches).
+				Console.Warning("Failed to watch '%s' for changes (%d), game list refreshes will scan every directory.", dir.c_str(), errno);
+				watches->failed = true;
+			}
+		}
+
+		FileSystem::FindResultsArray dir_files;
+		FileSystem::FindFiles(dir.c_str(), "*", FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES | (recursive ? FILESYSTEM_FIND_FOLDERS : 0),
+			&dir_files);
+		for (FILESYSTEM_FIND_DATA& ffd : dir_files)
+		{
+			if (ffd.Attributes & FILESYSTEM_FILE_ATTRIBUTE_DIRECTORY)
+				pending.push_back(std::move(ffd.FileName));
+			else
+				files.push_back(std::move(ffd));
+		}
+	}
+
+	return files;
+}
+
+void GameList::FinishWatches(size_t num_dirs, const std::vector<ListingWatches>& watches, std::vector<std::string> config)
+{
+	for (size_t i = 0; i < watches.size(); i++)
+	{
+		if (watches[i].failed)
+		{
+			CloseWatches();
+			return;
+		}
+
+		const bool recursive = (i >= num_dirs);
+		for (const auto& [wd, dir] : watches[i].added)
+			s_watch_dirs[wd] = WatchedDirectory{dir, recursive};
+	}
+
+	s_watch_config = std::move(config);
+	DevCon.WriteLn("Watching %zu game list directories for changes", s_watch_dirs.size());
+}
+
+void GameList::CloseWatches()
+{
+	if (s_watch_fd < 0)
+		return;
+
+	close(s_watch_fd);
+	s_watch_fd = -1;
+	s_watch_dirs.clear();
+	s_watch_config.clear();
+}
+
+bool GameList::RefreshChangedDirectories(
+	const std::vector<std::string>& config, const std::vector<std::string>& excluded_paths, ProgressCallback* progress)
+{
+	if (s_watch_fd < 0 || config != s_watch_config)
+		return false;
+
+	// Anything which changes which directories there are needs a full scan, to find the new ones
+	// and set up their watches. Files coming and going only need their own directory looked at.
+	std::unordered_set<std::string> changed_dirs;
+	alignas(inotify_event) char buffer[4096];
+	for (;;)
+	{
+		const ssize_t len = read(s_watch_fd, buffer, sizeof(buffer));
+		if (len < 0)
+		{
+			if (errno == EAGAIN)
 				break;
+			if (errno == EINTR)
+				continue;
 
-			ScanDirectory(dir.c_str(), true, only_cache, excluded_paths, played_time, progress);
-			progress->SetProgressValue(++directory_counter);
+			return false;
+		}
+
+		for (ssize_t pos = 0; pos < len;)
+		{
+			const inotify_event* ev = reinterpret_cast<const inotify_event*>(buffer + pos);
+			pos += sizeof(inotify_event) + ev->len;
+
+			if (ev->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_UNMOUNT | IN_DELETE_SELF | IN_MOVE_SELF))
+				return false;
+
+			const auto it = s_watch_dirs.find(ev->wd);
+			if (it == s_watch_dirs.end())
+				return false;
+
+			if (ev->mask & IN_ISDIR)
+			{
+				// Subdirectories of non-recursive directories aren't scanned anyway.
+				if (it->second.recursive && (ev->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)))
+					return false;
+
+				continue;
+			}
+
+			changed_dirs.insert(it->second.path);
 		}
 	}
 
-	// don't need unused cache entries
-	CloseCacheFileStream();
-	s_cache_map.clear();
+	if (changed_dirs.empty())
+	{
+		DevCon.WriteLn("No changes in game list directories since the last scan");
+		return true;
+	}
+
+	Console.WriteLn("Rescanning %zu changed game list directories", changed_dirs.size());
+
+	LoadCache();
+
+	// Games outside the changed directories are kept as they are. Their cache records are dropped from
+	// the map, same as a scan would, otherwise a compaction would write them out twice.
+	std::vector<Entry> old_entries;
+	{
+		std::unique_lock lock(s_mutex);
+		old_entries.swap(s_entries);
+		for (const Entry& entry : old_entries)
+		{
+			if (changed_dirs.find(std::string(Path::GetDirectory(entry.path))) != changed_dirs.end())
+				continue;
+
+			auto iter = UnorderedStringMapFind(s_cache_map, entry.path);
+			if (iter != s_cache_map.end())
+				s_cache_map.erase(iter);
+			s_entries.push_back(entry);
+		}
+	}
+
+	const PlayedTimeMap played_time(LoadPlayedTimeMap(GetPlayedTimeFile()));
+	cb::ThreadPool pool(SCAN_IO_THREADS);
+
+	progress->SetProgressRange(static_cast<u32>(changed_dirs.size()));
+	progress->SetProgressValue(0);
+
+	int directory_counter = 0;
+	for (const std::string& dir : changed_dirs)
+	{
+		if (progress->IsCancelled())
+			break;
+
+		ScanDirectory(dir.c_str(), false, false, FindDirectoryFiles(dir, false), excluded_paths, played_time, pool, progress);
+		progress->SetProgressValue(++directory_counter);
+	}
+
+	// The directories which weren't rescanned have changes which would otherwise be lost.
+	if (progress->IsCancelled())
+		CloseWatches();
+
+	FinishRefresh(false);
+	return true;
 }
 
+#endif
+
 bool GameList::RescanPath(const std::string& path)
 {
 	FILESYSTEM_STAT_DATA sd;
@@ -806,12 +1398,9 @@ bool GameList::RescanPath(const std::string& path)
 			return false;
 	}
 
-	// re-scan!
-	if (!ScanFile(path, sd.ModificationTime, lock, played_time))
-		return true;
-
-	// update cache.. this is far from ideal, but since everything's variable length, all we can do.
-	RewriteCacheFile();
+	// re-scan! the new record is appended to the cache, and takes precedence over the old one when it's loaded.
+	ScanFile(path, sd.ModificationTime, lock, played_time);
+	CloseCacheFileStream();
 	return true;
 }
 
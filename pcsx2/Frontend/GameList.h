@@ -120,6 +120,7 @@ namespace GameList
 	/// Populates the game list with files in the configured directories.
 	/// If invalidate_cache is set, all files will be re-scanned.
 	/// If only_cache is set, no new files will be scanned, only those present in the cache.
+	/// On Linux, after a full scan of local directories, later refreshes only rescan the directories which changed.
 	void Refresh(bool invalidate_cache, bool only_cache = false, ProgressCallback* progress = nullptr);
 
 	/// Re-scans a single entry in the game list.
@@ -219,6 +219,14 @@ void ImGuiManager::DrawPerformanceOverlay()
 			FormatProcessorStat(text, PerformanceMetrics::GetGSThreadUsage(), PerformanceMetrics::GetGSThreadAverageTime());
 			DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
 
+			text.clear();
+			fmt::format_to(std::back_inserter(text), "Ring: {:.2f}ms ({:.2f}ms) | {:.1f}% ({:.1f}%) | {:.1f} kicks", PerformanceMetrics::GetMTGSAverageLatency(),
+				PerformanceMetrics::GetMTGSMaximumLatency(), PerformanceMetrics::GetMTGSAverageRingUsage(), PerformanceMetrics::GetMTGSPeakRingUsage(),
+				PerformanceMetrics::GetMTGSKicksPerFrame());
+			if (PerformanceMetrics::GetMTGSStallsPerFrame() > 0.0f)
+				fmt::format_to(std::back_inserter(text), " | {:.1f} stalls", PerformanceMetrics::GetMTGSStallsPerFrame());
+			DRAW_LINE(fixed_font, text.c_str(), IM_COL32(255, 255, 255, 255));
+
 			const u32 gs_sw_threads = PerformanceMetrics::GetGSSWThreadCount();
 			for (u32 i = 0; i < gs_sw_threads; i++)
 			{
@@ -328,12 +328,16 @@ public:
 	using AsyncCallType = std::function<void()>;
 
 	// note: when m_ReadPos == m_WritePos, the fifo is empty
-	// Threading info: m_ReadPos is updated by the MTGS thread. m_WritePos is updated by the EE thread
+	// Threading info: m_ReadPos is updated by the MTGS thread. Producers claim space by advancing m_ReservePos,
+	// fill it in, then advance m_WritePos past it in the same order they reserved, so packets can be sent from
+	// any thread (EE, MTVU, host) without a lock. The MTGS thread never reads past m_WritePos.
 	std::atomic<unsigned int> m_ReadPos; // cur pos gs is reading from
-	std::atomic<unsigned int> m_WritePos; // cur pos ee thread is writing to
+	std::atomic<unsigned int> m_WritePos; // end of the packets which are ready to be read
+	std::atomic<unsigned int> m_ReservePos; // end of the packets which have been claimed by a producer
 
 	std::atomic<bool> m_SignalRingEnable;
 	std::atomic<int> m_SignalRingPosition;
+	std::atomic<bool> m_SignalRingOwned{false}; // set by the producer which is sleeping on m_sem_OnRingReset
 
 	std::atomic<int> m_QueuedFrameCount;
 	std::atomic<bool> m_VsyncSignalListener;
@@ -343,16 +347,31 @@ public:
 	Threading::UserspaceSemaphore m_sem_OnRingReset;
 	Threading::UserspaceSemaphore m_sem_Vsync;
 
-	// used to keep multiple threads from sending packets to the ringbuffer concurrently.
-	// (currently not used or implemented -- is a planned feature for a future threaded VU1)
-	//MutexLockRecursive m_PacketLocker;
-
 	// Used to delay the sending of events.  Performance is better if the ringbuffer
 	// has more than one command in it when the thread is kicked.
-	int m_CopyDataTally;
+	// The MTGS thread adjusts the threshold based on how much is left in the ring at each vsync, and
+	// whether producers stalled: when it's falling behind it gets kicked sooner, when it's keeping up
+	// it gets to sleep through more data.
+	std::atomic<u32> m_CopyDataTally; // qwc queued since the last kick
+	std::atomic<u32> m_KickThreshold;
+
+	static constexpr u32 MinKickThreshold = 0x400;
+	static constexpr u32 DefaultKickThreshold = 0x2000;
+	static constexpr u32 MaxKickThreshold = 0x10000;
+	static constexpr u32 KickBacklogQwc = 0x8000; // queued beyond the threshold at vsync which counts as falling behind
+	static constexpr int KickAdjustFrames = 8; // consecutive frames which must agree before the threshold moves
+
+	// Only touched by the MTGS thread.
+	int m_KickVotes; // positive while keeping up, negative while falling behind
+	u32 m_KickLastStallCount;
+
+	// Producer side statistics, totals since the thread was created. Read by PerformanceMetrics.
+	std::atomic<u32> m_KickCount{0};
+	std::atomic<u32> m_StallCount{0};
 
 	// These vars maintain instance data for sending Data Packets.
-	// Only one data packet can be constructed and uploaded at a time.
+	// Only one data packet can be constructed and uploaded at a time, and only from the EE thread.
+	// Simple packets can be sent from any thread.
 
 	uint m_packet_startpos; // size of the packet (data only, ie. not including the 16 byte command!)
 	uint m_packet_size; // size of the packet (data only, ie. not including the 16 byte command!)
@@ -438,10 +457,17 @@ protected:
 	void ThreadEntryPoint();
 	void MainLoop();
 
-	void GenericStall(uint size);
+	/// Claims size qwc in the ring, waiting for the MTGS thread to free up space if needed.
+	/// Returns the start of the claimed space, which must be passed to CommitRing() once it's been filled.
+	uint ReserveRing(uint size);
+	/// Makes a claimed block visible to the MTGS thread. Waits for anything claimed before it to be committed first.
+	void CommitRing(uint startpos, uint endpos);
+	void StallForRoom(uint startpos, uint size);
+	void KickAfter(u32 qwc);
+	void UpdateKickThreshold(u32 ring_used);
 
 	// Used internally by SendSimplePacket type functions
-	void _FinishSimplePacket();
+	void _FinishSimplePacket(uint pos);
 };
 
 // GetMTGS() is a required external implementation. This function is *NOT* provided
@@ -1110,4 +1110,20 @@ BEGIN_HOTKEY_LIST(g_gs_hotkeys)
 			 }
 		 }
 	 }},
+	{"PackTextureReplacements", "Graphics", "Pack Texture Replacements", [](s32 pressed) {
+		 if (!pressed)
+		 {
+			 if (!EmuConfig.GS.LoadTextureReplacements)
+			 {
+				 Host::AddKeyedOSDMessage("PackTextureReplacements", "Texture replacements are not enabled.", Host::OSD_INFO_DURATION);
+			 }
+			 else
+			 {
+				 Host::AddKeyedOSDMessage("PackTextureReplacements", "Packing texture replacements...", Host::OSD_INFO_DURATION);
+				 GetMTGS().RunOnGSThread([]() {
+					 GSTextureReplacements::PackReplacementTextures();
+				 });
+			 }
+		 }
+	 }},
 END_HOTKEY_LIST()
@@ -241,7 +241,7 @@ GSDumpZst::GSDumpZst(const std::string& fn, const std::string& serial, u32 crc,
 	// Compression level 6 provides a good balance between speed and ratio.
 	ZSTD_CCtx_setParameter(m_strm, ZSTD_c_compressionLevel, 6);
 
-	m_in_buff.reserve(_1mb);
+	m_in_buff.reserve(FRAME_SIZE);
 	m_out_buff.resize(_1mb);
 
 	AddHeader(serial, crc, screenshot_width, screenshot_height, screenshot_pixels, fd, regs);
@@ -249,7 +249,7 @@ GSDumpZst::GSDumpZst(const std::string& fn, const std::string& serial, u32 crc,
 
 GSDumpZst::~GSDumpZst()
 {
-	// Finish the stream
+	// Finish the last frame
 	Compress(ZSTD_e_end);
 
 	ZSTD_freeCStream(m_strm);
@@ -271,8 +271,9 @@ void GSDumpZst::AppendRawData(u8 c)
 
 void GSDumpZst::MayFlush()
 {
-	if (m_in_buff.size() >= _1mb)
-		Compress(ZSTD_e_continue);
+	// Ending the frame in the same call the data is passed in lets the encoder write its size.
+	if (m_in_buff.size() >= FRAME_SIZE)
+		Compress(ZSTD_e_end);
 }
 
 void GSDumpZst::Compress(ZSTD_EndDirective action)
@@ -114,6 +114,10 @@ public:
 
 class GSDumpZst final : public GSDumpBase
 {
+	// Data is compressed in independent frames of this size, each carrying its decompressed size,
+	// so the frames can be decompressed in parallel on replay.
+	static constexpr size_t FRAME_SIZE = 8 * _1mb;
+
 	ZSTD_CStream* m_strm;
 
 	std::vector<u8> m_in_buff;
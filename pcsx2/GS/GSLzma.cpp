@@ -18,10 +18,15 @@
 #include "common/AlignedMalloc.h"
 #include "common/FileSystem.h"
 #include "common/StringUtil.h"
+#include "common/Threading.h"
+#include "common/ThreadPool.h"
 
 #include "GSDump.h"
 #include "GSLzma.h"
 
+#include <future>
+#include <limits>
+
 using namespace GSDumpTypes;
 
 GSDumpFile::GSDumpFile(FILE* file, FILE* repack_file)
@@ -114,8 +119,31 @@ bool GSDumpFile::GetPreviewImageFromDump(const char* filename, u32* width, u32*
 	return true;
 }
 
+bool GSDumpFile::ReadRemaining(ByteArray* data)
+{
+	for (;;)
+	{
+		const size_t data_size = data->size();
+		data->resize(std::max<size_t>(data_size * 2, 8 * _1mb));
+
+		const size_t read_size = data->size() - data_size;
+		const size_t read = Read(data->data() + data_size, read_size);
+		if (read != read_size)
+		{
+			if (!IsEof())
+				return false;
+
+			data->resize(data_size + read);
+			data->shrink_to_fit();
+			return true;
+		}
+	}
+}
+
 bool GSDumpFile::ReadFile()
 {
+	BeginReadFile();
+
 	u32 ss;
 	if (Read(&m_crc, sizeof(m_crc)) != sizeof(m_crc) || Read(&ss, sizeof(ss)) != sizeof(ss))
 		return false;
@@ -160,25 +188,8 @@ bool GSDumpFile::ReadFile()
 	if (Read(m_regs_data.data(), m_regs_data.size()) != m_regs_data.size())
 		return false;
 
-	// read all the packet data in
-	// TODO: make this suck less by getting the full/extracted size and preallocating
-	for (;;)
-	{
-		const size_t packet_data_size = m_packet_data.size();
-		m_packet_data.resize(std::max<size_t>(packet_data_size * 2, 8 * _1mb));
-
-		const size_t read_size = m_packet_data.size() - packet_data_size;
-		const size_t read = Read(m_packet_data.data() + packet_data_size, read_size);
-		if (read != read_size)
-		{
-			if (!IsEof())
-				return false;
-
-			m_packet_data.resize(packet_data_size + read);
-			m_packet_data.shrink_to_fit();
-			break;
-		}
-	}
+	if (!ReadRemaining(&m_packet_data))
+		return false;
 
 	u8* data = m_packet_data.data();
 	size_t remaining = m_packet_data.size();
@@ -254,96 +265,128 @@ bool GSDumpFile::ReadFile()
 }
 
 /******************************************************************/
-GSDumpLzma::GSDumpLzma(FILE* file, FILE* repack_file)
+GSDumpDecompressor::GSDumpDecompressor(FILE* file, FILE* repack_file)
 	: GSDumpFile(file, repack_file)
 {
-	Initialize();
 }
 
-void GSDumpLzma::Initialize()
+GSDumpDecompressor::~GSDumpDecompressor()
 {
-	memset(&m_strm, 0, sizeof(lzma_stream));
+	StopDecodeThread();
+}
 
-	lzma_ret ret = lzma_stream_decoder(&m_strm, UINT32_MAX, 0);
+void GSDumpDecompressor::BeginReadFile()
+{
+	if (m_decode_eof || m_decode_thread.joinable())
+		return;
 
-	if (ret != LZMA_OK)
-	{
-		fprintf(stderr, "Error initializing the decoder! (error code %u)\n", ret);
-		throw "BAD"; // Just exit the program
-	}
+	m_decode_thread = std::thread(&GSDumpDecompressor::DecodeThreadEntryPoint, this);
+}
 
-	m_buff_size = 1024*1024;
-	m_area      = (uint8_t*)_aligned_malloc(m_buff_size, 32);
-	m_inbuf     = (uint8_t*)_aligned_malloc(BUFSIZ, 32);
-	m_avail     = 0;
-	m_start     = 0;
+void GSDumpDecompressor::StopDecodeThread()
+{
+	if (!m_decode_thread.joinable())
+		return;
 
-	m_strm.avail_in  = 0;
-	m_strm.next_in   = m_inbuf;
+	{
+		std::unique_lock lock(m_decode_mutex);
+		m_decode_thread_stop = true;
+		m_decode_cv.notify_all();
+	}
 
-	m_strm.avail_out = m_buff_size;
-	m_strm.next_out  = m_area;
+	m_decode_thread.join();
 }
 
-void GSDumpLzma::Decompress()
+void GSDumpDecompressor::DecodeThreadEntryPoint()
 {
-	lzma_action action = LZMA_RUN;
-
-	m_strm.next_out  = m_area;
-	m_strm.avail_out = m_buff_size;
+	Threading::SetNameOfCurrentThread("GS Dump Decompress");
 
-	// Nothing left in the input buffer. Read data from the file
-	if (m_strm.avail_in == 0 && !feof(m_fp))
+	for (;;)
 	{
-		m_strm.next_in   = m_inbuf;
-		m_strm.avail_in  = fread(m_inbuf, 1, BUFSIZ, m_fp);
-
-		if (ferror(m_fp))
+		// Fill the whole chunk, so the reader isn't woken for every block the decoder emits.
+		ByteArray chunk(CHUNK_SIZE);
+		size_t size = 0;
+		while (size < chunk.size())
 		{
-			fprintf(stderr, "Read error: %s\n", strerror(errno));
-			throw "BAD"; // Just exit the program
+			const size_t decoded = Decode(chunk.data() + size, chunk.size() - size);
+			if (decoded == 0)
+				break;
+			size += decoded;
 		}
+		chunk.resize(size);
+
+		std::unique_lock lock(m_decode_mutex);
+		m_decode_cv.wait(lock, [this]() { return m_decode_thread_stop || m_decoded_chunks.size() < MAX_QUEUED_CHUNKS; });
+		if (m_decode_thread_stop)
+			break;
+
+		const bool done = (size < CHUNK_SIZE);
+		if (size > 0)
+			m_decoded_chunks.push_back(std::move(chunk));
+		m_decode_thread_done = done;
+		m_decode_cv.notify_all();
+		if (done)
+			break;
 	}
+}
 
-	lzma_ret ret = lzma_code(&m_strm, action);
+bool GSDumpDecompressor::NextChunk()
+{
+	m_chunk_pos = 0;
+	if (m_decode_eof)
+	{
+		m_chunk.clear();
+		return false;
+	}
 
-	if (ret != LZMA_OK)
+	if (m_decode_thread.joinable())
 	{
-		if (ret == LZMA_STREAM_END)
-			fprintf(stderr, "LZMA decoder finished without error\n\n");
-		else
+		std::unique_lock lock(m_decode_mutex);
+		m_decode_cv.wait(lock, [this]() { return m_decode_thread_done || !m_decoded_chunks.empty(); });
+		if (m_decoded_chunks.empty())
 		{
-			fprintf(stderr, "Decoder error: (error code %u)\n", ret);
-			throw "BAD"; // Just exit the program
+			m_chunk.clear();
+			m_decode_eof = !m_decode_error;
+			return false;
 		}
+
+		m_chunk = std::move(m_decoded_chunks.front());
+		m_decoded_chunks.pop_front();
+		m_decode_cv.notify_all();
+		return true;
+	}
+
+	// Header or preview reads, keep the chunk small since most of it is likely to go unused.
+	m_chunk.resize(_1mb);
+	const size_t size = Decode(m_chunk.data(), m_chunk.size());
+	m_chunk.resize(size);
+	if (size == 0)
+	{
+		m_decode_eof = !m_decode_error;
+		return false;
 	}
 
-	m_start = 0;
-	m_avail = m_buff_size - m_strm.avail_out;
+	return true;
 }
 
-bool GSDumpLzma::IsEof()
+bool GSDumpDecompressor::IsEof()
 {
-	return feof(m_fp) && m_avail == 0 && m_strm.avail_in == 0;
+	return m_decode_eof && m_chunk_pos == m_chunk.size();
 }
 
-size_t GSDumpLzma::Read(void* ptr, size_t size)
+size_t GSDumpDecompressor::Read(void* ptr, size_t size)
 {
+	u8* dst = static_cast<u8*>(ptr);
 	size_t off = 0;
-	uint8_t* dst = (uint8_t*)ptr;
-	while (size && !IsEof())
+	while (off < size)
 	{
-		if (m_avail == 0)
-		{
-			Decompress();
-		}
+		if (m_chunk_pos == m_chunk.size() && !NextChunk())
+			break;
 
-		size_t l = std::min(size, m_avail);
-		memcpy(dst + off, m_area + m_start, l);
-		m_avail -= l;
-		size    -= l;
-		m_start += l;
-		off     += l;
+		const size_t len = std::min(size - off, m_chunk.size() - m_chunk_pos);
+		std::memcpy(dst + off, m_chunk.data() + m_chunk_pos, len);
+		m_chunk_pos += len;
+		off += len;
 	}
 
 	if (off > 0)
@@ -352,19 +395,141 @@ size_t GSDumpLzma::Read(void* ptr, size_t size)
 	return off;
 }
 
+bool GSDumpDecompressor::ReadRemaining(ByteArray* data)
+{
+	// When everything was decoded up front, hand the rest of it over rather than copying it.
+	if (!m_decode_eof || m_decode_thread.joinable())
+		return GSDumpFile::ReadRemaining(data);
+
+	m_chunk.erase(m_chunk.begin(), m_chunk.begin() + m_chunk_pos);
+	if (!m_chunk.empty())
+		Repack(m_chunk.data(), m_chunk.size());
+
+	*data = std::move(m_chunk);
+	m_chunk = {};
+	m_chunk_pos = 0;
+	return true;
+}
+
+void GSDumpDecompressor::SetDecodedData(ByteArray data)
+{
+	pxAssert(!m_decode_thread.joinable() && m_chunk_pos == m_chunk.size());
+	m_chunk = std::move(data);
+	m_chunk_pos = 0;
+	m_decode_eof = true;
+}
+
+/******************************************************************/
+GSDumpLzma::GSDumpLzma(FILE* file, FILE* repack_file)
+	: GSDumpDecompressor(file, repack_file)
+{
+	Initialize();
+}
+
+void GSDumpLzma::Initialize()
+{
+	m_inbuf = (uint8_t*)_aligned_malloc(INPUT_BUFFER_SIZE, 32);
+	m_decode_error = !InitializeDecoder(false);
+}
+
+bool GSDumpLzma::InitializeDecoder(bool multithreaded)
+{
+	lzma_end(&m_strm);
+	m_strm = LZMA_STREAM_INIT;
+
+	lzma_ret ret;
+#if LZMA_VERSION >= 50040002
+	if (multithreaded)
+	{
+		// Only helps dumps written in multiple blocks, single block streams decode on one thread regardless.
+		lzma_mt mt = {};
+		mt.threads = std::max<u32>(lzma_cputhreads(), 1);
+		mt.memlimit_threading = std::max<u64>(lzma_physmem() / 4, 64 * _1mb);
+		mt.memlimit_stop = UINT64_MAX;
+		ret = lzma_stream_decoder_mt(&m_strm, &mt);
+	}
+	else
+#endif
+	{
+		ret = lzma_stream_decoder(&m_strm, UINT32_MAX, 0);
+	}
+
+	if (ret != LZMA_OK)
+	{
+		Console.Error("(GSDumpLzma) Error initializing the decoder (error code %u)", ret);
+		return false;
+	}
+
+	m_strm.avail_in = 0;
+	m_strm.next_in = m_inbuf;
+	return true;
+}
+
+void GSDumpLzma::BeginReadFile()
+{
+#if LZMA_VERSION >= 50040002
+	// Nothing's been decoded yet, so the multithreaded decoder can take over from the start.
+	if (!m_decode_error && m_strm.total_in == 0 && m_strm.avail_in == 0 && FileSystem::FTell64(m_fp) == 0)
+		m_decode_error = !InitializeDecoder(true);
+#endif
+
+	GSDumpDecompressor::BeginReadFile();
+}
+
+size_t GSDumpLzma::Decode(u8* dst, size_t size)
+{
+	if (m_decode_error || m_stream_end)
+		return 0;
+
+	m_strm.next_out = dst;
+	m_strm.avail_out = size;
+
+	while (m_strm.avail_out > 0)
+	{
+		// Nothing left in the input buffer. Read data from the file
+		if (m_strm.avail_in == 0 && !feof(m_fp))
+		{
+			m_strm.next_in = m_inbuf;
+			m_strm.avail_in = fread(m_inbuf, 1, INPUT_BUFFER_SIZE, m_fp);
+
+			if (ferror(m_fp))
+			{
+				Console.Error("(GSDumpLzma) Read error: %s", strerror(errno));
+				m_decode_error = true;
+				break;
+			}
+		}
+
+		const lzma_ret ret = lzma_code(&m_strm, (m_strm.avail_in == 0 && feof(m_fp)) ? LZMA_FINISH : LZMA_RUN);
+		if (ret == LZMA_STREAM_END)
+		{
+			m_stream_end = true;
+			break;
+		}
+		else if (ret != LZMA_OK)
+		{
+			Console.Error("(GSDumpLzma) Decoder error (error code %u)", ret);
+			m_decode_error = true;
+			break;
+		}
+	}
+
+	return size - m_strm.avail_out;
+}
+
 GSDumpLzma::~GSDumpLzma()
 {
+	StopDecodeThread();
+
 	lzma_end(&m_strm);
 
 	if (m_inbuf)
 		_aligned_free(m_inbuf);
-	if (m_area)
-		_aligned_free(m_area);
 }
 
 /******************************************************************/
 GSDumpDecompressZst::GSDumpDecompressZst(FILE* file, FILE* repack_file)
-	: GSDumpFile(file, repack_file)
+	: GSDumpDecompressor(file, repack_file)
 {
 	Initialize();
 }
@@ -373,82 +538,150 @@ void GSDumpDecompressZst::Initialize()
 {
 	m_strm = ZSTD_createDStream();
 
-	m_area      = (uint8_t*)_aligned_malloc(OUTPUT_BUFFER_SIZE, 32);
 	m_inbuf.src = (uint8_t*)_aligned_malloc(INPUT_BUFFER_SIZE, 32);
 	m_inbuf.pos = 0;
 	m_inbuf.size = 0;
-	m_avail     = 0;
-	m_start     = 0;
 }
 
-void GSDumpDecompressZst::Decompress()
+void GSDumpDecompressZst::BeginReadFile()
+{
+	if (!DecodeFramesInParallel())
+		GSDumpDecompressor::BeginReadFile();
+}
+
+bool GSDumpDecompressZst::DecodeFramesInParallel()
 {
-	ZSTD_outBuffer outbuf = { m_area, OUTPUT_BUFFER_SIZE, 0 };
-	while (outbuf.pos == 0)
+	// Only possible before anything's been streamed.
+	if (m_decode_error || m_inbuf.size != 0 || FileSystem::FTell64(m_fp) != 0)
+		return false;
+
+	const s64 file_size = FileSystem::FSize64(m_fp);
+	if (file_size <= 0 || static_cast<u64>(file_size) > std::numeric_limits<size_t>::max())
+		return false;
+
+	ByteArray compressed(static_cast<size_t>(file_size));
+	if (std::fread(compressed.data(), compressed.size(), 1, m_fp) != 1)
 	{
-		// Nothing left in the input buffer. Read data from the file
-		if (m_inbuf.pos == m_inbuf.size && !feof(m_fp))
+		FileSystem::FSeek64(m_fp, 0, SEEK_SET);
+		return false;
+	}
+
+	// Dumps written by GSDumpZst are a series of independent frames, each with its size in the
+	// header. Older dumps are a single frame, or frames without sizes, and have to be streamed.
+	struct Frame
+	{
+		size_t src_offset;
+		size_t src_size;
+		size_t dst_offset;
+		size_t dst_size;
+	};
+	std::vector<Frame> frames;
+	size_t src_offset = 0;
+	size_t total_size = 0;
+	while (src_offset < compressed.size())
+	{
+		const u8* src = compressed.data() + src_offset;
+		const size_t src_remaining = compressed.size() - src_offset;
+		const size_t src_size = ZSTD_findFrameCompressedSize(src, src_remaining);
+		const unsigned long long dst_size = ZSTD_getFrameContentSize(src, src_remaining);
+		if (ZSTD_isError(src_size) || dst_size == ZSTD_CONTENTSIZE_UNKNOWN || dst_size == ZSTD_CONTENTSIZE_ERROR ||
+			dst_size > std::numeric_limits<size_t>::max() - total_size)
 		{
-			m_inbuf.size = fread((void*)m_inbuf.src, 1, INPUT_BUFFER_SIZE, m_fp);
-			m_inbuf.pos = 0;
+			frames.clear();
+			break;
+		}
 
-			if (ferror(m_fp))
-			{
-				fprintf(stderr, "Read error: %s\n", strerror(errno));
-				throw "BAD"; // Just exit the program
-			}
+		frames.push_back({src_offset, src_size, total_size, static_cast<size_t>(dst_size)});
+		src_offset += src_size;
+		total_size += static_cast<size_t>(dst_size);
+	}
+
+	if (frames.size() < 2)
+	{
+		FileSystem::FSeek64(m_fp, 0, SEEK_SET);
+		return false;
+	}
+
+	ByteArray decoded(total_size);
+	{
+		const int threads = std::clamp(static_cast<int>(cb::ThreadPool::GetNumLogicalCores()) - 1, 1, 8);
+		cb::ThreadPool pool(threads);
+		std::vector<std::future<bool>> results;
+		results.reserve(frames.size());
+		for (const Frame& frame : frames)
+		{
+			const u8* src = compressed.data() + frame.src_offset;
+			u8* dst = decoded.data() + frame.dst_offset;
+			results.push_back(pool.ScheduleAndGetFuture([src, dst, &frame]() {
+				const size_t size = ZSTD_decompress(dst, frame.dst_size, src, frame.src_size);
+				return (!ZSTD_isError(size) && size == frame.dst_size);
+			}));
 		}
 
-		size_t ret = ZSTD_decompressStream(m_strm, &outbuf, &m_inbuf);
-		if (ZSTD_isError(ret))
+		for (std::future<bool>& result : results)
 		{
-			fprintf(stderr, "Decoder error: (error code %s)\n", ZSTD_getErrorName(ret));
-			throw "BAD"; // Just exit the program
+			if (!result.get())
+				m_decode_error = true;
 		}
 	}
 
-	m_start = 0;
-	m_avail = outbuf.pos;
-}
+	if (m_decode_error)
+	{
+		Console.Error("(GSDumpDecompressZst) Failed to decompress frame.");
+		return true;
+	}
 
-bool GSDumpDecompressZst::IsEof()
-{
-	return feof(m_fp) && m_avail == 0 && m_inbuf.pos == m_inbuf.size;
+	SetDecodedData(std::move(decoded));
+	return true;
 }
 
-size_t GSDumpDecompressZst::Read(void* ptr, size_t size)
+size_t GSDumpDecompressZst::Decode(u8* dst, size_t size)
 {
-	size_t off = 0;
-	uint8_t* dst = (uint8_t*)ptr;
-	while (size && !IsEof())
+	if (m_decode_error)
+		return 0;
+
+	ZSTD_outBuffer outbuf = {dst, size, 0};
+	while (outbuf.pos < outbuf.size)
 	{
-		if (m_avail == 0)
+		// Nothing left in the input buffer. Read data from the file
+		if (m_inbuf.pos == m_inbuf.size && !feof(m_fp))
 		{
-			Decompress();
+			m_inbuf.size = fread((void*)m_inbuf.src, 1, INPUT_BUFFER_SIZE, m_fp);
+			m_inbuf.pos = 0;
+
+			if (ferror(m_fp))
+			{
+				Console.Error("(GSDumpDecompressZst) Read error: %s", strerror(errno));
+				m_decode_error = true;
+				break;
+			}
 		}
 
-		size_t l = std::min(size, m_avail);
-		memcpy(dst + off, m_area + m_start, l);
-		m_avail -= l;
-		size    -= l;
-		m_start += l;
-		off     += l;
-	}
+		// Keep going with no input, the decoder may still be holding output from the last call.
+		const size_t prev_pos = outbuf.pos;
+		const size_t ret = ZSTD_decompressStream(m_strm, &outbuf, &m_inbuf);
+		if (ZSTD_isError(ret))
+		{
+			Console.Error("(GSDumpDecompressZst) Decoder error: %s", ZSTD_getErrorName(ret));
+			m_decode_error = true;
+			break;
+		}
 
-	if (off > 0)
-		Repack(ptr, off);
+		if (outbuf.pos == prev_pos && m_inbuf.pos == m_inbuf.size && feof(m_fp))
+			break;
+	}
 
-	return off;
+	return outbuf.pos;
 }
 
 GSDumpDecompressZst::~GSDumpDecompressZst()
 {
+	StopDecodeThread();
+
 	ZSTD_freeDStream(m_strm);
 
 	if (m_inbuf.src)
 		_aligned_free((void*)m_inbuf.src);
-	if (m_area)
-		_aligned_free(m_area);
 }
 
 /******************************************************************/
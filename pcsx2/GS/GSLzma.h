@@ -15,8 +15,12 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <lzma.h>
@@ -313,6 +317,7 @@ public:
 	__fi const ByteArray& GetStateData() const { return m_state_data; }
 	__fi const GSDataArray& GetPackets() const { return m_dump_packets; }
 
+	/// Reads and decompresses the whole dump into memory.
 	bool ReadFile();
 
 protected:
@@ -321,6 +326,12 @@ protected:
 	virtual bool IsEof() = 0;
 	virtual size_t Read(void* ptr, size_t size) = 0;
 
+	/// Called by ReadFile() before anything is read, when the whole dump is going to be decompressed.
+	virtual void BeginReadFile() {}
+
+	/// Reads everything after the header.
+	virtual bool ReadRemaining(ByteArray* data);
+
 	void Repack(void* ptr, size_t size);
 
 	FILE* m_fp = nullptr;
@@ -338,50 +349,91 @@ private:
 	GSDataArray m_dump_packets;
 };
 
-class GSDumpLzma : public GSDumpFile
+/// Base for compressed dumps. Small reads (the header, previews) decompress on the calling thread.
+/// Once the whole dump is read, decompression moves to a worker thread which stays a bounded
+/// number of chunks ahead, so it overlaps with copying the data out.
+class GSDumpDecompressor : public GSDumpFile
 {
-	lzma_stream m_strm;
+public:
+	virtual ~GSDumpDecompressor();
 
-	size_t m_buff_size;
-	uint8_t* m_area;
-	uint8_t* m_inbuf;
+	bool IsEof() final;
+	size_t Read(void* ptr, size_t size) final;
+
+protected:
+	static constexpr size_t CHUNK_SIZE = 4 * _1mb;
+	static constexpr size_t MAX_QUEUED_CHUNKS = 8;
+
+	GSDumpDecompressor(FILE* file, FILE* repack_file);
 
-	size_t m_avail;
-	size_t m_start;
+	/// Decompresses up to size bytes, returning how many were written, or zero at the end of the
+	/// stream. Sets m_decode_error on failure.
+	virtual size_t Decode(u8* dst, size_t size) = 0;
+
+	void BeginReadFile() override;
+	bool ReadRemaining(ByteArray* data) override;
+
+	/// Supplies everything left in the dump at once, for decompressors which did it themselves.
+	void SetDecodedData(ByteArray data);
+
+	/// Stops the decode thread, must be called by subclass destructors before freeing the decoder.
+	void StopDecodeThread();
+
+	bool m_decode_error = false;
+
+private:
+	bool NextChunk();
+	void DecodeThreadEntryPoint();
+
+	ByteArray m_chunk;
+	size_t m_chunk_pos = 0;
+	bool m_decode_eof = false;
+
+	std::thread m_decode_thread;
+	std::mutex m_decode_mutex;
+	std::condition_variable m_decode_cv;
+	std::deque<ByteArray> m_decoded_chunks;
+	bool m_decode_thread_done = false;
+	bool m_decode_thread_stop = false;
+};
+
+class GSDumpLzma final : public GSDumpDecompressor
+{
+	static constexpr u32 INPUT_BUFFER_SIZE = 512 * _1kb;
+
+	lzma_stream m_strm = {};
+	uint8_t* m_inbuf;
+	bool m_stream_end = false;
 
-	void Decompress();
 	void Initialize();
+	bool InitializeDecoder(bool multithreaded);
+
+protected:
+	size_t Decode(u8* dst, size_t size) override;
+	void BeginReadFile() override;
 
 public:
 	GSDumpLzma(FILE* file, FILE* repack_file);
 	virtual ~GSDumpLzma();
-
-	bool IsEof() final;
-	size_t Read(void* ptr, size_t size) final;
 };
 
-class GSDumpDecompressZst : public GSDumpFile
+class GSDumpDecompressZst final : public GSDumpDecompressor
 {
 	static constexpr u32 INPUT_BUFFER_SIZE = 512 * _1kb;
-	static constexpr u32 OUTPUT_BUFFER_SIZE = 2 * _1mb;
 
 	ZSTD_DStream* m_strm;
 	ZSTD_inBuffer m_inbuf;
 
-	uint8_t* m_area;
-
-	size_t m_avail;
-	size_t m_start;
-
-	void Decompress();
 	void Initialize();
+	bool DecodeFramesInParallel();
+
+protected:
+	size_t Decode(u8* dst, size_t size) override;
+	void BeginReadFile() override;
 
 public:
 	GSDumpDecompressZst(FILE* file, FILE* repack_file);
 	virtual ~GSDumpDecompressZst();
-
-	bool IsEof() final;
-	size_t Read(void* ptr, size_t size) final;
 };
 
 class GSDumpRaw : public GSDumpFile
@@ -40,6 +40,7 @@ public:
 protected:
 	double m_counters[CounterLast] = {};
 	double m_stats[CounterLast] = {};
+	double m_totals[CounterLast] = {};
 	u64 m_frame = 0;
 	clock_t m_lastframe = 0;
 	int m_count = 0;
@@ -56,6 +57,8 @@ public:
 
 	void Put(counter_t c, double val) { m_counters[c] += val; }
 	double Get(counter_t c) { return m_stats[c]; }
+	/// Returns everything put to a counter since the last reset, for sampling at finer intervals than Update().
+	double GetTotal(counter_t c) const { return m_totals[c] + m_counters[c]; }
 	void Update();
 
 	__fi void AddDisplayFramebufferSpriteBlit() { m_disp_fb_sprite_blits++; }
@@ -28,6 +28,11 @@ static ProcessorFeatures::VectorISA getCurrentISA()
 	// For debugging
 	if (const char* over = getenv("OVERRIDE_VECTOR_ISA"))
 	{
+		if (strcasecmp(over, "avx512") == 0)
+		{
+			fprintf(stderr, "Vector ISA Override: AVX512\n");
+			return ProcessorFeatures::VectorISA::AVX512;
+		}
 		if (strcasecmp(over, "avx2") == 0)
 		{
 			fprintf(stderr, "Vector ISA Override: AVX2\n");
@@ -44,7 +49,12 @@ static ProcessorFeatures::VectorISA getCurrentISA()
 			return ProcessorFeatures::VectorISA::SSE4;
 		}
 	}
-	if (s_cpu.has(Xbyak::util::Cpu::tAVX2) && s_cpu.has(Xbyak::util::Cpu::tBMI1) && s_cpu.has(Xbyak::util::Cpu::tBMI2))
+	const bool hasAVX2 = s_cpu.has(Xbyak::util::Cpu::tAVX2) && s_cpu.has(Xbyak::util::Cpu::tBMI1) && s_cpu.has(Xbyak::util::Cpu::tBMI2);
+	// Xbyak only reports AVX-512 if the OS saves the opmask and zmm state
+	if (hasAVX2 && s_cpu.has(Xbyak::util::Cpu::tAVX512F) && s_cpu.has(Xbyak::util::Cpu::tAVX512BW) &&
+		s_cpu.has(Xbyak::util::Cpu::tAVX512DQ) && s_cpu.has(Xbyak::util::Cpu::tAVX512VL))
+		return ProcessorFeatures::VectorISA::AVX512;
+	else if (hasAVX2)
 		return ProcessorFeatures::VectorISA::AVX2;
 	else if (s_cpu.has(Xbyak::util::Cpu::tAVX))
 		return ProcessorFeatures::VectorISA::AVX;
@@ -70,7 +80,7 @@ static ProcessorFeatures getProcessorFeatures()
 		features.hasSlowGather = over[0] == 'Y' || over[0] == 'y' || over[0] == '1';
 		fprintf(stderr, "Processor gather override: %s\n", features.hasSlowGather ? "Slow" : "Fast");
 	}
-	else if (features.vectorISA == ProcessorFeatures::VectorISA::AVX2)
+	else if (features.vectorISA >= ProcessorFeatures::VectorISA::AVX2)
 	{
 		if (s_cpu.has(Xbyak::util::Cpu::tINTEL))
 		{
@@ -15,12 +15,16 @@
 
 #include "PrecompiledHeader.h"
 
+#include "common/Align.h"
 #include "common/AlignedMalloc.h"
 #include "common/HashCombine.h"
 #include "common/FileSystem.h"
 #include "common/Path.h"
 #include "common/StringUtil.h"
+#include "common/Threading.h"
 #include "common/ScopedGuard.h"
+#include "common/ThreadPool.h"
+#include "common/Timer.h"
 
 #include "Config.h"
 #include "Host.h"
@@ -29,9 +33,13 @@
 #include "GS/Renderers/HW/GSTextureReplacements.h"
 #include "VMManager.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstring>
+#include <deque>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -46,6 +54,7 @@
 #define TEXTURE_FILENAME_REGION_CLUT_FORMAT_STRING "%" PRIx64 "-%" PRIx64 "-r%" PRIx64 "-%08x"
 #define TEXTURE_REPLACEMENT_SUBDIRECTORY_NAME "replacements"
 #define TEXTURE_DUMP_SUBDIRECTORY_NAME "dumps"
+#define TEXTURE_REPLACEMENT_ARCHIVE_NAME "replacements.pak"
 
 namespace
 {
@@ -79,20 +88,75 @@ namespace
 		__fi bool operator==(const TextureName& rhs) const
 		{
 			return std::tie(TEX0Hash, CLUTHash, region.bits, bits) ==
-				   std::tie(rhs.TEX0Hash, rhs.CLUTHash, region.bits, rhs.bits);
+				   std::tie(rhs.TEX0Hash, rhs.CLUTHash, rhs.region.bits, rhs.bits);
 		}
 		__fi bool operator!=(const TextureName& rhs) const
 		{
 			return std::tie(TEX0Hash, CLUTHash, region.bits, bits) !=
-				   std::tie(rhs.TEX0Hash, rhs.CLUTHash, region.bits, rhs.bits);
+				   std::tie(rhs.TEX0Hash, rhs.CLUTHash, rhs.region.bits, rhs.bits);
 		}
 		__fi bool operator<(const TextureName& rhs) const
 		{
 			return std::tie(TEX0Hash, CLUTHash, region.bits, bits) <
-				   std::tie(rhs.TEX0Hash, rhs.CLUTHash, region.bits, rhs.bits);
+				   std::tie(rhs.TEX0Hash, rhs.CLUTHash, rhs.region.bits, rhs.bits);
 		}
 	};
 	static_assert(sizeof(TextureName) == 32, "ReplacementTextureName is expected size");
+
+	// Packed replacement archive. Holds the decoded texels of each replacement, so it can be mapped
+	// and uploaded straight from the mapping. All offsets are in bytes, and little endian.
+	//
+	//   ArchiveHeader
+	//   for each texture, aligned to ARCHIVE_ALIGNMENT:
+	//     ArchiveTexture, ArchiveLevel[num_levels], then the texels of each level
+	//   ArchiveIndexEntry[num_textures], sorted by name
+	//
+	// The format is stored as a GSTexture::Format, so bump the version if that enum changes.
+	static constexpr char ARCHIVE_MAGIC[8] = {'P', 'S', '2', 'T', 'X', 'P', 'A', 'K'};
+	static constexpr u32 ARCHIVE_VERSION = 1;
+	static constexpr u32 ARCHIVE_ALIGNMENT = 64;
+
+	struct ArchiveHeader
+	{
+		char magic[8];
+		u32 version;
+		u32 num_textures;
+		u64 index_offset;
+	};
+	static_assert(sizeof(ArchiveHeader) == 24);
+
+	struct ArchiveIndexEntry
+	{
+		TextureName name; // miplevel is always zero
+		u64 offset; // of the ArchiveTexture
+		u64 size; // of the ArchiveTexture, its levels, and their texels
+	};
+	static_assert(sizeof(ArchiveIndexEntry) == 48);
+
+	struct ArchiveTexture
+	{
+		u32 format;
+		u32 num_levels; // base level, then mips
+	};
+	static_assert(sizeof(ArchiveTexture) == 8);
+
+	struct ArchiveLevel
+	{
+		u32 width;
+		u32 height;
+		u32 pitch;
+		u32 size;
+		u64 offset; // from the start of the ArchiveTexture
+	};
+	static_assert(sizeof(ArchiveLevel) == 24);
+
+	// A texture going into a new archive, either a loose file or one carried over from the old archive.
+	struct PackSource
+	{
+		TextureName name;
+		std::string filename; // empty if archived
+		ArchiveIndexEntry archived;
+	};
 } // namespace
 
 namespace std
@@ -120,6 +184,20 @@ namespace GSTextureReplacements
 	static void QueueAsyncReplacementTextureLoad(const TextureName& name, const std::string& filename, bool mipmap, bool cache_only);
 	static void PrecacheReplacementTextures();
 	static void ClearReplacementTextures();
+	static void WarnCompressedReplacementWithoutMipmaps();
+
+	static std::string GetArchiveFilename();
+	static bool OpenReplacementArchive(std::time_t* mtime);
+	static void CloseReplacementArchive();
+	static const ArchiveIndexEntry* FindArchivedTexture(const TextureName& name);
+	static const ArchiveTexture* GetArchivedTexture(const FileSystem::MappedFile& archive, const ArchiveIndexEntry& entry);
+	static GSTexture* CreateArchivedReplacementTexture(const ArchiveIndexEntry& entry, bool mipmap);
+	static bool WriteArchivePadding(std::FILE* fp, u64* pos);
+	static bool WriteArchivedTexture(std::FILE* fp, u64* pos, const ReplacementTexture& rtex);
+	static bool BuildReplacementArchive(const std::vector<PackSource>& sources, const std::string& filename,
+		const std::string& temp_filename, u32* num_textures);
+	static void FinishPackingReplacementTextures();
+	static void CancelPackingReplacementTextures();
 
 	static void StartWorkerThread();
 	static void StopWorkerThread();
@@ -139,6 +217,21 @@ namespace GSTextureReplacements
 	/// Lookup map of texture names to replacements, if they exist.
 	static std::unordered_map<TextureName, std::string> s_replacement_texture_filenames;
 
+	/// Packed replacements, looked up when there's no newer loose file.
+	static FileSystem::MappedFile s_archive;
+	static const ArchiveIndexEntry* s_archive_index = nullptr;
+	static u32 s_archive_size = 0;
+
+	/// Archive being built by PackReplacementTextures(). The GS thread swaps it in once the packer is done.
+	static std::thread s_pack_thread;
+	static std::atomic_bool s_pack_done{false};
+	static std::atomic_bool s_pack_cancel{false};
+	static bool s_pack_success = false;
+	static u32 s_pack_num_textures = 0;
+	static std::string s_pack_serial;
+	static std::string s_pack_filename;
+	static std::string s_pack_temp_filename;
+
 	/// Lookup map of texture names without CLUT hash, to know when we need to disable paltex.
 	static std::unordered_set<TextureName> s_replacement_textures_without_clut_hash;
 
@@ -153,11 +246,12 @@ namespace GSTextureReplacements
 	/// Second element is whether the texture should be created with mipmaps.
 	static std::vector<std::pair<TextureName, bool>> s_async_loaded_textures;
 
-	/// Loader/dumper thread.
-	static std::thread s_worker_thread;
+	/// Loader/dumper threads.
+	static std::vector<std::thread> s_worker_threads;
 	static std::mutex s_worker_thread_mutex;
 	static std::condition_variable s_worker_thread_cv;
 	static std::queue<std::function<void()>> s_worker_thread_queue;
+	static u32 s_worker_threads_busy = 0;
 	static bool s_worker_thread_running = false;
 }; // namespace GSTextureReplacements
 
@@ -332,25 +426,27 @@ void GSTextureReplacements::ReloadReplacementMap()
 	SyncWorkerThread();
 
 	// clear out the caches
-	{
-		s_replacement_texture_filenames.clear();
-		s_replacement_textures_without_clut_hash.clear();
-
-		std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
-		s_replacement_texture_cache.clear();
-		s_pending_async_load_textures.clear();
-		s_async_loaded_textures.clear();
-	}
+	ClearReplacementTextures();
 
 	// can't replace bios textures.
 	if (s_current_serial.empty() || !GSConfig.LoadTextureReplacements)
 		return;
 
+	std::time_t archive_mtime = 0;
+	if (OpenReplacementArchive(&archive_mtime))
+	{
+		for (u32 i = 0; i < s_archive_size; i++)
+		{
+			TextureName name(s_archive_index[i].name);
+			name.CLUTHash = 0;
+			s_replacement_textures_without_clut_hash.insert(name);
+		}
+	}
+
 	const std::string replacement_dir(Path::Combine(GetGameTextureDirectory(), TEXTURE_REPLACEMENT_SUBDIRECTORY_NAME));
 
 	FileSystem::FindResultsArray files;
-	if (!FileSystem::FindFiles(replacement_dir.c_str(), "*", FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES | FILESYSTEM_FIND_RECURSIVE, &files))
-		return;
+	FileSystem::FindFiles(replacement_dir.c_str(), "*", FILESYSTEM_FIND_FILES | FILESYSTEM_FIND_HIDDEN_FILES | FILESYSTEM_FIND_RECURSIVE, &files);
 
 	std::string filename;
 	for (FILESYSTEM_FIND_DATA& fd : files)
@@ -365,6 +461,10 @@ void GSTextureReplacements::ReloadReplacementMap()
 		if (!name.has_value())
 			continue;
 
+		// already packed? loose files only win if they've been edited since
+		if (fd.ModificationTime <= archive_mtime && FindArchivedTexture(name.value()))
+			continue;
+
 		DbgCon.WriteLn("Found %ux%u replacement '%.*s'", name->Width(), name->Height(), static_cast<int>(filename.size()), filename.data());
 		s_replacement_texture_filenames.emplace(name.value(), std::move(fd.FileName));
 
@@ -373,8 +473,12 @@ void GSTextureReplacements::ReloadReplacementMap()
 		s_replacement_textures_without_clut_hash.insert(name.value());
 	}
 
-	if (!s_replacement_texture_filenames.empty())
+	if (s_archive_size > 0)
+		Console.WriteLn("Mapped %u packed replacement textures.", s_archive_size);
+
+	if (HasAnyReplacementTextures())
 	{
+		// packed textures are already decoded, so this only has to deal with the loose ones
 		if (GSConfig.PrecacheTextureReplacements)
 			PrecacheReplacementTextures();
 
@@ -415,6 +519,7 @@ void GSTextureReplacements::UpdateConfig(Pcsx2Config::GSOptions& old_config)
 
 void GSTextureReplacements::Shutdown()
 {
+	CancelPackingReplacementTextures();
 	StopWorkerThread();
 
 	std::string().swap(s_current_serial);
@@ -430,7 +535,7 @@ u32 GSTextureReplacements::CalcMipmapLevelsForReplacement(u32 width, u32 height)
 
 bool GSTextureReplacements::HasAnyReplacementTextures()
 {
-	return !s_replacement_texture_filenames.empty();
+	return !s_replacement_texture_filenames.empty() || s_archive_size > 0;
 }
 
 bool GSTextureReplacements::HasReplacementTextureWithOtherPalette(const GSTextureCache::HashCacheKey& hash)
@@ -447,7 +552,11 @@ GSTexture* GSTextureReplacements::LookupReplacementTexture(const GSTextureCache:
 	// replacement for this name exists?
 	auto fnit = s_replacement_texture_filenames.find(name);
 	if (fnit == s_replacement_texture_filenames.end())
-		return nullptr;
+	{
+		// packed textures are uploaded straight out of the mapping, there's nothing to decode
+		const ArchiveIndexEntry* entry = FindArchivedTexture(name);
+		return entry ? CreateArchivedReplacementTexture(*entry, mipmap) : nullptr;
+	}
 
 	// try the full cache first, to avoid reloading from disk
 	{
@@ -565,6 +674,7 @@ void GSTextureReplacements::ClearReplacementTextures()
 {
 	s_replacement_texture_filenames.clear();
 	s_replacement_textures_without_clut_hash.clear();
+	CloseReplacementArchive();
 
 	std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
 	s_replacement_texture_cache.clear();
@@ -578,16 +688,7 @@ GSTexture* GSTextureReplacements::CreateReplacementTexture(const ReplacementText
 	// in the future I guess we could decompress the dds and generate them... but there's no reason that modders can't generate mips in dds
 	if (mipmap && GSTexture::IsCompressedFormat(rtex.format) && rtex.mips.empty())
 	{
-		static bool log_once = false;
-		if (!log_once)
-		{
-			static const char* message =
-				"Disabling autogenerated mipmaps on one or more compressed replacement textures. Please generate mipmaps when compressing your textures.";
-			Console.Warning(message);
-			Host::AddIconOSDMessage("DisablingReplacementAutoGeneratedMipmap", ICON_FA_EXCLAMATION_CIRCLE, message, Host::OSD_WARNING_DURATION);
-			log_once = true;
-		}
-
+		WarnCompressedReplacementWithoutMipmaps();
 		mipmap = false;
 	}
 
@@ -611,8 +712,23 @@ GSTexture* GSTextureReplacements::CreateReplacementTexture(const ReplacementText
 	return tex;
 }
 
+void GSTextureReplacements::WarnCompressedReplacementWithoutMipmaps()
+{
+	static bool log_once = false;
+	if (log_once)
+		return;
+
+	static const char* message =
+		"Disabling autogenerated mipmaps on one or more compressed replacement textures. Please generate mipmaps when compressing your textures.";
+	Console.Warning(message);
+	Host::AddIconOSDMessage("DisablingReplacementAutoGeneratedMipmap", ICON_FA_EXCLAMATION_CIRCLE, message, Host::OSD_WARNING_DURATION);
+	log_once = true;
+}
+
 void GSTextureReplacements::ProcessAsyncLoadedTextures()
 {
+	FinishPackingReplacementTextures();
+
 	// this holds the lock while doing the upload, but it should be reasonably quick
 	std::unique_lock<std::mutex> lock(s_replacement_texture_cache_mutex);
 	for (const auto& [name, mipmap] : s_async_loaded_textures)
@@ -647,8 +763,11 @@ void GSTextureReplacements::DumpTexture(const GSTextureCache::HashCacheKey& hash
 {
 	// check if it's been dumped or replaced already
 	const TextureName name(CreateTextureName(hash, level));
-	if (s_dumped_textures.find(name) != s_dumped_textures.end() || s_replacement_texture_filenames.find(name) != s_replacement_texture_filenames.end())
+	if (s_dumped_textures.find(name) != s_dumped_textures.end() || s_replacement_texture_filenames.find(name) != s_replacement_texture_filenames.end() ||
+		FindArchivedTexture(name))
+	{
 		return;
+	}
 
 	s_dumped_textures.insert(name);
 
@@ -689,6 +808,371 @@ void GSTextureReplacements::ClearDumpedTextureList()
 	s_dumped_textures.clear();
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Packed Archive
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string GSTextureReplacements::GetArchiveFilename()
+{
+	return Path::Combine(GetGameTextureDirectory(), TEXTURE_REPLACEMENT_ARCHIVE_NAME);
+}
+
+bool GSTextureReplacements::OpenReplacementArchive(std::time_t* mtime)
+{
+	const std::string filename(GetArchiveFilename());
+	FILESYSTEM_STAT_DATA sd;
+	if (!FileSystem::StatFile(filename.c_str(), &sd))
+		return false;
+
+	if (!s_archive.Open(filename.c_str()))
+	{
+		Console.Error("Failed to map replacement archive '%s'.", filename.c_str());
+		return false;
+	}
+
+	// only the header and index are checked here, textures are checked as they're used
+	ArchiveHeader header = {};
+	if (s_archive.GetSize() >= sizeof(header))
+		std::memcpy(&header, s_archive.GetData(), sizeof(header));
+	if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(header.magic)) != 0 || header.version != ARCHIVE_VERSION || (header.index_offset % alignof(ArchiveIndexEntry)) != 0 ||
+		header.index_offset > s_archive.GetSize() ||
+		(s_archive.GetSize() - header.index_offset) / sizeof(ArchiveIndexEntry) < header.num_textures)
+	{
+		Console.Error("Replacement archive '%s' is invalid or from another version, ignoring it.", filename.c_str());
+		s_archive.Close();
+		return false;
+	}
+
+	s_archive_index = reinterpret_cast<const ArchiveIndexEntry*>(s_archive.GetData() + header.index_offset);
+	s_archive_size = header.num_textures;
+	*mtime = sd.ModificationTime;
+	return true;
+}
+
+void GSTextureReplacements::CloseReplacementArchive()
+{
+	s_archive.Close();
+	s_archive_index = nullptr;
+	s_archive_size = 0;
+}
+
+const ArchiveIndexEntry* GSTextureReplacements::FindArchivedTexture(const TextureName& name)
+{
+	const ArchiveIndexEntry* end = s_archive_index + s_archive_size;
+	const ArchiveIndexEntry* it = std::lower_bound(s_archive_index, end, name,
+		[](const ArchiveIndexEntry& entry, const TextureName& name) { return entry.name < name; });
+	return (it != end && it->name == name) ? it : nullptr;
+}
+
+const ArchiveTexture* GSTextureReplacements::GetArchivedTexture(const FileSystem::MappedFile& archive, const ArchiveIndexEntry& entry)
+{
+	const u64 file_size = archive.GetSize();
+	if (entry.offset > file_size || entry.size > (file_size - entry.offset) || entry.size < sizeof(ArchiveTexture) ||
+		(entry.offset % ARCHIVE_ALIGNMENT) != 0)
+	{
+		return nullptr;
+	}
+
+	const u8* data = archive.GetData() + entry.offset;
+	const ArchiveTexture* tex = reinterpret_cast<const ArchiveTexture*>(data);
+	if (tex->num_levels == 0 || tex->num_levels > (entry.size - sizeof(ArchiveTexture)) / sizeof(ArchiveLevel))
+		return nullptr;
+
+	const GSTexture::Format format = static_cast<GSTexture::Format>(tex->format);
+	if (format != GSTexture::Format::Color && !GSTexture::IsCompressedFormat(format))
+		return nullptr;
+
+	const ArchiveLevel* levels = reinterpret_cast<const ArchiveLevel*>(tex + 1);
+	for (u32 i = 0; i < tex->num_levels; i++)
+	{
+		const ArchiveLevel& level = levels[i];
+		if (level.width == 0 || level.height == 0 || level.offset > entry.size || level.size > (entry.size - level.offset))
+			return nullptr;
+
+		// the upload reads pitch bytes for every row (of blocks, for compressed formats), so they all have to be there
+		const u32 block_size = GSTexture::GetCompressedBlockSize(format);
+		const u32 row_size = ((level.width + block_size - 1) / block_size) * GSTexture::GetCompressedBytesPerBlock(format);
+		const u32 rows = (level.height + block_size - 1) / block_size;
+		if (level.pitch < row_size || static_cast<u64>(level.pitch) * rows > level.size)
+			return nullptr;
+	}
+
+	return tex;
+}
+
+GSTexture* GSTextureReplacements::CreateArchivedReplacementTexture(const ArchiveIndexEntry& entry, bool mipmap)
+{
+	const ArchiveTexture* atex = GetArchivedTexture(s_archive, entry);
+	if (!atex)
+	{
+		const TextureName& name = entry.name;
+		Console.Error("Packed replacement %" PRIx64 "-%08x is corrupted.", name.TEX0Hash, name.bits);
+		return nullptr;
+	}
+
+	const GSTexture::Format format = static_cast<GSTexture::Format>(atex->format);
+	if (mipmap && GSTexture::IsCompressedFormat(format) && atex->num_levels == 1)
+		WarnCompressedReplacementWithoutMipmaps();
+
+	const ArchiveLevel* levels = reinterpret_cast<const ArchiveLevel*>(atex + 1);
+	const u32 num_levels = mipmap ? atex->num_levels : 1;
+	GSTexture* tex = g_gs_device->CreateTexture(levels[0].width, levels[0].height, static_cast<int>(num_levels), format);
+	if (!tex)
+		return nullptr;
+
+	const u8* data = reinterpret_cast<const u8*>(atex);
+	for (u32 i = 0; i < num_levels; i++)
+	{
+		const ArchiveLevel& level = levels[i];
+		tex->Update(GSVector4i(0, 0, static_cast<int>(level.width), static_cast<int>(level.height)), data + level.offset,
+			level.pitch, i);
+	}
+
+	return tex;
+}
+
+bool GSTextureReplacements::WriteArchivePadding(std::FILE* fp, u64* pos)
+{
+	static constexpr u8 zeros[ARCHIVE_ALIGNMENT] = {};
+	const u64 padding = Common::AlignUpPow2(*pos, ARCHIVE_ALIGNMENT) - *pos;
+	if (padding > 0 && std::fwrite(zeros, padding, 1, fp) != 1)
+		return false;
+
+	*pos += padding;
+	return true;
+}
+
+bool GSTextureReplacements::WriteArchivedTexture(std::FILE* fp, u64* pos, const ReplacementTexture& rtex)
+{
+	const u32 num_levels = static_cast<u32>(rtex.mips.size()) + 1;
+
+	ArchiveTexture atex;
+	atex.format = static_cast<u32>(rtex.format);
+	atex.num_levels = num_levels;
+
+	// texels are kept 16 byte aligned within the texture, for the upload
+	std::vector<ArchiveLevel> levels(num_levels);
+	u64 offset = Common::AlignUpPow2(sizeof(ArchiveTexture) + sizeof(ArchiveLevel) * num_levels, 16);
+	for (u32 i = 0; i < num_levels; i++)
+	{
+		const bool base = (i == 0);
+		levels[i].width = base ? rtex.width : rtex.mips[i - 1].width;
+		levels[i].height = base ? rtex.height : rtex.mips[i - 1].height;
+		levels[i].pitch = base ? rtex.pitch : rtex.mips[i - 1].pitch;
+		levels[i].size = static_cast<u32>(base ? rtex.data.size() : rtex.mips[i - 1].data.size());
+		levels[i].offset = offset;
+		offset = Common::AlignUpPow2(offset + levels[i].size, 16);
+	}
+
+	static constexpr u8 zeros[16] = {};
+	u64 written = sizeof(ArchiveTexture) + sizeof(ArchiveLevel) * num_levels;
+	if (std::fwrite(&atex, sizeof(atex), 1, fp) != 1 || std::fwrite(levels.data(), sizeof(ArchiveLevel), num_levels, fp) != num_levels)
+		return false;
+
+	for (u32 i = 0; i < num_levels; i++)
+	{
+		const std::vector<u8>& data = (i == 0) ? rtex.data : rtex.mips[i - 1].data;
+		if ((levels[i].offset > written && std::fwrite(zeros, levels[i].offset - written, 1, fp) != 1) ||
+			(!data.empty() && std::fwrite(data.data(), data.size(), 1, fp) != 1))
+		{
+			return false;
+		}
+
+		written = levels[i].offset + data.size();
+	}
+
+	*pos += written;
+	return true;
+}
+
+void GSTextureReplacements::PackReplacementTextures()
+{
+	if (s_pack_thread.joinable())
+	{
+		Host::AddKeyedOSDMessage("PackTextureReplacements", "Texture replacements are already being packed.", Host::OSD_INFO_DURATION);
+		return;
+	}
+
+	if (s_current_serial.empty() || !HasAnyReplacementTextures())
+	{
+		Host::AddKeyedOSDMessage("PackTextureReplacements", "There are no texture replacements to pack.", Host::OSD_INFO_DURATION);
+		return;
+	}
+
+	// everything packed before is carried over, unless there's a newer loose file.
+	// the sources are copied, since the maps can be reloaded while the archive is built.
+	std::vector<PackSource> sources;
+	sources.reserve(s_replacement_texture_filenames.size() + s_archive_size);
+	for (const auto& it : s_replacement_texture_filenames)
+		sources.push_back({it.first, it.second, {}});
+	for (u32 i = 0; i < s_archive_size; i++)
+	{
+		if (s_replacement_texture_filenames.find(s_archive_index[i].name) == s_replacement_texture_filenames.end())
+			sources.push_back({s_archive_index[i].name, std::string(), s_archive_index[i]});
+	}
+	std::sort(sources.begin(), sources.end(), [](const PackSource& lhs, const PackSource& rhs) { return lhs.name < rhs.name; });
+
+	s_pack_serial = s_current_serial;
+	s_pack_filename = GetArchiveFilename();
+	s_pack_temp_filename = s_pack_filename + ".new";
+	s_pack_done.store(false, std::memory_order_relaxed);
+	s_pack_cancel.store(false, std::memory_order_relaxed);
+	s_pack_thread = std::thread([sources = std::move(sources)]() {
+		Threading::SetNameOfCurrentThread("Texture Packer");
+		s_pack_success = BuildReplacementArchive(sources, s_pack_filename, s_pack_temp_filename, &s_pack_num_textures);
+		s_pack_done.store(true, std::memory_order_release);
+	});
+}
+
+bool GSTextureReplacements::BuildReplacementArchive(const std::vector<PackSource>& sources, const std::string& filename,
+	const std::string& temp_filename, u32* num_textures)
+{
+	// the GS thread keeps using its own mapping of the old archive until this one is swapped in
+	FileSystem::MappedFile old_archive;
+	if (std::any_of(sources.begin(), sources.end(), [](const PackSource& src) { return src.filename.empty(); }) &&
+		!old_archive.Open(filename.c_str()))
+	{
+		Console.Error("Failed to map replacement archive '%s'.", filename.c_str());
+		return false;
+	}
+
+	auto fp = FileSystem::OpenManagedCFile(temp_filename.c_str(), "wb");
+	if (!fp)
+	{
+		Console.Error("Failed to open '%s' for writing.", temp_filename.c_str());
+		return false;
+	}
+
+	Console.WriteLn("Packing %zu replacement textures to '%s'...", sources.size(), filename.c_str());
+	Common::Timer timer;
+
+	// decode in parallel, but write in order, with a bounded number of decoded textures in flight
+	const int threads = std::clamp(static_cast<int>(cb::ThreadPool::GetNumLogicalCores()) - 1, 1, 8);
+	cb::ThreadPool pool(threads);
+	std::deque<std::future<std::optional<ReplacementTexture>>> decoded;
+	size_t next_decode = 0;
+
+	ArchiveHeader header = {};
+	std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+	header.version = ARCHIVE_VERSION;
+
+	std::vector<ArchiveIndexEntry> index;
+	index.reserve(sources.size());
+	u64 pos = sizeof(header);
+	bool success = (std::fwrite(&header, sizeof(header), 1, fp.get()) == 1);
+	for (size_t i = 0; i < sources.size() && success; i++)
+	{
+		if (s_pack_cancel.load(std::memory_order_relaxed))
+		{
+			success = false;
+			break;
+		}
+
+		for (; next_decode < sources.size() && decoded.size() < static_cast<size_t>(threads) * 2; next_decode++)
+		{
+			const PackSource& src = sources[next_decode];
+			if (!src.filename.empty())
+			{
+				decoded.push_back(pool.ScheduleAndGetFuture([&src]() {
+					return LoadReplacementTexture(src.name, src.filename, false);
+				}));
+			}
+		}
+
+		const PackSource& src = sources[i];
+		ArchiveIndexEntry entry = {};
+		entry.name = src.name;
+		entry.name.miplevel = 0;
+		success = WriteArchivePadding(fp.get(), &pos);
+		entry.offset = pos;
+		if (src.filename.empty())
+		{
+			// already decoded, copy it over as-is
+			if (!GetArchivedTexture(old_archive, src.archived))
+			{
+				Console.Error("Dropping corrupted packed replacement %" PRIx64 "-%08x.", src.name.TEX0Hash, src.name.bits);
+				continue;
+			}
+
+			success = success && std::fwrite(old_archive.GetData() + src.archived.offset, src.archived.size, 1, fp.get()) == 1;
+			pos += src.archived.size;
+		}
+		else
+		{
+			std::optional<ReplacementTexture> rtex(decoded.front().get());
+			decoded.pop_front();
+			if (!rtex.has_value())
+			{
+				Console.Error("Failed to load '%s', it won't be packed.", src.filename.c_str());
+				continue;
+			}
+
+			success = success && WriteArchivedTexture(fp.get(), &pos, rtex.value());
+		}
+
+		entry.size = pos - entry.offset;
+		index.push_back(entry);
+	}
+
+	// wait for anything still decoding before the pool goes away, if writing failed
+	for (auto& it : decoded)
+		it.wait();
+
+	header.num_textures = static_cast<u32>(index.size());
+	header.index_offset = Common::AlignUpPow2(pos, ARCHIVE_ALIGNMENT);
+	success = success && WriteArchivePadding(fp.get(), &pos) &&
+			  (index.empty() || std::fwrite(index.data(), sizeof(ArchiveIndexEntry), index.size(), fp.get()) == index.size()) &&
+			  FileSystem::FSeek64(fp.get(), 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, fp.get()) == 1 &&
+			  std::fflush(fp.get()) == 0;
+	fp.reset();
+
+	if (success)
+		Console.WriteLn("Packed %u replacement textures in %.2f seconds.", header.num_textures, timer.GetTimeSeconds());
+
+	*num_textures = header.num_textures;
+	return success;
+}
+
+void GSTextureReplacements::FinishPackingReplacementTextures()
+{
+	if (!s_pack_thread.joinable() || !s_pack_done.load(std::memory_order_acquire))
+		return;
+
+	s_pack_thread.join();
+
+	// the old archive has to be unmapped before it can be replaced on Windows
+	const bool current_game = (s_pack_serial == s_current_serial);
+	if (current_game)
+		CloseReplacementArchive();
+
+	if (!s_pack_success || !FileSystem::RenamePath(s_pack_temp_filename.c_str(), s_pack_filename.c_str()))
+	{
+		Console.Error("Failed to write replacement archive '%s'.", s_pack_filename.c_str());
+		FileSystem::DeleteFilePath(s_pack_temp_filename.c_str());
+		Host::AddKeyedOSDMessage("PackTextureReplacements", "Failed to pack texture replacements.", Host::OSD_ERROR_DURATION);
+	}
+	else
+	{
+		Host::AddKeyedFormattedOSDMessage("PackTextureReplacements", Host::OSD_INFO_DURATION,
+			"Packed %u texture replacements.", s_pack_num_textures);
+	}
+
+	// pick up the new archive, and drop the loose files it now covers
+	if (current_game)
+		ReloadReplacementMap();
+}
+
+void GSTextureReplacements::CancelPackingReplacementTextures()
+{
+	if (!s_pack_thread.joinable())
+		return;
+
+	s_pack_cancel.store(true, std::memory_order_relaxed);
+	s_pack_thread.join();
+	FileSystem::DeleteFilePath(s_pack_temp_filename.c_str());
+	Console.Warning("Packing texture replacements was cancelled.");
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Worker Thread
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -697,25 +1181,30 @@ void GSTextureReplacements::StartWorkerThread()
 {
 	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
 
-	if (s_worker_thread.joinable())
+	if (!s_worker_threads.empty())
 		return;
 
+	// decoding is what takes the time, so spread it out, leaving room for the EE, GS and VU threads
+	const u32 num_threads = std::clamp(cb::ThreadPool::GetNumLogicalCores(), 4u, 11u) - 3u;
 	s_worker_thread_running = true;
-	s_worker_thread = std::thread(WorkerThreadEntryPoint);
+	for (u32 i = 0; i < num_threads; i++)
+		s_worker_threads.emplace_back(WorkerThreadEntryPoint);
 }
 
 void GSTextureReplacements::StopWorkerThread()
 {
 	{
 		std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-		if (!s_worker_thread.joinable())
+		if (s_worker_threads.empty())
 			return;
 
 		s_worker_thread_running = false;
-		s_worker_thread_cv.notify_one();
+		s_worker_thread_cv.notify_all();
 	}
 
-	s_worker_thread.join();
+	for (std::thread& thread : s_worker_threads)
+		thread.join();
+	s_worker_threads.clear();
 
 	// clear out workery-things too
 	CancelPendingLoadsAndDumps();
@@ -723,7 +1212,7 @@ void GSTextureReplacements::StopWorkerThread()
 
 void GSTextureReplacements::QueueWorkerThreadItem(std::function<void()> fn)
 {
-	pxAssert(s_worker_thread.joinable());
+	pxAssert(!s_worker_threads.empty());
 
 	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
 	s_worker_thread_queue.push(std::move(fn));
@@ -743,22 +1232,24 @@ void GSTextureReplacements::WorkerThreadEntryPoint()
 
 		std::function<void()> fn = std::move(s_worker_thread_queue.front());
 		s_worker_thread_queue.pop();
+		s_worker_threads_busy++;
 		lock.unlock();
 		fn();
 		lock.lock();
+		s_worker_threads_busy--;
 	}
 }
 
 void GSTextureReplacements::SyncWorkerThread()
 {
 	std::unique_lock<std::mutex> lock(s_worker_thread_mutex);
-	if (!s_worker_thread.joinable())
+	if (s_worker_threads.empty())
 		return;
 
 	// not the most efficient by far, but it only gets called on config changes, so whatever
 	for (;;)
 	{
-		if (s_worker_thread_queue.empty())
+		if (s_worker_thread_queue.empty() && s_worker_threads_busy == 0)
 			break;
 
 		lock.unlock();
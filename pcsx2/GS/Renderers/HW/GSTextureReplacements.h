@@ -41,6 +41,11 @@ namespace GSTextureReplacements
 	void Initialize(GSTextureCache* tc);
 	void GameChanged();
 	void ReloadReplacementMap();
+
+	/// Decodes every replacement for the current game into one archive, which is mapped instead of
+	/// loading the loose files. Loose files edited after packing still take precedence. The archive is
+	/// built on its own thread, and swapped in by ProcessAsyncLoadedTextures() once it's done.
+	void PackReplacementTextures();
 	void UpdateConfig(Pcsx2Config::GSOptions& old_config);
 	void Shutdown();
 
@@ -92,12 +92,15 @@ GSDrawScanlineCodeGenerator2::GSDrawScanlineCodeGenerator2(Xbyak::CodeGenerator*
 	, _m_local__gd__tex(r13)
 	, _rb(xym5), _ga(xym6), _fm(xym3), _zm(xym4), _fd(xym2), _test(xym15)
 	, _z(xym8), _f(xym9), _s(xym10), _t(xym11), _q(xym12), _f_rb(xym13), _f_ga(xym14)
+	, _clut_lo(16), _clut_hi(17)
 {
 	// Free: r14, r15, rbp, to use, remember to save them.
 	m_sel.key = key;
 	use_lod = m_sel.mmin;
 	if (isYmm)
 		ASSERT(hasAVX2);
+	if (m_sel.tlu4)
+		ASSERT(isYmm && hasAVX512);
 }
 
 // MARK: - Helpers
@@ -233,6 +236,13 @@ void GSDrawScanlineCodeGenerator2::alltrue(const XYm& test)
 
 void GSDrawScanlineCodeGenerator2::blend(const XYm& a, const XYm& b, const XYm& mask)
 {
+	if (hasAVX512)
+	{
+		// a = mask ? b : a
+		vpternlogd(a, b, mask, 0xd8);
+		return;
+	}
+
 	pand(b, mask);
 	pandn(mask, a);
 	if (hasAVX)
@@ -248,6 +258,13 @@ void GSDrawScanlineCodeGenerator2::blend(const XYm& a, const XYm& b, const XYm&
 
 void GSDrawScanlineCodeGenerator2::blendr(const XYm& b, const XYm& a, const XYm& mask)
 {
+	if (hasAVX512)
+	{
+		// b = mask ? b : a
+		vpternlogd(b, a, mask, 0xe4);
+		return;
+	}
+
 	pand(b, mask);
 	pandn(mask, a);
 	por(b, mask);
@@ -353,6 +370,12 @@ void GSDrawScanlineCodeGenerator2::Generate()
 	if (need_clut)
 		mov(_m_local__gd__clut, _rip_global(clut));
 
+	if (need_clut && m_sel.tlu4)
+	{
+		vmovdqu32(_clut_lo, ptr[_m_local__gd__clut]);
+		vmovdqu32(_clut_hi, ptr[_m_local__gd__clut + 32]);
+	}
+
 	Init();
 
 	if (!m_sel.edge)
@@ -3208,6 +3231,21 @@ void GSDrawScanlineCodeGenerator2::ReadTexelImplYmm(
 				pcmpeqd(t1[i], t1[i]);
 				vpgatherdd(dst[i], ptr[tex + src[i] * 4], t1[i]);
 			}
+			else if (m_sel.tlu4)
+			{
+				// Only the index loads are scalar, the clut lookup is a permute across the two registers holding it
+
+				vextracti128(xt1, src[i], 1);
+
+				for (int j = 0; j < 4; j++)
+				{
+					ReadTexelIndex(xdst, xsrc, j, texInRBX);
+					ReadTexelIndex(xt2, xt1, j, texInRBX);
+				}
+
+				vinserti128(dst[i], dst[i], xt2, 1);
+				vpermi2d(dst[i], _clut_lo, _clut_hi);
+			}
 			else
 			{
 				vextracti128(xt1, src[i], 1);
@@ -3300,3 +3338,24 @@ void GSDrawScanlineCodeGenerator2::ReadTexelImpl(const Xmm& dst, const Xmm& addr
 	else
 		pinsrd(dst, src, i);
 }
+
+/// Loads the clut index of texel `i` of `addr` into lane `i` of `dst`
+/// Destroys: rax
+void GSDrawScanlineCodeGenerator2::ReadTexelIndex(const Xmm& dst, const Xmm& addr, u8 i, bool texInRBX)
+{
+	ASSERT(i < 4);
+
+	AddressReg tex = texInRBX ? rbx : _m_local__gd__tex;
+
+	if (i == 0)
+		movd(eax, addr);
+	else
+		pextrd(eax, addr, i);
+
+	movzx(eax, byte[tex + rax]);
+
+	if (i == 0)
+		movd(dst, eax);
+	else
+		pinsrd(dst, eax, i);
+}
@@ -82,6 +82,8 @@ class GSDrawScanlineCodeGenerator2 : public GSNewCodeGenerator
 	const XYm _rb, _ga, _fm, _zm, _fd, _test;
 	/// Always valid if needed, x64 only
 	const XYm _z, _f, _s, _t, _q, _f_rb, _f_ga;
+	/// AVX-512 only, clut[0-7] and clut[8-15] if m_sel.tlu4 (EVEX-only registers, so nothing else touches them)
+	const Xbyak::Ymm _clut_lo, _clut_hi;
 
 public:
 	GSDrawScanlineCodeGenerator2(Xbyak::CodeGenerator* base, const ProcessorFeatures& cpu, u64 key);
@@ -177,6 +179,7 @@ private:
 		const Xmm& s2,   const Xmm& s3,
 		int pixels,      int mip_offset);
 	void ReadTexelImpl(const Xmm& dst, const Xmm& addr, u8 i, bool texInA3, bool preserveDst);
+	void ReadTexelIndex(const Xmm& dst, const Xmm& addr, u8 i, bool texInRBX);
 };
 
 MULTI_ISA_UNSHARED_END
@@ -91,7 +91,7 @@ public:
 	using AddressReg = Xbyak::Reg64;
 	using RipType = Xbyak::RegRip;
 
-	const bool hasAVX, hasAVX2, hasFMA;
+	const bool hasAVX, hasAVX2, hasAVX512, hasFMA;
 
 	const Xmm xmm0{0}, xmm1{1}, xmm2{2}, xmm3{3}, xmm4{4}, xmm5{5}, xmm6{6}, xmm7{7}, xmm8{8}, xmm9{9}, xmm10{10}, xmm11{11}, xmm12{12}, xmm13{13}, xmm14{14}, xmm15{15};
 	const Ymm ymm0{0}, ymm1{1}, ymm2{2}, ymm3{3}, ymm4{4}, ymm5{5}, ymm6{6}, ymm7{7}, ymm8{8}, ymm9{9}, ymm10{10}, ymm11{11}, ymm12{12}, ymm13{13}, ymm14{14}, ymm15{15};
@@ -107,6 +107,7 @@ public:
 		: actual(*actual)
 		, hasAVX(cpu.vectorISA >= ProcessorFeatures::VectorISA::AVX)
 		, hasAVX2(cpu.vectorISA >= ProcessorFeatures::VectorISA::AVX2)
+		, hasAVX512(cpu.vectorISA >= ProcessorFeatures::VectorISA::AVX512)
 		, hasFMA(cpu.hasFMA)
 	{
 	}
@@ -124,6 +125,7 @@ public:
 //   SSEONLY: available only on SSE (exception on AVX)
 //   AVX:     available only on AVX (exception on SSE)
 //   AVX2:    available only on AVX2 (exception on AVX/SSE)
+//   AVX512:  available only on AVX-512 F/BW/DQ/VL (exception otherwise)
 //   FMA:     available only with FMA
 // SFORWARD forwards an SSE-AVX pair where the AVX variant takes the same number of registers (e.g. pshufd dst, src + vpshufd dst, src)
 // AFORWARD forwards an SSE-AVX pair where the AVX variant takes an extra destination register (e.g. shufps dst, src + vshufps dst, src, src)
@@ -163,6 +165,12 @@ public:
 	else \
 		throw Error(Error::ERR_AVX_INSTR_IN_SSE);
 
+#define ACTUAL_FORWARD_AVX512(name, ...) \
+	if (hasAVX512) \
+		actual.name(__VA_ARGS__); \
+	else \
+		throw Error(Error::ERR_AVX_INSTR_IN_SSE);
+
 #define ACTUAL_FORWARD_FMA(name, ...) \
 	if (hasFMA) \
 		actual.name(__VA_ARGS__); \
@@ -389,6 +397,9 @@ public:
 	FORWARD(2, AVX2, vpbroadcastq,   ARGS_XO)
 	FORWARD(2, AVX2, vpbroadcastw,   ARGS_XO)
 	FORWARD(3, AVX2, vpermq,         const Ymm&, const Operand&, u8)
+	FORWARD(3, AVX512, vpermi2d,     ARGS_XXO)
+	FORWARD(2, AVX512, vmovdqu32,    ARGS_XO)
+	FORWARD(4, AVX512, vpternlogd,   const Xmm&, const Xmm&, const Operand&, u8)
 	FORWARD(3, AVX2, vpgatherdd,     const Xmm&, const Address&, const Xmm&);
 	FORWARD(3, AVX2, vpsravd,        ARGS_XXO)
 	FORWARD(3, AVX2, vpsrlvd,        ARGS_XXO)
@@ -414,6 +425,7 @@ public:
 #undef FORWARD2
 #undef FORWARD1
 #undef ACTUAL_FORWARD_FMA
+#undef ACTUAL_FORWARD_AVX512
 #undef ACTUAL_FORWARD_AVX2
 #undef ACTUAL_FORWARD_AVX
 #undef ACTUAL_FORWARD_SSE
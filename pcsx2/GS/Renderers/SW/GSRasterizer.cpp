@@ -48,6 +48,7 @@ GSRasterizer::GSRasterizer(GSDrawScanline* ds, int id, int threads)
 	: m_ds(ds)
 	, m_id(id)
 	, m_threads(threads)
+	, m_band(-1)
 	, m_scanmsk_value(0)
 {
 	memset(&m_pixels, 0, sizeof(m_pixels));
@@ -63,9 +64,23 @@ GSRasterizer::GSRasterizer(GSDrawScanline* ds, int id, int threads)
 	int rows = (2048 >> m_thread_height) + 16;
 	m_scanline = (u8*)_aligned_malloc(rows, 64);
 
-	for (int i = 0; i < rows; i++)
+	if (threads > 0)
 	{
-		m_scanline[i] = (i % threads) == id ? 1 : 0;
+		for (int i = 0; i < rows; i++)
+		{
+			m_scanline[i] = (i % threads) == id ? 1 : 0;
+		}
+
+		m_skip_rows = (threads - 1) << m_thread_height;
+	}
+	else
+	{
+		// Nothing is ours until SetBand(). The last row stops FindMyNextScanline() from running
+		// off the end when the primitive starts below our band, and leaving the band skips
+		// straight past the bottom of the screen.
+		std::memset(m_scanline, 0, rows);
+		m_scanline[rows - 1] = 1;
+		m_skip_rows = 2048;
 	}
 }
 
@@ -122,6 +137,17 @@ int GSRasterizer::FindMyNextScanline(int top) const
 	return top;
 }
 
+void GSRasterizer::SetBand(int band)
+{
+	ASSERT(m_threads == 0 && band >= 0 && band < (2048 >> m_thread_height));
+
+	if (m_band >= 0)
+		m_scanline[m_band] = 0;
+
+	m_band = band;
+	m_scanline[band] = 1;
+}
+
 int GSRasterizer::GetPixels(bool reset)
 {
 	int pixels = m_pixels.sum;
@@ -136,7 +162,12 @@ int GSRasterizer::GetPixels(bool reset)
 
 void GSRasterizer::Draw(GSRasterizerData& data)
 {
-	if ((data.vertex && data.vertex_count == 0) || (data.index && data.index_count == 0))
+	Draw(data, data.index, data.index_count);
+}
+
+void GSRasterizer::Draw(GSRasterizerData& data, const u32* index, int index_count)
+{
+	if ((data.vertex && data.vertex_count == 0) || (index && index_count == 0))
 		return;
 
 	m_pixels.actual = 0;
@@ -154,8 +185,7 @@ void GSRasterizer::Draw(GSRasterizerData& data)
 	const GSVertexSW* vertex = data.vertex;
 	const GSVertexSW* vertex_end = data.vertex + data.vertex_count;
 
-	const u32* index = data.index;
-	const u32* index_end = data.index + data.index_count;
+	const u32* index_end = index + index_count;
 
 	u32 tmp_index[] = {0, 1, 2};
 
@@ -172,11 +202,11 @@ void GSRasterizer::Draw(GSRasterizerData& data)
 
 			if (scissor_test)
 			{
-				DrawPoint<true>(vertex, data.vertex_count, index, data.index_count);
+				DrawPoint<true>(vertex, data.vertex_count, index, index_count);
 			}
 			else
 			{
-				DrawPoint<false>(vertex, data.vertex_count, index, data.index_count);
+				DrawPoint<false>(vertex, data.vertex_count, index, index_count);
 			}
 
 			break;
@@ -597,7 +627,7 @@ void GSRasterizer::DrawTriangleSection(int top, int bottom, GSVertexSW2& RESTRIC
 
 		if (!IsOneOfMyScanlines(top))
 		{
-			top += (m_threads - 1) << m_thread_height;
+			top += m_skip_rows;
 		}
 	}
 
@@ -775,7 +805,7 @@ void GSRasterizer::DrawTriangleSection(int top, int bottom, GSVertexSW& RESTRICT
 
 		if (!IsOneOfMyScanlines(top))
 		{
-			top += (m_threads - 1) << m_thread_height;
+			top += m_skip_rows;
 		}
 	}
 
@@ -839,7 +869,7 @@ void GSRasterizer::DrawSprite(const GSVertexSW* vertex, const u32* index)
 				m_pixels.actual += pixels;
 				m_pixels.total += pixels;
 
-				top = r.bottom + ((m_threads - 1) << m_thread_height);
+				top = r.bottom + m_skip_rows;
 			}
 		}
 
@@ -1200,22 +1230,27 @@ void GSSingleRasterizer::PrintStats()
 GSRasterizerList::GSRasterizerList(int threads)
 {
 	m_thread_height = compute_best_thread_height(threads);
+	m_band_count = 2048 >> m_thread_height;
 
-	const int rows = (2048 >> m_thread_height) + 16;
-	m_scanline = static_cast<u8*>(_aligned_malloc(rows, 64));
+	m_bands = std::make_unique<Band[]>(m_band_count);
+	for (int i = 0; i < m_band_count; i++)
+		m_bands[i].items = std::make_unique<BandItem[]>(BAND_QUEUE_SIZE);
 
-	for (int i = 0; i < rows; i++)
-	{
-		m_scanline[i] = static_cast<u8>(i % threads);
-	}
+	m_bin_counts.resize(m_band_count);
+	m_bin_offsets.resize(m_band_count);
 
 	PerformanceMetrics::SetGSSWThreadCount(threads);
 }
 
 GSRasterizerList::~GSRasterizerList()
 {
+	m_exit.store(true, std::memory_order_release);
+	for (const std::unique_ptr<Worker>& worker : m_workers)
+		worker->sema.NotifyOfWork();
+	for (const std::unique_ptr<Worker>& worker : m_workers)
+		worker->thread.join();
+
 	PerformanceMetrics::SetGSSWThreadCount(0);
-	_aligned_free(m_scanline);
 }
 
 void GSRasterizerList::OnWorkerStartup(int i)
@@ -1244,6 +1279,186 @@ void GSRasterizerList::OnWorkerShutdown(int i)
 {
 }
 
+void GSRasterizerList::WorkerThread(int id)
+{
+	OnWorkerStartup(id);
+
+	Worker& worker = *m_workers[id];
+	for (;;)
+	{
+		worker.sema.WaitForWorkWithSpin();
+		if (m_exit.load(std::memory_order_acquire))
+			break;
+
+		while (ProcessBands(id))
+			;
+	}
+
+	OnWorkerShutdown(id);
+}
+
+bool GSRasterizerList::ProcessBands(int id)
+{
+	Worker& worker = *m_workers[id];
+	const int threads = static_cast<int>(m_workers.size());
+	const int active = m_active_bands.load(std::memory_order_acquire);
+
+	// Our own bands first, they're the most likely to still be in our cache.
+	bool did_work = false;
+	for (int band = id; band < active; band += threads)
+		did_work |= ProcessBand(worker, band);
+	if (did_work)
+		return true;
+
+	// Then help out with everyone else's, starting with our neighbours so the thieves spread out.
+	for (int i = 1; i < active; i++)
+	{
+		const int band = (id + i) % active;
+		if ((band % threads) != id && ProcessBand(worker, band))
+			return true;
+	}
+
+	return false;
+}
+
+bool GSRasterizerList::ProcessBand(Worker& worker, int index)
+{
+	Band& band = m_bands[index];
+	if (band.head.load(std::memory_order_relaxed) == band.tail.load(std::memory_order_acquire) ||
+		band.owned.load(std::memory_order_relaxed) || band.owned.exchange(true, std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	worker.r->SetBand(index);
+
+	for (;;)
+	{
+		u32 head = band.head.load(std::memory_order_relaxed);
+		const u32 tail = band.tail.load(std::memory_order_acquire);
+		for (; head != tail; head++)
+		{
+			BandItem& item = band.items[head % BAND_QUEUE_SIZE];
+			worker.r->Draw(*item.data.get(), item.index, item.index_count);
+			item.data = nullptr;
+			band.head.store(head + 1, std::memory_order_release);
+		}
+
+		// The producer may have pushed after we last looked, in which case nobody else has been
+		// told about it, so check again once the band is given up.
+		band.owned.store(false, std::memory_order_seq_cst);
+		if (band.tail.load(std::memory_order_seq_cst) == head || band.owned.exchange(true, std::memory_order_acquire))
+			break;
+	}
+
+	return true;
+}
+
+void GSRasterizerList::Push(int index, const GSRingHeap::SharedPtr<GSRasterizerData>& data, const u32* indices, int index_count)
+{
+	Band& band = m_bands[index];
+	Worker& owner = *m_workers[index % m_workers.size()];
+	const u32 tail = band.tail.load(std::memory_order_relaxed);
+	while ((tail - band.head.load(std::memory_order_acquire)) >= BAND_QUEUE_SIZE)
+	{
+		owner.sema.NotifyOfWork();
+		std::this_thread::yield();
+	}
+
+	BandItem& item = band.items[tail % BAND_QUEUE_SIZE];
+	item.data = data;
+	item.index = indices;
+	item.index_count = index_count;
+
+	if (index >= m_active_bands.load(std::memory_order_relaxed))
+		m_active_bands.store(index + 1, std::memory_order_release);
+
+	band.tail.store(tail + 1, std::memory_order_seq_cst);
+	owner.notify = true;
+}
+
+int GSRasterizerList::GetIndicesPerPrim(GS_PRIM_CLASS primclass)
+{
+	switch (primclass)
+	{
+		case GS_POINT_CLASS:
+			return 1;
+		case GS_TRIANGLE_CLASS:
+			return 3;
+		default:
+			return 2;
+	}
+}
+
+void GSRasterizerList::QueueBinned(const GSRingHeap::SharedPtr<GSRasterizerData>& data, int top, int bottom)
+{
+	GSRasterizerData& d = *data.get();
+	const int stride = GetIndicesPerPrim(d.primclass);
+	const int prims = d.index_count / stride;
+	const GSVector4i r = d.bbox.rintersect(d.scissor);
+
+	// Work out which bands each primitive can touch. This only has to be conservative: the rows are
+	// padded by one each way to cover rounding and antialiased edges, and the rasterizer clips to the band.
+	m_prim_bands.resize(prims);
+	std::fill(m_bin_counts.begin() + top, m_bin_counts.begin() + bottom, 0);
+
+	const u32* index = d.index;
+	for (int i = 0; i < prims; i++, index += stride)
+	{
+		float ymin = d.vertex[index[0]].p.y;
+		float ymax = ymin;
+		for (int j = 1; j < stride; j++)
+		{
+			const float y = d.vertex[index[j]].p.y;
+			ymin = std::min(ymin, y);
+			ymax = std::max(ymax, y);
+		}
+
+		const int first_row = std::max(static_cast<int>(std::floor(std::clamp(ymin, -2.0f, 2048.0f))) - 1, r.top);
+		const int last_row = std::min(static_cast<int>(std::ceil(std::clamp(ymax, -2.0f, 2048.0f))) + 1, r.bottom - 1);
+		if (first_row > last_row)
+		{
+			m_prim_bands[i] = {1, 0};
+			continue;
+		}
+
+		const int first_band = first_row >> m_thread_height;
+		const int last_band = last_row >> m_thread_height;
+		m_prim_bands[i] = {static_cast<u16>(first_band), static_cast<u16>(last_band)};
+		for (int band = first_band; band <= last_band; band++)
+			m_bin_counts[band]++;
+	}
+
+	u32 total = 0;
+	for (int band = top; band < bottom; band++)
+	{
+		m_bin_offsets[band] = total;
+		total += m_bin_counts[band];
+	}
+	if (total == 0)
+		return;
+
+	d.bins = static_cast<u32*>(m_bin_heap.alloc(sizeof(u32) * stride * total, alignof(u32)));
+
+	index = d.index;
+	for (int i = 0; i < prims; i++, index += stride)
+	{
+		for (int band = m_prim_bands[i].first; band <= m_prim_bands[i].second; band++)
+		{
+			u32* dst = d.bins + (m_bin_offsets[band]++) * stride;
+			for (int j = 0; j < stride; j++)
+				dst[j] = index[j];
+		}
+	}
+
+	for (int band = top; band < bottom; band++)
+	{
+		const u32 count = m_bin_counts[band];
+		if (count > 0)
+			Push(band, data, d.bins + (m_bin_offsets[band] - count) * stride, static_cast<int>(count * stride));
+	}
+}
+
 void GSRasterizerList::Queue(const GSRingHeap::SharedPtr<GSRasterizerData>& data)
 {
 	GSVector4i r = data->bbox.rintersect(data->scissor);
@@ -1257,12 +1472,33 @@ void GSRasterizerList::Queue(const GSRingHeap::SharedPtr<GSRasterizerData>& data
 
 	ASSERT(r.top >= 0 && r.top < 2048 && r.bottom >= 0 && r.bottom < 2048);
 
-	int top = r.top >> m_thread_height;
-	int bottom = std::min<int>((r.bottom + (1 << m_thread_height) - 1) >> m_thread_height, top + m_workers.size());
+	const int top = r.top >> m_thread_height;
+	const int bottom = std::min<int>((r.bottom + (1 << m_thread_height) - 1) >> m_thread_height, m_band_count);
+	if (top >= bottom)
+		return;
 
-	while (top < bottom)
+	if ((bottom - top) > 1 && data->index && (data->index_count / GetIndicesPerPrim(data->primclass)) >= MIN_PRIMS_TO_BIN)
 	{
-		m_workers[m_scanline[top++]]->Push(data);
+		QueueBinned(data, top, bottom);
+	}
+	else
+	{
+		for (int band = top; band < bottom; band++)
+			Push(band, data, data->index, data->index_count);
+	}
+
+	// Wake the owners of the bands we touched, and one more thread, which can pick up any of
+	// those bands if its owner is still busy with an earlier draw.
+	const u32 threads = static_cast<u32>(m_workers.size());
+	m_next_thief = (m_next_thief + 1) % threads;
+	m_workers[m_next_thief]->notify = true;
+	for (const std::unique_ptr<Worker>& worker : m_workers)
+	{
+		if (worker->notify)
+		{
+			worker->notify = false;
+			worker->sema.NotifyOfWork();
+		}
 	}
 }
 
@@ -1270,10 +1506,12 @@ void GSRasterizerList::Sync()
 {
 	if (!IsSynced())
 	{
-		for (size_t i = 0; i < m_workers.size(); i++)
-		{
-			m_workers[i]->Wait();
-		}
+		// A worker only goes back to sleep once it can't find any band with work that nobody else
+		// is drawing, so once they're all asleep, everything has been drawn.
+		for (const std::unique_ptr<Worker>& worker : m_workers)
+			worker->sema.WaitForEmptyWithSpin();
+
+		ASSERT(IsSynced());
 
 		g_perfmon.Put(GSPerfMon::SyncPoint, 1);
 	}
@@ -1281,12 +1519,11 @@ void GSRasterizerList::Sync()
 
 bool GSRasterizerList::IsSynced() const
 {
-	for (size_t i = 0; i < m_workers.size(); i++)
+	const int active = m_active_bands.load(std::memory_order_relaxed);
+	for (int i = 0; i < active; i++)
 	{
-		if (!m_workers[i]->IsEmpty())
-		{
+		if (m_bands[i].head.load(std::memory_order_acquire) != m_bands[i].tail.load(std::memory_order_relaxed))
 			return false;
-		}
 	}
 
 	return true;
@@ -1296,9 +1533,9 @@ int GSRasterizerList::GetPixels(bool reset)
 {
 	int pixels = 0;
 
-	for (size_t i = 0; i < m_workers.size(); i++)
+	for (const std::unique_ptr<Worker>& worker : m_workers)
 	{
-		pixels += m_r[i]->GetPixels(reset);
+		pixels += worker->r->GetPixels(reset);
 	}
 
 	return pixels;
@@ -1317,13 +1554,16 @@ std::unique_ptr<IRasterizer> GSRasterizerList::Create(int threads)
 
 	for (int i = 0; i < threads; i++)
 	{
-		rl->m_r.push_back(std::unique_ptr<GSRasterizer>(new GSRasterizer(&rl->m_ds, i, threads)));
-		auto& r = *rl->m_r[i];
-		rl->m_workers.push_back(std::unique_ptr<GSWorker>(new GSWorker([i]() { GSRasterizerList::OnWorkerStartup(i); },
-			[&r](GSRingHeap::SharedPtr<GSRasterizerData>& item) { r.Draw(*item.get()); },
-			[i]() { GSRasterizerList::OnWorkerShutdown(i); })));
+		std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+		worker->r = std::unique_ptr<GSRasterizer>(new GSRasterizer(&rl->m_ds, i, 0));
+		worker->notify = false;
+		rl->m_workers.push_back(std::move(worker));
 	}
 
+	// Workers look at each other's bands, so only start them once they all exist.
+	for (int i = 0; i < threads; i++)
+		rl->m_workers[i]->thread = std::thread(&GSRasterizerList::WorkerThread, rl.get(), i);
+
 	return rl;
 }
 
@@ -40,6 +40,7 @@ public:
 	int vertex_count;
 	u32* index;
 	int index_count;
+	u32* bins; // per-band copies of the indices, filled in by GSRasterizerList
 	u64 frame;
 	u64 start;
 	int pixels;
@@ -61,6 +62,7 @@ public:
 		, vertex_count(0)
 		, index(NULL)
 		, index_count(0)
+		, bins(nullptr)
 		, frame(0)
 		, start(0)
 		, pixels(0)
@@ -73,6 +75,8 @@ public:
 	{
 		if (buff != NULL)
 			GSRingHeap::free(buff);
+		if (bins)
+			GSRingHeap::free(bins);
 	}
 };
 
@@ -83,6 +87,8 @@ protected:
 	int m_id;
 	int m_threads;
 	int m_thread_height;
+	int m_band;
+	int m_skip_rows;
 	u8* m_scanline;
 	u8 m_scanmsk_value;
 	GSVector4i m_scissor;
@@ -121,6 +127,7 @@ protected:
 	__forceinline void DrawEdge(int pixels, int left, int top, const GSVertexSW& scan);
 
 public:
+	/// With threads == 0, the rasterizer doesn't own any scanlines until SetBand() is called.
 	GSRasterizer(GSDrawScanline* ds, int id, int threads);
 	~GSRasterizer();
 
@@ -128,7 +135,11 @@ public:
 	__forceinline bool IsOneOfMyScanlines(int top, int bottom) const;
 	__forceinline int FindMyNextScanline(int top) const;
 
+	/// Restricts drawing to a single band of (1 << thread height) scanlines.
+	void SetBand(int band);
+
 	void Draw(GSRasterizerData& data);
+	void Draw(GSRasterizerData& data, const u32* index, int index_count);
 	int GetPixels(bool reset);
 };
 
@@ -163,21 +174,68 @@ private:
 	GSRasterizer m_r;
 };
 
+// Splits the screen into bands of scanlines, and sorts the primitives of each draw into the
+// bands they touch, so every primitive is only set up by the bands that need it. Each band keeps
+// its draws in order, and is drawn by one worker at a time. Workers prefer their own bands (band
+// number modulo thread count), but will take over any other band with pending work when they run
+// out, so a few busy bands don't leave the rest of the threads idle.
 class GSRasterizerList final : public IRasterizer
 {
 protected:
-	using GSWorker = GSJobQueue<GSRingHeap::SharedPtr<GSRasterizerData>, 65536>;
+	static constexpr u32 BAND_QUEUE_SIZE = 512;
+
+	// Draws with fewer primitives than this are sent whole to every band they touch.
+	static constexpr int MIN_PRIMS_TO_BIN = 2;
+
+	struct BandItem
+	{
+		GSRingHeap::SharedPtr<GSRasterizerData> data;
+		const u32* index;
+		int index_count;
+	};
+
+	struct alignas(64) Band
+	{
+		std::atomic<u32> head{0}; // advanced by the owner once an item is drawn
+		std::atomic<u32> tail{0}; // advanced by the producer
+		std::atomic<bool> owned{false};
+		std::unique_ptr<BandItem[]> items;
+	};
+
+	struct alignas(64) Worker
+	{
+		std::unique_ptr<GSRasterizer> r;
+		Threading::WorkSema sema;
+		std::thread thread;
+		bool notify;
+	};
 
 	GSDrawScanline m_ds;
+	GSRingHeap m_bin_heap;
 
-	// Worker threads depend on the rasterizers, so don't change the order.
-	std::vector<std::unique_ptr<GSRasterizer>> m_r;
-	std::vector<std::unique_ptr<GSWorker>> m_workers;
-	u8* m_scanline;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::unique_ptr<Band[]> m_bands;
+	int m_band_count;
+	std::atomic<int> m_active_bands{0};
 	int m_thread_height;
+	u32 m_next_thief = 0;
+	std::atomic<bool> m_exit{false};
+
+	// Scratch space for binning.
+	std::vector<u32> m_bin_counts;
+	std::vector<u32> m_bin_offsets;
+	std::vector<std::pair<u16, u16>> m_prim_bands;
 
 	GSRasterizerList(int threads);
 
+	static int GetIndicesPerPrim(GS_PRIM_CLASS primclass);
+
+	void Push(int band, const GSRingHeap::SharedPtr<GSRasterizerData>& data, const u32* index, int index_count);
+	void QueueBinned(const GSRingHeap::SharedPtr<GSRasterizerData>& data, int top, int bottom);
+	bool ProcessBand(Worker& worker, int band);
+	bool ProcessBands(int id);
+	void WorkerThread(int id);
+
 	static void OnWorkerStartup(int i);
 	static void OnWorkerShutdown(int i);
 
@@ -1049,6 +1049,11 @@ bool GSRendererSW::GetScanlineGlobalData(SharedData* data)
 				gd.clut = (u32*)m_vertex_heap.alloc(sizeof(u32) * 256, 32); // FIXME: might address uninitialized data of the texture (0xCD) that is not in 0-15 range for 4-bpp formats
 
 				memcpy(gd.clut, (const u32*)m_mem.m_clut, sizeof(u32) * GSLocalMemory::m_psm[context->TEX0.PSM].pal);
+
+#if _M_AVX512
+				// 4-bit palettes fit in two ymm registers, the texel lookup becomes a single vpermi2d
+				gd.sel.tlu4 = GSLocalMemory::m_psm[context->TEX0.PSM].pal == 16;
+#endif
 			}
 
 			gd.sel.wms = context->CLAMP.WMS;
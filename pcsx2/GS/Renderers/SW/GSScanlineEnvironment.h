@@ -65,6 +65,7 @@ union GSScanlineSelector
 		u32 notest : 1; // 55 (no ztest, no atest, no date, no scissor test, and horizontally aligned to 4 pixels)
 		// TODO: 1D texture flag? could save 2 texture reads and 4 lerps with bilinear, and also the texture coordinate clamp/wrap code in one direction
 		u32 zequal : 1; // 56
+		u32 tlu4   : 1; // 57 (clut has 16 entries, only set when the jit can keep it in registers)
 		u32 breakpoint : 1; // Insert a trap to stop the program, helpful to stop debugger on a program
 	};
 
@@ -109,12 +110,12 @@ union GSScanlineSelector
 			"tfx:%d tcc:%d fst:%d ltf:%d tlu:%d wms:%d wmt:%d mmin:%d lcm:%d tw:%d "
 			"fba:%d cclamp:%d date:%d datm:%d "
 			"prim:%d abe:%d %d%d%d%d fge:%d dthe:%d notest:%d pabe:%d aa1:%d "
-			"fwrite:%d ftest:%d zoverflow:%d zequal:%d zclamp:%d edge:%d",
+			"fwrite:%d ftest:%d zoverflow:%d zequal:%d zclamp:%d edge:%d tlu4:%d",
 			fpsm, zpsm, ztst, ztest, atst, afail, iip, rfb, fb, zb, zwrite,
 			tfx, tcc, fst, ltf, tlu, wms, wmt, mmin, lcm, tw,
 			fba, colclamp, date, datm,
 			prim, abe, aba, abb, abc, abd, fge, dthe, notest, pabe, aa1,
-			fwrite, ftest, zoverflow, zequal, zclamp, edge);
+			fwrite, ftest, zoverflow, zequal, zclamp, edge, tlu4);
 		return str;
 	}
 
@@ -60,6 +60,11 @@ static u64 s_frame_ticks = 0;
 static u64 s_next_frame_time = 0;
 static bool s_is_dump_runner = false;
 
+// The runner boots the same dump once per pass, so keep it decompressed in between.
+static std::unique_ptr<GSDumpFile> s_cached_dump_file;
+static std::string s_cached_dump_filename;
+static std::time_t s_cached_dump_mtime = 0;
+
 R5900cpu GSDumpReplayerCpu = {
 	GSDumpReplayerCpuReserve,
 	GSDumpReplayerCpuShutdown,
@@ -100,18 +105,33 @@ int GSDumpReplayer::GetLoopCount()
 
 bool GSDumpReplayer::Initialize(const char* filename)
 {
-	Common::Timer timer;
-	Console.WriteLn("(GSDumpReplayer) Reading file '%s'...", filename);
-
-	s_dump_file = GSDumpFile::OpenGSDump(filename);
-	if (!s_dump_file || !s_dump_file->ReadFile())
+	FILESYSTEM_STAT_DATA sd;
+	const std::time_t mtime = FileSystem::StatFile(filename, &sd) ? sd.ModificationTime : 0;
+	if (s_cached_dump_file && s_cached_dump_filename == filename && s_cached_dump_mtime == mtime)
 	{
-		Host::ReportFormattedErrorAsync("GSDumpReplayer", "Failed to open or read '%s'.", filename);
-		s_dump_file.reset();
-		return false;
+		Console.WriteLn("(GSDumpReplayer) Reusing previously read '%s'.", filename);
+		s_dump_file = std::move(s_cached_dump_file);
+	}
+	else
+	{
+		s_cached_dump_file.reset();
+
+		Common::Timer timer;
+		Console.WriteLn("(GSDumpReplayer) Reading file '%s'...", filename);
+
+		s_dump_file = GSDumpFile::OpenGSDump(filename);
+		if (!s_dump_file || !s_dump_file->ReadFile())
+		{
+			Host::ReportFormattedErrorAsync("GSDumpReplayer", "Failed to open or read '%s'.", filename);
+			s_dump_file.reset();
+			return false;
+		}
+
+		Console.WriteLn("(GSDumpReplayer) Read file in %.2f ms.", timer.GetTimeMilliseconds());
 	}
 
-	Console.WriteLn("(GSDumpReplayer) Read file in %.2f ms.", timer.GetTimeMilliseconds());
+	s_cached_dump_filename = filename;
+	s_cached_dump_mtime = mtime;
 
 	// We replace all CPUs.
 	Cpu = &GSDumpReplayerCpu;
@@ -138,6 +158,9 @@ bool GSDumpReplayer::ChangeDump(const char* filename)
 
 	s_dump_file = std::move(new_dump);
 	s_current_packet = 0;
+	s_cached_dump_filename = filename;
+	FILESYSTEM_STAT_DATA sd;
+	s_cached_dump_mtime = FileSystem::StatFile(filename, &sd) ? sd.ModificationTime : 0;
 
 	// Don't forget to reset the GS!
 	GSDumpReplayerCpuReset();
@@ -152,7 +175,11 @@ void GSDumpReplayer::Shutdown()
 	psxCpu = nullptr;
 	CpuVU0 = nullptr;
 	CpuVU1 = nullptr;
-	s_dump_file.reset();
+
+	if (s_is_dump_runner)
+		s_cached_dump_file = std::move(s_dump_file);
+	else
+		s_dump_file.reset();
 }
 
 std::string GSDumpReplayer::GetDumpSerial()
@@ -26,14 +26,19 @@
 #include "common/StringUtil.h"
 #include "common/Timer.h"
 
+#include "svnrev.h"
+
 #include <sstream>
 #include "ryml_std.hpp"
 #include "ryml.hpp"
 #include "fmt/core.h"
 #include "fmt/ranges.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <mutex>
 #include <optional>
+#include <xxhash.h>
 
 namespace GameDatabaseSchema
 {
@@ -42,17 +47,69 @@ namespace GameDatabaseSchema
 	static bool isUserHackHWFix(GSHWFixId id);
 } // namespace GameDatabaseSchema
 
+// The YAML is compiled into a binary index in the cache directory on first use, which later
+// runs map instead of parsing the YAML again. The index is a table of lower-cased serials,
+// sorted for binary search, each pointing at a packed record which is only decoded into a
+// GameEntry when that game is looked up. It's keyed on a hash of the YAML and of the build,
+// as records hold fix IDs, so editing the YAML or updating rebuilds it.
 namespace GameDatabase
 {
+	static constexpr u32 CACHE_MAGIC = 0x42444750; // PGDB
+	static constexpr u32 CACHE_VERSION = 1;
+
+	struct CacheHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 source_hash;
+		u32 num_entries;
+		u32 serials_size;
+		u32 records_size;
+		u32 pad;
+	};
+
+	struct CacheEntry
+	{
+		u32 serial_offset;
+		u32 serial_length;
+		u32 record_offset;
+		u32 record_length;
+	};
+
 	static void parseAndInsert(const std::string_view& serial, const c4::yml::NodeRef& node);
 	static void initDatabase();
+	static bool parseDatabase(const std::string& buf);
+	static u64 getSourceHash(const std::string& buf);
+	static std::string getCachePath();
+	static bool setIndex(const u8* data, size_t size, u64 source_hash);
+	static bool loadIndex(u64 source_hash);
+	static void buildIndex(u64 source_hash, bool persist);
+	static void writeRecord(std::vector<u8>& data, const GameDatabaseSchema::GameEntry& entry);
+	static bool readRecord(const u8* data, size_t size, GameDatabaseSchema::GameEntry* entry);
+	static const CacheEntry* findEntry(const std::string_view& serial);
 } // namespace GameDatabase
 
 static constexpr char GAMEDB_YAML_FILE_NAME[] = "GameIndex.yaml";
+static constexpr char GAMEDB_CACHE_FILE_NAME[] = "gamedb.cache";
 
+// Only filled while compiling the YAML.
 static std::unordered_map<std::string, GameDatabaseSchema::GameEntry> s_game_db;
 static std::once_flag s_load_once_flag;
 
+// The index, either mapped from the cache or built in memory when it can't be written.
+static FileSystem::MappedFile s_index_file;
+static std::vector<u8> s_index_buffer;
+static const GameDatabase::CacheEntry* s_index_entries = nullptr;
+static const char* s_index_serials = nullptr;
+static const u8* s_index_records = nullptr;
+static u32 s_index_num_entries = 0;
+static u32 s_index_serials_size = 0;
+static u32 s_index_records_size = 0;
+
+// Entries decoded so far, by index. Never removed, as callers hold on to the pointers.
+static std::mutex s_decoded_mutex;
+static std::unordered_map<u32, GameDatabaseSchema::GameEntry> s_decoded_entries;
+
 std::string GameDatabaseSchema::GameEntry::memcardFiltersAsString() const
 {
 	return fmt::to_string(fmt::join(memcardFilters, "/"));
@@ -903,8 +960,9 @@ u32 GameDatabaseSchema::GameEntry::applyGSHardwareFixes(Pcsx2Config::GSOptions&
 	return num_applied_fixes;
 }
 
-void GameDatabase::initDatabase()
+bool GameDatabase::parseDatabase(const std::string& buf)
 {
+	bool result = true;
 	ryml::Callbacks rymlCallbacks = ryml::get_callbacks();
 	rymlCallbacks.m_error = [](const char* msg, size_t msg_len, ryml::Location loc, void*) {
 		throw std::runtime_error(fmt::format("[YAML] Parsing error at {}:{} (bufpos={}): {}",
@@ -917,14 +975,7 @@ void GameDatabase::initDatabase()
 	});
 	try
 	{
-		auto buf = Host::ReadResourceFileToString(GAMEDB_YAML_FILE_NAME);
-		if (!buf.has_value())
-		{
-			Console.Error("[GameDB] Unable to open GameDB file, file does not exist.");
-			return;
-		}
-
-		ryml::Tree tree = ryml::parse_in_arena(c4::to_csubstr(buf.value()));
+		ryml::Tree tree = ryml::parse_in_arena(c4::to_csubstr(buf));
 		ryml::NodeRef root = tree.rootref();
 
 		for (const auto& n : root.children())
@@ -949,8 +1000,343 @@ void GameDatabase::initDatabase()
 	catch (const std::exception& e)
 	{
 		Console.Error(fmt::format("[GameDB] Error occured when initializing GameDB: {}", e.what()));
+		result = false;
 	}
 	ryml::reset_callbacks();
+	return result;
+}
+
+u64 GameDatabase::getSourceHash(const std::string& buf)
+{
+	const s64 rev = SVN_REV;
+	XXH64_state_t* state = XXH64_createState();
+	XXH64_reset(state, CACHE_VERSION);
+	XXH64_update(state, GIT_HASH, std::strlen(GIT_HASH));
+	XXH64_update(state, &rev, sizeof(rev));
+#ifndef DISABLE_BUILD_DATE
+	// Builds from outside of git don't get a hash or revision.
+	static constexpr const char build_date[] = __DATE__ " " __TIME__;
+	XXH64_update(state, build_date, sizeof(build_date));
+#endif
+	XXH64_update(state, buf.data(), buf.size());
+	const u64 hash = XXH64_digest(state);
+	XXH64_freeState(state);
+	return hash;
+}
+
+std::string GameDatabase::getCachePath()
+{
+	return EmuFolders::Cache.empty() ? std::string() : Path::Combine(EmuFolders::Cache, GAMEDB_CACHE_FILE_NAME);
+}
+
+bool GameDatabase::setIndex(const u8* data, size_t size, u64 source_hash)
+{
+	CacheHeader hdr;
+	if (size < sizeof(hdr))
+		return false;
+
+	std::memcpy(&hdr, data, sizeof(hdr));
+	if (hdr.magic != CACHE_MAGIC || hdr.version != CACHE_VERSION || hdr.source_hash != source_hash ||
+		size != sizeof(hdr) + static_cast<u64>(hdr.num_entries) * sizeof(CacheEntry) + hdr.serials_size + hdr.records_size)
+	{
+		return false;
+	}
+
+	const CacheEntry* entries = reinterpret_cast<const CacheEntry*>(data + sizeof(hdr));
+	for (u32 i = 0; i < hdr.num_entries; i++)
+	{
+		const CacheEntry& entry = entries[i];
+		if (static_cast<u64>(entry.serial_offset) + entry.serial_length > hdr.serials_size ||
+			static_cast<u64>(entry.record_offset) + entry.record_length > hdr.records_size)
+		{
+			return false;
+		}
+	}
+
+	s_index_entries = entries;
+	s_index_serials = reinterpret_cast<const char*>(data + sizeof(hdr) + hdr.num_entries * sizeof(CacheEntry));
+	s_index_records = reinterpret_cast<const u8*>(s_index_serials + hdr.serials_size);
+	s_index_num_entries = hdr.num_entries;
+	s_index_serials_size = hdr.serials_size;
+	s_index_records_size = hdr.records_size;
+	return true;
+}
+
+bool GameDatabase::loadIndex(u64 source_hash)
+{
+	const std::string path(getCachePath());
+	if (path.empty() || !s_index_file.Open(path.c_str()))
+		return false;
+
+	if (!setIndex(s_index_file.GetData(), s_index_file.GetSize(), source_hash))
+	{
+		Console.WriteLn("[GameDB] Cached index is out of date, rebuilding.");
+		s_index_file.Close();
+		return false;
+	}
+
+	return true;
+}
+
+void GameDatabase::buildIndex(u64 source_hash, bool persist)
+{
+	std::vector<std::pair<std::string_view, const GameDatabaseSchema::GameEntry*>> sorted;
+	sorted.reserve(s_game_db.size());
+	for (const auto& it : s_game_db)
+		sorted.emplace_back(it.first, &it.second);
+	std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+	std::vector<CacheEntry> entries;
+	std::string serials;
+	std::vector<u8> records;
+	entries.reserve(sorted.size());
+	for (const auto& [serial, game] : sorted)
+	{
+		CacheEntry entry;
+		entry.serial_offset = static_cast<u32>(serials.size());
+		entry.serial_length = static_cast<u32>(serial.size());
+		entry.record_offset = static_cast<u32>(records.size());
+		serials.append(serial);
+		writeRecord(records, *game);
+		entry.record_length = static_cast<u32>(records.size()) - entry.record_offset;
+		entries.push_back(entry);
+	}
+
+	CacheHeader hdr = {};
+	hdr.magic = CACHE_MAGIC;
+	hdr.version = CACHE_VERSION;
+	hdr.source_hash = source_hash;
+	hdr.num_entries = static_cast<u32>(entries.size());
+	hdr.serials_size = static_cast<u32>(serials.size());
+	hdr.records_size = static_cast<u32>(records.size());
+
+	s_index_buffer.resize(sizeof(hdr) + entries.size() * sizeof(CacheEntry) + serials.size() + records.size());
+	u8* ptr = s_index_buffer.data();
+	std::memcpy(ptr, &hdr, sizeof(hdr));
+	ptr += sizeof(hdr);
+	std::memcpy(ptr, entries.data(), entries.size() * sizeof(CacheEntry));
+	ptr += entries.size() * sizeof(CacheEntry);
+	std::memcpy(ptr, serials.data(), serials.size());
+	ptr += serials.size();
+	std::memcpy(ptr, records.data(), records.size());
+
+	// Other instances may have the old index mapped, so it's replaced rather than truncated and rewritten.
+	const std::string path(persist ? getCachePath() : std::string());
+	if (!path.empty())
+	{
+		const std::string temp_path(path + ".tmp");
+		if (!FileSystem::WriteBinaryFile(temp_path.c_str(), s_index_buffer.data(), s_index_buffer.size()) ||
+			!FileSystem::RenamePath(temp_path.c_str(), path.c_str()))
+		{
+			Console.Warning("[GameDB] Failed to write cached index to '%s'", path.c_str());
+			FileSystem::DeleteFilePath(temp_path.c_str());
+		}
+	}
+
+	// Serve lookups from the same data as would have been loaded.
+	setIndex(s_index_buffer.data(), s_index_buffer.size(), source_hash);
+}
+
+void GameDatabase::writeRecord(std::vector<u8>& data, const GameDatabaseSchema::GameEntry& entry)
+{
+	auto write = [&data](const void* src, size_t size) {
+		data.insert(data.end(), static_cast<const u8*>(src), static_cast<const u8*>(src) + size);
+	};
+	auto write_u32 = [&write](u32 value) { write(&value, sizeof(value)); };
+	auto write_string = [&write, &write_u32](const std::string& str) {
+		write_u32(static_cast<u32>(str.size()));
+		write(str.data(), str.size());
+	};
+
+	write_string(entry.name);
+	write_string(entry.region);
+	const s8 modes[] = {
+		static_cast<s8>(entry.compat),
+		static_cast<s8>(entry.eeRoundMode),
+		static_cast<s8>(entry.vu0RoundMode),
+		static_cast<s8>(entry.vu1RoundMode),
+		static_cast<s8>(entry.eeClampMode),
+		static_cast<s8>(entry.vu0ClampMode),
+		static_cast<s8>(entry.vu1ClampMode),
+	};
+	write(modes, sizeof(modes));
+
+	write_u32(static_cast<u32>(entry.gameFixes.size()));
+	for (const GamefixId id : entry.gameFixes)
+		write_u32(static_cast<u32>(id));
+
+	write_u32(static_cast<u32>(entry.speedHacks.size()));
+	for (const auto& [id, value] : entry.speedHacks)
+	{
+		write_u32(static_cast<u32>(id));
+		write_u32(static_cast<u32>(value));
+	}
+
+	write_u32(static_cast<u32>(entry.gsHWFixes.size()));
+	for (const auto& [id, value] : entry.gsHWFixes)
+	{
+		write_u32(static_cast<u32>(id));
+		write_u32(static_cast<u32>(value));
+	}
+
+	write_u32(static_cast<u32>(entry.memcardFilters.size()));
+	for (const std::string& filter : entry.memcardFilters)
+		write_string(filter);
+
+	write_u32(static_cast<u32>(entry.patches.size()));
+	for (const auto& [crc, patch] : entry.patches)
+	{
+		write_u32(crc);
+		write_string(patch);
+	}
+
+	write_u32(static_cast<u32>(entry.dynaPatches.size()));
+	for (const DynamicPatch& patch : entry.dynaPatches)
+	{
+		write_u32(static_cast<u32>(patch.pattern.size()));
+		write(patch.pattern.data(), patch.pattern.size() * sizeof(DynamicPatchEntry));
+		write_u32(static_cast<u32>(patch.replacement.size()));
+		write(patch.replacement.data(), patch.replacement.size() * sizeof(DynamicPatchEntry));
+	}
+}
+
+bool GameDatabase::readRecord(const u8* data, size_t size, GameDatabaseSchema::GameEntry* entry)
+{
+	const u8* ptr = data;
+	const u8* const end = data + size;
+	auto read = [&ptr, end](void* dst, size_t len) {
+		if (static_cast<size_t>(end - ptr) < len)
+			return false;
+		std::memcpy(dst, ptr, len);
+		ptr += len;
+		return true;
+	};
+	auto read_u32 = [&read](u32* value) { return read(value, sizeof(*value)); };
+	auto read_count = [&ptr, end, &read_u32](u32* count, size_t min_size) {
+		// Counts are checked against what's left, so a bad one can't allocate the world.
+		return read_u32(count) && static_cast<u64>(*count) * min_size <= static_cast<size_t>(end - ptr);
+	};
+	auto read_string = [&read, &read_count](std::string* str) {
+		u32 len;
+		if (!read_count(&len, 1))
+			return false;
+		str->resize(len);
+		return read(str->data(), len);
+	};
+
+	s8 modes[7];
+	if (!read_string(&entry->name) || !read_string(&entry->region) || !read(modes, sizeof(modes)))
+		return false;
+
+	entry->compat = static_cast<GameDatabaseSchema::Compatibility>(modes[0]);
+	entry->eeRoundMode = static_cast<GameDatabaseSchema::RoundMode>(modes[1]);
+	entry->vu0RoundMode = static_cast<GameDatabaseSchema::RoundMode>(modes[2]);
+	entry->vu1RoundMode = static_cast<GameDatabaseSchema::RoundMode>(modes[3]);
+	entry->eeClampMode = static_cast<GameDatabaseSchema::ClampMode>(modes[4]);
+	entry->vu0ClampMode = static_cast<GameDatabaseSchema::ClampMode>(modes[5]);
+	entry->vu1ClampMode = static_cast<GameDatabaseSchema::ClampMode>(modes[6]);
+
+	u32 count, id, value;
+	if (!read_count(&count, sizeof(u32)))
+		return false;
+	entry->gameFixes.reserve(count);
+	for (u32 i = 0; i < count; i++)
+	{
+		if (!read_u32(&id))
+			return false;
+		entry->gameFixes.push_back(static_cast<GamefixId>(id));
+	}
+
+	if (!read_count(&count, sizeof(u32) * 2))
+		return false;
+	entry->speedHacks.reserve(count);
+	for (u32 i = 0; i < count; i++)
+	{
+		if (!read_u32(&id) || !read_u32(&value))
+			return false;
+		entry->speedHacks.emplace_back(static_cast<SpeedhackId>(id), static_cast<int>(value));
+	}
+
+	if (!read_count(&count, sizeof(u32) * 2))
+		return false;
+	entry->gsHWFixes.reserve(count);
+	for (u32 i = 0; i < count; i++)
+	{
+		if (!read_u32(&id) || !read_u32(&value))
+			return false;
+		entry->gsHWFixes.emplace_back(static_cast<GameDatabaseSchema::GSHWFixId>(id), static_cast<s32>(value));
+	}
+
+	if (!read_count(&count, sizeof(u32)))
+		return false;
+	entry->memcardFilters.resize(count);
+	for (std::string& filter : entry->memcardFilters)
+	{
+		if (!read_string(&filter))
+			return false;
+	}
+
+	if (!read_count(&count, sizeof(u32) * 2))
+		return false;
+	for (u32 i = 0; i < count; i++)
+	{
+		std::string patch;
+		if (!read_u32(&id) || !read_string(&patch))
+			return false;
+		entry->patches.emplace(id, std::move(patch));
+	}
+
+	if (!read_count(&count, sizeof(u32) * 2))
+		return false;
+	entry->dynaPatches.resize(count);
+	for (DynamicPatch& patch : entry->dynaPatches)
+	{
+		if (!read_count(&count, sizeof(DynamicPatchEntry)))
+			return false;
+		patch.pattern.resize(count);
+		if (!read(patch.pattern.data(), count * sizeof(DynamicPatchEntry)) || !read_count(&count, sizeof(DynamicPatchEntry)))
+			return false;
+		patch.replacement.resize(count);
+		if (!read(patch.replacement.data(), count * sizeof(DynamicPatchEntry)))
+			return false;
+	}
+
+	return (ptr == end);
+}
+
+const GameDatabase::CacheEntry* GameDatabase::findEntry(const std::string_view& serial)
+{
+	const CacheEntry* const end = s_index_entries + s_index_num_entries;
+	const CacheEntry* it = std::lower_bound(s_index_entries, end, serial, [](const CacheEntry& entry, const std::string_view& value) {
+		return std::string_view(s_index_serials + entry.serial_offset, entry.serial_length) < value;
+	});
+	if (it == end || std::string_view(s_index_serials + it->serial_offset, it->serial_length) != serial)
+		return nullptr;
+
+	return it;
+}
+
+void GameDatabase::initDatabase()
+{
+	auto buf = Host::ReadResourceFileToString(GAMEDB_YAML_FILE_NAME);
+	if (!buf.has_value())
+	{
+		Console.Error("[GameDB] Unable to open GameDB file, file does not exist.");
+		return;
+	}
+
+	// Hashing the YAML is a small fraction of the time it takes to parse it.
+	const u64 source_hash = getSourceHash(buf.value());
+	if (loadIndex(source_hash))
+		return;
+
+	// Don't keep a partial database around, and don't cache the empty one either, so the next run tries again.
+	const bool parsed = parseDatabase(buf.value());
+	if (!parsed)
+		s_game_db.clear();
+
+	buildIndex(source_hash, parsed);
+	s_game_db = {};
 }
 
 void GameDatabase::ensureLoaded()
@@ -959,7 +1345,7 @@ void GameDatabase::ensureLoaded()
 		Common::Timer timer;
 		Console.WriteLn(fmt::format("[GameDB] Has not been initialized yet, initializing..."));
 		initDatabase();
-		Console.WriteLn("[GameDB] %zu games on record (loaded in %.2fms)", s_game_db.size(), timer.GetTimeMilliseconds());
+		Console.WriteLn("[GameDB] %u games on record (loaded in %.2fms)", s_index_num_entries, timer.GetTimeMilliseconds());
 	});
 }
 
@@ -973,13 +1359,27 @@ const GameDatabaseSchema::GameEntry* GameDatabase::findGame(const std::string_vi
 		return nullptr;
 
 	Console.WriteLn(fmt::format("[GameDB] Searching for '{}' in GameDB", serialLower));
-	const auto gameEntry = s_game_db.find(serialLower);
-	if (gameEntry != s_game_db.end())
+	const CacheEntry* entry = findEntry(serialLower);
+	if (!entry)
 	{
-		Console.WriteLn(fmt::format("[GameDB] Found '{}' in GameDB", serialLower));
-		return &gameEntry->second;
+		Console.Error(fmt::format("[GameDB] Could not find '{}' in GameDB", serialLower));
+		return nullptr;
 	}
 
-	Console.Error(fmt::format("[GameDB] Could not find '{}' in GameDB", serialLower));
-	return nullptr;
+	const u32 index = static_cast<u32>(entry - s_index_entries);
+	std::unique_lock lock(s_decoded_mutex);
+	auto it = s_decoded_entries.find(index);
+	if (it == s_decoded_entries.end())
+	{
+		GameDatabaseSchema::GameEntry gameEntry;
+		if (!readRecord(s_index_records + entry->record_offset, entry->record_length, &gameEntry))
+		{
+			Console.Error(fmt::format("[GameDB] Entry for '{}' is corrupted", serialLower));
+			return nullptr;
+		}
+		it = s_decoded_entries.emplace(index, std::move(gameEntry)).first;
+	}
+
+	Console.WriteLn(fmt::format("[GameDB] Found '{}' in GameDB", serialLower));
+	return &it->second;
 }
@@ -23,11 +23,167 @@
 #include "DEV9/DEV9.h"
 #include "IopHw.h"
 
+#include <bitset>
+
 uptr *psxMemWLUT = NULL;
 const uptr *psxMemRLUT = NULL;
 
 IopVM_MemoryAllocMess* iopMem = NULL;
 
+uptr iopFastmemBase = 0;
+
+static constexpr u32 IOP_FASTMEM_RAM_MIRRORS = 4;
+static constexpr u32 IOP_FASTMEM_RAM_PAGES = Ps2MemSize::IopRam / __pagesize;
+
+static std::unique_ptr<SharedMemoryMappingArea> s_fastmem_area;
+static std::bitset<IOP_FASTMEM_RAM_PAGES> s_fastmem_code_pages;
+static std::vector<std::pair<u8*, u32>> s_fastmem_mappings;
+static bool s_fastmem_isolated = false;
+
+// --------------------------------------------------------------------------------------
+//  IOP fastmem view
+// --------------------------------------------------------------------------------------
+static void ReleaseFastmem()
+{
+	iopFastmemBase = 0;
+	if (!s_fastmem_area)
+		return;
+
+	for (const auto& [ptr, size] : s_fastmem_mappings)
+		s_fastmem_area->Unmap(ptr, size);
+	s_fastmem_mappings.clear();
+	s_fastmem_area.reset();
+}
+
+static void AllocFastmem()
+{
+	pxAssert(!s_fastmem_area);
+	s_fastmem_area = SharedMemoryMappingArea::Create(IOP_FASTMEM_AREA_SIZE);
+	if (!s_fastmem_area)
+	{
+		Console.Error("Failed to allocate IOP fastmem area, IOP memory accesses will go through the handlers.");
+		return;
+	}
+
+	void* const file_handle = GetVmMemory().MainMemory()->GetFileHandle();
+	const uptr main_base = reinterpret_cast<uptr>(GetVmMemory().MainMemory()->GetBase());
+	const auto map = [&](u32 iop_addr, const u8* ptr, u32 size, const PageProtectionMode& mode) {
+		u8* view = s_fastmem_area->OffsetPointer(iop_addr);
+		if (!s_fastmem_area->Map(file_handle, reinterpret_cast<uptr>(ptr) - main_base, view, size, mode))
+		{
+			Console.Error("Failed to map IOP fastmem view at %08X", iop_addr);
+			return false;
+		}
+		s_fastmem_mappings.emplace_back(view, size);
+		return true;
+	};
+
+	// Same layout as the LUTs in iopMemoryReserve::Reset(), minus the pages which need handlers.
+	bool okay = true;
+	for (u32 i = 0; i < IOP_FASTMEM_RAM_MIRRORS; i++)
+		okay = okay && map(i * Ps2MemSize::IopRam, iopMem->Main, Ps2MemSize::IopRam, PageAccess_ReadWrite());
+	okay = okay && map(0x1fc00000, eeMem->ROM, Ps2MemSize::Rom, PageAccess_ReadOnly());
+	okay = okay && map(0x1e000000, eeMem->ROM1, Ps2MemSize::Rom1, PageAccess_ReadOnly());
+	okay = okay && map(0x1e400000, eeMem->ROM2, Ps2MemSize::Rom2, PageAccess_ReadOnly());
+	if (!okay)
+	{
+		ReleaseFastmem();
+		return;
+	}
+
+	iopFastmemBase = reinterpret_cast<uptr>(s_fastmem_area->BasePointer());
+	DevCon.WriteLn(Color_StrongGreen, "IOP fastmem area: %p - %p",
+		iopFastmemBase, iopFastmemBase + (IOP_FASTMEM_AREA_SIZE - 1));
+}
+
+static void ProtectFastmemRamPages(u32 first_page, u32 num_pages, bool writable)
+{
+	for (u32 i = 0; i < IOP_FASTMEM_RAM_MIRRORS; i++)
+	{
+		HostSys::MemProtect(s_fastmem_area->OffsetPointer(i * Ps2MemSize::IopRam + first_page * __pagesize),
+			num_pages * __pagesize, writable ? PageAccess_ReadWrite() : PageAccess_ReadOnly());
+	}
+}
+
+bool iopMemGetFastmemAddress(uptr host_addr, u32* guest_addr)
+{
+	if (!iopFastmemBase || host_addr < iopFastmemBase || host_addr >= (iopFastmemBase + IOP_FASTMEM_AREA_SIZE))
+		return false;
+
+	*guest_addr = static_cast<u32>(host_addr - iopFastmemBase);
+	return true;
+}
+
+void iopMemProtectFastmemCode(u32 addr, u32 size)
+{
+	addr &= 0x1fffffff;
+	if (!iopFastmemBase || addr >= IOP_FASTMEM_RAM_MIRRORS * Ps2MemSize::IopRam || size == 0)
+		return;
+
+	addr &= Ps2MemSize::IopRam - 1;
+	const u32 first_page = addr / __pagesize;
+	const u32 last_page = std::min((addr + size - 1) / __pagesize, IOP_FASTMEM_RAM_PAGES - 1);
+	for (u32 page = first_page; page <= last_page; page++)
+	{
+		if (s_fastmem_code_pages[page])
+			continue;
+
+		s_fastmem_code_pages[page] = true;
+		if (!s_fastmem_isolated)
+			ProtectFastmemRamPages(page, 1, false);
+	}
+}
+
+bool iopMemUnprotectFastmemCode(u32 addr)
+{
+	addr &= 0x1fffffff;
+	if (!iopFastmemBase || s_fastmem_isolated || addr >= IOP_FASTMEM_RAM_MIRRORS * Ps2MemSize::IopRam)
+		return false;
+
+	const u32 page = (addr & (Ps2MemSize::IopRam - 1)) / __pagesize;
+	if (!s_fastmem_code_pages[page])
+		return false;
+
+	s_fastmem_code_pages[page] = false;
+	ProtectFastmemRamPages(page, 1, true);
+	return true;
+}
+
+void iopMemUpdateFastmemIsolation()
+{
+	const bool isolated = (psxRegs.CP0.n.Status & 0x10000) != 0;
+	if (!iopFastmemBase || isolated == s_fastmem_isolated)
+		return;
+
+	s_fastmem_isolated = isolated;
+
+	// Code pages are read-only either way.
+	u32 page = 0;
+	while (page < IOP_FASTMEM_RAM_PAGES)
+	{
+		if (s_fastmem_code_pages[page])
+		{
+			page++;
+			continue;
+		}
+
+		const u32 first_page = page;
+		while (page < IOP_FASTMEM_RAM_PAGES && !s_fastmem_code_pages[page])
+			page++;
+		ProtectFastmemRamPages(first_page, page - first_page, !isolated);
+	}
+}
+
+void iopMemResetFastmemProtection()
+{
+	if (!iopFastmemBase)
+		return;
+
+	s_fastmem_code_pages.reset();
+	s_fastmem_isolated = (psxRegs.CP0.n.Status & 0x10000) != 0;
+	ProtectFastmemRamPages(0, IOP_FASTMEM_RAM_PAGES, !s_fastmem_isolated);
+}
+
 alignas(__pagesize) u8 iopHw[Ps2MemSize::IopHardware];
 
 // --------------------------------------------------------------------------------------
@@ -53,12 +209,16 @@ void iopMemoryReserve::Assign(VirtualMemoryManagerPtr allocator)
 
 	VtlbMemoryReserve::Assign(std::move(allocator), HostMemoryMap::IOPmemOffset, sizeof(*iopMem));
 	iopMem = reinterpret_cast<IopVM_MemoryAllocMess*>(GetPtr());
+
+	AllocFastmem();
 }
 
 void iopMemoryReserve::Release()
 {
 	_parent::Release();
 
+	ReleaseFastmem();
+
 	safe_aligned_free(psxMemWLUT);
 	psxMemRLUT = nullptr;
 	iopMem = nullptr;
@@ -85,6 +85,33 @@ extern void iopMemWrite32(u32 mem, u32 value);
 
 std::string iopMemReadString(u32 mem, int maxlen = 65536);
 
+// Host view of the IOP's 512MB physical address space, used by the recompiler for fastmem.
+// RAM (and its mirrors) is mapped read/write and the ROMs read-only. Everything else is left
+// unmapped, so hardware register accesses fault and get backpatched to the handlers.
+// Null if the view couldn't be created.
+extern uptr iopFastmemBase;
+
+static constexpr u32 IOP_FASTMEM_AREA_SIZE = 0x20000000;
+
+// Returns true if host_addr lies within the fastmem view, and the IOP address it corresponds to.
+extern bool iopMemGetFastmemAddress(uptr host_addr, u32* guest_addr);
+
+// Write-protects the RAM pages which [addr, addr+size) was recompiled from, so fastmem stores
+// to them fault, and get sent through the handlers which clear the recompiled blocks.
+extern void iopMemProtectFastmemCode(u32 addr, u32 size);
+
+// Makes the RAM page containing addr writable again, for when a store to it faulted and the
+// recompiler is throwing out the blocks compiled from it. Returns false if it wasn't a code
+// page, i.e. the fault was for something else.
+extern bool iopMemUnprotectFastmemCode(u32 addr);
+
+// Makes all of RAM read-only in the fastmem view while the cache is isolated (Status.IsC), since
+// those writes have to be dropped.
+extern void iopMemUpdateFastmemIsolation();
+
+// Drops all code protection. Called when the recompiler is reset.
+extern void iopMemResetFastmemProtection();
+
 namespace IopMemory
 {
 	// Sif functions not made yet (will for future Iop improvements):
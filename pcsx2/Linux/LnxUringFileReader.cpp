@@ -0,0 +1,465 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "AsyncFileReader.h"
+#include "HostSettings.h"
+#include "common/AlignedMalloc.h"
+#include "common/FileSystem.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// We talk to the kernel directly rather than pulling in liburing, we only need reads.
+struct UringFileReader::Ring
+{
+	int fd = -1;
+
+	void* sqPtr = MAP_FAILED;
+	size_t sqSize = 0;
+	void* cqPtr = MAP_FAILED;
+	size_t cqSize = 0;
+	io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	size_t sqesSize = 0;
+
+	u32* sqHead;
+	u32* sqTail;
+	u32 sqMask;
+	u32* sqArray;
+	u32 sqEntries;
+	u32 toSubmit = 0;
+
+	u32* cqHead;
+	u32* cqTail;
+	u32 cqMask;
+	io_uring_cqe* cqes;
+
+	~Ring()
+	{
+		if (sqes != MAP_FAILED)
+			munmap(sqes, sqesSize);
+		if (cqPtr != MAP_FAILED && cqPtr != sqPtr)
+			munmap(cqPtr, cqSize);
+		if (sqPtr != MAP_FAILED)
+			munmap(sqPtr, sqSize);
+		if (fd >= 0)
+			close(fd);
+	}
+
+	bool Init(u32 entries)
+	{
+		io_uring_params params = {};
+		fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (fd < 0)
+			return false;
+
+		sqSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+		cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			sqSize = cqSize = std::max(sqSize, cqSize);
+
+		sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sqPtr == MAP_FAILED)
+			return false;
+
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			cqPtr = sqPtr;
+		else if ((cqPtr = mmap(nullptr, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING)) == MAP_FAILED)
+			return false;
+
+		sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+		if (sqes == MAP_FAILED)
+			return false;
+
+		u8* sq = static_cast<u8*>(sqPtr);
+		sqHead = reinterpret_cast<u32*>(sq + params.sq_off.head);
+		sqTail = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+		sqMask = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+		sqArray = reinterpret_cast<u32*>(sq + params.sq_off.array);
+		sqEntries = params.sq_entries;
+
+		u8* cq = static_cast<u8*>(cqPtr);
+		cqHead = reinterpret_cast<u32*>(cq + params.cq_off.head);
+		cqTail = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+		cqMask = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	bool QueueRead(int file, void* buffer, u32 size, s64 offset, u64 userData)
+	{
+		const u32 tail = *sqTail;
+		if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+			return false;
+
+		const u32 index = tail & sqMask;
+		io_uring_sqe* sqe = &sqes[index];
+		std::memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = file;
+		sqe->addr = reinterpret_cast<u64>(buffer);
+		sqe->len = size;
+		sqe->off = static_cast<u64>(offset);
+		sqe->user_data = userData;
+		sqArray[index] = index;
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+		toSubmit++;
+		return true;
+	}
+
+	int Enter(u32 minComplete)
+	{
+		int ret;
+		do
+		{
+			ret = static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+				minComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+		} while (ret < 0 && errno == EINTR);
+
+		if (ret > 0)
+			toSubmit -= std::min<u32>(toSubmit, static_cast<u32>(ret));
+		return ret;
+	}
+};
+
+UringFileReader::UringFileReader()
+	: m_fd(-1)
+	, m_direct(false)
+	, m_blockData(nullptr)
+	, m_numBlocks(0)
+	, m_readahead(0)
+	, m_useCounter(0)
+	, m_pending(0)
+	, m_ringFailed(false)
+	, m_readBuffer(nullptr)
+	, m_readOffset(0)
+	, m_readSize(0)
+	, m_lastReadEnd(-1)
+{
+	m_blocksize = 2048;
+}
+
+UringFileReader::~UringFileReader()
+{
+	Close();
+}
+
+AsyncFileReader* UringFileReader::Create()
+{
+	if (!Host::GetBaseBoolSettingValue("EmuCore", "CdvdUseIoUring", true))
+		return nullptr;
+
+	std::unique_ptr<UringFileReader> reader = std::make_unique<UringFileReader>();
+	reader->m_ring = std::make_unique<Ring>();
+	if (!reader->m_ring->Init(64))
+	{
+		DevCon.WriteLn("(UringFileReader) io_uring is unavailable (%d), using libaio.", errno);
+		return nullptr;
+	}
+
+	return reader.release();
+}
+
+bool UringFileReader::OpenFile(bool direct)
+{
+	if (m_fd >= 0)
+		close(m_fd);
+
+	m_direct = direct;
+	m_fd = FileSystem::OpenFDFile(m_filename.c_str(), O_RDONLY | (direct ? O_DIRECT : 0), 0);
+	return (m_fd >= 0);
+}
+
+bool UringFileReader::Open(std::string fileName)
+{
+	m_filename = std::move(fileName);
+
+	// O_DIRECT skips the page cache, which saves a copy and stops a big ISO on a network share
+	// from evicting everything else. Not every filesystem supports it, so fall back if we have to.
+	const bool direct = Host::GetBaseBoolSettingValue("EmuCore", "CdvdDirectIO", false);
+	if (!OpenFile(direct) && (!direct || !OpenFile(false)))
+		return false;
+
+	const u32 readaheadKB = Host::GetBaseUIntSettingValue("EmuCore", "CdvdFlatReadaheadKB", 1024);
+	m_readahead = std::min<u32>(readaheadKB * 1024 / BlockSize, 32);
+
+	// Enough blocks for the readahead window plus the largest request we're likely to see,
+	// requests larger than this are still fine, they just go a block at a time.
+	m_numBlocks = m_readahead + 8;
+	m_blockData = static_cast<u8*>(_aligned_malloc(static_cast<size_t>(m_numBlocks) * BlockSize, Alignment));
+	m_blocks = std::make_unique<Block[]>(m_numBlocks);
+	for (u32 i = 0; i < m_numBlocks; i++)
+		m_blocks[i] = {-1, m_blockData + static_cast<size_t>(i) * BlockSize, 0, false, 0};
+
+	m_pending = 0;
+	m_lastReadEnd = -1;
+
+	if (m_direct)
+	{
+		// Check the filesystem is actually happy with our alignment, some only complain on read.
+		const int ret = static_cast<int>(pread(m_fd, m_blockData, Alignment, 0));
+		if (ret < 0 && errno == EINVAL)
+		{
+			Console.Warning("(UringFileReader) O_DIRECT is not supported for '%s', using buffered reads.", m_filename.c_str());
+			if (!OpenFile(false))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+UringFileReader::Block* UringFileReader::FindBlock(s64 index)
+{
+	for (u32 i = 0; i < m_numBlocks; i++)
+	{
+		if (m_blocks[i].index == index)
+			return &m_blocks[i];
+	}
+
+	return nullptr;
+}
+
+UringFileReader::Block* UringFileReader::QueueBlock(s64 index)
+{
+	if (Block* block = FindBlock(index))
+		return block;
+
+	// Reuse the least recently used block the kernel isn't writing to.
+	Block* victim = nullptr;
+	for (;;)
+	{
+		for (u32 i = 0; i < m_numBlocks; i++)
+		{
+			Block& block = m_blocks[i];
+			if (!block.pending && (!victim || block.lastUse < victim->lastUse))
+				victim = &block;
+		}
+		if (victim)
+			break;
+
+		// Everything's in flight, and if the ring is broken it's going to stay that way.
+		if (!Submit() || !Reap(true))
+			return nullptr;
+	}
+
+	victim->index = index;
+	victim->result = 0;
+	victim->lastUse = ++m_useCounter;
+
+	const u64 userData = static_cast<u64>(victim - m_blocks.get());
+	while (!m_ringFailed && !m_ring->QueueRead(m_fd, victim->data, BlockSize, index * BlockSize, userData))
+	{
+		// Submission queue is full, which can only happen if nothing's been submitted yet.
+		Submit();
+	}
+
+	if (m_ringFailed)
+	{
+		const ssize_t ret = pread(m_fd, victim->data, BlockSize, index * BlockSize);
+		victim->result = (ret < 0) ? -errno : static_cast<int>(ret);
+		return victim;
+	}
+
+	victim->pending = true;
+	m_pending++;
+	return victim;
+}
+
+bool UringFileReader::Enter(u32 minComplete)
+{
+	if (m_ringFailed)
+		return false;
+
+	if (m_ring->Enter(minComplete) >= 0)
+		return true;
+
+	// Blocks which are still in flight are never reused, the kernel may yet write to them.
+	Console.Error("(UringFileReader) io_uring_enter failed (%d), reading '%s' with pread from now on.", errno, m_filename.c_str());
+	m_ringFailed = true;
+	return false;
+}
+
+bool UringFileReader::Submit()
+{
+	if (m_ring->toSubmit == 0)
+		return !m_ringFailed;
+
+	return Enter(0);
+}
+
+bool UringFileReader::Reap(bool wait)
+{
+	// Completions can't be trusted to match our blocks after a failure, they may be from before a reopen.
+	if (m_ringFailed || (wait && m_pending > 0 && !Enter(1)))
+		return false;
+
+	u32 head = *m_ring->cqHead;
+	const u32 tail = __atomic_load_n(m_ring->cqTail, __ATOMIC_ACQUIRE);
+	for (; head != tail; head++)
+	{
+		const io_uring_cqe& cqe = m_ring->cqes[head & m_ring->cqMask];
+		Block& block = m_blocks[cqe.user_data];
+		block.result = cqe.res;
+		block.pending = false;
+		m_pending--;
+	}
+	__atomic_store_n(m_ring->cqHead, head, __ATOMIC_RELEASE);
+	return true;
+}
+
+bool UringFileReader::WaitAll()
+{
+	if (!m_ring)
+		return true;
+
+	Submit();
+	while (m_pending > 0 && Reap(true))
+		;
+
+	return (m_pending == 0);
+}
+
+int UringFileReader::ReadSync(void* pBuffer, uint sector, uint count)
+{
+	BeginRead(pBuffer, sector, count);
+	return FinishRead();
+}
+
+void UringFileReader::BeginRead(void* pBuffer, uint sector, uint count)
+{
+	m_readBuffer = pBuffer;
+	m_readOffset = sector * (s64)m_blocksize + m_dataoffset;
+	m_readSize = count * m_blocksize;
+
+	// Queue everything the request touches, so the pieces are read in parallel.
+	const s64 first = m_readOffset / BlockSize;
+	const s64 last = (m_readOffset + m_readSize - 1) / BlockSize;
+	for (s64 i = first; i <= last && i < first + m_numBlocks - m_readahead; i++)
+	{
+		Block* block = QueueBlock(i);
+		if (!block)
+			break; // FinishRead() reports it
+		block->lastUse = ++m_useCounter;
+	}
+
+	// Games stream movies and audio sequentially, so keep the next few blocks coming.
+	// Not worth it once we're reading synchronously.
+	if (m_readOffset == m_lastReadEnd && !m_ringFailed)
+	{
+		for (s64 i = last + 1; i <= last + m_readahead; i++)
+			QueueBlock(i);
+	}
+	m_lastReadEnd = m_readOffset + m_readSize;
+
+	Submit();
+}
+
+int UringFileReader::FinishRead(void)
+{
+	if (!m_readBuffer)
+		return -1;
+
+	u8* dst = static_cast<u8*>(m_readBuffer);
+	s64 offset = m_readOffset;
+	const s64 end = m_readOffset + m_readSize;
+	m_readBuffer = nullptr;
+
+	while (offset < end)
+	{
+		const s64 index = offset / BlockSize;
+		Block* block = QueueBlock(index);
+		if (!block)
+		{
+			Console.Error("(UringFileReader) Read of '%s' at %lld failed, no buffers left.", m_filename.c_str(), index * BlockSize);
+			return -1;
+		}
+
+		block->lastUse = ++m_useCounter;
+		Submit();
+		while (block->pending && Reap(true))
+			;
+
+		if (block->pending)
+		{
+			// The ring failed with this block in flight, go again with pread.
+			block->index = -1;
+			continue;
+		}
+
+		if (block->result < 0)
+		{
+			Console.Error("(UringFileReader) Read of '%s' at %lld failed: %d", m_filename.c_str(), index * BlockSize, block->result);
+			block->index = -1;
+			return -1;
+		}
+
+		const u32 blockOffset = static_cast<u32>(offset - index * BlockSize);
+		if (static_cast<u32>(block->result) <= blockOffset)
+			break; // end of file
+
+		const u32 available = std::min<u32>(static_cast<u32>(block->result) - blockOffset, static_cast<u32>(end - offset));
+		std::memcpy(dst, block->data + blockOffset, available);
+		dst += available;
+		offset += available;
+
+		// Short read, we're at the end of the file. Don't keep the block, the file could grow.
+		if (static_cast<u32>(block->result) < BlockSize)
+		{
+			block->index = -1;
+			break;
+		}
+	}
+
+	return static_cast<int>(offset - m_readOffset);
+}
+
+void UringFileReader::CancelRead(void)
+{
+	// Reads land in our own buffers, so there's nothing to stop, just forget the request.
+	m_readBuffer = nullptr;
+}
+
+void UringFileReader::Close(void)
+{
+	// The kernel may still be writing to our buffers, if we can't wait for it they have to be leaked.
+	if (WaitAll())
+		safe_aligned_free(m_blockData);
+	else
+		m_blockData = nullptr;
+
+	if (m_fd >= 0)
+		close(m_fd);
+	m_fd = -1;
+
+	m_blocks.reset();
+	m_numBlocks = 0;
+	m_readBuffer = nullptr;
+}
+
+uint UringFileReader::GetBlockCount(void) const
+{
+	struct stat64 sysStatData;
+	if (fstat64(m_fd, &sysStatData) < 0)
+		return 0;
+
+	return (int)(sysStatData.st_size / m_blocksize);
+}
@@ -29,8 +29,11 @@
 #include "Host.h"
 #include "HostDisplay.h"
 #include "IconsFontAwesome5.h"
+#include "PerformanceMetrics.h"
 #include "VMManager.h"
 
+#include "common/Timer.h"
+
 // Uncomment this to enable profiling of the GS RingBufferCopy function.
 //#define PCSX2_GSRING_SAMPLING_STATS
 
@@ -67,6 +70,7 @@ SysMtgsThread::SysMtgsThread()
 {
 	m_ReadPos = 0;
 	m_WritePos = 0;
+	m_ReservePos = 0;
 	m_packet_size = 0;
 	m_packet_writepos = 0;
 
@@ -76,6 +80,9 @@ SysMtgsThread::SysMtgsThread()
 	m_SignalRingPosition = 0;
 
 	m_CopyDataTally = 0;
+	m_KickThreshold = DefaultKickThreshold;
+	m_KickVotes = 0;
+	m_KickLastStallCount = 0;
 }
 
 SysMtgsThread::~SysMtgsThread()
@@ -210,7 +217,8 @@ struct RingCmdPacket_Vsync
 
 	// must be 16 byte aligned
 	u32 registers_written;
-	u32 pad[3];
+	u32 submit_time[2]; // Common::Timer value when the packet was queued, for the latency stats
+	u32 pad;
 };
 
 void SysMtgsThread::PostVsyncStart(bool registers_written)
@@ -229,12 +237,14 @@ void SysMtgsThread::PostVsyncStart(bool registers_written)
 	remainder[1] = GSIMR._u32;
 	(GSRegSIGBLID&)remainder[2] = GSSIGLBLID;
 	remainder[4] = static_cast<u32>(registers_written);
+	const Common::Timer::Value submit_time = Common::Timer::GetCurrentValue();
+	std::memcpy(&remainder[5], &submit_time, sizeof(submit_time));
 	m_packet_writepos = (m_packet_writepos + 2) & RingBufferMask;
 
 	SendDataPacket();
 
 	// Vsyncs should always start the GS thread, regardless of how little has actually be queued.
-	if (m_CopyDataTally != 0)
+	if (m_CopyDataTally.load(std::memory_order_relaxed) != 0)
 		SetEvent();
 
 	// If the MTGS is allowed to queue a lot of frames in advance, it creates input lag.
@@ -511,6 +521,13 @@ void SysMtgsThread::MainLoop()
 							((u32&)RingBuffer.Regs[0x1010]) = remainder[1];
 							((GSRegSIGBLID&)RingBuffer.Regs[0x1080]) = (GSRegSIGBLID&)remainder[2];
 
+							Common::Timer::Value submit_time;
+							std::memcpy(&submit_time, &remainder[5], sizeof(submit_time));
+							const float latency = static_cast<float>(Common::Timer::ConvertValueToMilliseconds(Common::Timer::GetCurrentValue() - submit_time));
+							const u32 ring_used = (m_WritePos.load(std::memory_order_relaxed) - local_ReadPos) & RingBufferMask;
+							PerformanceMetrics::OnMTGSVsync(latency, ring_used);
+							UpdateKickThreshold(ring_used);
+
 							// CSR & 0x2000; is the pageflip id.
 #ifdef __LIBRETRO__
 							if(!flush_all)
@@ -736,7 +753,57 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 void SysMtgsThread::SetEvent()
 {
 	m_sem_event.NotifyOfWork();
-	m_CopyDataTally = 0;
+	m_CopyDataTally.store(0, std::memory_order_relaxed);
+	m_KickCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Kicks the GS thread once enough data has been queued since the last kick.
+void SysMtgsThread::KickAfter(u32 qwc)
+{
+	if (EmuConfig.GS.SynchronousMTGS)
+	{
+		WaitGS();
+		return;
+	}
+
+	const u32 tally = m_CopyDataTally.fetch_add(qwc, std::memory_order_relaxed) + qwc;
+	if (tally > m_KickThreshold.load(std::memory_order_relaxed))
+		SetEvent();
+}
+
+// Called by the MTGS thread at each vsync packet, with how much of the ring was still queued behind it.
+void SysMtgsThread::UpdateKickThreshold(u32 ring_used)
+{
+	// If there's a backlog, or the producers had to wait for room, we're the bottleneck, so get started as
+	// soon as there's a bit of work. If everything that was kicked has been drained, we're keeping up, so
+	// sleep through more of the frame, since every wakeup costs the EE a syscall. The backlog is measured
+	// in ring space rather than time, so how long the GS takes to draw doesn't feed back into it.
+	const u32 stalls = m_StallCount.load(std::memory_order_relaxed);
+	const bool stalled = (stalls != m_KickLastStallCount);
+	m_KickLastStallCount = stalls;
+
+	u32 threshold = m_KickThreshold.load(std::memory_order_relaxed);
+	int vote = 0;
+	if (stalled || ring_used > threshold + KickBacklogQwc)
+		vote = -1;
+	else if (ring_used <= threshold)
+		vote = 1;
+
+	// Only move once several frames in a row agree, so a single heavy frame doesn't flip it back and forth.
+	if (vote == 0 || (vote > 0) != (m_KickVotes > 0))
+		m_KickVotes = vote;
+	else
+		m_KickVotes += vote;
+
+	if (m_KickVotes <= -KickAdjustFrames)
+		threshold = std::max(threshold / 2, MinKickThreshold);
+	else if (m_KickVotes >= KickAdjustFrames)
+		threshold = std::min(threshold * 2, MaxKickThreshold);
+	else
+		return;
+
+	m_KickVotes = 0;
+	m_KickThreshold.store(threshold, std::memory_order_relaxed);
 }
 
 u8* SysMtgsThread::GetDataPacketPtr() const
@@ -750,116 +817,123 @@ void SysMtgsThread::SendDataPacket()
 	// make sure a previous copy block has been started somewhere.
 	pxAssert(m_packet_size != 0);
 
-	uint actualSize = ((m_packet_writepos - m_packet_startpos) & RingBufferMask) - 1;
-	pxAssert(actualSize <= m_packet_size);
+	// The whole reservation gets published, so the packet must fill it (the tag already holds the size).
+	pxAssert((((m_packet_writepos - m_packet_startpos) & RingBufferMask) - 1) == m_packet_size);
 	pxAssert(m_packet_writepos < RingBufferSize);
 
-	PacketTagType& tag = (PacketTagType&)RingBuffer[m_packet_startpos];
-	tag.data[0] = actualSize;
+	CommitRing(m_packet_startpos, m_packet_writepos);
 
-	m_WritePos.store(m_packet_writepos, std::memory_order_release);
+	const u32 size = m_packet_size;
+	m_packet_size = 0;
+	KickAfter(size);
+}
 
-	if (EmuConfig.GS.SynchronousMTGS)
-	{
-		WaitGS();
-	}
+static __fi uint RingFreeRoom(uint writepos, uint readpos)
+{
+	if (writepos < readpos)
+		return readpos - writepos;
 	else
+		return RingBufferSize - (writepos - readpos);
+}
+
+uint SysMtgsThread::ReserveRing(uint size)
+{
+	// Sanity checks! (within the confines of our ringbuffer please!)
+	pxAssert(size < RingBufferSize);
+
+	uint startpos = m_ReservePos.load(std::memory_order_relaxed);
+	for (;;)
 	{
-		m_CopyDataTally += m_packet_size;
-		if (m_CopyDataTally > 0x2000)
-			SetEvent();
-	}
+		pxAssert(startpos < RingBufferSize);
 
-	m_packet_size = 0;
+		// Space which has been reserved but not committed yet counts as used, since the reserve
+		// position is always ahead of what the GS thread is allowed to read.
+		if (RingFreeRoom(startpos, m_ReadPos.load(std::memory_order_acquire)) <= size)
+		{
+			StallForRoom(startpos, size);
+			startpos = m_ReservePos.load(std::memory_order_relaxed);
+			continue;
+		}
 
-	//m_PacketLocker.Release();
+		if (m_ReservePos.compare_exchange_weak(startpos, (startpos + size) & RingBufferMask, std::memory_order_relaxed))
+			return startpos;
+	}
 }
 
-void SysMtgsThread::GenericStall(uint size)
+void SysMtgsThread::CommitRing(uint startpos, uint endpos)
 {
-	// Note on volatiles: m_WritePos is not modified by the GS thread, so there's no need
-	// to use volatile reads here.  We do cache it though, since we know it never changes,
-	// except for calls to RingbufferRestert() -- handled below.
-	const uint writepos = m_WritePos.load(std::memory_order_relaxed);
+	// Packets become visible in the order they were reserved. Anyone ahead of us is between
+	// ReserveRing() and CommitRing(), just filling in their packet, so this is a very short wait.
+	while (m_WritePos.load(std::memory_order_acquire) != startpos)
+		SpinWait();
 
-	// Sanity checks! (within the confines of our ringbuffer please!)
-	pxAssert(size < RingBufferSize);
-	pxAssert(writepos < RingBufferSize);
+	m_WritePos.store(endpos, std::memory_order_release);
+}
 
+void SysMtgsThread::StallForRoom(uint writepos, uint size)
+{
 	// generic gs wait/stall.
 	// if the writepos is past the readpos then we're safe.
 	// But if not then we need to make sure the readpos is outside the scope of
 	// the block about to be written (writepos + size)
 
 	uint readpos = m_ReadPos.load(std::memory_order_acquire);
-	uint freeroom;
-
-	if (writepos < readpos)
-		freeroom = readpos - writepos;
-	else
-		freeroom = RingBufferSize - (writepos - readpos);
+	uint freeroom = RingFreeRoom(writepos, readpos);
+	if (freeroom > size)
+		return;
 
-	if (freeroom <= size)
-	{
-		// writepos will overlap readpos if we commit the data, so we need to wait until
-		// readpos is out past the end of the future write pos, or until it wraps around
-		// (in which case writepos will be >= readpos).
+	m_StallCount.fetch_add(1, std::memory_order_relaxed);
 
-		// Ideally though we want to wait longer, because if we just toss in this packet
-		// the next packet will likely stall up too.  So lets set a condition for the MTGS
-		// thread to wake up the EE once there's a sizable chunk of the ringbuffer emptied.
+	// writepos will overlap readpos if we commit the data, so we need to wait until
+	// readpos is out past the end of the future write pos, or until it wraps around
+	// (in which case writepos will be >= readpos).
 
-		uint somedone = (RingBufferSize - freeroom) / 4;
-		if (somedone < size + 1)
-			somedone = size + 1;
+	// Ideally though we want to wait longer, because if we just toss in this packet
+	// the next packet will likely stall up too.  So lets set a condition for the MTGS
+	// thread to wake up the producer once there's a sizable chunk of the ringbuffer emptied.
 
-		// FMV Optimization: FMVs typically send *very* little data to the GS, in some cases
-		// every other frame is nothing more than a page swap.  Sleeping the EEcore is a
-		// waste of time, and we get better results using a spinwait.
+	uint somedone = (RingBufferSize - freeroom) / 4;
+	if (somedone < size + 1)
+		somedone = size + 1;
 
-		if (somedone > 0x80)
-		{
-			pxAssertDev(m_SignalRingEnable == 0, "MTGS Thread Synchronization Error");
-			m_SignalRingPosition.store(somedone, std::memory_order_release);
+	// FMV Optimization: FMVs typically send *very* little data to the GS, in some cases
+	// every other frame is nothing more than a page swap.  Sleeping the EEcore is a
+	// waste of time, and we get better results using a spinwait.
+	// The ring signal only has room for one sleeper, if another producer already owns it, spin instead.
 
-			//Console.WriteLn( Color_Blue, "(EEcore Sleep) PrepDataPacker \tringpos=0x%06x, writepos=0x%06x, signalpos=0x%06x", readpos, writepos, m_SignalRingPosition );
+	if (somedone > 0x80 && !m_SignalRingOwned.exchange(true, std::memory_order_acquire))
+	{
+		pxAssertDev(m_SignalRingEnable == 0, "MTGS Thread Synchronization Error");
+		m_SignalRingPosition.store(somedone, std::memory_order_release);
 
-			while (true)
-			{
-				m_SignalRingEnable.store(true, std::memory_order_release);
-				SetEvent();
-				m_sem_OnRingReset.Wait();
-				readpos = m_ReadPos.load(std::memory_order_acquire);
-				//Console.WriteLn( Color_Blue, "(EEcore Awake) Report!\tringpos=0x%06x", readpos );
-
-				if (writepos < readpos)
-					freeroom = readpos - writepos;
-				else
-					freeroom = RingBufferSize - (writepos - readpos);
-
-				if (freeroom > size)
-					break;
-			}
+		//Console.WriteLn( Color_Blue, "(EEcore Sleep) PrepDataPacker \tringpos=0x%06x, writepos=0x%06x, signalpos=0x%06x", readpos, writepos, m_SignalRingPosition );
 
-			pxAssertDev(m_SignalRingPosition <= 0, "MTGS Thread Synchronization Error");
-		}
-		else
+		while (true)
 		{
-			//Console.WriteLn( Color_StrongGray, "(EEcore Spin) PrepDataPacket!" );
+			m_SignalRingEnable.store(true, std::memory_order_release);
 			SetEvent();
-			while (true)
-			{
-				SpinWait();
-				readpos = m_ReadPos.load(std::memory_order_acquire);
+			m_sem_OnRingReset.Wait();
+			readpos = m_ReadPos.load(std::memory_order_acquire);
+			//Console.WriteLn( Color_Blue, "(EEcore Awake) Report!\tringpos=0x%06x", readpos );
 
-				if (writepos < readpos)
-					freeroom = readpos - writepos;
-				else
-					freeroom = RingBufferSize - (writepos - readpos);
+			if (RingFreeRoom(writepos, readpos) > size)
+				break;
+		}
 
-				if (freeroom > size)
-					break;
-			}
+		pxAssertDev(m_SignalRingPosition <= 0, "MTGS Thread Synchronization Error");
+		m_SignalRingOwned.store(false, std::memory_order_release);
+	}
+	else
+	{
+		//Console.WriteLn( Color_StrongGray, "(EEcore Spin) PrepDataPacket!" );
+		SetEvent();
+		while (true)
+		{
+			SpinWait();
+			readpos = m_ReadPos.load(std::memory_order_acquire);
+
+			if (RingFreeRoom(writepos, readpos) > size)
+				break;
 		}
 	}
 }
@@ -868,11 +942,10 @@ void SysMtgsThread::PrepDataPacket(MTGS_RingCommand cmd, u32 size)
 {
 	m_packet_size = size;
 	++size; // takes into account our RingCommand QWC.
-	GenericStall(size);
 
 	// Command qword: Low word is the command, and the high word is the packet
 	// length in SIMDs (128 bits).
-	const unsigned int local_WritePos = m_WritePos.load(std::memory_order_relaxed);
+	const unsigned int local_WritePos = ReserveRing(size);
 
 	PacketTagType& tag = (PacketTagType&)RingBuffer[local_WritePos];
 	tag.command = cmd;
@@ -888,36 +961,30 @@ void SysMtgsThread::PrepDataPacket(MTGS_RingCommand cmd, u32 size)
 //  size - size of the packet data, in smd128's
 void SysMtgsThread::PrepDataPacket(GIF_PATH pathidx, u32 size)
 {
-	//m_PacketLocker.Acquire();
-
 	PrepDataPacket((MTGS_RingCommand)pathidx, size);
 }
 
-__fi void SysMtgsThread::_FinishSimplePacket()
+__fi void SysMtgsThread::_FinishSimplePacket(uint pos)
 {
-	uint future_writepos = (m_WritePos.load(std::memory_order_relaxed) + 1) & RingBufferMask;
-	pxAssert(future_writepos != m_ReadPos.load(std::memory_order_acquire));
-	m_WritePos.store(future_writepos, std::memory_order_release);
+	CommitRing(pos, (pos + 1) & RingBufferMask);
 
 	if (EmuConfig.GS.SynchronousMTGS)
 		WaitGS();
 	else
-		++m_CopyDataTally;
+		m_CopyDataTally.fetch_add(1, std::memory_order_relaxed);
 }
 
 void SysMtgsThread::SendSimplePacket(MTGS_RingCommand type, int data0, int data1, int data2)
 {
-	//ScopedLock locker( m_PacketLocker );
-
-	GenericStall(1);
-	PacketTagType& tag = (PacketTagType&)RingBuffer[m_WritePos.load(std::memory_order_relaxed)];
+	const uint pos = ReserveRing(1);
+	PacketTagType& tag = (PacketTagType&)RingBuffer[pos];
 
 	tag.command = type;
 	tag.data[0] = data0;
 	tag.data[1] = data1;
 	tag.data[2] = data2;
 
-	_FinishSimplePacket();
+	_FinishSimplePacket(pos);
 }
 
 void SysMtgsThread::SendSimpleGSPacket(MTGS_RingCommand type, u32 offset, u32 size, GIF_PATH path)
@@ -925,25 +992,19 @@ void SysMtgsThread::SendSimpleGSPacket(MTGS_RingCommand type, u32 offset, u32 si
 	SendSimplePacket(type, (int)offset, (int)size, (int)path);
 
 	if (!EmuConfig.GS.SynchronousMTGS)
-	{
-		m_CopyDataTally += size / 16;
-		if (m_CopyDataTally > 0x2000)
-			SetEvent();
-	}
+		KickAfter(size / 16);
 }
 
 void SysMtgsThread::SendPointerPacket(MTGS_RingCommand type, u32 data0, void* data1)
 {
-	//ScopedLock locker( m_PacketLocker );
-
-	GenericStall(1);
-	PacketTagType& tag = (PacketTagType&)RingBuffer[m_WritePos.load(std::memory_order_relaxed)];
+	const uint pos = ReserveRing(1);
+	PacketTagType& tag = (PacketTagType&)RingBuffer[pos];
 
 	tag.command = type;
 	tag.data[0] = data0;
 	tag.pointer = (uptr)data1;
 
-	_FinishSimplePacket();
+	_FinishSimplePacket(pos);
 }
 
 void SysMtgsThread::SendGameCRC(u32 crc)
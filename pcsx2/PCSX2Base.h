@@ -30,6 +30,14 @@
 	#error PCSX2 requires compiling for at least SSE 4.1
 #endif
 
+// AVX-512 builds are AVX2 builds as far as _M_SSE is concerned
+// Code that can make use of EVEX encodings (mask registers, 32 vector registers) checks this instead
+#if _M_SSE >= 0x501 && defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512DQ__) && defined(__AVX512VL__)
+	#define _M_AVX512 1
+#else
+	#define _M_AVX512 0
+#endif
+
 // Starting with AVX, processors have fast unaligned loads
 // Reduce code duplication by not compiling multiple versions
 #if _M_SSE >= 0x500
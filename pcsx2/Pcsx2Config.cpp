@@ -192,6 +192,7 @@ void Pcsx2Config::ProfilerOptions::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapBitBool(RecBlocks_IOP);
 	SettingsWrapBitBool(RecBlocks_VU0);
 	SettingsWrapBitBool(RecBlocks_VU1);
+	SettingsWrapBitBool(JitDump);
 }
 
 Pcsx2Config::RecompilerOptions::RecompilerOptions()
@@ -210,6 +211,7 @@ Pcsx2Config::RecompilerOptions::RecompilerOptions()
 	EnableVU1 = true;
 	EnableFastmem = true;
 	PauseOnTLBMiss = false;
+	EnableTranslationCache = false;
 
 	// vu and fpu clamping default to standard overflow.
 	vu0Overflow = true;
@@ -288,6 +290,7 @@ void Pcsx2Config::RecompilerOptions::LoadSave(SettingsWrapper& wrap)
 	SettingsWrapBitBool(EnableVU1);
 	SettingsWrapBitBool(EnableFastmem);
 	SettingsWrapBitBool(PauseOnTLBMiss);
+	SettingsWrapBitBool(EnableTranslationCache);
 
 	SettingsWrapBitBool(vu0Overflow);
 	SettingsWrapBitBool(vu0ExtraOverflow);
@@ -1334,6 +1337,9 @@ void Pcsx2Config::LoadSave(SettingsWrapper& wrap)
 
 	SettingsWrapBitBool(BackupSavestate);
 	SettingsWrapBitBool(SavestateZstdCompression);
+	SettingsWrapBitBool(EnableRewind);
+	SettingsWrapEntry(RewindFrequency);
+	SettingsWrapEntry(RewindBufferSizeMB);
 	SettingsWrapBitBool(McdEnableEjection);
 	SettingsWrapBitBool(McdFolderAutoManage);
 
@@ -1435,7 +1441,9 @@ bool Pcsx2Config::operator==(const Pcsx2Config& right) const
 		OpEqu(Framerate) &&
 		OpEqu(Trace) &&
 		OpEqu(BaseFilenames) &&
-		OpEqu(GzipIsoIndexTemplate);
+		OpEqu(GzipIsoIndexTemplate) &&
+		OpEqu(RewindFrequency) &&
+		OpEqu(RewindBufferSizeMB);
 	for (u32 i = 0; i < sizeof(Mcd) / sizeof(Mcd[0]); i++)
 	{
 		equal &= OpEqu(Mcd[i].Enabled);
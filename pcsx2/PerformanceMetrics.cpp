@@ -86,6 +86,21 @@ static float s_accumulated_gpu_time = 0.0f;
 static float s_gpu_usage = 0.0f;
 static u32 s_presents_since_last_update = 0;
 
+static float s_mtgs_latency_accumulator = 0.0f;
+static float s_mtgs_max_latency_accumulator = 0.0f;
+static u64 s_mtgs_ring_used_accumulator = 0;
+static u32 s_mtgs_peak_ring_used_accumulator = 0;
+static u32 s_mtgs_vsyncs_since_last_update = 0;
+static u32 s_last_mtgs_kicks = 0;
+static u32 s_last_mtgs_stalls = 0;
+
+static float s_mtgs_average_latency = 0.0f;
+static float s_mtgs_maximum_latency = 0.0f;
+static float s_mtgs_average_ring_usage = 0.0f;
+static float s_mtgs_peak_ring_usage = 0.0f;
+static float s_mtgs_kicks_per_frame = 0.0f;
+static float s_mtgs_stalls_per_frame = 0.0f;
+
 void PerformanceMetrics::Clear()
 {
 	Reset();
@@ -109,6 +124,13 @@ void PerformanceMetrics::Clear()
 	s_average_gpu_time = 0.0f;
 	s_gpu_usage = 0.0f;
 
+	s_mtgs_average_latency = 0.0f;
+	s_mtgs_maximum_latency = 0.0f;
+	s_mtgs_average_ring_usage = 0.0f;
+	s_mtgs_peak_ring_usage = 0.0f;
+	s_mtgs_kicks_per_frame = 0.0f;
+	s_mtgs_stalls_per_frame = 0.0f;
+
 	s_frame_number = 0;
 
 	s_frame_time_history.fill(0.0f);
@@ -128,6 +150,14 @@ void PerformanceMetrics::Reset()
 	s_accumulated_gpu_time = 0.0f;
 	s_presents_since_last_update = 0;
 
+	s_mtgs_latency_accumulator = 0.0f;
+	s_mtgs_max_latency_accumulator = 0.0f;
+	s_mtgs_ring_used_accumulator = 0;
+	s_mtgs_peak_ring_used_accumulator = 0;
+	s_mtgs_vsyncs_since_last_update = 0;
+	s_last_mtgs_kicks = GetMTGS().m_KickCount.load(std::memory_order_relaxed);
+	s_last_mtgs_stalls = GetMTGS().m_StallCount.load(std::memory_order_relaxed);
+
 	s_last_update_time.Reset();
 	s_last_frame_time.Reset();
 
@@ -236,6 +266,28 @@ void PerformanceMetrics::Update(bool gs_register_write, bool fb_blit, bool is_sk
 		thread.time = static_cast<double>(delta) * time_divider;
 	}
 
+	if (s_mtgs_vsyncs_since_last_update > 0)
+	{
+		const float vsyncs = static_cast<float>(s_mtgs_vsyncs_since_last_update);
+		s_mtgs_average_latency = s_mtgs_latency_accumulator / vsyncs;
+		s_mtgs_average_ring_usage = static_cast<float>(s_mtgs_ring_used_accumulator) * (100.0f / RingBufferSize) / vsyncs;
+	}
+	s_mtgs_maximum_latency = s_mtgs_max_latency_accumulator;
+	s_mtgs_peak_ring_usage = static_cast<float>(s_mtgs_peak_ring_used_accumulator) * (100.0f / RingBufferSize);
+	s_mtgs_latency_accumulator = 0.0f;
+	s_mtgs_max_latency_accumulator = 0.0f;
+	s_mtgs_ring_used_accumulator = 0;
+	s_mtgs_peak_ring_used_accumulator = 0;
+	s_mtgs_vsyncs_since_last_update = 0;
+
+	// Producer counters are totals, written by whichever thread sent the packet.
+	const u32 mtgs_kicks = GetMTGS().m_KickCount.load(std::memory_order_relaxed);
+	const u32 mtgs_stalls = GetMTGS().m_StallCount.load(std::memory_order_relaxed);
+	s_mtgs_kicks_per_frame = static_cast<float>(mtgs_kicks - s_last_mtgs_kicks) / static_cast<float>(s_frames_since_last_update);
+	s_mtgs_stalls_per_frame = static_cast<float>(mtgs_stalls - s_last_mtgs_stalls) / static_cast<float>(s_frames_since_last_update);
+	s_last_mtgs_kicks = mtgs_kicks;
+	s_last_mtgs_stalls = mtgs_stalls;
+
 	s_frames_since_last_update = 0;
 	s_unskipped_frames_since_last_update = 0;
 	s_presents_since_last_update = 0;
@@ -249,6 +301,15 @@ void PerformanceMetrics::OnGPUPresent(float gpu_time)
 	s_presents_since_last_update++;
 }
 
+void PerformanceMetrics::OnMTGSVsync(float latency, u32 ring_used)
+{
+	s_mtgs_latency_accumulator += latency;
+	s_mtgs_max_latency_accumulator = std::max(s_mtgs_max_latency_accumulator, latency);
+	s_mtgs_ring_used_accumulator += ring_used;
+	s_mtgs_peak_ring_used_accumulator = std::max(s_mtgs_peak_ring_used_accumulator, ring_used);
+	s_mtgs_vsyncs_since_last_update++;
+}
+
 void PerformanceMetrics::SetCPUThread(Threading::ThreadHandle thread)
 {
 	s_last_cpu_time = thread ? thread.GetCPUTime() : 0;
@@ -372,6 +433,11 @@ double PerformanceMetrics::GetGSSWThreadAverageTime(u32 index)
 	return s_gs_sw_threads[index].time;
 }
 
+u64 PerformanceMetrics::GetGSSWThreadCPUTime(u32 index)
+{
+	return s_gs_sw_threads[index].handle.GetCPUTime();
+}
+
 float PerformanceMetrics::GetGPUUsage()
 {
 	return s_gpu_usage;
@@ -382,6 +448,36 @@ float PerformanceMetrics::GetGPUAverageTime()
 	return s_average_gpu_time;
 }
 
+float PerformanceMetrics::GetMTGSAverageLatency()
+{
+	return s_mtgs_average_latency;
+}
+
+float PerformanceMetrics::GetMTGSMaximumLatency()
+{
+	return s_mtgs_maximum_latency;
+}
+
+float PerformanceMetrics::GetMTGSAverageRingUsage()
+{
+	return s_mtgs_average_ring_usage;
+}
+
+float PerformanceMetrics::GetMTGSPeakRingUsage()
+{
+	return s_mtgs_peak_ring_usage;
+}
+
+float PerformanceMetrics::GetMTGSKicksPerFrame()
+{
+	return s_mtgs_kicks_per_frame;
+}
+
+float PerformanceMetrics::GetMTGSStallsPerFrame()
+{
+	return s_mtgs_stalls_per_frame;
+}
+
 const PerformanceMetrics::FrameTimeHistory& PerformanceMetrics::GetFrameTimeHistory()
 {
 	return s_frame_time_history;
@@ -35,6 +35,10 @@ namespace PerformanceMetrics
 	void Update(bool gs_register_write, bool fb_blit, bool is_skipping_present);
 	void OnGPUPresent(float gpu_time);
 
+	/// Called by the GS thread when it processes a vsync, with how long the vsync packet waited in the
+	/// ring (in milliseconds), and how much of the ring was in use (in qwords) at that point.
+	void OnMTGSVsync(float latency, u32 ring_used);
+
 	/// Sets the EE thread for CPU usage calculations.
 	void SetCPUThread(Threading::ThreadHandle thread);
 
@@ -70,9 +74,20 @@ namespace PerformanceMetrics
 	double GetGSSWThreadUsage(u32 index);
 	double GetGSSWThreadAverageTime(u32 index);
 
+	/// Returns the CPU time consumed by a GS software thread, at the GetThreadTicksPerSecond() frequency.
+	/// Only valid on the GS thread.
+	u64 GetGSSWThreadCPUTime(u32 index);
+
 	float GetGPUUsage();
 	float GetGPUAverageTime();
 
+	float GetMTGSAverageLatency();
+	float GetMTGSMaximumLatency();
+	float GetMTGSAverageRingUsage();
+	float GetMTGSPeakRingUsage();
+	float GetMTGSKicksPerFrame();
+	float GetMTGSStallsPerFrame();
+
 	const FrameTimeHistory& GetFrameTimeHistory();
 	u32 GetFrameTimeHistoryPos();
 } // namespace PerformanceMetrics
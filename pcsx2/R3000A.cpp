@@ -29,6 +29,8 @@
 #include "CDVD/Ps1CD.h"
 #include "CDVD/CDVD.h"
 
+#include "common/EventScheduler.h"
+
 using namespace R3000A;
 
 R3000Acpu *psxCpu;
@@ -46,9 +48,13 @@ bool iopEventTestIsActive = false;
 
 alignas(16) psxRegisters psxRegs;
 
+// Deadlines of the events in psxRegs.interrupt, so event tests only look at the ones which are due.
+static EventScheduler<32> s_iopEvents;
+
 void psxReset()
 {
 	memzero(psxRegs);
+	s_iopEvents.Clear();
 
 	psxRegs.pc = 0xbfc00000; // Start in bootstrap
 	psxRegs.CP0.n.Status = 0x10900000; // COP0 enabled | BEV = 1 | TS = 1
@@ -127,6 +133,16 @@ __fi int psxTestCycle( u32 startCycle, s32 delta )
 	return (int)(psxRegs.cycle - startCycle) >= delta;
 }
 
+static __fi u32 psxEventDeadline( u32 n )
+{
+	return psxRegs.sCycle[n] + psxRegs.eCycle[n];
+}
+
+void psxRebuildEvents()
+{
+	s_iopEvents.Rebuild(psxRegs.interrupt, psxEventDeadline);
+}
+
 __fi void PSX_INT( IopEventId n, s32 ecycle )
 {
 	// 19 is CDVD read int, it's supposed to be high.
@@ -137,6 +153,7 @@ __fi void PSX_INT( IopEventId n, s32 ecycle )
 
 	psxRegs.sCycle[n] = psxRegs.cycle;
 	psxRegs.eCycle[n] = ecycle;
+	s_iopEvents.Schedule(n, psxEventDeadline(n));
 
 	psxSetNextBranchDelta(ecycle);
 
@@ -152,33 +169,20 @@ __fi void PSX_INT( IopEventId n, s32 ecycle )
 
 static __fi void IopTestEvent( IopEventId n, void (*callback)() )
 {
-	if( !(psxRegs.interrupt & (1 << n)) ) return;
+	if( !(psxRegs.interrupt & (1 << n)) || !s_iopEvents.IsDue(n) ) return;
 
-	if( psxTestCycle( psxRegs.sCycle[n], psxRegs.eCycle[n] ) )
-	{
-		psxRegs.interrupt &= ~(1 << n);
-		callback();
-	}
-	else
-		psxSetNextBranch( psxRegs.sCycle[n], psxRegs.eCycle[n] );
+	s_iopEvents.ClearDue(n);
+	psxRegs.interrupt &= ~(1 << n);
+	callback();
+
+	// Handlers often queue their next event right away, so pick up anything that's already
+	// due for the remaining slots, like the per-slot cycle test did.
+	s_iopEvents.CollectDue(psxRegs.cycle, psxRegs.interrupt, psxEventDeadline);
 }
 
-static __fi void Sio0TestEvent(IopEventId n)
+static void sio0EventInterrupt()
 {
-	if (!(psxRegs.interrupt & (1 << n)))
-	{
-		return;
-	}
-
-	if (psxTestCycle(psxRegs.sCycle[n], psxRegs.eCycle[n]))
-	{
-		psxRegs.interrupt &= ~(1 << n);
-		sio0.Interrupt(Sio0Interrupt::TEST_EVENT);
-	}
-	else
-	{
-		psxSetNextBranch(psxRegs.sCycle[n], psxRegs.eCycle[n]);
-	}
+	sio0.Interrupt(Sio0Interrupt::TEST_EVENT);
 }
 
 static __fi void _psxTestInterrupts()
@@ -186,7 +190,7 @@ static __fi void _psxTestInterrupts()
 	IopTestEvent(IopEvt_SIF0,		sif0Interrupt);	// SIF0
 	IopTestEvent(IopEvt_SIF1,		sif1Interrupt);	// SIF1
 	IopTestEvent(IopEvt_SIF2,		sif2Interrupt);	// SIF2
-	Sio0TestEvent(IopEvt_SIO);
+	IopTestEvent(IopEvt_SIO,		sio0EventInterrupt);
 	IopTestEvent(IopEvt_CdvdRead,	cdvdReadInterrupt);
 	IopTestEvent(IopEvt_CdvdSectorReady, cdvdSectorReady);
 
@@ -224,7 +228,13 @@ __ri void iopEventTest()
 	if (psxRegs.interrupt)
 	{
 		iopEventTestIsActive = true;
-		_psxTestInterrupts();
+		s_iopEvents.CollectDue(psxRegs.cycle, psxRegs.interrupt, psxEventDeadline);
+		if (s_iopEvents.GetDueMask() & psxRegs.interrupt)
+			_psxTestInterrupts();
+
+		u32 deadline;
+		if (s_iopEvents.PeekNext(psxRegs.interrupt, psxEventDeadline, &deadline))
+			psxSetNextBranch(psxRegs.cycle, deadline - psxRegs.cycle);
 		iopEventTestIsActive = false;
 	}
 
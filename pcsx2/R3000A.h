@@ -204,7 +204,11 @@ extern R3000Acpu *psxCpu;
 extern R3000Acpu psxInt;
 extern R3000Acpu psxRec;
 
+// Called from the page fault handler, for faults in the IOP fastmem view.
+extern bool psxRecBackpatchLoadStore(uptr code_address, uptr fault_address);
+
 extern void psxReset();
+extern void psxRebuildEvents();	// requeues psxRegs.interrupt after it's been restored
 extern void psxException(u32 code, u32 step);
 extern void iopEventTest();
 extern void psxMemReset();
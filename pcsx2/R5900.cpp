@@ -24,6 +24,7 @@
 #include "ps2/pgif.h" // pgif init
 #include "VUmicro.h"
 #include "COP0.h"
+#include "Cache.h"
 #include "MTVU.h"
 #include "VMManager.h"
 
@@ -41,6 +42,8 @@
 #include "DebugTools/SymbolMap.h"
 #include "R5900OpcodeTables.h"
 
+#include "common/EventScheduler.h"
+
 using namespace R5900;	// for R5900 disasm tools
 
 s32 EEsCycle;		// used to sync the IOP to the EE
@@ -59,6 +62,9 @@ static const uint eeWaitCycles = 3072;
 
 bool eeEventTestIsActive = false;
 
+// Deadlines of the events in cpuRegs.interrupt, so event tests only look at the ones which are due.
+static EventScheduler<32> s_eeEvents;
+
 u32 g_eeloadMain = 0, g_eeloadExec = 0, g_osdsys_str = 0;
 
 /* I don't know how much space for args there is in the memory block used for args in full boot mode,
@@ -84,6 +90,8 @@ void cpuReset()
 	memzero(cpuRegs);
 	memzero(fpuRegs);
 	memzero(tlb);
+	rebuildCachedPages();
+	s_eeEvents.Clear();
 
 	cpuRegs.pc				= 0xbfc00000; //set pc reg to stack
 	cpuRegs.CP0.n.Config	= 0x440;
@@ -275,29 +283,47 @@ __fi void cpuClearInt( uint i )
 	cpuRegs.dmastall &= ~(1 << i);
 }
 
+static __fi u32 cpuEventDeadline( u32 n )
+{
+	return cpuRegs.sCycle[n] + cpuRegs.eCycle[n];
+}
+
+void cpuRebuildEvents()
+{
+	s_eeEvents.Rebuild(cpuRegs.interrupt, cpuEventDeadline);
+}
+
 static __fi void TESTINT( u8 n, void (*callback)() )
 {
 	if( !(cpuRegs.interrupt & (1 << n)) ) return;
 
-	if(!g_GameStarted || CHECK_INSTANTDMAHACK || cpuTestCycle( cpuRegs.sCycle[n], cpuRegs.eCycle[n] ) )
+	if(!g_GameStarted || CHECK_INSTANTDMAHACK)
 	{
 		cpuClearInt( n );
 		callback();
+		return;
 	}
-	else
-		cpuSetNextEvent( cpuRegs.sCycle[n], cpuRegs.eCycle[n] );
-}
 
-// [TODO] move this function to Dmac.cpp, and remove most of the DMAC-related headers from
-// being included into R5900.cpp.
-static __fi bool _cpuTestInterrupts()
-{
+	if( !s_eeEvents.IsDue(n) ) return;
+	s_eeEvents.ClearDue(n);
 
-	if (!dmacRegs.ctrl.DMAE || (psHu8(DMAC_ENABLER+2) & 1))
+	// The IPU pushes its deadline back in place, which may have happened after this was found due.
+	if( !cpuTestCycle( cpuRegs.sCycle[n], cpuRegs.eCycle[n] ) )
 	{
-		//Console.Write("DMAC Disabled or suspended");
-		return false;
+		s_eeEvents.Schedule(n, cpuEventDeadline(n));
+		return;
 	}
+
+	cpuClearInt( n );
+	callback();
+
+	// Handlers often queue their next event right away, so pick up anything that's already
+	// due for the remaining slots, like the per-slot cycle test did.
+	s_eeEvents.CollectDue(cpuRegs.cycle, cpuRegs.interrupt, cpuEventDeadline);
+}
+
+static __fi void _cpuDispatchInterrupts()
+{
 	/* These are 'pcsx2 interrupts', they handle asynchronous stuff
 	   that depends on the cycle timings */
 	TESTINT(VU_MTVU_BUSY,	MTVUInterrupt);
@@ -328,6 +354,27 @@ static __fi bool _cpuTestInterrupts()
 		TESTINT(VIF_VU0_FINISH, vif0VUFinish);
 		TESTINT(VIF_VU1_FINISH, vif1VUFinish);
 	}
+}
+
+// [TODO] move this function to Dmac.cpp, and remove most of the DMAC-related headers from
+// being included into R5900.cpp.
+static __fi bool _cpuTestInterrupts()
+{
+
+	if (!dmacRegs.ctrl.DMAE || (psHu8(DMAC_ENABLER+2) & 1))
+	{
+		//Console.Write("DMAC Disabled or suspended");
+		return false;
+	}
+
+	// Usually nothing is due yet, and all we need is the next deadline.
+	s_eeEvents.CollectDue(cpuRegs.cycle, cpuRegs.interrupt, cpuEventDeadline);
+	if ((s_eeEvents.GetDueMask() & cpuRegs.interrupt) || !g_GameStarted || CHECK_INSTANTDMAHACK)
+		_cpuDispatchInterrupts();
+
+	u32 deadline;
+	if (s_eeEvents.PeekNext(cpuRegs.interrupt, cpuEventDeadline, &deadline))
+		cpuSetNextEvent(cpuRegs.cycle, deadline - cpuRegs.cycle);
 
 	if ((cpuRegs.interrupt & 0x1FFFF) & ~cpuRegs.dmastall)
 		return true;
@@ -553,6 +600,7 @@ __fi void CPU_INT( EE_EventType n, s32 ecycle)
 	cpuRegs.interrupt |= 1 << n;
 	cpuRegs.sCycle[n] = cpuRegs.cycle;
 	cpuRegs.eCycle[n] = ecycle;
+	s_eeEvents.Schedule(n, cpuEventDeadline(n));
 
 	// Interrupt is happening soon: make sure both EE and IOP are aware.
 
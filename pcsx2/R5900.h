@@ -416,6 +416,7 @@ extern void cpuTlbMissR(u32 addr, u32 bd);
 extern void cpuTlbMissW(u32 addr, u32 bd);
 extern void cpuTestHwInts();
 extern void cpuClearInt(uint n);
+extern void cpuRebuildEvents();	// requeues cpuRegs.interrupt after it's been restored
 extern void GoemonPreloadTlb();
 extern void GoemonUnloadTlb(u32 key);
 
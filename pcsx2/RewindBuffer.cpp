@@ -0,0 +1,421 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "RewindBuffer.h"
+#include "SaveState.h"
+
+#include "common/Threading.h"
+#include "common/Timer.h"
+
+#include <zstd.h>
+
+// Favour speed, the deltas are mostly zero pages which compress well at any level.
+static constexpr int REWIND_COMPRESSION_LEVEL = 1;
+
+RewindBuffer::Slot::Slot()
+	: state("Rewind Capture Buffer")
+{
+}
+
+RewindBuffer::RewindBuffer(size_t memory_budget)
+	: m_budget(memory_budget)
+{
+	m_cctx = ZSTD_createCCtx();
+	m_dctx = ZSTD_createDCtx();
+	ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, REWIND_COMPRESSION_LEVEL);
+	m_worker = std::thread(&RewindBuffer::WorkerThread, this);
+}
+
+RewindBuffer::~RewindBuffer()
+{
+	{
+		// A capture in flight may still have the GS thread writing into it.
+		std::unique_lock lock(m_mutex);
+		WaitForWorker(lock);
+		m_shutdown = true;
+	}
+	m_work_cv.notify_one();
+	m_worker.join();
+
+	ZSTD_freeCCtx(m_cctx);
+	ZSTD_freeDCtx(m_dctx);
+}
+
+void RewindBuffer::Capture()
+{
+	Common::Timer timer;
+
+	u32 index;
+	{
+		std::unique_lock lock(m_mutex);
+		if (m_queued == NumSlots)
+		{
+			m_skipped++;
+			return;
+		}
+		index = m_capture_slot;
+	}
+
+	// The worker only touches queued slots, so this one is ours. It keeps its size between captures,
+	// so after the first one this is a straight copy of the machine state. The GS state isn't waited
+	// for, the worker does that.
+	Slot& slot = m_slots[index];
+	u32 size;
+	try
+	{
+		size = SaveState_SaveToMemory(slot.state, slot.gs);
+	}
+	catch (std::exception& e)
+	{
+		Console.Error("(RewindBuffer) Failed to capture state: %s", e.what());
+		return;
+	}
+
+	{
+		std::unique_lock lock(m_mutex);
+		slot.size = size;
+		slot.memory = static_cast<size_t>(slot.state.GetSizeInBytes()) + slot.gs.data.capacity();
+		m_capture_slot = (m_capture_slot + 1) % NumSlots;
+		m_queued++;
+		m_last_capture_ms = timer.GetTimeMilliseconds();
+	}
+	m_work_cv.notify_one();
+}
+
+void RewindBuffer::WaitForWorker(std::unique_lock<std::mutex>& lock)
+{
+	m_done_cv.wait(lock, [this]() { return m_queued == 0; });
+}
+
+void RewindBuffer::WorkerThread()
+{
+	Threading::SetNameOfCurrentThread("Rewind Encoder");
+
+	std::unique_lock lock(m_mutex);
+	for (;;)
+	{
+		m_work_cv.wait(lock, [this]() { return m_queued > 0 || m_shutdown; });
+		if (m_shutdown)
+			break;
+
+		Slot& slot = m_slots[m_encode_slot];
+		lock.unlock();
+		if (SaveState_CompleteMemoryState(slot.state, slot.gs))
+			Encode(slot.state.GetPtr(), slot.size);
+		else
+			Console.Error("(RewindBuffer) Failed to capture GS state.");
+		lock.lock();
+
+		m_encode_slot = (m_encode_slot + 1) % NumSlots;
+		m_queued--;
+		m_done_cv.notify_all();
+	}
+}
+
+void RewindBuffer::Encode(const u8* state, u32 size)
+{
+	// Deltas need a keyframe of the same layout to apply against.
+	if (m_force_keyframe || m_group_length >= MaxGroupLength || size != m_reference.size())
+		EncodeKeyframe(state, size);
+	else
+		EncodeDelta(state, size);
+}
+
+bool RewindBuffer::Compress(std::vector<u8>* out, size_t* out_pos, const void* src, size_t size, bool end)
+{
+	// Appends to out, growing it as needed, so nothing is sized for the worst case.
+	ZSTD_inBuffer in = {src, size, 0};
+	for (;;)
+	{
+		if (*out_pos == out->size())
+			out->resize(std::max(out->size() * 2, ZSTD_CStreamOutSize()));
+
+		ZSTD_outBuffer ob = {out->data(), out->size(), *out_pos};
+		const size_t remaining = ZSTD_compressStream2(m_cctx, &ob, &in, end ? ZSTD_e_end : ZSTD_e_continue);
+		*out_pos = ob.pos;
+		if (ZSTD_isError(remaining))
+		{
+			Console.Error("(RewindBuffer) Failed to compress snapshot: %s", ZSTD_getErrorName(remaining));
+			ZSTD_CCtx_reset(m_cctx, ZSTD_reset_session_only);
+			return false;
+		}
+
+		if (end ? (remaining == 0) : (in.pos == in.size))
+			return true;
+	}
+}
+
+void RewindBuffer::EncodeKeyframe(const u8* state, u32 size)
+{
+	Snapshot snap;
+	snap.id = ++m_next_id;
+	snap.keyframe = true;
+	snap.size = size;
+
+	size_t compressed = 0;
+	if (!Compress(&snap.data, &compressed, state, size, true))
+		return;
+	snap.data.resize(compressed);
+	snap.data.shrink_to_fit();
+
+	std::unique_lock lock(m_mutex);
+	UpdateWorkerMemory();
+	m_reference.assign(state, state + size);
+	m_reference_id = snap.id;
+	m_snapshot_memory += snap.data.size();
+	m_snapshots.push_back(std::move(snap));
+	m_force_keyframe = false;
+	m_group_length = 0;
+	EnforceBudget();
+}
+
+void RewindBuffer::EncodeDelta(const u8* state, u32 size)
+{
+	// Layout: a bitmap of the pages which differ from the keyframe, followed by those pages XORed with it.
+	const u32 pages = (size + PageSize - 1) / PageSize;
+	const u32 bitmap_size = (pages + 7) / 8;
+	m_bitmap.assign(bitmap_size, 0);
+
+	const u8* ref = m_reference.data();
+	for (u32 page = 0; page < pages; page++)
+	{
+		const u32 offset = page * PageSize;
+		const u32 len = std::min(PageSize, size - offset);
+		if (std::memcmp(state + offset, ref + offset, len) != 0)
+			m_bitmap[page / 8] |= static_cast<u8>(1u << (page % 8));
+	}
+
+	Snapshot snap;
+	snap.id = ++m_next_id;
+	snap.keyframe = false;
+	snap.size = size;
+
+	size_t compressed = 0;
+	if (!Compress(&snap.data, &compressed, m_bitmap.data(), bitmap_size, false))
+		return;
+
+	for (u32 page = 0; page < pages; page++)
+	{
+		if (!(m_bitmap[page / 8] & (1u << (page % 8))))
+			continue;
+
+		const u32 offset = page * PageSize;
+		const u32 len = std::min(PageSize, size - offset);
+		for (u32 i = 0; i < len; i++)
+			m_page[i] = state[offset + i] ^ ref[offset + i];
+		if (!Compress(&snap.data, &compressed, m_page, len, false))
+			return;
+	}
+
+	if (!Compress(&snap.data, &compressed, nullptr, 0, true))
+		return;
+	snap.data.resize(compressed);
+	snap.data.shrink_to_fit();
+
+	std::unique_lock lock(m_mutex);
+	UpdateWorkerMemory();
+	m_snapshot_memory += snap.data.size();
+	m_snapshots.push_back(std::move(snap));
+	m_group_length++;
+	EnforceBudget();
+}
+
+void RewindBuffer::UpdateWorkerMemory()
+{
+	m_worker_memory = m_bitmap.capacity() + sizeof(m_page) + ZSTD_sizeof_CCtx(m_cctx) + ZSTD_sizeof_DCtx(m_dctx);
+}
+
+size_t RewindBuffer::GetFixedMemory() const
+{
+	size_t size = m_reference.capacity() + m_worker_memory;
+	for (const Slot& slot : m_slots)
+		size += slot.memory;
+	return size;
+}
+
+void RewindBuffer::EnforceBudget()
+{
+	// The capture slots and the reference are needed whatever we keep, so snapshots get what's left.
+	// Deltas are useless without their keyframe, so whole groups go at once, oldest first.
+	const size_t fixed = GetFixedMemory();
+	while (m_snapshot_memory + fixed > m_budget && !m_snapshots.empty())
+	{
+		do
+		{
+			m_snapshot_memory -= m_snapshots.front().data.size();
+			m_snapshots.pop_front();
+		} while (!m_snapshots.empty() && !m_snapshots.front().keyframe);
+	}
+
+	if (m_snapshots.empty())
+	{
+		// Even a single keyframe doesn't fit, or we've just thrown away the newest group.
+		std::vector<u8>().swap(m_reference);
+		m_reference_id = 0;
+		m_force_keyframe = true;
+
+		if (fixed > m_budget && !m_budget_warned)
+		{
+			Console.Warning("(RewindBuffer) The %zu MB budget doesn't cover the %zu MB needed to capture, nothing can be kept.",
+				m_budget / _1mb, (fixed + _1mb - 1) / _1mb);
+			m_budget_warned = true;
+		}
+	}
+}
+
+static bool DecompressStream(ZSTD_DCtx* dctx, ZSTD_inBuffer* in, void* dst, size_t size)
+{
+	ZSTD_outBuffer out = {dst, size, 0};
+	while (out.pos < out.size)
+	{
+		const size_t in_pos = in->pos;
+		const size_t out_pos = out.pos;
+		const size_t ret = ZSTD_decompressStream(dctx, &out, in);
+		if (ZSTD_isError(ret) || (out.pos == out_pos && in->pos == in_pos))
+			return false;
+	}
+
+	return true;
+}
+
+bool RewindBuffer::Decode(const Snapshot& snap, const Snapshot& keyframe, VmStateBuffer& dst)
+{
+	// Holding rewind walks back through a group one snapshot at a time, so the keyframe is kept
+	// decompressed in the reference, instead of being decompressed again for every step.
+	if (m_reference_id != keyframe.id)
+	{
+		m_reference.resize(keyframe.size);
+
+		const size_t size = ZSTD_decompressDCtx(m_dctx, m_reference.data(), m_reference.size(), keyframe.data.data(), keyframe.data.size());
+		if (ZSTD_isError(size) || size != keyframe.size)
+		{
+			m_reference_id = 0;
+			return false;
+		}
+		m_reference_id = keyframe.id;
+	}
+
+	dst.MakeRoomFor(snap.size);
+	std::memcpy(dst.GetPtr(), m_reference.data(), keyframe.size);
+
+	if (&snap == &keyframe)
+		return true;
+
+	const u32 pages = (snap.size + PageSize - 1) / PageSize;
+	const u32 bitmap_size = (pages + 7) / 8;
+	m_bitmap.resize(bitmap_size);
+
+	ZSTD_DCtx_reset(m_dctx, ZSTD_reset_session_only);
+	ZSTD_inBuffer in = {snap.data.data(), snap.data.size(), 0};
+	if (!DecompressStream(m_dctx, &in, m_bitmap.data(), bitmap_size))
+		return false;
+
+	u8* out = dst.GetPtr();
+	for (u32 page = 0; page < pages; page++)
+	{
+		if (!(m_bitmap[page / 8] & (1u << (page % 8))))
+			continue;
+
+		const u32 offset = page * PageSize;
+		const u32 len = std::min(PageSize, snap.size - offset);
+		if (!DecompressStream(m_dctx, &in, m_page, len))
+			return false;
+
+		for (u32 i = 0; i < len; i++)
+			out[offset + i] ^= m_page[i];
+	}
+
+	return true;
+}
+
+bool RewindBuffer::Rewind()
+{
+	std::unique_lock lock(m_mutex);
+	WaitForWorker(lock);
+
+	if (m_snapshots.empty())
+		return false;
+
+	auto keyframe = m_snapshots.end() - 1;
+	while (!keyframe->keyframe && keyframe != m_snapshots.begin())
+		--keyframe;
+
+	// The worker is idle, so any slot can take the decoded state.
+	Slot& slot = m_slots[m_capture_slot];
+	const bool decoded = keyframe->keyframe && Decode(m_snapshots.back(), *keyframe, slot.state);
+	slot.memory = static_cast<size_t>(slot.state.GetSizeInBytes()) + slot.gs.data.capacity();
+	UpdateWorkerMemory();
+
+	// Out of history, keep the oldest snapshot so the game holds there for as long as rewind is.
+	if (m_snapshots.size() > 1)
+	{
+		m_snapshot_memory -= m_snapshots.back().data.size();
+		m_snapshots.pop_back();
+	}
+
+	// The game now continues from an older point, so start a new group rather than extending one
+	// which has lost its newer snapshots. The reference is kept for the next step back.
+	m_force_keyframe = true;
+	lock.unlock();
+
+	if (!decoded)
+	{
+		Console.Error("(RewindBuffer) Failed to decode snapshot.");
+		return false;
+	}
+
+	try
+	{
+		SaveState_LoadFromMemory(slot.state);
+	}
+	catch (std::exception& e)
+	{
+		Console.Error("(RewindBuffer) Failed to load snapshot: %s", e.what());
+		return false;
+	}
+
+	return true;
+}
+
+void RewindBuffer::Clear()
+{
+	std::unique_lock lock(m_mutex);
+	WaitForWorker(lock);
+
+	m_snapshots.clear();
+	std::vector<u8>().swap(m_reference);
+	m_reference_id = 0;
+	m_snapshot_memory = 0;
+	m_force_keyframe = true;
+	m_group_length = 0;
+}
+
+RewindBuffer::Stats RewindBuffer::GetStats()
+{
+	std::unique_lock lock(m_mutex);
+
+	Stats stats = {};
+	stats.snapshots = static_cast<u32>(m_snapshots.size());
+	for (const Snapshot& snap : m_snapshots)
+		stats.keyframes += snap.keyframe ? 1 : 0;
+	stats.skipped = m_skipped;
+	stats.memory_fixed = GetFixedMemory();
+	stats.memory_used = m_snapshot_memory + stats.memory_fixed;
+	stats.memory_budget = m_budget;
+	stats.last_capture_ms = m_last_capture_ms;
+	return stats;
+}
@@ -0,0 +1,141 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "SaveState.h"
+#include "System.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+typedef struct ZSTD_DCtx_s ZSTD_DCtx;
+
+// In-memory ring of machine snapshots for rewinding.
+//
+// Snapshots are grouped behind a keyframe. The keyframe is stored zstd compressed, and the
+// snapshots after it are stored as page-level XOR deltas against it (unchanged pages aren't
+// stored at all), which are then compressed too. Captures alternate between two slots: the CPU
+// thread copies the state into one while the worker is still encoding the other, the GS thread
+// saves its state when it catches up, and the worker streams the encoded snapshot out once both
+// are in. Everything the buffer allocates, including those slots, counts towards the budget.
+class RewindBuffer
+{
+public:
+	struct Stats
+	{
+		u32 snapshots;
+		u32 keyframes;
+		u32 skipped; // captures dropped because both slots were still waiting on the worker
+		size_t memory_used; // snapshots plus the fixed buffers below
+		size_t memory_fixed; // capture slots, keyframe reference and compression contexts
+		size_t memory_budget;
+		double last_capture_ms; // time the CPU thread spent in the last Capture()
+	};
+
+	static constexpr u32 PageSize = 4096;
+
+	// Snapshots after a keyframe before starting a new one. Longer groups are smaller, but
+	// deltas grow as the game drifts away from the keyframe.
+	static constexpr u32 MaxGroupLength = 30;
+
+	explicit RewindBuffer(size_t memory_budget);
+	~RewindBuffer();
+
+	/// Snapshots the current machine state. Must be called on the CPU thread with the VM in a consistent
+	/// state (e.g. at vsync). Never waits for the worker, if both slots are still queued the capture is skipped.
+	void Capture();
+
+	/// Loads the most recent snapshot, and drops it from the ring, unless it's the only one left, so that
+	/// holding rewind stays on the oldest point. Returns false if there's nothing to load.
+	bool Rewind();
+
+	/// Drops every snapshot, e.g. after a save state is loaded.
+	void Clear();
+
+	Stats GetStats();
+
+private:
+	struct Snapshot
+	{
+		u64 id;
+		bool keyframe;
+		u32 size; // uncompressed size of the state
+		std::vector<u8> data;
+	};
+
+	// Raw state, filled by the CPU and GS threads, then read by the worker.
+	struct Slot
+	{
+		Slot();
+
+		VmStateBuffer state;
+		SaveStateDeferredGS gs;
+		u32 size = 0;
+		size_t memory = 0; // allocated size of state and gs, updated under m_mutex
+	};
+
+	static constexpr u32 NumSlots = 2;
+
+	void WorkerThread();
+	void Encode(const u8* state, u32 size);
+	void EncodeKeyframe(const u8* state, u32 size);
+	void EncodeDelta(const u8* state, u32 size);
+	bool Compress(std::vector<u8>* out, size_t* out_pos, const void* src, size_t size, bool end);
+	bool Decode(const Snapshot& snap, const Snapshot& keyframe, VmStateBuffer& dst);
+	void UpdateWorkerMemory();
+	size_t GetFixedMemory() const;
+	void EnforceBudget();
+	void WaitForWorker(std::unique_lock<std::mutex>& lock);
+
+	size_t m_budget;
+
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_work_cv;
+	std::condition_variable m_done_cv;
+	bool m_shutdown = false;
+
+	Slot m_slots[NumSlots];
+	u32 m_capture_slot = 0; // the slot the next capture goes to
+	u32 m_encode_slot = 0; // the oldest slot waiting for the worker
+	u32 m_queued = 0; // captured slots the worker hasn't finished with
+
+	// Uncompressed copy of keyframe m_reference_id. Normally the newest, which new deltas are built
+	// against; while rewinding, the one the last rewind was decoded from.
+	std::vector<u8> m_reference;
+	u64 m_reference_id = 0;
+	u64 m_next_id = 0;
+	bool m_force_keyframe = true;
+
+	// Worker state. Deltas are streamed through zstd a page at a time, so there's no full size scratch buffer.
+	// Rewind() uses it too, with the worker idle.
+	ZSTD_CCtx* m_cctx = nullptr;
+	ZSTD_DCtx* m_dctx = nullptr;
+	std::vector<u8> m_bitmap;
+	u8 m_page[PageSize];
+	size_t m_worker_memory = 0; // allocated size of the above, updated under m_mutex
+
+	std::deque<Snapshot> m_snapshots;
+	size_t m_snapshot_memory = 0;
+	u32 m_group_length = 0;
+	u32 m_skipped = 0;
+	bool m_budget_warned = false;
+	double m_last_capture_ms = 0.0;
+};
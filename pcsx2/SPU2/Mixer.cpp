@@ -17,6 +17,7 @@
 #include "common/Assertions.h"
 
 #include "SPU2/Global.h"
+#include "SPU2/Mixer_MultiISA.h"
 #include "SPU2/spu2.h"
 #include "SPU2/interpolate_table.h"
 
@@ -353,7 +354,9 @@ __forceinline static s32 GaussianInterpolate(s32 pv4, s32 pv3, s32 pv2, s32 pv1,
 	return out;
 }
 
-static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
+// Steps the voice up to its sample pointer, leaving the samples to interpolate between in
+// PV1-4. Returns the interpolation phase.
+static __forceinline s32 ReadVoiceSamples(V_Core& thiscore, uint voiceidx)
 {
 	V_Voice& vc(thiscore.Voices[voiceidx]);
 
@@ -368,7 +371,15 @@ static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
 
 	const s32 mu = vc.SP + 0x1000;
 
-	return GaussianInterpolate(vc.PV4, vc.PV3, vc.PV2, vc.PV1, (mu & 0x0ff0) >> 4);
+	return (mu & 0x0ff0) >> 4;
+}
+
+static __forceinline s32 GetVoiceValues(V_Core& thiscore, uint voiceidx)
+{
+	const s32 i = ReadVoiceSamples(thiscore, voiceidx);
+	const V_Voice& vc(thiscore.Voices[voiceidx]);
+
+	return GaussianInterpolate(vc.PV4, vc.PV3, vc.PV2, vc.PV1, i);
 }
 
 // This is Dr. Hell's noise algorithm as implemented in pcsxr
@@ -505,7 +516,7 @@ static __forceinline StereoOut32 MixVoice(uint coreidx, uint voiceidx)
 
 const VoiceMixSet VoiceMixSet::Empty((StereoOut32()), (StereoOut32())); // Don't use SteroOut32::Empty because C++ doesn't make any dep/order checks on global initializers.
 
-static __forceinline void MixCoreVoices(VoiceMixSet& dest, const uint coreidx)
+void MixCoreVoicesReference(VoiceMixSet& dest, const uint coreidx)
 {
 	V_Core& thiscore(Cores[coreidx]);
 
@@ -522,6 +533,134 @@ static __forceinline void MixCoreVoices(VoiceMixSet& dest, const uint coreidx)
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+//  SIMD voice mixing
+//
+// MixVoice interleaves the parts of a voice with control flow (sample fetch and ADPCM decode,
+// IRQ checks, looping, the ADSR state machine) with straight arithmetic (interpolation,
+// envelope, volume, gating). The SIMD mixer runs the former one voice at a time exactly as
+// MixVoice does, collecting the operands of the latter a voice per lane, then does the
+// arithmetic for all the voices of the core together. Same operations in the same order, so
+// the result matches MixVoice bit for bit. The arithmetic lives in Mixer_MultiISA.cpp, so it
+// uses AVX2 when the CPU has it, even in builds which only require SSE4.1.
+
+// Everything MixVoice does for the voice up to the interpolation, with the operands for the
+// rest stored in the voice's lane. Returns true if the voice is playing.
+static __forceinline bool PrepareVoiceLane(VoiceLanes& lanes, uint coreidx, uint voiceidx)
+{
+	V_Core& thiscore(Cores[coreidx]);
+	V_Voice& vc(thiscore.Voices[voiceidx]);
+
+	pxAssertMsg((vc.SCurrent <= 28) && (vc.SCurrent != 0), "Current sample should always range from 1->28");
+
+	vc.Volume.Update();
+	UpdatePitch(coreidx, voiceidx);
+
+	s32 pv4 = 0, pv3 = 0, pv2 = 0, pv1 = 0;
+	s32 coef4 = 0, coef3 = 0, coef2 = 0, coef1 = 0;
+	const bool playing = (vc.ADSR.Phase > 0);
+	if (playing)
+	{
+		if (vc.Noise)
+		{
+			pv1 = GetNoiseValues(thiscore);
+			coef1 = 0x8000;
+		}
+		else
+		{
+			const s32 i = ReadVoiceSamples(thiscore, voiceidx);
+			pv4 = vc.PV4;
+			pv3 = vc.PV3;
+			pv2 = vc.PV2;
+			pv1 = vc.PV1;
+			coef4 = interpTable[0x0FF - i];
+			coef3 = interpTable[0x1FF - i];
+			coef2 = interpTable[0x100 + i];
+			coef1 = interpTable[0x000 + i];
+		}
+
+		CalculateADSR(thiscore, voiceidx);
+	}
+	else
+	{
+		while (vc.SP >= 0)
+			GetNextDataDummy(thiscore, voiceidx); // Dummy is enough
+	}
+
+	// Write-back of raw voice data (post ADSR applied). Can't wait for the SIMD pass, the voices
+	// after this one might be reading from there.
+	if (voiceidx == 1 || voiceidx == 3)
+	{
+		s32 Value = 0;
+		if (playing)
+		{
+			Value = ((coef4 * pv4) >> 15) + ((coef3 * pv3) >> 15) + ((coef2 * pv2) >> 15) + ((coef1 * pv1) >> 15);
+			Value = ApplyVolume(Value, vc.ADSR.Value);
+		}
+
+		if (voiceidx == 1)
+			spu2M_WriteFast(((0 == coreidx) ? 0x400 : 0xc00) + OutPos, Value);
+		else
+			spu2M_WriteFast(((0 == coreidx) ? 0x600 : 0xe00) + OutPos, Value);
+	}
+
+	lanes.PV4[voiceidx] = pv4;
+	lanes.PV3[voiceidx] = pv3;
+	lanes.PV2[voiceidx] = pv2;
+	lanes.PV1[voiceidx] = pv1;
+	lanes.Coef4[voiceidx] = coef4;
+	lanes.Coef3[voiceidx] = coef3;
+	lanes.Coef2[voiceidx] = coef2;
+	lanes.Coef1[voiceidx] = coef1;
+	lanes.Envelope[voiceidx] = vc.ADSR.Value;
+	lanes.VolL[voiceidx] = vc.Volume.Left.Value;
+	lanes.VolR[voiceidx] = vc.Volume.Right.Value;
+	lanes.DryL[voiceidx] = thiscore.VoiceGates[voiceidx].DryL;
+	lanes.DryR[voiceidx] = thiscore.VoiceGates[voiceidx].DryR;
+	lanes.WetL[voiceidx] = thiscore.VoiceGates[voiceidx].WetL;
+	lanes.WetR[voiceidx] = thiscore.VoiceGates[voiceidx].WetR;
+
+	return playing;
+}
+
+void MixCoreVoices(VoiceMixSet& dest, const uint coreidx)
+{
+	V_Core& thiscore(Cores[coreidx]);
+
+	// A modulated voice's pitch depends on the output of the voice before it in this very
+	// sample, which the SIMD pass only produces at the end.
+	for (uint voiceidx = 1; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		if (thiscore.Voices[voiceidx].Modulated)
+		{
+			MixCoreVoicesReference(dest, coreidx);
+			return;
+		}
+	}
+
+	VoiceLanes lanes;
+	u32 playing = 0;
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		if (PrepareVoiceLane(lanes, coreidx, voiceidx))
+			playing |= 1u << voiceidx;
+	}
+
+	static void (*const mix_voice_lanes)(VoiceMixSet&, VoiceLanes&) = MULTI_ISA_SELECT(MixVoiceLanes);
+	mix_voice_lanes(dest, lanes);
+
+	for (uint voiceidx = 0; voiceidx < V_Core::NumVoices; ++voiceidx)
+	{
+		if (!(playing & (1u << voiceidx)))
+			continue;
+
+		thiscore.Voices[voiceidx].OutX = lanes.Out[voiceidx];
+
+		if (IsDevBuild)
+			DebugCores[coreidx].Voices[voiceidx].displayPeak = std::max(DebugCores[coreidx].Voices[voiceidx].displayPeak, lanes.Out[voiceidx]);
+	}
+}
+
 StereoOut32 V_Core::Mix(const VoiceMixSet& inVoices, const StereoOut32& Input, const StereoOut32& Ext)
 {
 	MasterVol.Update();
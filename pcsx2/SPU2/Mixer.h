@@ -15,6 +15,15 @@
 
 #pragma once
 
+struct VoiceMixSet;
+
 extern void Mix();
+
+// Mixes the current sample of a core's voices into dest. MixCoreVoices does the arithmetic for
+// all the voices at once with SIMD, except on cores using pitch modulation; the reference mixer
+// goes one voice at a time, and is what the SIMD one has to match bit for bit.
+extern void MixCoreVoices(VoiceMixSet& dest, uint coreidx);
+extern void MixCoreVoicesReference(VoiceMixSet& dest, uint coreidx);
+
 extern s32 clamp_mix(s32 x);
 extern StereoOut32 clamp_mix(StereoOut32 sample);
@@ -0,0 +1,108 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+
+#include "SPU2/Mixer_MultiISA.h"
+
+MULTI_ISA_UNSHARED_START
+
+#if _M_SSE >= 0x501
+using VoiceVec = __m256i;
+static constexpr uint VoiceVecLanes = 8;
+
+static __forceinline VoiceVec VoiceVecLoad(const s32* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+static __forceinline void VoiceVecStore(s32* p, VoiceVec v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+static __forceinline VoiceVec VoiceVecZero() { return _mm256_setzero_si256(); }
+static __forceinline VoiceVec VoiceVecAdd(VoiceVec a, VoiceVec b) { return _mm256_add_epi32(a, b); }
+static __forceinline VoiceVec VoiceVecAnd(VoiceVec a, VoiceVec b) { return _mm256_and_si256(a, b); }
+
+// (a * b) >> 15 per lane, the product has to fit 32 bits.
+static __forceinline VoiceVec VoiceVecMulShr15(VoiceVec a, VoiceVec b) { return _mm256_srai_epi32(_mm256_mullo_epi32(a, b), 15); }
+
+// MulShr32((a << 1), b) per lane.
+static __forceinline VoiceVec VoiceVecApplyVolume(VoiceVec a, VoiceVec b)
+{
+	a = _mm256_slli_epi32(a, 1);
+	const __m256i even = _mm256_mul_epi32(a, b);
+	const __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+#else
+using VoiceVec = __m128i;
+static constexpr uint VoiceVecLanes = 4;
+
+static __forceinline VoiceVec VoiceVecLoad(const s32* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+static __forceinline void VoiceVecStore(s32* p, VoiceVec v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+static __forceinline VoiceVec VoiceVecZero() { return _mm_setzero_si128(); }
+static __forceinline VoiceVec VoiceVecAdd(VoiceVec a, VoiceVec b) { return _mm_add_epi32(a, b); }
+static __forceinline VoiceVec VoiceVecAnd(VoiceVec a, VoiceVec b) { return _mm_and_si128(a, b); }
+
+// (a * b) >> 15 per lane, the product has to fit 32 bits.
+static __forceinline VoiceVec VoiceVecMulShr15(VoiceVec a, VoiceVec b) { return _mm_srai_epi32(_mm_mullo_epi32(a, b), 15); }
+
+// MulShr32((a << 1), b) per lane.
+static __forceinline VoiceVec VoiceVecApplyVolume(VoiceVec a, VoiceVec b)
+{
+	a = _mm_slli_epi32(a, 1);
+	const __m128i even = _mm_mul_epi32(a, b);
+	const __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_blend_epi16(_mm_srli_epi64(even, 32), odd, 0xCC);
+}
+#endif
+
+static_assert((V_Core::NumVoices % VoiceVecLanes) == 0);
+
+void MixVoiceLanes(VoiceMixSet& dest, VoiceLanes& lanes)
+{
+	VoiceVec dryl = VoiceVecZero();
+	VoiceVec dryr = VoiceVecZero();
+	VoiceVec wetl = VoiceVecZero();
+	VoiceVec wetr = VoiceVecZero();
+
+	for (uint v = 0; v < V_Core::NumVoices; v += VoiceVecLanes)
+	{
+		// Interpolation terms are shifted one at a time, as in GaussianInterpolate.
+		VoiceVec value = VoiceVecMulShr15(VoiceVecLoad(&lanes.Coef4[v]), VoiceVecLoad(&lanes.PV4[v]));
+		value = VoiceVecAdd(value, VoiceVecMulShr15(VoiceVecLoad(&lanes.Coef3[v]), VoiceVecLoad(&lanes.PV3[v])));
+		value = VoiceVecAdd(value, VoiceVecMulShr15(VoiceVecLoad(&lanes.Coef2[v]), VoiceVecLoad(&lanes.PV2[v])));
+		value = VoiceVecAdd(value, VoiceVecMulShr15(VoiceVecLoad(&lanes.Coef1[v]), VoiceVecLoad(&lanes.PV1[v])));
+
+		value = VoiceVecApplyVolume(value, VoiceVecLoad(&lanes.Envelope[v]));
+		VoiceVecStore(&lanes.Out[v], value);
+
+		const VoiceVec left = VoiceVecApplyVolume(value, VoiceVecLoad(&lanes.VolL[v]));
+		const VoiceVec right = VoiceVecApplyVolume(value, VoiceVecLoad(&lanes.VolR[v]));
+		dryl = VoiceVecAdd(dryl, VoiceVecAnd(left, VoiceVecLoad(&lanes.DryL[v])));
+		dryr = VoiceVecAdd(dryr, VoiceVecAnd(right, VoiceVecLoad(&lanes.DryR[v])));
+		wetl = VoiceVecAdd(wetl, VoiceVecAnd(left, VoiceVecLoad(&lanes.WetL[v])));
+		wetr = VoiceVecAdd(wetr, VoiceVecAnd(right, VoiceVecLoad(&lanes.WetR[v])));
+	}
+
+	alignas(32) s32 sums[4][VoiceVecLanes];
+	VoiceVecStore(sums[0], dryl);
+	VoiceVecStore(sums[1], dryr);
+	VoiceVecStore(sums[2], wetl);
+	VoiceVecStore(sums[3], wetr);
+	for (uint i = 0; i < VoiceVecLanes; i++)
+	{
+		dest.Dry.Left += sums[0][i];
+		dest.Dry.Right += sums[1][i];
+		dest.Wet.Left += sums[2][i];
+		dest.Wet.Right += sums[3][i];
+	}
+}
+
+MULTI_ISA_UNSHARED_END
@@ -0,0 +1,50 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "GS/MultiISA.h"
+#include "SPU2/Global.h"
+
+// Operands of the arithmetic part of mixing a core's voices, a voice per lane. Filled in by
+// Mixer.cpp, and mixed with the widest vectors the CPU has.
+struct alignas(32) VoiceLanes
+{
+	// Samples and Gaussian coefficients. Silent voices have all zero coefficients, noise voices
+	// have the noise sample in PV1 at unity (0x8000) and the rest zero.
+	s32 PV4[V_Core::NumVoices];
+	s32 PV3[V_Core::NumVoices];
+	s32 PV2[V_Core::NumVoices];
+	s32 PV1[V_Core::NumVoices];
+	s32 Coef4[V_Core::NumVoices];
+	s32 Coef3[V_Core::NumVoices];
+	s32 Coef2[V_Core::NumVoices];
+	s32 Coef1[V_Core::NumVoices];
+
+	s32 Envelope[V_Core::NumVoices];
+	s32 VolL[V_Core::NumVoices];
+	s32 VolR[V_Core::NumVoices];
+
+	// Voice gates, sign extended.
+	s32 DryL[V_Core::NumVoices];
+	s32 DryR[V_Core::NumVoices];
+	s32 WetL[V_Core::NumVoices];
+	s32 WetR[V_Core::NumVoices];
+
+	// Voice output with the envelope applied (OutX), written by the SIMD pass.
+	s32 Out[V_Core::NumVoices];
+};
+
+MULTI_ISA_DEF(void MixVoiceLanes(VoiceMixSet& dest, VoiceLanes& lanes);)
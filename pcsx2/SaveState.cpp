@@ -22,6 +22,7 @@
 #include "common/SafeArray.inl"
 #include "common/ScopedGuard.h"
 #include "common/StringUtil.h"
+#include "common/ThreadPool.h"
 #include "common/ZipHelpers.h"
 
 #include "ps2/BiosTools.h"
@@ -51,13 +52,23 @@
 
 #include "fmt/core.h"
 
+#include <atomic>
 #include <csetjmp>
 #include <png.h>
+#include <zstd.h>
 
 using namespace R5900;
 
 static tlbs s_tlb_backup[std::size(tlb)];
 
+// Print this until the MTVU problem in gifPathFreeze is taken care of (rama).
+// Only for states on disk, rewind takes one every few frames.
+static void WarnIfMTVU()
+{
+	if (THREAD_VU1)
+		Console.Warning("MTVU speedhack is enabled, saved states may not be stable");
+}
+
 static void PreLoadPrep()
 {
 	// ensure everything is in sync before we start overwriting stuff.
@@ -68,14 +79,15 @@ static void PreLoadPrep()
 	// backup current TLBs, since we're going to overwrite them all
 	std::memcpy(s_tlb_backup, tlb, sizeof(s_tlb_backup));
 
-	// clear protected pages, since we don't want to fault loading EE memory
-	mmap_ResetBlockTracking();
-
-	SysClearExecutionCache();
+	// unprotect pages, since we don't want to fault loading EE memory, and remember
+	// the code so we only need to throw out what the state changes.
+	SysBeginStateLoad();
 }
 
 static void PostLoadPrep()
 {
+	SysEndStateLoad();
+
 	resetCache();
 //	WriteCP0Status(cpuRegs.CP0.n.Status.val);
 	for (int i = 0; i < 48; i++)
@@ -180,9 +192,6 @@ SaveStateBase& SaveStateBase::FreezeInternals()
 {
 	const u32 previousCRC = ElfCRC;
 
-	// Print this until the MTVU problem in gifPathFreeze is taken care of (rama)
-	if (THREAD_VU1) Console.Warning("MTVU speedhack is enabled, saved states may not be stable");
-
 	// Second Block - Various CPU Registers and States
 	// -----------------------------------------------
 	FreezeTag( "cpuRegs" );
@@ -203,6 +212,10 @@ SaveStateBase& SaveStateBase::FreezeInternals()
 	{
 		DiscSerial = localDiscSerial;
 
+		// The event queues are derived from the saved pending masks and deadlines.
+		cpuRebuildEvents();
+		psxRebuildEvents();
+
 		if (ElfCRC != previousCRC)
 		{
 			// HACK: LastELF isn't in the save state... Load it before we go too far into restoring state.
@@ -391,6 +404,21 @@ static void SysState_ComponentFreezeIn(zip_file_t* zf, SysState_Component comp)
 		throw std::runtime_error(std::string(" * ") + comp.name + std::string(": Error loading state!\n"));
 }
 
+static void SysState_ComponentFreezeInMemory(const u8* data, u32 size, SysState_Component comp)
+{
+	freezeData fP = { 0, nullptr };
+	if (comp.freeze(FreezeAction::Size, &fP) != 0)
+		fP.size = 0;
+
+	// The component may modify the buffer while loading.
+	auto copy = std::make_unique<u8[]>(fP.size);
+	std::memcpy(copy.get(), data, std::min<u32>(size, fP.size));
+	fP.data = copy.get();
+
+	if (size != static_cast<u32>(fP.size) || comp.freeze(FreezeAction::Load, &fP) != 0)
+		throw std::runtime_error(std::string(" * ") + comp.name + std::string(": Error loading state!\n"));
+}
+
 static void SysState_ComponentFreezeOut(SaveStateBase& writer, SysState_Component comp)
 {
 	freezeData fP = { 0, NULL };
@@ -404,6 +432,16 @@ static void SysState_ComponentFreezeOut(SaveStateBase& writer, SysState_Componen
 	return;
 }
 
+static void SysState_ComponentFreezeInMemoryNew(const u8* data, u32 size, const char* name, bool (*do_state_func)(StateWrapper&))
+{
+	StateWrapper::ReadOnlyMemoryStream stream(data, size);
+	StateWrapper sw(&stream, StateWrapper::Mode::Read, g_SaveVersion);
+
+	// TODO: Get rid of the bloody exceptions.
+	if (!do_state_func(sw))
+		throw std::runtime_error(fmt::format(" * {}: Error loading state!", name));
+}
+
 static void SysState_ComponentFreezeInNew(zip_file_t* zf, const char* name, bool(*do_state_func)(StateWrapper&))
 {
 	// TODO: We could decompress on the fly here for a little bit more speed.
@@ -415,12 +453,7 @@ static void SysState_ComponentFreezeInNew(zip_file_t* zf, const char* name, bool
 			data = std::move(optdata.value());
 	}
 
-	StateWrapper::ReadOnlyMemoryStream stream(data.empty() ? nullptr : data.data(), data.size());
-	StateWrapper sw(&stream, StateWrapper::Mode::Read, g_SaveVersion);
-
-	// TODO: Get rid of the bloody exceptions.
-	if (!do_state_func(sw))
-		throw std::runtime_error(fmt::format(" * {}: Error loading state!", name));
+	SysState_ComponentFreezeInMemoryNew(data.empty() ? nullptr : data.data(), static_cast<u32>(data.size()), name, do_state_func);
 }
 
 static void SysState_ComponentFreezeOutNew(SaveStateBase& writer, const char* name, u32 reserve, bool (*do_state_func)(StateWrapper&))
@@ -454,8 +487,19 @@ public:
 
 	virtual const char* GetFilename() const = 0;
 	virtual void FreezeIn(zip_file_t* zf) const = 0;
+	virtual void FreezeInMemory(const u8* data, u32 size) const = 0;
 	virtual void FreezeOut(SaveStateBase& writer) const = 0;
 	virtual bool IsRequired() const = 0;
+
+	// Saves for SaveState_SaveToMemory(). Returns true if the data was left for the GS thread to write.
+	virtual bool FreezeOutDeferred(SaveStateBase& writer, SaveStateDeferredGS& deferred) const
+	{
+		FreezeOut(writer);
+		return false;
+	}
+
+	// Where `size` bytes of this entry can be decompressed to directly, or null if it has to go through FreezeInMemory().
+	virtual u8* GetDirectLoadPtr(u32 size) const { return nullptr; }
 };
 
 class MemorySavestateEntry : public BaseSavestateEntry
@@ -466,8 +510,10 @@ protected:
 
 public:
 	virtual void FreezeIn(zip_file_t* zf) const;
+	virtual void FreezeInMemory(const u8* data, u32 size) const;
 	virtual void FreezeOut(SaveStateBase& writer) const;
 	virtual bool IsRequired() const { return true; }
+	virtual u8* GetDirectLoadPtr(u32 size) const { return (size == GetDataSize()) ? GetDataPtr() : nullptr; }
 
 protected:
 	virtual u8* GetDataPtr() const = 0;
@@ -485,6 +531,11 @@ void MemorySavestateEntry::FreezeIn(zip_file_t* zf) const
 	}
 }
 
+void MemorySavestateEntry::FreezeInMemory(const u8* data, u32 size) const
+{
+	std::memcpy(GetDataPtr(), data, std::min(size, GetDataSize()));
+}
+
 void MemorySavestateEntry::FreezeOut(SaveStateBase& writer) const
 {
 	writer.FreezeMem(GetDataPtr(), GetDataSize());
@@ -507,12 +558,6 @@ public:
 	const char* GetFilename() const { return "eeMemory.bin"; }
 	u8* GetDataPtr() const { return eeMem->Main; }
 	uint GetDataSize() const { return sizeof(eeMem->Main); }
-
-	virtual void FreezeIn(zip_file_t* zf) const
-	{
-		SysClearExecutionCache();
-		MemorySavestateEntry::FreezeIn(zf);
-	}
 };
 
 class SavestateEntry_IopMemory : public MemorySavestateEntry
@@ -602,6 +647,7 @@ public:
 
 	const char* GetFilename() const { return "SPU2.bin"; }
 	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeIn(zf, SPU2_); }
+	void FreezeInMemory(const u8* data, u32 size) const { return SysState_ComponentFreezeInMemory(data, size, SPU2_); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOut(writer, SPU2_); }
 	bool IsRequired() const { return true; }
 };
@@ -613,6 +659,7 @@ public:
 
 	const char* GetFilename() const { return "USB.bin"; }
 	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeInNew(zf, "USB", &USB::DoState); }
+	void FreezeInMemory(const u8* data, u32 size) const { return SysState_ComponentFreezeInMemoryNew(data, size, "USB", &USB::DoState); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOutNew(writer, "USB", 16 * 1024, &USB::DoState); }
 	bool IsRequired() const { return false; }
 };
@@ -624,6 +671,7 @@ public:
 
 	const char* GetFilename() const { return "PAD.bin"; }
 	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeIn(zf, PAD_); }
+	void FreezeInMemory(const u8* data, u32 size) const { return SysState_ComponentFreezeInMemory(data, size, PAD_); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOut(writer, PAD_); }
 	bool IsRequired() const { return true; }
 };
@@ -635,8 +683,34 @@ public:
 
 	const char* GetFilename() const { return "GS.bin"; }
 	void FreezeIn(zip_file_t* zf) const { return SysState_ComponentFreezeIn(zf, GS); }
+	void FreezeInMemory(const u8* data, u32 size) const { return SysState_ComponentFreezeInMemory(data, size, GS); }
 	void FreezeOut(SaveStateBase& writer) const { return SysState_ComponentFreezeOut(writer, GS); }
 	bool IsRequired() const { return true; }
+
+	bool FreezeOutDeferred(SaveStateBase& writer, SaveStateDeferredGS& deferred) const
+	{
+		// The size is fixed, so only the first save has to wait on the GS thread for it.
+		if (deferred.data.empty())
+		{
+			freezeData fP = {0, nullptr};
+			if (SysState_MTGSFreeze(FreezeAction::Size, &fP) != 0 || fP.size <= 0)
+				throw std::runtime_error(" * GS: Failed to get state size");
+			deferred.data.resize(fP.size);
+		}
+
+		// Same layout as SysState_ComponentFreezeOut(), filled in at the same point in the ring.
+		const int size = static_cast<int>(deferred.data.size());
+		deferred.offset = static_cast<u32>(writer.GetCurrentPos());
+		writer.PrepBlock(size);
+		writer.CommitBlock(size);
+
+		GetMTGS().RunOnGSThread([&deferred]() {
+			freezeData fP = {static_cast<int>(deferred.data.size()), deferred.data.data()};
+			deferred.result = GSfreeze(FreezeAction::Save, &fP);
+			deferred.done.Post();
+		});
+		return true;
+	}
 };
 
 #ifdef ENABLE_ACHIEVEMENTS
@@ -660,6 +734,12 @@ class SaveStateEntry_Achievements : public BaseSavestateEntry
 			Achievements::LoadState(nullptr, 0);
 	}
 
+	void FreezeInMemory(const u8* data, u32 size) const override
+	{
+		if (Achievements::IsActive())
+			Achievements::LoadState(size ? data : nullptr, size);
+	}
+
 	void FreezeOut(SaveStateBase& writer) const override
 	{
 		if (!Achievements::IsActive())
@@ -704,6 +784,8 @@ static const std::unique_ptr<BaseSavestateEntry> SavestateEntries[] = {
 
 std::unique_ptr<ArchiveEntryList> SaveState_DownloadState()
 {
+	WarnIfMTVU();
+
 	std::unique_ptr<ArchiveEntryList> destlist = std::make_unique<ArchiveEntryList>(new VmStateBuffer("Zippable Savestate"));
 
 	memSavingState saveme(destlist->GetBuffer());
@@ -729,6 +811,75 @@ std::unique_ptr<ArchiveEntryList> SaveState_DownloadState()
 	return destlist;
 }
 
+u32 SaveState_SaveToMemory(VmStateBuffer& buffer, SaveStateDeferredGS& gs)
+{
+	memSavingState saveme(buffer);
+	saveme.FreezeBios();
+	saveme.FreezeInternals();
+
+	// Each entry is prefixed by its size, since they aren't all fixed size.
+	bool gs_queued = false;
+	try
+	{
+		for (const std::unique_ptr<BaseSavestateEntry>& entry : SavestateEntries)
+		{
+			const int sizepos = saveme.GetCurrentPos();
+			u32 size = 0;
+			saveme.Freeze(size);
+
+			gs_queued |= entry->FreezeOutDeferred(saveme, gs);
+			size = static_cast<u32>(saveme.GetCurrentPos() - sizepos - sizeof(size));
+			std::memcpy(buffer.GetPtr(sizepos), &size, sizeof(size));
+		}
+	}
+	catch (...)
+	{
+		// Don't leave the GS thread writing into gs, or its completion to be mistaken for the next save's.
+		if (gs_queued)
+			gs.done.Wait();
+		throw;
+	}
+
+	return static_cast<u32>(saveme.GetCurrentPos());
+}
+
+bool SaveState_CompleteMemoryState(VmStateBuffer& buffer, SaveStateDeferredGS& gs)
+{
+	gs.done.Wait();
+	if (gs.result != 0)
+		return false;
+
+	std::memcpy(buffer.GetPtr(gs.offset), gs.data.data(), gs.data.size());
+	return true;
+}
+
+void SaveState_LoadFromMemory(const VmStateBuffer& buffer)
+{
+	PreLoadPrep();
+
+	try
+	{
+		memLoadingState loadme(buffer);
+		loadme.FreezeBios();
+		loadme.FreezeInternals();
+
+		for (const std::unique_ptr<BaseSavestateEntry>& entry : SavestateEntries)
+		{
+			u32 size;
+			loadme.Freeze(size);
+			entry->FreezeInMemory(buffer.GetPtr(loadme.GetCurrentPos()), size);
+			loadme.CommitBlock(static_cast<int>(size));
+		}
+	}
+	catch (...)
+	{
+		SysEndStateLoad();
+		throw;
+	}
+
+	PostLoadPrep();
+}
+
 std::unique_ptr<SaveStateScreenshotData> SaveState_SaveScreenshot()
 {
 	static constexpr u32 SCREENSHOT_WIDTH = 640;
@@ -895,12 +1046,214 @@ static bool SaveState_ReadScreenshot(zip_t* zf, u32* out_width, u32* out_height,
 	return true;
 }
 
+// --------------------------------------------------------------------------------------
+//  Framed zstd entries
+// --------------------------------------------------------------------------------------
+// With zstd compression, entries are compressed by us rather than by libzip, and stored as-is
+// in the archive. Each entry is split into independent frames, so saving can compress them
+// across several threads, and loading can decompress them straight into emulated memory while
+// the rest of the state is being applied.
+
+static constexpr u32 FRAMED_ENTRY_MAGIC = 0x465A5350; // 'PSZF'
+static constexpr u32 FRAMED_ENTRY_FRAME_SIZE = 1 * _1mb;
+
+struct FramedEntryHeader
+{
+	u32 magic;
+	u32 uncompressed_size;
+	u32 frame_size;
+	u32 frame_count;
+	// followed by frame_count compressed frame sizes (u32), then the frames themselves
+};
+
+static std::unique_ptr<cb::ThreadPool> CreateStateThreadPool()
+{
+	// Leave a core for the emulator, we're usually running alongside it.
+	const int threads = std::clamp(static_cast<int>(cb::ThreadPool::GetNumLogicalCores()) - 1, 1, 8);
+	return std::make_unique<cb::ThreadPool>(threads);
+}
+
+bool SaveState_CompressFramed(ArchiveEntryList* srclist, std::vector<SaveStateFramedEntry>* entries)
+{
+	struct Frame
+	{
+		const u8* src;
+		u32 size;
+		std::vector<u8> data;
+	};
+
+	// Queue every frame of every entry up front, so big entries don't hold up the rest.
+	const uint listlen = srclist->GetLength();
+	std::vector<std::vector<Frame>> frames(listlen);
+	std::vector<std::future<bool>> results;
+	std::unique_ptr<cb::ThreadPool> pool = CreateStateThreadPool();
+	for (uint i = 0; i < listlen; ++i)
+	{
+		const ArchiveEntry& entry = (*srclist)[i];
+		const u8* src = srclist->GetPtr(entry.GetDataIndex());
+		const u32 size = static_cast<u32>(entry.GetDataSize());
+		if (!size)
+			continue;
+
+		const u32 frame_count = (size + FRAMED_ENTRY_FRAME_SIZE - 1) / FRAMED_ENTRY_FRAME_SIZE;
+		frames[i].resize(frame_count);
+		for (u32 j = 0; j < frame_count; j++)
+		{
+			Frame* frame = &frames[i][j];
+			frame->src = src + j * FRAMED_ENTRY_FRAME_SIZE;
+			frame->size = std::min(FRAMED_ENTRY_FRAME_SIZE, size - j * FRAMED_ENTRY_FRAME_SIZE);
+			results.push_back(pool->ScheduleAndGetFuture([frame]() {
+				frame->data.resize(ZSTD_compressBound(frame->size));
+				const size_t compressed = ZSTD_compress(frame->data.data(), frame->data.size(), frame->src, frame->size, 0);
+				if (ZSTD_isError(compressed))
+				{
+					Console.Error("Failed to compress save state frame: %s", ZSTD_getErrorName(compressed));
+					return false;
+				}
+
+				frame->data.resize(compressed);
+				return true;
+			}));
+		}
+	}
+
+	bool result = true;
+	for (std::future<bool>& future : results)
+		result &= future.get();
+	if (!result)
+		return false;
+
+	for (uint i = 0; i < listlen; ++i)
+	{
+		if (frames[i].empty())
+			continue;
+
+		const FramedEntryHeader header = {FRAMED_ENTRY_MAGIC, static_cast<u32>((*srclist)[i].GetDataSize()),
+			FRAMED_ENTRY_FRAME_SIZE, static_cast<u32>(frames[i].size())};
+		size_t total_size = sizeof(header) + sizeof(u32) * frames[i].size();
+		for (const Frame& frame : frames[i])
+			total_size += frame.data.size();
+
+		SaveStateFramedEntry& out = entries->emplace_back();
+		out.name = (*srclist)[i].GetFilename();
+		out.data.resize(total_size);
+
+		u8* ptr = out.data.data();
+		std::memcpy(ptr, &header, sizeof(header));
+		ptr += sizeof(header);
+		for (const Frame& frame : frames[i])
+		{
+			const u32 frame_size = static_cast<u32>(frame.data.size());
+			std::memcpy(ptr, &frame_size, sizeof(frame_size));
+			ptr += sizeof(frame_size);
+		}
+		for (Frame& frame : frames[i])
+		{
+			std::memcpy(ptr, frame.data.data(), frame.data.size());
+			ptr += frame.data.size();
+			std::vector<u8>().swap(frame.data);
+		}
+	}
+
+	return true;
+}
+
+/// Checks a stored entry for the framed layout, returning the frame sizes if it is one.
+static bool SaveState_ParseFramed(const std::vector<u8>& data, FramedEntryHeader* header, const u32** frame_sizes)
+{
+	if (data.size() < sizeof(FramedEntryHeader))
+		return false;
+
+	std::memcpy(header, data.data(), sizeof(FramedEntryHeader));
+	if (header->magic != FRAMED_ENTRY_MAGIC || header->frame_size == 0 ||
+		header->frame_count != (header->uncompressed_size + header->frame_size - 1) / header->frame_size ||
+		(data.size() - sizeof(FramedEntryHeader)) / sizeof(u32) < header->frame_count)
+	{
+		return false;
+	}
+
+	*frame_sizes = reinterpret_cast<const u32*>(data.data() + sizeof(FramedEntryHeader));
+	return true;
+}
+
+/// Queues decompression of every frame in a framed entry into dst, which must be uncompressed_size bytes.
+/// Nothing is queued if the entry is truncated, but once it returns true, data has to outlive the results.
+static bool SaveState_QueueFramedDecompress(cb::ThreadPool* pool, const std::vector<u8>& data, u8* dst,
+	std::vector<std::future<bool>>* results)
+{
+	FramedEntryHeader header;
+	const u32* frame_sizes;
+	if (!SaveState_ParseFramed(data, &header, &frame_sizes))
+		return false;
+
+	const u8* src = data.data() + sizeof(FramedEntryHeader) + sizeof(u32) * header.frame_count;
+	size_t remaining = data.size() - sizeof(FramedEntryHeader) - sizeof(u32) * header.frame_count;
+	for (u32 i = 0; i < header.frame_count; i++)
+	{
+		if (frame_sizes[i] > remaining)
+			return false;
+
+		remaining -= frame_sizes[i];
+	}
+
+	for (u32 i = 0; i < header.frame_count; i++)
+	{
+		const u32 compressed_size = frame_sizes[i];
+		u8* frame_dst = dst + static_cast<size_t>(i) * header.frame_size;
+		const u32 frame_size = std::min(header.frame_size, header.uncompressed_size - i * header.frame_size);
+		results->push_back(pool->ScheduleAndGetFuture([src, compressed_size, frame_dst, frame_size]() {
+			const size_t size = ZSTD_decompress(frame_dst, frame_size, src, compressed_size);
+			return (!ZSTD_isError(size) && size == frame_size);
+		}));
+
+		src += compressed_size;
+	}
+
+	return true;
+}
+
+bool SaveState_DecompressFramed(const std::vector<u8>& data, std::vector<u8>* out)
+{
+	FramedEntryHeader header;
+	const u32* frame_sizes;
+	if (!SaveState_ParseFramed(data, &header, &frame_sizes))
+		return false;
+
+	out->resize(header.uncompressed_size);
+	std::unique_ptr<cb::ThreadPool> pool = CreateStateThreadPool();
+	std::vector<std::future<bool>> results;
+	bool result = SaveState_QueueFramedDecompress(pool.get(), data, out->data(), &results);
+	for (std::future<bool>& future : results)
+		result &= future.get();
+
+	return result;
+}
+
+/// Reads a whole entry without decompressing it, if libzip stored it as-is.
+static bool SaveState_ReadStoredEntry(zip_t* zf, s64 index, std::vector<u8>* data)
+{
+	zip_stat_t zst;
+	if (zip_stat_index(zf, index, 0, &zst) != 0 || !(zst.valid & ZIP_STAT_COMP_METHOD) ||
+		zst.comp_method != ZIP_CM_STORE || zst.size < sizeof(FramedEntryHeader))
+	{
+		return false;
+	}
+
+	auto zff = zip_fopen_index_managed(zf, index, 0);
+	if (!zff)
+		return false;
+
+	data->resize(zst.size);
+	return (zip_fread(zff.get(), data->data(), zst.size) == static_cast<zip_int64_t>(zst.size));
+}
+
 // --------------------------------------------------------------------------------------
 //  CompressThread_VmState
 // --------------------------------------------------------------------------------------
-static bool SaveState_AddToZip(zip_t* zf, ArchiveEntryList* srclist, SaveStateScreenshotData* screenshot)
+static bool SaveState_AddToZip(zip_t* zf, ArchiveEntryList* srclist, const std::vector<SaveStateFramedEntry>& framed,
+	SaveStateScreenshotData* screenshot)
 {
-	// use zstd compression, it can be 10x+ faster for saving.
+	// framed entries cover everything when zstd is enabled, but follow the setting for anything else.
 	const u32 compression = EmuConfig.SavestateZstdCompression ? ZIP_CM_ZSTD : ZIP_CM_DEFLATE;
 	const u32 compression_level = 0;
 
@@ -921,7 +1274,24 @@ static bool SaveState_AddToZip(zip_t* zf, ArchiveEntryList* srclist, SaveStateSc
 		zip_set_file_compression(zf, fi, ZIP_CM_STORE, 0);
 	}
 
-	const uint listlen = srclist->GetLength();
+	// already compressed, just store them
+	for (const SaveStateFramedEntry& entry : framed)
+	{
+		zip_source_t* const zs = zip_source_buffer(zf, entry.data.data(), entry.data.size(), 0);
+		if (!zs)
+			return false;
+
+		const s64 fi = zip_file_add(zf, entry.name.c_str(), zs, ZIP_FL_ENC_UTF_8);
+		if (fi < 0)
+		{
+			zip_source_free(zs);
+			return false;
+		}
+
+		zip_set_file_compression(zf, fi, ZIP_CM_STORE, 0);
+	}
+
+	const uint listlen = srclist ? srclist->GetLength() : 0;
 	for (uint i = 0; i < listlen; ++i)
 	{
 		const ArchiveEntry& entry = (*srclist)[i];
@@ -953,6 +1323,20 @@ static bool SaveState_AddToZip(zip_t* zf, ArchiveEntryList* srclist, SaveStateSc
 
 bool SaveState_ZipToDisk(std::unique_ptr<ArchiveEntryList> srclist, std::unique_ptr<SaveStateScreenshotData> screenshot, const char* filename)
 {
+	// use zstd compression, it can be 10x+ faster for saving.
+	std::vector<SaveStateFramedEntry> framed;
+	if (EmuConfig.SavestateZstdCompression)
+	{
+		if (!SaveState_CompressFramed(srclist.get(), &framed))
+		{
+			Console.Error("Failed to compress save state for '%s'", filename);
+			return false;
+		}
+
+		// Everything we need is in the compressed copies now, don't hang on to the raw state while writing.
+		srclist.reset();
+	}
+
 	zip_error_t ze = {};
 	zip_source_t* zs = zip_source_file_create(filename, 0, 0, &ze);
 	zip_t* zf = nullptr;
@@ -966,7 +1350,7 @@ bool SaveState_ZipToDisk(std::unique_ptr<ArchiveEntryList> srclist, std::unique_
 	}
 
 	// discard zip file if we fail saving something
-	if (!SaveState_AddToZip(zf, srclist.get(), screenshot.get()))
+	if (!SaveState_AddToZip(zf, srclist.get(), framed, screenshot.get()))
 	{
 		Console.Error("Failed to save state to zip file '%s'", filename);
 		zip_discard(zf);
@@ -1040,6 +1424,24 @@ static bool LoadInternalStructuresState(zip_t* zf, s64 index)
 		return false;
 
 	// Load all the internal data
+	std::vector<u8> stored;
+	FramedEntryHeader header;
+	const u32* frame_sizes;
+	if (SaveState_ReadStoredEntry(zf, index, &stored) && SaveState_ParseFramed(stored, &header, &frame_sizes))
+	{
+		VmStateBuffer buffer(static_cast<int>(header.uncompressed_size), "StateBuffer_UnzipFromDisk");
+		std::unique_ptr<cb::ThreadPool> pool = CreateStateThreadPool();
+		std::vector<std::future<bool>> results;
+		bool result = SaveState_QueueFramedDecompress(pool.get(), stored, buffer.GetPtr(), &results);
+		for (std::future<bool>& future : results)
+			result &= future.get();
+		if (!result)
+			return false;
+
+		memLoadingState(buffer).FreezeBios().FreezeInternals();
+		return true;
+	}
+
 	auto zff = zip_fopen_index_managed(zf, index, 0);
 	if (!zff)
 		return false;
@@ -1054,6 +1456,8 @@ static bool LoadInternalStructuresState(zip_t* zf, s64 index)
 
 void SaveState_UnzipFromDisk(const std::string& filename)
 {
+	WarnIfMTVU();
+
 	zip_error_t ze = {};
 	auto zf = zip_open_managed(filename.c_str(), ZIP_RDONLY, &ze);
 	if (!zf)
@@ -1090,6 +1494,10 @@ void SaveState_UnzipFromDisk(const std::string& filename)
 			throwIt = true;
 	}
 
+	// Whatever made it into memory has to be invalidated if the load fails or throws part way, and
+	// block tracking resumed. Does nothing once PostLoadPrep() has ended the load.
+	ScopedGuard end_load([]() { SysEndStateLoad(); });
+
 	if (!throwIt)
 	{
 		PreLoadPrep();
@@ -1098,6 +1506,13 @@ void SaveState_UnzipFromDisk(const std::string& filename)
 
 	if (!throwIt)
 	{
+		// Framed entries which can go straight into emulated memory are decompressed on the pool,
+		// while the remaining components are applied here. The compressed data has to stay alive
+		// until the pool is done with it.
+		std::vector<std::vector<u8>> stored_entries;
+		std::unique_ptr<cb::ThreadPool> pool = CreateStateThreadPool();
+		std::vector<std::future<bool>> results;
+
 		for (u32 i = 0; i < std::size(SavestateEntries); ++i)
 		{
 			if (entryIndices[i] < 0)
@@ -1106,6 +1521,35 @@ void SaveState_UnzipFromDisk(const std::string& filename)
 				continue;
 			}
 
+			std::vector<u8> stored;
+			FramedEntryHeader header;
+			const u32* frame_sizes;
+			if (SaveState_ReadStoredEntry(zf.get(), entryIndices[i], &stored) && SaveState_ParseFramed(stored, &header, &frame_sizes))
+			{
+				if (u8* dst = SavestateEntries[i]->GetDirectLoadPtr(header.uncompressed_size))
+				{
+					// Moving the vector keeps its storage, so the queued frames can keep pointing into it.
+					const std::vector<u8>& entry = stored_entries.emplace_back(std::move(stored));
+					if (!SaveState_QueueFramedDecompress(pool.get(), entry, dst, &results))
+					{
+						throwIt = true;
+						break;
+					}
+
+					continue;
+				}
+
+				std::vector<u8> data;
+				if (!SaveState_DecompressFramed(stored, &data))
+				{
+					throwIt = true;
+					break;
+				}
+
+				SavestateEntries[i]->FreezeInMemory(data.data(), header.uncompressed_size);
+				continue;
+			}
+
 			auto zff = zip_fopen_index_managed(zf.get(), entryIndices[i], 0);
 			if (!zff)
 			{
@@ -1115,6 +1559,9 @@ void SaveState_UnzipFromDisk(const std::string& filename)
 
 			SavestateEntries[i]->FreezeIn(zff.get());
 		}
+
+		for (std::future<bool>& future : results)
+			throwIt |= !future.get();
 	}
 
 	if (throwIt)
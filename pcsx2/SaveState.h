@@ -22,6 +22,7 @@
 #include "System.h"
 #include "common/Assertions.h"
 #include "common/Exceptions.h"
+#include "common/Threading.h"
 
 enum class FreezeAction
 {
@@ -36,7 +37,7 @@ enum class FreezeAction
 // [SAVEVERSION+]
 // This informs the auto updater that the users savestates will be invalidated.
 
-static const u32 g_SaveVersion = (0x9A34 << 16) | 0x0000;
+static const u32 g_SaveVersion = (0x9A34 << 16) | 0x0001;
 
 
 // the freezing data between submodules and core
@@ -68,6 +69,34 @@ extern bool SaveState_ZipToDisk(std::unique_ptr<ArchiveEntryList> srclist, std::
 extern bool SaveState_ReadScreenshot(const std::string& filename, u32* out_width, u32* out_height, std::vector<u32>* out_pixels);
 extern void SaveState_UnzipFromDisk(const std::string& filename);
 
+// Entries which are compressed by us into independent zstd frames, and stored as-is in the archive.
+struct SaveStateFramedEntry
+{
+	std::string name;
+	std::vector<u8> data;
+};
+
+extern bool SaveState_CompressFramed(ArchiveEntryList* srclist, std::vector<SaveStateFramedEntry>* entries);
+extern bool SaveState_DecompressFramed(const std::vector<u8>& data, std::vector<u8>* out);
+
+// GS state of an in-memory save, which the GS thread writes when it reaches that point in its ring
+// rather than the CPU thread waiting for it. Reused between saves, data is sized on the first one.
+struct SaveStateDeferredGS
+{
+	std::vector<u8> data;
+	u32 offset = 0; // where data goes in the state buffer
+	int result = 0;
+	Threading::KernelSemaphore done;
+};
+
+// Flat, uncompressed states for keeping in memory (e.g. rewind). These aren't meant to be
+// kept across runs, there's no versioning beyond the usual internal structures check.
+// The state isn't complete until SaveState_CompleteMemoryState() has been called with the
+// same gs, which may be done from another thread; it must be before the next save.
+extern u32 SaveState_SaveToMemory(VmStateBuffer& buffer, SaveStateDeferredGS& gs);
+extern bool SaveState_CompleteMemoryState(VmStateBuffer& buffer, SaveStateDeferredGS& gs);
+extern void SaveState_LoadFromMemory(const VmStateBuffer& buffer);
+
 // --------------------------------------------------------------------------------------
 //  SaveStateBase class
 // --------------------------------------------------------------------------------------
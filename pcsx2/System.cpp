@@ -16,6 +16,7 @@
 #include "PrecompiledHeader.h"
 #include "Common.h"
 #include "R3000A.h"
+#include "IopMem.h"
 #include "VUmicro.h"
 #include "newVif.h"
 #include "MTVU.h"
@@ -34,6 +35,10 @@
 
 #include "GSDumpReplayer.h"
 
+#define XXH_STATIC_LINKING_ONLY 1
+#define XXH_INLINE_ALL 1
+#include <xxhash.h>
+
 #include "svnrev.h"
 
 extern R5900cpu GSDumpReplayerCpu;
@@ -353,6 +358,128 @@ void SysClearExecutionCache()
 	}
 }
 
+GuestPageHashes::GuestPageHashes(u32 size)
+	: m_hashes(size / PageSize)
+	, m_hashed(size / PageSize)
+{
+}
+
+GuestPageHashes::~GuestPageHashes() = default;
+
+void GuestPageHashes::Reset()
+{
+	std::fill(m_hashed.begin(), m_hashed.end(), false);
+}
+
+void GuestPageHashes::Hash(const u8* mem, u32 page)
+{
+	m_hashes[page] = XXH3_64bits(mem + page * PageSize, PageSize);
+	m_hashed[page] = true;
+}
+
+bool GuestPageHashes::HasChanged(const u8* mem, u32 page) const
+{
+	return m_hashed[page] && m_hashes[page] != XXH3_64bits(mem + page * PageSize, PageSize);
+}
+
+// EE pages are only hashed if they hold recompiled code, those are what SysEndStateLoad() goes through.
+static_assert(GuestPageHashes::PageSize == __pagesize, "EE hashes are indexed by protection page");
+static GuestPageHashes s_state_load_ee(Ps2MemSize::MainRam);
+static GuestPageHashes s_state_load_iop(Ps2MemSize::IopRam);
+static GuestPageHashes s_state_load_scratch(Ps2MemSize::Scratch);
+static bool s_state_load_active = false;
+
+// Loading a state used to call SysClearExecutionCache(), which meant recompiling everything the
+// game touched afterwards.  States of the same game almost always share most of their code,
+// so instead we remember what the code pages looked like before the load, and afterwards only
+// throw out blocks from pages which are different.  Must be called with the VU thread idle.
+void SysBeginStateLoad()
+{
+	s_state_load_active = true;
+
+	// Lift write protection so the load doesn't fault, without forgetting the code pages.
+	mmap_SuspendBlockTracking();
+
+	s_state_load_ee.Reset();
+	for (u32 i = 0; i < s_state_load_ee.GetPageCount(); i++)
+	{
+		if (mmap_IsTrackedRamPage(i))
+			s_state_load_ee.Hash(eeMem->Main, i);
+	}
+
+	// The IOP rec has no page tracking, it's invalidated on every write, so just hash the lot.
+	// Scratchpad isn't write protected either.
+	for (u32 i = 0; i < s_state_load_iop.GetPageCount(); i++)
+		s_state_load_iop.Hash(iopMem->Main, i);
+	for (u32 i = 0; i < s_state_load_scratch.GetPageCount(); i++)
+		s_state_load_scratch.Hash(eeMem->Scratch, i);
+
+	// microVU keys its program cache on the contents of micro memory, so it only needs telling that
+	// the memory may have changed, it'll reuse any programs which still match.  This clears the
+	// pipeline state, so it must happen before the state's copy of it is loaded.
+	CpuVU0->Clear(0, VU0_PROGSIZE);
+	CpuVU1->Clear(0, VU1_PROGSIZE);
+}
+
+// Does what SysClearExecutionCache() does, except for the EE and IOP recompiler resets, which are
+// replaced by clearing the pages the load changed.  Those resets drop every block, and with them
+// the state kept for the blocks: the RAM copy that blocks in self-modifying pages check themselves
+// against, the fastmem backpatch info, and the page protection.  That state belongs to the blocks
+// and is left consistent by Clear() for the ones which go, the same as when the game overwrites its
+// own code.  Nothing the recompilers generate depends on the rest of the machine state: registers
+// and hardware are read at run time, ROM isn't part of a state, TLB changes are remapped and
+// cleared by the loader, and the IOP's cache isolation is reapplied below.
+void SysEndStateLoad()
+{
+	if (!std::exchange(s_state_load_active, false))
+		return;
+
+	u32 ee_cleared = 0, iop_cleared = 0;
+	for (u32 i = 0; i < s_state_load_ee.GetPageCount(); i++)
+	{
+		if (s_state_load_ee.HasChanged(eeMem->Main, i))
+		{
+			mmap_InvalidateRamPage(i);
+			ee_cleared++;
+		}
+	}
+	mmap_ResumeBlockTracking();
+
+	for (u32 i = 0; i < s_state_load_scratch.GetPageCount(); i++)
+	{
+		if (s_state_load_scratch.HasChanged(eeMem->Scratch, i))
+		{
+			Cpu->Clear(0x70000000 + i * GuestPageHashes::PageSize, GuestPageHashes::PageSize / 4);
+			ee_cleared++;
+		}
+	}
+
+	for (u32 i = 0; i < s_state_load_iop.GetPageCount(); i++)
+	{
+		if (s_state_load_iop.HasChanged(iopMem->Main, i))
+		{
+			psxCpu->Clear(i * GuestPageHashes::PageSize, GuestPageHashes::PageSize / 4);
+			iop_cleared++;
+		}
+	}
+
+	// The state's IOP Status may isolate the cache where the old one didn't, or the other way round,
+	// and only the recompiled MTC0 updates the fastmem protection for it otherwise.
+	iopMemUpdateFastmemIsolation();
+
+	// Cheap to rebuild, so these are reset as before.
+	if (CHECK_EEREC && !EmuConfig.Cpu.Recompiler.EnableVU0)
+		CpuMicroVU0.Reset();
+
+	if (newVifDynaRec)
+	{
+		dVifReset(0);
+		dVifReset(1);
+	}
+
+	DevCon.WriteLn("State load invalidated %u EE and %u IOP code pages.", ee_cleared, iop_cleared);
+}
+
 // This function returns part of EXTINFO data of the BIOS rom
 // This module contains information about Sony build environment at offst 0x10
 // first 15 symbols is build date/time that is unique per rom and can be used as unique serial
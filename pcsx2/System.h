@@ -141,8 +141,35 @@ public:
 // implemented by the provisioning interface.
 extern SysCpuProviderPack& GetCpuProviders();
 
+// --------------------------------------------------------------------------------------
+//  GuestPageHashes
+// --------------------------------------------------------------------------------------
+// Hashes of the 4KB pages of a block of guest memory.  Taken before a savestate load and checked
+// after it, to find the pages whose recompiled code the load made stale.  Pages which weren't
+// hashed are never reported as changed.
+class GuestPageHashes
+{
+public:
+	static constexpr u32 PageSize = 0x1000;
+
+	explicit GuestPageHashes(u32 size);
+	~GuestPageHashes();
+
+	u32 GetPageCount() const { return static_cast<u32>(m_hashes.size()); }
+
+	void Reset();
+	void Hash(const u8* mem, u32 page);
+	bool HasChanged(const u8* mem, u32 page) const;
+
+private:
+	std::vector<u64> m_hashes;
+	std::vector<bool> m_hashed;
+};
+
 extern void SysLogMachineCaps();		// Detects cpu type and fills cpuInfo structs.
 extern void SysClearExecutionCache();	// clears recompiled execution caches!
+extern void SysBeginStateLoad();		// call before a savestate overwrites guest memory
+extern void SysEndStateLoad();			// drops only the recompiled code whose source changed
 
 extern std::string SysGetBiosDiscID();
 extern std::string SysGetDiscID();
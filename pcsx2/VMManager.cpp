@@ -23,6 +23,7 @@
 
 #include "common/Console.h"
 #include "common/FileSystem.h"
+#include "common/Perf.h"
 #include "common/ScopedGuard.h"
 #include "common/StringUtil.h"
 #include "common/SettingsWrapper.h"
@@ -48,6 +49,7 @@
 #include "Patch.h"
 #include "PerformanceMetrics.h"
 #include "R5900.h"
+#include "RewindBuffer.h"
 #include "SPU2/spu2.h"
 #include "DEV9/DEV9.h"
 #include "USB/USB.h"
@@ -58,6 +60,8 @@
 
 #include "DebugTools/MIPSAnalyst.h"
 #include "DebugTools/SymbolMap.h"
+#include "x86/BlockProfiler.h"
+#include "x86/TranslationCache.h"
 
 #include "IconsFontAwesome5.h"
 
@@ -85,6 +89,7 @@ namespace VMManager
 	static void CheckForPatchConfigChanges(const Pcsx2Config& old_config);
 	static void CheckForDEV9ConfigChanges(const Pcsx2Config& old_config);
 	static void CheckForMemoryCardConfigChanges(const Pcsx2Config& old_config);
+	static void UpdateRewindBuffer();
 	static void EnforceAchievementsChallengeModeSettings();
 	static void LogUnsafeSettingsToConsole(const std::string& messages);
 	static void WarnAboutUnsafeSettings();
@@ -124,6 +129,10 @@ static Threading::ThreadHandle s_vm_thread_handle;
 static std::deque<std::thread> s_save_state_threads;
 static std::mutex s_save_state_threads_mutex;
 
+static std::unique_ptr<RewindBuffer> s_rewind_buffer;
+static u32 s_rewind_frame_counter = 0;
+static bool s_rewinding = false;
+
 static std::recursive_mutex s_info_mutex;
 static std::string s_disc_path;
 static u32 s_game_crc;
@@ -766,6 +775,9 @@ void VMManager::UpdateRunningGame(bool resetting, bool game_starting)
 		ApplySettings();
 #endif
 
+	// Settings are final now, so the translation cache is keyed on the right ones.
+	TranslationCache::Open(s_game_serial, s_game_crc);
+
 	GetMTGS().SendGameCRC(new_crc);
 
 	Host::OnGameChanged(s_disc_path, s_elf_override, s_game_serial, s_game_name, s_game_crc);
@@ -1055,6 +1067,7 @@ bool VMManager::Initialize(VMBootParameters boot_params)
 	s_cpu_implementation_changed = false;
 	s_cpu_provider_pack->ApplyConfig();
 	SetCPUState(EmuConfig.Cpu.sseMXCSR, EmuConfig.Cpu.sseVU0MXCSR, EmuConfig.Cpu.sseVU1MXCSR);
+	BlockProfiler::ApplyConfig();
 	SysClearExecutionCache();
 	memBindConditionalHandlers();
 
@@ -1083,6 +1096,8 @@ bool VMManager::Initialize(VMBootParameters boot_params)
 		}
 	}
 
+	UpdateRewindBuffer();
+
 	return true;
 }
 
@@ -1099,6 +1114,13 @@ void VMManager::Shutdown(bool save_resume_state)
 		vu1Thread.WaitVU();
 	GetMTGS().WaitGS();
 
+	TranslationCache::Close();
+	BlockProfiler::WriteReport(s_game_serial);
+	Perf::CloseJitDump();
+
+	s_rewind_buffer.reset();
+	s_rewinding = false;
+
 	if (!GSDumpReplayer::IsReplayingDump() && save_resume_state)
 	{
 		std::string resume_file_name(GetCurrentSaveStateFileName(-1));
@@ -1196,6 +1218,10 @@ void VMManager::Reset()
 	s_active_widescreen_patches = 0;
 	s_active_no_interlacing_patches = 0;
 
+	// Rewinding past a reset would be confusing.
+	if (s_rewind_buffer)
+		s_rewind_buffer->Clear();
+
 	SysClearExecutionCache();
 	memBindConditionalHandlers();
 	UpdateVSyncRate();
@@ -1267,6 +1293,8 @@ bool VMManager::DoLoadState(const char* filename)
 	{
 		Host::OnSaveStateLoading(filename);
 		SaveState_UnzipFromDisk(filename);
+		if (s_rewind_buffer)
+			s_rewind_buffer->Clear();
 		UpdateRunningGame(false, false);
 		Host::OnSaveStateLoaded(filename, true);
 		if (g_InputRecording.isActive())
@@ -1626,6 +1654,21 @@ void VMManager::Internal::VSyncOnCPUThread()
 	ApplyLoadedPatches(PPT_CONTINUOUSLY);
 	ApplyLoadedPatches(PPT_COMBINED_0_1);
 
+	if (s_rewind_buffer)
+	{
+		if (s_rewinding)
+		{
+			// Hold on the oldest snapshot once we run out.
+			s_rewind_buffer->Rewind();
+			s_rewind_frame_counter = 0;
+		}
+		else if (++s_rewind_frame_counter >= EmuConfig.RewindFrequency)
+		{
+			s_rewind_frame_counter = 0;
+			s_rewind_buffer->Capture();
+		}
+	}
+
 	// Frame advance must be done *before* pumping messages, because otherwise
 	// we'll immediately reduce the counter we just set.
 	if (s_frame_advance_count > 0)
@@ -1671,8 +1714,10 @@ void VMManager::CheckForCPUConfigChanges(const Pcsx2Config& old_config)
 
 	Console.WriteLn("Updating CPU configuration...");
 	SetCPUState(EmuConfig.Cpu.sseMXCSR, EmuConfig.Cpu.sseVU0MXCSR, EmuConfig.Cpu.sseVU1MXCSR);
+	BlockProfiler::ApplyConfig();
 	SysClearExecutionCache();
 	memBindConditionalHandlers();
+	TranslationCache::Open(s_game_serial, s_game_crc);
 
 	if (EmuConfig.Cpu.Recompiler.EnableFastmem != old_config.Cpu.Recompiler.EnableFastmem)
 		vtlb_ResetFastmem();
@@ -1804,6 +1849,12 @@ void VMManager::CheckForConfigChanges(const Pcsx2Config& old_config)
 		CheckForMemoryCardConfigChanges(old_config);
 		USB::CheckForConfigChanges(old_config);
 
+		if (EmuConfig.EnableRewind != old_config.EnableRewind ||
+			EmuConfig.RewindBufferSizeMB != old_config.RewindBufferSizeMB)
+		{
+			UpdateRewindBuffer();
+		}
+
 		if (EmuConfig.EnableCheats != old_config.EnableCheats ||
 			EmuConfig.EnableWideScreenPatches != old_config.EnableWideScreenPatches ||
 			EmuConfig.EnableNoInterlacingPatches != old_config.EnableNoInterlacingPatches)
@@ -1820,6 +1871,36 @@ void VMManager::CheckForConfigChanges(const Pcsx2Config& old_config)
 	Host::CheckForSettingsChanges(old_config);
 }
 
+void VMManager::UpdateRewindBuffer()
+{
+	s_rewind_buffer.reset();
+	s_rewind_frame_counter = 0;
+	s_rewinding = false;
+
+	if (!EmuConfig.EnableRewind || GSDumpReplayer::IsReplayingDump())
+		return;
+
+	Console.WriteLn("(VMManager) Rewind enabled, snapshot every %u frames, %u MB budget.",
+		EmuConfig.RewindFrequency, EmuConfig.RewindBufferSizeMB);
+	s_rewind_buffer = std::make_unique<RewindBuffer>(static_cast<size_t>(EmuConfig.RewindBufferSizeMB) * _1mb);
+}
+
+void VMManager::SetRewinding(bool rewinding)
+{
+	if (!s_rewind_buffer)
+		return;
+
+	s_rewinding = rewinding;
+	if (!rewinding)
+	{
+		const RewindBuffer::Stats stats = s_rewind_buffer->GetStats();
+		DevCon.WriteLn("(VMManager) Rewind: %u snapshots (%u keyframes), %.1f of %.1f MB (%.1f MB capture buffers), last capture %.2f ms, %u skipped.",
+			stats.snapshots, stats.keyframes, static_cast<double>(stats.memory_used) / _1mb,
+			static_cast<double>(stats.memory_budget) / _1mb, static_cast<double>(stats.memory_fixed) / _1mb,
+			stats.last_capture_ms, stats.skipped);
+	}
+}
+
 void VMManager::ApplySettings()
 {
 	Console.WriteLn("Applying settings...");
@@ -1987,7 +2068,7 @@ void VMManager::WarnAboutUnsafeSettings()
 	if (!EmuConfig.Cpu.Recompiler.EnableIOP)
 		messages += ICON_FA_EXCLAMATION_CIRCLE " IOP Recompiler is not enabled, this will significantly reduce performance.\n";
 	if (EmuConfig.Cpu.Recompiler.EnableEECache)
-		messages += ICON_FA_EXCLAMATION_CIRCLE " EE Cache is enabled, this will significantly reduce performance.\n";
+		messages += ICON_FA_EXCLAMATION_CIRCLE " EE Cache is enabled, this may reduce performance.\n";
 	if (!EmuConfig.Speedhacks.WaitLoop)
 		messages += ICON_FA_EXCLAMATION_CIRCLE " EE Wait Loop Detection is not enabled, this may reduce performance.\n";
 	if (!EmuConfig.Speedhacks.IntcStat)
@@ -131,6 +131,9 @@ namespace VMManager
 	/// Waits until all compressing save states have finished saving to disk.
 	void WaitForSaveStateFlush();
 
+	/// While set, each vsync steps back to the previous rewind snapshot instead of taking a new one.
+	void SetRewinding(bool rewinding);
+
 	/// Removes all save states for the specified serial and crc. Returns the number of files deleted.
 	u32 DeleteSaveStates(const char* game_serial, u32 game_crc, bool also_backups = true);
 
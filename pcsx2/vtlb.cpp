@@ -35,6 +35,7 @@
 #include "COP0.h"
 #include "Cache.h"
 #include "IopMem.h"
+#include "R3000A.h"
 #include "Host.h"
 #include "VMManager.h"
 
@@ -126,38 +127,13 @@ vtlb_private::VTLBVirtual::VTLBVirtual(VTLBPhysical phys, u32 paddr, u32 vaddr)
 
 __inline int CheckCache(u32 addr)
 {
-	u32 mask;
-
 	if (((cpuRegs.CP0.n.Config >> 16) & 0x1) == 0)
 	{
 		//DevCon.Warning("Data Cache Disabled! %x", cpuRegs.CP0.n.Config);
 		return false; //
 	}
 
-	for (int i = 1; i < 48; i++)
-	{
-		if (((tlb[i].EntryLo1 & 0x38) >> 3) == 0x3)
-		{
-			mask = tlb[i].PageMask;
-
-			if ((addr >= tlb[i].PFN1) && (addr <= tlb[i].PFN1 + mask))
-			{
-				//DevCon.Warning("Yay! Cache check cache addr=%x, mask=%x, addr+mask=%x, VPN2=%x PFN0=%x", addr, mask, (addr & mask), tlb[i].VPN2, tlb[i].PFN0);
-				return true;
-			}
-		}
-		if (((tlb[i].EntryLo0 & 0x38) >> 3) == 0x3)
-		{
-			mask = tlb[i].PageMask;
-
-			if ((addr >= tlb[i].PFN0) && (addr <= tlb[i].PFN0 + mask))
-			{
-				//DevCon.Warning("Yay! Cache check cache addr=%x, mask=%x, addr+mask=%x, VPN2=%x PFN0=%x", addr, mask, (addr & mask), tlb[i].VPN2, tlb[i].PFN0);
-				return true;
-			}
-		}
-	}
-	return false;
+	return isCachedPage(addr);
 }
 // --------------------------------------------------------------------------------------
 // Interpreter Implementations of VTLB Memory Operations.
@@ -1472,6 +1448,11 @@ bool vtlb_private::PageFaultHandler(const PageFaultInfo& info)
 {
 	pxAssert(eeMem);
 
+	// the IOP recompiler has its own fastmem view, and all faults in it are backpatched
+	u32 iop_addr;
+	if (CHECK_FASTMEM && iopMemGetFastmemAddress(info.addr, &iop_addr))
+		return psxRecBackpatchLoadStore(info.pc, info.addr);
+
 	u32 vaddr;
 	if (CHECK_FASTMEM && vtlb_GetGuestAddress(info.addr, &vaddr))
 	{
@@ -1516,3 +1497,45 @@ void mmap_ResetBlockTracking()
 		HostSys::MemProtect(eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite());
 	vtlb_UpdateFastmemProtection(0, Ps2MemSize::MainRam, PageAccess_ReadWrite());
 }
+
+// Removes write protection from main RAM so it can be overwritten by a state load, but unlike
+// mmap_ResetBlockTracking(), remembers which pages hold recompiled code.  Pages whose contents
+// change should be passed to mmap_InvalidateRamPage(), then mmap_ResumeBlockTracking() puts the
+// protection back on the remaining ones.
+void mmap_SuspendBlockTracking()
+{
+	if (eeMem)
+		HostSys::MemProtect(eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite());
+	vtlb_UpdateFastmemProtection(0, Ps2MemSize::MainRam, PageAccess_ReadWrite());
+}
+
+void mmap_ResumeBlockTracking()
+{
+	pxAssert(eeMem);
+
+	for (u32 rampage = 0; rampage < std::size(m_PageProtectInfo); rampage++)
+	{
+		if (m_PageProtectInfo[rampage].Mode != ProtMode_Write)
+			continue;
+
+		HostSys::MemProtect(&eeMem->Main[rampage << __pageshift], __pagesize, PageAccess_ReadOnly());
+		vtlb_UpdateFastmemProtection(rampage << __pageshift, __pagesize, PageAccess_ReadOnly());
+	}
+}
+
+// rampage - page index relative to psM.
+// Returns true if any recompiled blocks were built from code in this page.
+bool mmap_IsTrackedRamPage(u32 rampage)
+{
+	const vtlb_ProtectionMode mode = m_PageProtectInfo[rampage].Mode;
+	return (mode == ProtMode_Write || mode == ProtMode_Manual);
+}
+
+// rampage - page index relative to psM.
+// Drops the recompiled blocks belonging to the page, and forgets its protection status, so the
+// page is protected afresh when code in it is next compiled.
+void mmap_InvalidateRamPage(u32 rampage)
+{
+	m_PageProtectInfo[rampage].Mode = ProtMode_None;
+	Cpu->Clear(m_PageProtectInfo[rampage].ReverseRamMap, __pagesize / 4);
+}
@@ -299,6 +299,10 @@ enum vtlb_ProtectionMode
 extern vtlb_ProtectionMode mmap_GetRamPageInfo(u32 paddr);
 extern void mmap_MarkCountedRamPage(u32 paddr);
 extern void mmap_ResetBlockTracking();
+extern void mmap_SuspendBlockTracking();
+extern void mmap_ResumeBlockTracking();
+extern bool mmap_IsTrackedRamPage(u32 rampage);
+extern void mmap_InvalidateRamPage(u32 rampage);
 
 // --------------------------------------------------------------------------------------
 //  Goemon game fix
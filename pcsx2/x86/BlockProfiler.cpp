@@ -0,0 +1,304 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "BlockProfiler.h"
+
+#include "Config.h"
+#include "DebugTools/Debug.h"
+
+#include "common/FileSystem.h"
+#include "common/Path.h"
+#include "common/Perf.h"
+#include "common/StringUtil.h"
+#include "common/emitter/x86emitter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace x86Emitter;
+
+namespace BlockProfiler
+{
+	// Enough for every block most games compile in a session. Kept static rather than allocated,
+	// so the recompiled code can address the counters relative to RIP.
+	static constexpr u32 MAX_COUNTERS = 256 * 1024;
+
+	// Blocks listed in the report, and how many of the hottest of those are disassembled.
+	static constexpr u32 REPORT_LISTED_BLOCKS = 1000;
+	static constexpr u32 REPORT_DISASSEMBLED_BLOCKS = 100;
+
+	struct BlockInfo
+	{
+		s32 id;
+		Cpu cpu;
+		u32 pc;
+		u32 cycles;
+		uptr host;
+		u32 host_size;
+		std::vector<u32> code;
+	};
+
+	// All compiles of the same guest block, for the report.
+	struct MergedBlock
+	{
+		const BlockInfo* hottest; // compile with the most executions, the one disassembled
+		u64 hottest_executions;
+		u64 executions;
+		u64 cycles;
+		u32 compiles;
+	};
+
+	static const char* const s_cpu_names[] = {"EE", "IOP", "VU0", "VU1"};
+	static_assert(std::size(s_cpu_names) == static_cast<size_t>(Cpu::Count));
+
+	alignas(64) static u64 s_counters[MAX_COUNTERS];
+	static std::atomic<u32> s_next_counter{0};
+	static std::atomic_bool s_counters_exhausted{false};
+
+	static std::mutex s_blocks_mutex;
+	static std::vector<BlockInfo> s_blocks;
+
+	static void DisassembleBlock(std::FILE* fp, const BlockInfo& block);
+} // namespace BlockProfiler
+
+void BlockProfiler::ApplyConfig()
+{
+	const bool jitdump = EmuConfig.Profiler.Enabled && EmuConfig.Profiler.JitDump;
+	if (jitdump == Perf::IsJitDumpOpen())
+		return;
+
+	if (!jitdump)
+	{
+		Perf::CloseJitDump();
+		Console.WriteLn("Profiler: Closed perf jitdump.");
+	}
+	else if (Perf::OpenJitDump())
+	{
+		Console.WriteLn("Profiler: Writing recompiled code to a perf jitdump.");
+	}
+	else
+	{
+		Console.Error("Profiler: Failed to open the perf jitdump.");
+	}
+}
+
+bool BlockProfiler::IsEnabled(Cpu cpu)
+{
+	const Pcsx2Config::ProfilerOptions& opts = EmuConfig.Profiler;
+	if (!opts.Enabled)
+		return false;
+
+	switch (cpu)
+	{
+		case Cpu::EE:
+			return opts.RecBlocks_EE;
+		case Cpu::IOP:
+			return opts.RecBlocks_IOP;
+		case Cpu::VU0:
+			return opts.RecBlocks_VU0;
+		case Cpu::VU1:
+			return opts.RecBlocks_VU1;
+		default:
+			return false;
+	}
+}
+
+s32 BlockProfiler::EmitCounter(Cpu cpu)
+{
+	u32 id = s_next_counter.load(std::memory_order_relaxed);
+	do
+	{
+		if (id >= MAX_COUNTERS)
+		{
+			if (!s_counters_exhausted.exchange(true, std::memory_order_relaxed))
+				Console.Warning("Profiler: Out of block counters, %s blocks compiled from now on aren't counted.", s_cpu_names[static_cast<u32>(cpu)]);
+			return -1;
+		}
+	} while (!s_next_counter.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+
+	xADD(ptr64[&s_counters[id]], 1);
+	return static_cast<s32>(id);
+}
+
+void BlockProfiler::AddBlock(s32 id, Cpu cpu, u32 pc, const void* guest, u32 guest_size, u32 cycles, uptr host, u32 host_size)
+{
+	if (id < 0)
+		return;
+
+	BlockInfo info;
+	info.id = id;
+	info.cpu = cpu;
+	info.pc = pc;
+	info.cycles = cycles;
+	info.host = host;
+	info.host_size = host_size;
+	if (guest)
+	{
+		info.code.resize(guest_size / sizeof(u32));
+		std::memcpy(info.code.data(), guest, info.code.size() * sizeof(u32));
+	}
+
+	std::unique_lock lock(s_blocks_mutex);
+	s_blocks.push_back(std::move(info));
+}
+
+void BlockProfiler::DisassembleBlock(std::FILE* fp, const BlockInfo& block)
+{
+	const u32 count = static_cast<u32>(block.code.size());
+	switch (block.cpu)
+	{
+		case Cpu::EE:
+		{
+			std::string line;
+			for (u32 i = 0; i < count; i++)
+			{
+				const u32 pc = block.pc + i * 4;
+				line.clear();
+				R5900::disR5900Fasm(line, block.code[i], pc, false);
+				std::fprintf(fp, "  %08x %08x: %s\n", pc, block.code[i], line.c_str());
+			}
+		}
+		break;
+
+		case Cpu::IOP:
+		{
+			// The IOP disassembler prefixes the address and opcode itself.
+			for (u32 i = 0; i < count; i++)
+				std::fprintf(fp, "  %s\n", R3000A::disR3000AF(block.code[i], block.pc + i * 4));
+		}
+		break;
+
+		case Cpu::VU0:
+		case Cpu::VU1:
+		{
+			// Lower instruction in the first word, upper in the second. Both halves share the
+			// disassembler's output buffer, so the upper has to be copied out first.
+			const bool vu1 = (block.cpu == Cpu::VU1);
+			for (u32 i = 0; i + 1 < count; i += 2)
+			{
+				const u32 pc = block.pc + i * 4;
+				const u32 lower = block.code[i];
+				const u32 upper = block.code[i + 1];
+				const std::string upper_str(vu1 ? disVU1MicroUF(upper, pc) : disVU0MicroUF(upper, pc));
+				const char* lower_str = vu1 ? disVU1MicroLF(lower, pc) : disVU0MicroLF(lower, pc);
+				std::fprintf(fp, "  %04x %08x %08x: %-40s %s\n", pc, upper, lower, upper_str.c_str(), lower_str);
+			}
+		}
+		break;
+
+		default:
+			break;
+	}
+}
+
+void BlockProfiler::WriteReport(const std::string& serial)
+{
+	std::unique_lock lock(s_blocks_mutex);
+
+	// Merge every compile of a guest block, whether it was recompiled after being cleared, or
+	// (for microVU) compiled again for a different pipeline state.
+	std::unordered_map<u64, MergedBlock> merged;
+	u64 cpu_executions[static_cast<u32>(Cpu::Count)] = {};
+	u64 cpu_cycles[static_cast<u32>(Cpu::Count)] = {};
+	for (const BlockInfo& block : s_blocks)
+	{
+		const u64 executions = s_counters[block.id];
+		if (executions == 0)
+			continue;
+
+		const u32 cpu = static_cast<u32>(block.cpu);
+		MergedBlock& mb = merged[(static_cast<u64>(cpu) << 32) | block.pc];
+		if (!mb.hottest || executions > mb.hottest_executions)
+		{
+			mb.hottest = &block;
+			mb.hottest_executions = executions;
+		}
+		mb.executions += executions;
+		mb.cycles += executions * block.cycles;
+		mb.compiles++;
+
+		cpu_executions[cpu] += executions;
+		cpu_cycles[cpu] += executions * block.cycles;
+	}
+
+	if (!merged.empty())
+	{
+		std::vector<const MergedBlock*> sorted;
+		sorted.reserve(merged.size());
+		for (const auto& it : merged)
+			sorted.push_back(&it.second);
+		std::sort(sorted.begin(), sorted.end(), [](const MergedBlock* lhs, const MergedBlock* rhs) {
+			return (lhs->cycles != rhs->cycles) ? (lhs->cycles > rhs->cycles) : (lhs->executions > rhs->executions);
+		});
+
+		const std::string path(Path::Combine(EmuFolders::Logs,
+			StringUtil::StdStringFromFormat("blockprofile_%s.txt", serial.empty() ? "unknown" : serial.c_str())));
+		auto fp = FileSystem::OpenManagedCFile(path.c_str(), "wb");
+		if (fp)
+		{
+			std::fprintf(fp.get(), "Recompiler block profile for %s\n", serial.empty() ? "unknown" : serial.c_str());
+			std::fprintf(fp.get(), "Cycles are estimated, as the guest cycles of one pass through a block times its executions.\n\n");
+			for (u32 cpu = 0; cpu < static_cast<u32>(Cpu::Count); cpu++)
+			{
+				if (cpu_executions[cpu] == 0)
+					continue;
+				std::fprintf(fp.get(), "%-4s %20llu executions %20llu cycles\n", s_cpu_names[cpu],
+					static_cast<unsigned long long>(cpu_executions[cpu]), static_cast<unsigned long long>(cpu_cycles[cpu]));
+			}
+
+			std::fprintf(fp.get(), "\n%6s %-4s %-8s %16s %18s %7s %6s %10s %8s\n", "Rank", "CPU", "PC", "Executions",
+				"Cycles", "% CPU", "Insns", "Host bytes", "Compiles");
+			const u32 listed = std::min<u32>(static_cast<u32>(sorted.size()), REPORT_LISTED_BLOCKS);
+			for (u32 i = 0; i < listed; i++)
+			{
+				const MergedBlock& mb = *sorted[i];
+				const BlockInfo& block = *mb.hottest;
+				const u32 cpu = static_cast<u32>(block.cpu);
+				const u32 insns = static_cast<u32>(block.code.size()) / ((block.cpu >= Cpu::VU0) ? 2 : 1);
+				std::fprintf(fp.get(), "%6u %-4s %08x %16llu %18llu %6.2f%% %6u %10u %8u\n", i + 1, s_cpu_names[cpu], block.pc,
+					static_cast<unsigned long long>(mb.executions), static_cast<unsigned long long>(mb.cycles),
+					cpu_cycles[cpu] ? (static_cast<double>(mb.cycles) * 100.0 / static_cast<double>(cpu_cycles[cpu])) : 0.0,
+					insns, block.host_size, mb.compiles);
+			}
+
+			const u32 disassembled = std::min<u32>(listed, REPORT_DISASSEMBLED_BLOCKS);
+			for (u32 i = 0; i < disassembled; i++)
+			{
+				const BlockInfo& block = *sorted[i]->hottest;
+				std::fprintf(fp.get(), "\n#%u %s %08x, %u cycles per pass, host code at %p (%u bytes):\n", i + 1,
+					s_cpu_names[static_cast<u32>(block.cpu)], block.pc, block.cycles, reinterpret_cast<void*>(block.host),
+					block.host_size);
+				DisassembleBlock(fp.get(), block);
+			}
+
+			Console.WriteLn("Profiler: Wrote %zu blocks to '%s'.", merged.size(), path.c_str());
+		}
+		else
+		{
+			Console.Error("Profiler: Failed to open '%s' for writing.", path.c_str());
+		}
+	}
+
+	s_blocks.clear();
+	std::memset(s_counters, 0, sizeof(s_counters));
+	s_next_counter.store(0, std::memory_order_relaxed);
+	s_counters_exhausted.store(false, std::memory_order_relaxed);
+}
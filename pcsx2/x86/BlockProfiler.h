@@ -0,0 +1,60 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <string>
+
+// Runtime profiling of the recompiled code, driven by the Profiler options.
+//
+// With RecBlocks_* set, each block compiled for that CPU bumps its own 64bit counter on entry.
+// The guest cycles a block accounts for are estimated statically, as the cycles of one pass
+// through it times its execution count, so the numbers say where the guest time goes, not the
+// host time. When the VM shuts down, blocks are merged by guest PC and written to the logs
+// folder hottest first, along with their disassembly and the size of their host code.
+//
+// With JitDump set, the recompiled code is also written to a perf jitdump (see common/Perf.h).
+namespace BlockProfiler
+{
+	enum class Cpu : u8
+	{
+		EE,
+		IOP,
+		VU0,
+		VU1,
+		Count
+	};
+
+	/// Opens or closes the jitdump to match the settings. Call before the recompilers are reset.
+	void ApplyConfig();
+
+	/// Returns true if blocks compiled for this CPU should be counted.
+	bool IsEnabled(Cpu cpu);
+
+	/// Emits the increment of a new counter at the current emitter position, returning its id,
+	/// or -1 once the counters run out.
+	s32 EmitCounter(Cpu cpu);
+
+	/// Describes the block a counter was emitted into, once it's compiled. guest points to its
+	/// code, guest_size bytes of it; cycles is the guest cycles of one pass through the block.
+	/// Safe to call from the VU thread.
+	void AddBlock(s32 id, Cpu cpu, u32 pc, const void* guest, u32 guest_size, u32 cycles, uptr host, u32 host_size);
+
+	/// Writes the report for everything counted so far, and starts over. Call as the VM shuts
+	/// down, the counters are handed out again so the recompilers must be reset before use.
+	void WriteReport(const std::string& serial);
+} // namespace BlockProfiler
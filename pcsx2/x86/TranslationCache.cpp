@@ -0,0 +1,463 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "TranslationCache.h"
+
+#include "Config.h"
+#include "MTVU.h"
+
+#include "common/FileSystem.h"
+#include "common/Path.h"
+#include "common/StringUtil.h"
+#include "common/Timer.h"
+
+#include "svnrev.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <xxhash.h>
+
+namespace TranslationCache
+{
+	static constexpr u32 CACHE_MAGIC = 0x31435450; // PTC1
+	static constexpr u32 CACHE_VERSION = 1;
+
+	// Recording stops at these, games which get there are generating blocks on the fly and
+	// most of what they'd add would never be seen again.
+	static constexpr u32 MAX_VIF_BLOCKS = 16384;
+	static constexpr u32 MAX_MICRO_PROGRAMS = 4096;
+	static constexpr u32 MAX_PROGRAM_ENTRIES = 1024;
+
+	struct FileHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 build_id;
+		u64 config_hash;
+		u32 num_vif_blocks;
+		u32 num_programs;
+	};
+
+	struct ProgramHeader
+	{
+		u32 vu_index;
+		u32 start_pc;
+		u64 hash;
+		u32 num_ranges;
+		u32 num_entries;
+		u32 data_size;
+		u32 pad;
+	};
+
+	static u64 GetBuildID();
+	static u64 GetConfigHash();
+	static u64 ComputeProgramHash(const MicroProgram& prog);
+	static u64 ComputeVifKey(const VifBlock& block);
+	static bool IsValidProgram(const MicroProgram& prog);
+	static void Load();
+	static void Save();
+	static void Prewarm();
+	static void ClearRecords();
+
+	static std::mutex s_mutex;
+	static std::atomic_bool s_recording{false};
+	static std::string s_path;
+	static u64 s_config_hash = 0;
+	static bool s_dirty = false;
+
+	static std::vector<VifBlock> s_vif_blocks;
+	static std::unordered_set<u64> s_vif_keys;
+	static std::unordered_map<u64, MicroProgram> s_programs;
+} // namespace TranslationCache
+
+u64 TranslationCache::GetBuildID()
+{
+	const s64 rev = SVN_REV;
+	XXH64_state_t* state = XXH64_createState();
+	XXH64_reset(state, CACHE_VERSION);
+	XXH64_update(state, GIT_HASH, std::strlen(GIT_HASH));
+	XXH64_update(state, &rev, sizeof(rev));
+#ifndef DISABLE_BUILD_DATE
+	// Builds from outside of git don't get a hash or revision.
+	static constexpr const char build_date[] = __DATE__ " " __TIME__;
+	XXH64_update(state, build_date, sizeof(build_date));
+#endif
+	const u64 id = XXH64_digest(state);
+	XXH64_freeState(state);
+	return id;
+}
+
+u64 TranslationCache::GetConfigHash()
+{
+	// Everything the VIF and microVU recompilers consult while generating code.
+	Pcsx2Config::RecompilerOptions recompiler = EmuConfig.Cpu.Recompiler;
+	recompiler.EnableTranslationCache = false;
+
+	const u32 values[] = {
+		recompiler.bitset,
+		EmuConfig.Gamefixes.bitset,
+		EmuConfig.Speedhacks.vuFlagHack,
+		THREAD_VU1,
+		EmuConfig.Cpu.sseVU0MXCSR.bitmask,
+		EmuConfig.Cpu.sseVU1MXCSR.bitmask,
+	};
+	return XXH64(values, sizeof(values), 0);
+}
+
+u64 TranslationCache::ComputeProgramHash(const MicroProgram& prog)
+{
+	XXH64_state_t* state = XXH64_createState();
+	XXH64_reset(state, prog.vuIndex);
+	XXH64_update(state, &prog.startPC, sizeof(prog.startPC));
+	XXH64_update(state, prog.ranges.data(), prog.ranges.size() * sizeof(MicroRange));
+	XXH64_update(state, prog.data.data(), prog.data.size());
+	const u64 hash = XXH64_digest(state);
+	XXH64_freeState(state);
+	return hash;
+}
+
+u64 TranslationCache::ComputeVifKey(const VifBlock& block)
+{
+	return XXH64(&block, sizeof(block), 0);
+}
+
+bool TranslationCache::IsValidProgram(const MicroProgram& prog)
+{
+	if (prog.vuIndex > 1 || prog.ranges.empty() || prog.entries.empty())
+		return false;
+
+	const s32 mem_size = prog.vuIndex ? 0x4000 : 0x1000;
+	if (prog.startPC >= static_cast<u32>(mem_size / 8))
+		return false;
+
+	size_t data_size = 0;
+	for (const MicroRange& range : prog.ranges)
+	{
+		if (range.start < 0 || range.end > mem_size || range.start >= range.end || ((range.start | range.end) & 7))
+			return false;
+		data_size += range.end - range.start;
+	}
+
+	for (const MicroEntry& entry : prog.entries)
+	{
+		if (entry.startPC >= static_cast<u32>(mem_size) || (entry.startPC & 7))
+			return false;
+	}
+
+	return (data_size == prog.data.size() && ComputeProgramHash(prog) == prog.hash);
+}
+
+void TranslationCache::ClearRecords()
+{
+	s_vif_blocks.clear();
+	s_vif_keys.clear();
+	s_programs.clear();
+	s_dirty = false;
+}
+
+void TranslationCache::Load()
+{
+	std::optional<std::vector<u8>> data = FileSystem::ReadBinaryFile(s_path.c_str());
+	if (!data.has_value())
+		return;
+
+	const u8* ptr = data->data();
+	const u8* const end = ptr + data->size();
+	auto read = [&ptr, end](void* dst, size_t size) {
+		if (static_cast<size_t>(end - ptr) < size)
+			return false;
+		std::memcpy(dst, ptr, size);
+		ptr += size;
+		return true;
+	};
+
+	FileHeader hdr;
+	if (!read(&hdr, sizeof(hdr)) || hdr.magic != CACHE_MAGIC || hdr.version != CACHE_VERSION)
+	{
+		Console.Warning("(TranslationCache) Ignoring invalid cache file '%s'", s_path.c_str());
+		return;
+	}
+	if (hdr.build_id != GetBuildID() || hdr.config_hash != s_config_hash)
+	{
+		Console.WriteLn("(TranslationCache) Discarding '%s', it was made by a different build or with different settings",
+			Path::GetFileName(s_path).data());
+		return;
+	}
+
+	for (u32 i = 0; i < hdr.num_vif_blocks; i++)
+	{
+		VifBlock block;
+		if (!read(&block, sizeof(block)) || block.idx > 1)
+		{
+			Console.Warning("(TranslationCache) Cache file '%s' is corrupted", s_path.c_str());
+			ClearRecords();
+			return;
+		}
+		if (s_vif_keys.insert(ComputeVifKey(block)).second)
+			s_vif_blocks.push_back(block);
+	}
+
+	for (u32 i = 0; i < hdr.num_programs; i++)
+	{
+		ProgramHeader phdr;
+		MicroProgram prog;
+		bool okay = read(&phdr, sizeof(phdr)) && phdr.num_ranges <= 0x800 && phdr.num_entries <= MAX_PROGRAM_ENTRIES &&
+					phdr.data_size <= 0x4000;
+		if (okay)
+		{
+			prog.vuIndex = phdr.vu_index;
+			prog.startPC = phdr.start_pc;
+			prog.hash = phdr.hash;
+			prog.ranges.resize(phdr.num_ranges);
+			prog.data.resize(phdr.data_size);
+			prog.entries.resize(phdr.num_entries);
+			okay = read(prog.ranges.data(), prog.ranges.size() * sizeof(MicroRange)) &&
+				   read(prog.data.data(), prog.data.size()) &&
+				   read(prog.entries.data(), prog.entries.size() * sizeof(MicroEntry)) &&
+				   IsValidProgram(prog);
+		}
+		if (!okay)
+		{
+			Console.Warning("(TranslationCache) Cache file '%s' is corrupted", s_path.c_str());
+			ClearRecords();
+			return;
+		}
+
+		const u64 hash = prog.hash;
+		s_programs.emplace(hash, std::move(prog));
+	}
+}
+
+void TranslationCache::Save()
+{
+	if (!s_dirty || s_path.empty())
+		return;
+
+	std::vector<u8> data;
+	auto write = [&data](const void* src, size_t size) {
+		data.insert(data.end(), static_cast<const u8*>(src), static_cast<const u8*>(src) + size);
+	};
+
+	FileHeader hdr = {};
+	hdr.magic = CACHE_MAGIC;
+	hdr.version = CACHE_VERSION;
+	hdr.build_id = GetBuildID();
+	hdr.config_hash = s_config_hash;
+	hdr.num_vif_blocks = static_cast<u32>(s_vif_blocks.size());
+	hdr.num_programs = static_cast<u32>(s_programs.size());
+	write(&hdr, sizeof(hdr));
+	write(s_vif_blocks.data(), s_vif_blocks.size() * sizeof(VifBlock));
+
+	for (const auto& it : s_programs)
+	{
+		const MicroProgram& prog = it.second;
+		ProgramHeader phdr = {};
+		phdr.vu_index = prog.vuIndex;
+		phdr.start_pc = prog.startPC;
+		phdr.hash = prog.hash;
+		phdr.num_ranges = static_cast<u32>(prog.ranges.size());
+		phdr.num_entries = static_cast<u32>(prog.entries.size());
+		phdr.data_size = static_cast<u32>(prog.data.size());
+		write(&phdr, sizeof(phdr));
+		write(prog.ranges.data(), prog.ranges.size() * sizeof(MicroRange));
+		write(prog.data.data(), prog.data.size());
+		write(prog.entries.data(), prog.entries.size() * sizeof(MicroEntry));
+	}
+
+	if (!FileSystem::EnsureDirectoryExists(std::string(Path::GetDirectory(s_path)).c_str(), true))
+		return;
+
+	// Write to a temporary file and swap it in, so a crash can't leave a truncated cache behind.
+	const std::string temp_path(StringUtil::StdStringFromFormat("%s.new", s_path.c_str()));
+	auto fp = FileSystem::OpenManagedCFile(temp_path.c_str(), "wb");
+	if (!fp)
+		return;
+
+	bool success = (std::fwrite(data.data(), data.size(), 1, fp.get()) == 1);
+	success = success && (std::fflush(fp.get()) == 0);
+	fp.reset();
+
+	if (!success || !FileSystem::RenamePath(temp_path.c_str(), s_path.c_str()))
+	{
+		Console.Warning("(TranslationCache) Can't write cache file '%s'", s_path.c_str());
+		FileSystem::DeleteFilePath(temp_path.c_str());
+		return;
+	}
+
+	DevCon.WriteLn("(TranslationCache) Saved %zu VIF unpacks and %zu microprograms to '%s'",
+		s_vif_blocks.size(), s_programs.size(), s_path.c_str());
+	s_dirty = false;
+}
+
+void TranslationCache::Prewarm()
+{
+	// VIF1 and microVU1 belong to the VU thread while MTVU is on. Once it's idle nothing else
+	// records, so the programs can be used in place.
+	if (THREAD_VU1)
+		vu1Thread.WaitVU();
+
+	std::vector<VifBlock> vif_blocks;
+	std::vector<const MicroProgram*> programs;
+	{
+		std::unique_lock lock(s_mutex);
+		vif_blocks = s_vif_blocks;
+		programs.reserve(s_programs.size());
+		for (const auto& it : s_programs)
+			programs.push_back(&it.second);
+	}
+	if (vif_blocks.empty() && programs.empty())
+		return;
+
+	Common::Timer timer;
+
+	u32 vif_compiled = 0;
+	for (const VifBlock& block : vif_blocks)
+		vif_compiled += dVifPrewarm(block);
+
+	u32 micro_compiled = 0;
+	for (const MicroProgram* prog : programs)
+	{
+		const bool rec_enabled = prog->vuIndex ? EmuConfig.Cpu.Recompiler.EnableVU1 : EmuConfig.Cpu.Recompiler.EnableVU0;
+		micro_compiled += (rec_enabled && mVUprewarm(*prog));
+	}
+
+	// Opened again without the recompilers having been reset in between, everything was cached already.
+	if (vif_compiled == 0 && micro_compiled == 0)
+		return;
+
+	Console.WriteLn("(TranslationCache) Prewarmed %u/%zu VIF unpacks and %u/%zu microprograms in %.2f ms",
+		vif_compiled, vif_blocks.size(), micro_compiled, programs.size(), timer.GetTimeMilliseconds());
+}
+
+void TranslationCache::Open(const std::string& serial, u32 crc)
+{
+	// Nothing to key the cache on at the BIOS.
+	if (!EmuConfig.Cpu.Recompiler.EnableTranslationCache || crc == 0)
+	{
+		Close();
+		return;
+	}
+
+	const std::string path(Path::Combine(EmuFolders::Cache,
+		Path::Combine("translations", StringUtil::StdStringFromFormat("%s_%08X.bin", serial.c_str(), crc))));
+	const u64 config_hash = GetConfigHash();
+
+	if (s_recording.load(std::memory_order_relaxed) && path == s_path)
+	{
+		// Same game, the recompilers were just reset (e.g. the VM was, or the settings changed). What we
+		// have is useless if the settings changed the generated code, otherwise translate it all again.
+		if (config_hash != s_config_hash)
+		{
+			std::unique_lock lock(s_mutex);
+			ClearRecords();
+			s_config_hash = config_hash;
+		}
+	}
+	else
+	{
+		Close();
+
+		std::unique_lock lock(s_mutex);
+		s_path = path;
+		s_config_hash = config_hash;
+		Load();
+		s_recording.store(true, std::memory_order_release);
+	}
+
+	Prewarm();
+}
+
+void TranslationCache::Close()
+{
+	if (!s_recording.load(std::memory_order_relaxed))
+		return;
+
+	// Pick up everything that's still in the microVU caches.
+	if (THREAD_VU1)
+		vu1Thread.WaitVU();
+	if (EmuConfig.Cpu.Recompiler.EnableVU0)
+		mVUharvestTranslations(0);
+	if (EmuConfig.Cpu.Recompiler.EnableVU1)
+		mVUharvestTranslations(1);
+
+	std::unique_lock lock(s_mutex);
+	s_recording.store(false, std::memory_order_release);
+	Save();
+	ClearRecords();
+	s_path.clear();
+}
+
+bool TranslationCache::IsRecording()
+{
+	return s_recording.load(std::memory_order_acquire);
+}
+
+void TranslationCache::AddVifBlock(const VifBlock& block)
+{
+	std::unique_lock lock(s_mutex);
+	if (!s_recording.load(std::memory_order_relaxed) || s_vif_blocks.size() >= MAX_VIF_BLOCKS)
+		return;
+
+	if (s_vif_keys.insert(ComputeVifKey(block)).second)
+	{
+		s_vif_blocks.push_back(block);
+		s_dirty = true;
+	}
+}
+
+void TranslationCache::AddMicroProgram(MicroProgram prog)
+{
+	prog.hash = ComputeProgramHash(prog);
+
+	std::unique_lock lock(s_mutex);
+	if (!s_recording.load(std::memory_order_relaxed))
+		return;
+
+	auto it = s_programs.find(prog.hash);
+	if (it == s_programs.end())
+	{
+		if (s_programs.size() >= MAX_MICRO_PROGRAMS)
+			return;
+
+		if (prog.entries.size() > MAX_PROGRAM_ENTRIES)
+			prog.entries.resize(MAX_PROGRAM_ENTRIES);
+
+		const u64 hash = prog.hash;
+		s_programs.emplace(hash, std::move(prog));
+		s_dirty = true;
+		return;
+	}
+
+	// Seen before (e.g. harvested again after a prewarm), keep any new ways into it.
+	std::vector<MicroEntry>& entries = it->second.entries;
+	for (const MicroEntry& entry : prog.entries)
+	{
+		if (entries.size() >= MAX_PROGRAM_ENTRIES)
+			break;
+
+		const bool known = std::any_of(entries.begin(), entries.end(), [&entry](const MicroEntry& e) {
+			return e.startPC == entry.startPC && std::memcmp(e.pState, entry.pState, sizeof(e.pState)) == 0;
+		});
+		if (!known)
+		{
+			entries.push_back(entry);
+			s_dirty = true;
+		}
+	}
+}
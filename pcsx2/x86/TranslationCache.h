@@ -0,0 +1,89 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+
+#include <string>
+#include <vector>
+
+// Per-game record of what the VIF unpack and microVU recompilers have translated, kept on
+// disk so the next boot of the same game can translate all of it up front, rather than
+// stalling on the first use of each block during play.
+//
+// The translated code itself isn't stored, it embeds the absolute addresses of emulator
+// state and of the dispatchers, which move between runs. What's stored is everything the
+// recompilers need to reproduce it: the nVifBlock keys, and for microVU the micro memory
+// each program was compiled from (keyed by a hash of its contents), with the pipeline
+// states its blocks were entered with.
+//
+// Files are tied to the emulator build, and to the settings which change the generated
+// code (clamp modes, gamefixes, flag hack, MTVU); a mismatch on either discards the file.
+namespace TranslationCache
+{
+	struct VifBlock
+	{
+		u32 idx;
+		u32 isFill;
+		u32 hash_key; // nVifBlock::hash_key
+		u32 key0;
+		u32 key1;
+	};
+
+	struct MicroRange
+	{
+		s32 start; // in bytes, as microRange
+		s32 end;
+	};
+
+	struct MicroEntry
+	{
+		u32 startPC; // in bytes
+		u8 pState[160]; // microRegInfo the block was entered with
+	};
+
+	struct MicroProgram
+	{
+		u32 vuIndex;
+		u32 startPC; // in 64bit words, as microProgram::startPC
+		u64 hash; // over vuIndex, startPC, ranges and data
+		std::vector<MicroRange> ranges; // sorted, non-overlapping
+		std::vector<u8> data; // micro memory over each range, back to back
+		std::vector<MicroEntry> entries;
+	};
+
+	/// Switches to the cache for the given game, saving the previous game's. Translates everything
+	/// recorded for it which isn't already in the recompiler caches. Must be called on the CPU thread,
+	/// outside of recompiled code being compiled. Does nothing if the cache is disabled.
+	void Open(const std::string& serial, u32 crc);
+
+	/// Saves the current game's cache, and stops recording.
+	void Close();
+
+	/// Records a VIF unpack block. Called by the VIF recompiler, from either thread.
+	void AddVifBlock(const VifBlock& block);
+
+	/// Records a microprogram. Called by microVU when harvesting its programs, from either thread.
+	void AddMicroProgram(MicroProgram prog);
+
+	/// Returns true if translations are being recorded.
+	bool IsRecording();
+} // namespace TranslationCache
+
+// Implemented by the recompilers. The prewarm functions return true if anything was compiled.
+extern bool dVifPrewarm(const TranslationCache::VifBlock& block);
+extern void mVUharvestTranslations(u32 vuIndex);
+extern bool mVUprewarm(const TranslationCache::MicroProgram& prog);
@@ -37,6 +37,7 @@
 #endif
 
 #include "iCore.h"
+#include "BlockProfiler.h"
 
 #include "Config.h"
 
@@ -48,6 +49,9 @@
 
 #include "fmt/core.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 // #define DUMP_BLOCKS 1
 // #define TRACE_BLOCKS 1
 
@@ -99,6 +103,7 @@ static u32 s_saveHasConstReg = 0, s_saveFlushedConstReg = 0;
 static EEINST* s_psaveInstInfo = NULL;
 
 u32 s_psxBlockCycles = 0; // cycles of current block recompiling
+static s32 s_psxBlockProfileId = -1; // BlockProfiler counter of current block recompiling
 static u32 s_savenBlockCycles = 0;
 static bool s_recompilingDelaySlot = false;
 
@@ -109,6 +114,7 @@ extern void (*rpsxBSC[64])();
 void rpsxpropBSC(EEINST* prev, EEINST* pinst);
 
 static void iopClearRecLUT(BASEBLOCK* base, int count);
+static void psxRecClearLoadStoreInfo();
 
 #define PSX_GETBLOCK(x) PC_GETBLOCK_(x, psxRecLUT)
 
@@ -993,6 +999,9 @@ void recResetIOP()
 	recBlocks.Reset();
 	g_psxMaxRecMem = 0;
 
+	psxRecClearLoadStoreInfo();
+	iopMemResetFastmemProtection();
+
 	recPtr = *recMem;
 	psxbranch = 0;
 }
@@ -1112,6 +1121,189 @@ static __fi void recClearIOP(u32 Addr, u32 Size)
 		pc += PSXREC_CLEARM(pc);
 }
 
+struct PsxLoadStoreBackpatchInfo
+{
+	u32 guest_pc;
+	u32 gpr_bitmask;
+	u8 code_size;
+	u8 address_register;
+	u8 data_register;
+	u8 size_in_bits;
+	bool is_signed;
+	bool is_load;
+};
+
+static std::unordered_map<uptr, PsxLoadStoreBackpatchInfo> s_fastmem_backpatch_info;
+static std::unordered_set<u32> s_fastmem_faulting_pcs;
+
+void psxRecAddLoadStoreInfo(uptr code_address, u32 code_size, u32 guest_pc, u32 gpr_bitmask,
+	u8 address_register, u8 data_register, u8 size_in_bits, bool is_signed, bool is_load)
+{
+	pxAssert(code_size < std::numeric_limits<u8>::max());
+
+	s_fastmem_backpatch_info[code_address] = PsxLoadStoreBackpatchInfo{guest_pc, gpr_bitmask, static_cast<u8>(code_size),
+		address_register, data_register, size_in_bits, is_signed, is_load};
+}
+
+bool psxRecIsFaultingPC(u32 guest_pc)
+{
+	return (s_fastmem_faulting_pcs.find(guest_pc) != s_fastmem_faulting_pcs.end());
+}
+
+static void psxRecClearLoadStoreInfo()
+{
+	s_fastmem_backpatch_info.clear();
+	s_fastmem_faulting_pcs.clear();
+}
+
+// Replaces a faulting fastmem access with a jump to a thunk which calls the memory handler.
+static void psxRecDynBackpatchLoadStore(uptr code_address, const PsxLoadStoreBackpatchInfo& info)
+{
+	static constexpr u32 GPR_SIZE = 8;
+
+	// on win32, we need to reserve an additional 32 bytes shadow space when calling out to C
+#ifdef _WIN32
+	static constexpr u32 SHADOW_SIZE = 32;
+#else
+	static constexpr u32 SHADOW_SIZE = 0;
+#endif
+
+	const auto needs_save = [&info](u32 i) {
+		return (info.gpr_bitmask & (1u << i)) && xRegisterBase::IsCallerSaved(i) &&
+			   (!info.is_load || info.data_register != i);
+	};
+
+	// the thunk goes after the blocks, so it's thrown away with them when the recompiler is reset
+	pxAssertRel(recPtr < recMem->GetPtrEnd() - _4kb, "IOP recompiler cache is full");
+	x86SetPtr(recPtr);
+	x86Align(16);
+	u8* thunk = x86Ptr;
+
+	u32 num_gprs = 0;
+	for (u32 i = 0; i < iREGCNT_GPR; i++)
+		num_gprs += needs_save(i) ? 1 : 0;
+
+	const u32 stack_size = (((num_gprs + 1) & ~1u) * GPR_SIZE) + SHADOW_SIZE;
+	if (stack_size > 0)
+	{
+		xSUB(rsp, stack_size);
+
+		u32 stack_offset = SHADOW_SIZE;
+		for (u32 i = 0; i < iREGCNT_GPR; i++)
+		{
+			if (needs_save(i))
+			{
+				xMOV(ptr64[rsp + stack_offset], xRegister64(i));
+				stack_offset += GPR_SIZE;
+			}
+		}
+	}
+
+	if (!info.is_load && info.data_register != arg2reg.GetId())
+		xMOV(arg2regd, xRegister32(info.data_register));
+
+	// the address register holds the host pointer, turn it back into an IOP address
+	if (info.address_register != arg1reg.GetId())
+		xMOV(arg1reg, xRegister64(info.address_register));
+	xSUB(arg1reg, ptr64[&iopFastmemBase]);
+
+	switch (info.size_in_bits)
+	{
+		case 8:
+			xFastCall(info.is_load ? (void*)iopMemRead8 : (void*)iopMemWrite8);
+			break;
+		case 16:
+			xFastCall(info.is_load ? (void*)iopMemRead16 : (void*)iopMemWrite16);
+			break;
+		case 32:
+			xFastCall(info.is_load ? (void*)iopMemRead32 : (void*)iopMemWrite32);
+			break;
+
+			jNO_DEFAULT
+	}
+
+	if (info.is_load)
+	{
+		const xRegister32 dreg(info.data_register);
+		switch (info.size_in_bits)
+		{
+			case 8:
+				info.is_signed ? xMOVSX(dreg, al) : xMOVZX(dreg, al);
+				break;
+			case 16:
+				info.is_signed ? xMOVSX(dreg, ax) : xMOVZX(dreg, ax);
+				break;
+			case 32:
+				if (info.data_register != eax.GetId())
+					xMOV(dreg, eax);
+				break;
+
+				jNO_DEFAULT
+		}
+	}
+
+	if (stack_size > 0)
+	{
+		u32 stack_offset = SHADOW_SIZE;
+		for (u32 i = 0; i < iREGCNT_GPR; i++)
+		{
+			if (needs_save(i))
+			{
+				xMOV(xRegister64(i), ptr64[rsp + stack_offset]);
+				stack_offset += GPR_SIZE;
+			}
+		}
+
+		xADD(rsp, stack_size);
+	}
+
+	xJMP((void*)(code_address + info.code_size));
+	recPtr = x86Ptr;
+
+	// backpatch to a jump to the thunk
+	x86SetPtr((u8*)code_address);
+	xJMP(thunk);
+
+	// fill the rest of it with nops, if any
+	pxAssertRel(static_cast<u32>((uptr)x86Ptr - code_address) <= info.code_size, "Overflowed when backpatching");
+	for (u32 i = static_cast<u32>((uptr)x86Ptr - code_address); i < info.code_size; i++)
+		xNOP();
+}
+
+bool psxRecBackpatchLoadStore(uptr code_address, uptr fault_address)
+{
+	u32 guest_addr;
+	if (!iopMemGetFastmemAddress(fault_address, &guest_addr))
+		return false;
+
+	auto iter = s_fastmem_backpatch_info.find(code_address);
+	if (iter == s_fastmem_backpatch_info.end())
+		return false;
+
+	// A store to a page code was compiled from. Throw out the blocks from that page and let the store
+	// through, the page gets protected again when code is next compiled from it. Backpatching would
+	// send the store through the handlers for good, even once the code is long gone.
+	if (!iter->second.is_load && iopMemUnprotectFastmemCode(guest_addr))
+	{
+		recClearIOP((guest_addr & (Ps2MemSize::IopRam - 1)) & ~static_cast<u32>(__pagesize - 1), __pagesize / 4);
+		return true;
+	}
+
+	const PsxLoadStoreBackpatchInfo info = iter->second;
+	s_fastmem_backpatch_info.erase(iter);
+
+	DevCon.WriteLn("(IOP) Backpatching %s at %p[%u] (pc %08X addr %08X): Bitmask %08X Addr %u Data %u Size %u",
+		info.is_load ? "load" : "store", (void*)code_address, info.code_size, info.guest_pc, guest_addr,
+		info.gpr_bitmask, info.address_register, info.data_register, info.size_in_bits);
+
+	psxRecDynBackpatchLoadStore(code_address, info);
+
+	// recompile the block with a direct handler call next time, rather than going through the thunk
+	s_fastmem_faulting_pcs.insert(info.guest_pc);
+	recClearIOP(info.guest_pc, 1);
+	return true;
+}
+
 void psxSetBranchReg(u32 reg)
 {
 	psxbranch = 1;
@@ -1598,6 +1790,8 @@ static void iopRecRecompile(const u32 startpc)
 
 	_initX86regs();
 
+	s_psxBlockProfileId = BlockProfiler::IsEnabled(BlockProfiler::Cpu::IOP) ? BlockProfiler::EmitCounter(BlockProfiler::Cpu::IOP) : -1;
+
 	if ((psxHu32(HW_ICFG) & 8) && (HWADDR(startpc) == 0xa0 || HWADDR(startpc) == 0xb0 || HWADDR(startpc) == 0xc0))
 	{
 		xFastCall((void*)psxBiosCall);
@@ -1769,9 +1963,15 @@ StartRecomp:
 	s_pCurBlockEx->x86size = xGetPtr() - recPtr;
 
 	Perf::iop.map(s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size, s_pCurBlockEx->startpc);
+	BlockProfiler::AddBlock(s_psxBlockProfileId, BlockProfiler::Cpu::IOP, startpc, iopVirtMemR<u32>(startpc), psxpc - startpc, psxScaleBlockCycles(),
+		s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size);
 
 	recPtr = xGetPtr();
 
+	// stores through fastmem to this code have to go through the handlers, so the block gets cleared
+	if (CHECK_FASTMEM)
+		iopMemProtectFastmemCode(startpc, psxpc - startpc);
+
 	pxAssert((g_psxHasConstReg & g_psxFlushedConstReg) == g_psxHasConstReg);
 
 	s_pCurBlock = NULL;
@@ -57,6 +57,11 @@ extern void psxSetBranchReg(u32 reg);
 extern void psxSetBranchImm(u32 imm);
 extern void psxRecompileNextInstruction(bool delayslot, bool swapped_delayslot);
 
+// Fastmem loads/stores, which get backpatched to a handler call if they fault.
+void psxRecAddLoadStoreInfo(uptr code_address, u32 code_size, u32 guest_pc, u32 gpr_bitmask,
+	u8 address_register, u8 data_register, u8 size_in_bits, bool is_signed, bool is_load);
+bool psxRecIsFaultingPC(u32 guest_pc);
+
 ////////////////////////////////////////////////////////////////////
 // IOP Constant Propagation Defines, Vars, and API - From here down!
 
@@ -21,6 +21,7 @@
 #include "IopMem.h"
 #include "IopDma.h"
 #include "IopGte.h"
+#include "Config.h"
 
 using namespace x86Emitter;
 
@@ -1085,6 +1086,101 @@ static void rpsxCalcStoreOperand()
 		xMOV(arg2regd, ptr32[&psxRegs.GPR.r[_Rt_]]);
 }
 
+// we need enough for a 32-bit jump forwards (5 bytes)
+static constexpr u32 LOADSTORE_PADDING = 5;
+
+static bool rpsxUseFastmem()
+{
+	// psxpc has already been advanced past the load/store
+	return CHECK_FASTMEM && iopFastmemBase && !psxRecIsFaultingPC(psxpc - 4);
+}
+
+static u32 rpsxGetAllocatedGPRBitmask()
+{
+	u32 mask = 0;
+	for (u32 i = 0; i < iREGCNT_GPR; i++)
+	{
+		if (x86regs[i].inuse)
+			mask |= (1u << i);
+	}
+	return mask;
+}
+
+// Turns the IOP address in arg1 into a pointer into the fastmem view.
+static void rpsxCalcFastmemAddress()
+{
+	xAND(arg1regd, 0x1fffffff);
+	xADD(arg1reg, ptr64[&iopFastmemBase]);
+}
+
+static void rpsxEndFastmemAccess(const u8* codeStart, int data_reg, int size, bool sign, bool is_load)
+{
+	const u32 padding = LOADSTORE_PADDING - std::min<u32>(static_cast<u32>(x86Ptr - codeStart), 5);
+	for (u32 i = 0; i < padding; i++)
+		xNOP();
+
+	psxRecAddLoadStoreInfo((uptr)codeStart, static_cast<u32>(x86Ptr - codeStart), psxpc - 4,
+		rpsxGetAllocatedGPRBitmask(), static_cast<u8>(arg1reg.GetId()), static_cast<u8>(data_reg),
+		static_cast<u8>(size), sign, is_load);
+}
+
+static void rpsxFastmemLoad(int size, bool sign)
+{
+	rpsxCalcFastmemAddress();
+
+	const int rt = (_Rt_ != 0) ? rpsxAllocRegIfUsed(_Rt_, MODE_WRITE) : -1;
+	if (rt < 0)
+		_freeX86reg(eax);
+
+	const xRegister32 dreg((rt < 0) ? eax.GetId() : rt);
+	const u8* codeStart = x86Ptr;
+	switch (size)
+	{
+		case 8:
+			sign ? xMOVSX(dreg, ptr8[arg1reg]) : xMOVZX(dreg, ptr8[arg1reg]);
+			break;
+		case 16:
+			sign ? xMOVSX(dreg, ptr16[arg1reg]) : xMOVZX(dreg, ptr16[arg1reg]);
+			break;
+		case 32:
+			xMOV(dreg, ptr32[arg1reg]);
+			break;
+
+			jNO_DEFAULT
+	}
+
+	rpsxEndFastmemAccess(codeStart, dreg.GetId(), size, sign, true);
+
+	// if not caching, write back
+	if (rt < 0 && _Rt_ != 0)
+		xMOV(ptr32[&psxRegs.GPR.r[_Rt_]], eax);
+}
+
+static void rpsxFastmemStore(int size)
+{
+	const xRegister32 rt(_allocX86reg(X86TYPE_PSX, _Rt_, MODE_READ));
+	rpsxCalcAddressOperand();
+	rpsxCalcFastmemAddress();
+
+	const u8* codeStart = x86Ptr;
+	switch (size)
+	{
+		case 8:
+			xMOV(ptr8[arg1reg], xRegister8(rt));
+			break;
+		case 16:
+			xMOV(ptr16[arg1reg], xRegister16(rt));
+			break;
+		case 32:
+			xMOV(ptr32[arg1reg], rt);
+			break;
+
+			jNO_DEFAULT
+	}
+
+	rpsxEndFastmemAccess(codeStart, rt.GetId(), size, false, false);
+}
+
 static void rpsxLoad(int size, bool sign)
 {
 	rpsxCalcAddressOperand();
@@ -1095,6 +1191,12 @@ static void rpsxLoad(int size, bool sign)
 		_deletePSXtoX86reg(_Rt_, DELETE_REG_FREE_NO_WRITEBACK);
 	}
 
+	if (rpsxUseFastmem())
+	{
+		rpsxFastmemLoad(size, sign);
+		return;
+	}
+
 	_psxFlushCall(FLUSH_FULLVTLB);
 	xTEST(arg1regd, 0x10000000);
 	xForwardJZ8 is_ram_read;
@@ -1201,6 +1303,12 @@ static void rpsxLW()
 
 static void rpsxSB()
 {
+	if (rpsxUseFastmem())
+	{
+		rpsxFastmemStore(8);
+		return;
+	}
+
 	rpsxCalcAddressOperand();
 	rpsxCalcStoreOperand();
 	_psxFlushCall(FLUSH_FULLVTLB);
@@ -1209,6 +1317,12 @@ static void rpsxSB()
 
 static void rpsxSH()
 {
+	if (rpsxUseFastmem())
+	{
+		rpsxFastmemStore(16);
+		return;
+	}
+
 	rpsxCalcAddressOperand();
 	rpsxCalcStoreOperand();
 	_psxFlushCall(FLUSH_FULLVTLB);
@@ -1225,6 +1339,12 @@ static void rpsxSW()
 		return;
 	}
 
+	if (rpsxUseFastmem())
+	{
+		rpsxFastmemStore(32);
+		return;
+	}
+
 	rpsxCalcAddressOperand();
 	rpsxCalcStoreOperand();
 	_psxFlushCall(FLUSH_FULLVTLB);
@@ -1970,6 +2090,13 @@ static void rpsxMTC0()
 		const int rt = _allocX86reg(X86TYPE_PSX, _Rt_, MODE_READ);
 		xMOV(ptr32[&psxRegs.CP0.r[_Rd_]], xRegister32(rt));
 	}
+
+	// Status.IsC changes whether RAM writes go through
+	if (_Rd_ == 12 && CHECK_FASTMEM && iopFastmemBase)
+	{
+		_psxFlushCall(FLUSH_FULLVTLB);
+		xFastCall((void*)iopMemUpdateFastmemIsolation);
+	}
 }
 
 static void rpsxCTC0()
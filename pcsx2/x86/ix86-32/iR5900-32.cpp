@@ -33,6 +33,7 @@
 
 #include "DebugTools/Breakpoints.h"
 #include "Patch.h"
+#include "x86/BlockProfiler.h"
 
 #include "common/AlignedMalloc.h"
 #include "common/FastJmp.h"
@@ -74,6 +75,7 @@ static __fi u32 HWADDR(u32 mem) { return hwLUT[mem >> 16] + mem; }
 
 u32 s_nBlockCycles = 0; // cycles of current block recompiling
 bool s_nBlockInterlocked = false; // Block is VU0 interlocked
+static s32 s_nBlockProfileId = -1; // BlockProfiler counter of current block recompiling
 u32 pc; // recompiler pc
 int g_branch; // set for branch
 
@@ -2245,6 +2247,8 @@ static void recRecompile(const u32 startpc)
 	_initX86regs();
 	_initXMMregs();
 
+	s_nBlockProfileId = BlockProfiler::IsEnabled(BlockProfiler::Cpu::EE) ? BlockProfiler::EmitCounter(BlockProfiler::Cpu::EE) : -1;
+
 #ifdef TRACE_BLOCKS
 	xFastCall((void*)PreBlockCheck, pc);
 #endif
@@ -2681,6 +2685,8 @@ StartRecomp:
 	}
 #endif
 	Perf::ee.map(s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size, s_pCurBlockEx->startpc);
+	BlockProfiler::AddBlock(s_nBlockProfileId, BlockProfiler::Cpu::EE, startpc, PSM(startpc), pc - startpc, scaleblockcycles(),
+		s_pCurBlockEx->fnptr, s_pCurBlockEx->x86size);
 
 	recPtr = xGetPtr();
 
@@ -430,10 +430,11 @@ void recSWL()
 
 	// If we're not using fastmem, we need to flush early. Because the first read
 	// (which would flush) happens inside a branch.
-	if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+	if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 		iFlushCall(FLUSH_FULLVTLB);
 
-	xForwardJE8 skip;
+	// The read can be too long for a short jump when the data cache is emulated.
+	xForwardJE32 skip;
 	xSHL(temp, 3);
 
 	vtlb_DynGenReadNonQuad(32, false, false, arg1regd.GetId(), RETURN_READ_IN_RAX);
@@ -505,10 +506,11 @@ void recSWR()
 
 	// If we're not using fastmem, we need to flush early. Because the first read
 	// (which would flush) happens inside a branch.
-	if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+	if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 		iFlushCall(FLUSH_FULLVTLB);
 
-	xForwardJE8 skip;
+	// The read can be too long for a short jump when the data cache is emulated.
+	xForwardJE32 skip;
 	xSHL(temp, 3);
 
 	vtlb_DynGenReadNonQuad(32, false, false, arg1regd.GetId(), RETURN_READ_IN_RAX);
@@ -841,10 +843,11 @@ void recSDL()
 
 		// If we're not using fastmem, we need to flush early. Because the first read
 		// (which would flush) happens inside a branch.
-		if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+		if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 			iFlushCall(FLUSH_FULLVTLB);
 
-		xForwardJE8 skip;
+		// The read can be too long for a short jump when the data cache is emulated.
+		xForwardJE32 skip;
 		xADD(temp1, 1);
 		vtlb_DynGenReadNonQuad(64, false, false, arg1regd.GetId(), RETURN_READ_IN_RAX);
 
@@ -927,10 +930,11 @@ void recSDR()
 
 		// If we're not using fastmem, we need to flush early. Because the first read
 		// (which would flush) happens inside a branch.
-		if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+		if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 			iFlushCall(FLUSH_FULLVTLB);
 
-		xForwardJE8 skip;
+		// The read can be too long for a short jump when the data cache is emulated.
+		xForwardJE32 skip;
 		vtlb_DynGenReadNonQuad(64, false, false, arg1regd.GetId(), RETURN_READ_IN_RAX);
 
 		xMOV(edx, 64);
@@ -17,6 +17,7 @@
 #include "PrecompiledHeader.h"
 
 #include "Common.h"
+#include "Cache.h"
 #include "vtlb.h"
 
 #include "iCore.h"
@@ -172,11 +173,104 @@ namespace vtlb_private
 		xADD(arg1reg, rax);
 	}
 
+	// Holds the value of a store across the call made on a cache miss.
+	alignas(16) static u128 s_cacheMissValue;
+
+	// ------------------------------------------------------------------------
+	// Redirects a direct access to the EE data cache, when the cache is on and the page is
+	// mapped cached. Tags are checked inline, only misses call out (to fill the line and
+	// write back the one it replaces). Same alignment as the interpreter's cache accesses.
+	// In: arg1reg: host pointer, eax: low half of the vtlb entry (arg1 - eax = guest vaddr).
+	// Out: arg1reg: pointer to access, in the cache line if cached.
+	// Clobbers rax, arg3reg, arg4reg, r10 and r11. Preserves the store value.
+	//
+	static void DynGen_CacheLookup(u32 bits, bool store)
+	{
+		const u32 bytes = bits / 8;
+
+		xTEST(ptr32[&cpuRegs.CP0.n.Config], 0x10000);
+		xForwardJZ32 uncached;
+
+		xMOV(r11d, arg1regd);
+		xSUB(r11d, eax);
+		xMOV(eax, r11d);
+		xSHR(eax, 12);
+		xBT(ptr[(void*)eeCachedPages], eax);
+		xForwardJNC32 uncached_page;
+
+		// rax = the tag a hit would have: the line's page, valid. r10 = offset of the set's tags.
+		xMOV(rax, arg1reg);
+		xAND(rax, ~static_cast<s32>(CACHE_TAG_FLAGS));
+		xOR(rax, CACHE_TAG_VALID);
+		xMOV(r10d, arg1regd);
+		xAND(r10d, 0xFC0);
+		xSHR(r10d, 2);
+
+		xLoadFarAddr(arg3reg, getCacheTags());
+		xMOV(arg4reg, ptr64[arg3reg + r10]);
+		xAND(arg4reg, ~static_cast<s32>(CACHE_TAG_FLAGS ^ CACHE_TAG_VALID));
+		xCMP(arg4reg, rax);
+		xForwardJE8 hit;
+		xADD(r10d, sizeof(uptr));
+		xMOV(arg4reg, ptr64[arg3reg + r10]);
+		xAND(arg4reg, ~static_cast<s32>(CACHE_TAG_FLAGS ^ CACHE_TAG_VALID));
+		xCMP(arg4reg, rax);
+		xForwardJNE8 miss;
+
+		hit.SetTarget();
+		if (store)
+			xOR(ptr64[arg3reg + r10], CACHE_TAG_DIRTY);
+		xAND(arg1regd, 0x3F & ~(bytes - 1));
+		xLoadFarAddr(arg3reg, getCacheData());
+		xADD(arg1reg, arg3reg);
+		xSHL(r10d, 3);
+		xADD(arg1reg, r10);
+		xForwardJump32 done;
+
+		miss.SetTarget();
+		if (store)
+		{
+			if (bits == 128)
+				xMOVAPS(ptr128[&s_cacheMissValue], xRegisterSSE::GetArgRegister(1, 0));
+			else
+				xMOV(ptr64[&s_cacheMissValue], arg2reg);
+		}
+		xMOV(arg1regd, r11d);
+		xFastCall(store ? (void*)writeCacheLine : (void*)readCacheLine);
+		if (store)
+		{
+			if (bits == 128)
+				xMOVAPS(xRegisterSSE::GetArgRegister(1, 0), ptr128[&s_cacheMissValue]);
+			else
+				xMOV(arg2reg, ptr64[&s_cacheMissValue]);
+		}
+		xMOV(arg1reg, rax);
+		if (bytes > 1)
+			xAND(arg1reg, ~static_cast<s32>(bytes - 1));
+
+		uncached.SetTarget();
+		uncached_page.SetTarget();
+		done.SetTarget();
+	}
+
+	// ------------------------------------------------------------------------
+	// Sets up arg1reg and eax as DynGen_PrepRegs does, for a direct access to a known address.
+	static void DynGen_PrepConstRegs(u32 addr_const, uptr ppf)
+	{
+		_freeX86reg(arg1regd);
+		xMOV64(arg1reg, ppf);
+		_freeX86reg(eax);
+		xMOV(eax, static_cast<u32>(ppf - addr_const));
+	}
+
 	// ------------------------------------------------------------------------
 	static void DynGen_DirectRead(u32 bits, bool sign)
 	{
 		pxAssert(bits == 8 || bits == 16 || bits == 32 || bits == 64 || bits == 128);
 
+		if (CHECK_CACHE)
+			DynGen_CacheLookup(bits, false);
+
 		switch (bits)
 		{
 			case 8:
@@ -215,6 +309,9 @@ namespace vtlb_private
 	// ------------------------------------------------------------------------
 	static void DynGen_DirectWrite(u32 bits)
 	{
+		if (CHECK_CACHE)
+			DynGen_CacheLookup(bits, true);
+
 		switch (bits)
 		{
 			case 8:
@@ -273,6 +370,17 @@ static u8* GetIndirectDispatcherPtr(int mode, int operandsize, int sign = 0)
 // the vtlb Indirect Dispatcher.
 //
 
+template <typename JumpToHandler, typename JumpToDone, typename GenDirectFn>
+static void DynGen_HandlerTestJumps(const GenDirectFn& gen_direct, int mode, int szidx, bool sign)
+{
+	JumpToHandler to_handler;
+	gen_direct();
+	JumpToDone done;
+	to_handler.SetTarget();
+	xFastCall(GetIndirectDispatcherPtr(mode, szidx, sign));
+	done.SetTarget();
+}
+
 template <typename GenDirectFn>
 static void DynGen_HandlerTest(const GenDirectFn& gen_direct, int mode, int bits, bool sign = false)
 {
@@ -286,12 +394,12 @@ static void DynGen_HandlerTest(const GenDirectFn& gen_direct, int mode, int bits
 		case 128: szidx = 4; break;
 		jNO_DEFAULT;
 	}
-	xForwardJS8 to_handler;
-	gen_direct();
-	xForwardJump8 done;
-	to_handler.SetTarget();
-	xFastCall(GetIndirectDispatcherPtr(mode, szidx, sign));
-	done.SetTarget();
+
+	// The cache lookup makes the direct path too long for short jumps.
+	if (CHECK_CACHE)
+		DynGen_HandlerTestJumps<xForwardJS32, xForwardJump32>(gen_direct, mode, szidx, sign);
+	else
+		DynGen_HandlerTestJumps<xForwardJS8, xForwardJump8>(gen_direct, mode, szidx, sign);
 }
 
 // ------------------------------------------------------------------------
@@ -402,7 +510,7 @@ int vtlb_DynGenReadNonQuad(u32 bits, bool sign, bool xmm, int addr_reg, vtlb_Rea
 	pxAssume(bits <= 64);
 
 	int x86_dest_reg;
-	if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+	if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 	{
 		iFlushCall(FLUSH_FULLVTLB);
 
@@ -486,7 +594,26 @@ int vtlb_DynGenReadNonQuad_Const(u32 bits, bool sign, bool xmm, u32 addr_const,
 
 	int x86_dest_reg;
 	auto vmv = vtlbdata.vmap[addr_const >> VTLB_PAGE_BITS];
-	if (!vmv.isHandler(addr_const))
+	if (!vmv.isHandler(addr_const) && CHECK_CACHE)
+	{
+		// Whether the page is cached can change without the block being cleared, so the
+		// cache lookup is done at runtime.
+		iFlushCall(FLUSH_FULLVTLB);
+		DynGen_PrepConstRegs(addr_const, vmv.assumePtr(addr_const));
+		DynGen_DirectRead(bits, sign);
+
+		if (!xmm)
+		{
+			x86_dest_reg = dest_reg_alloc ? dest_reg_alloc() : (_freeX86reg(eax), eax.GetId());
+			xMOV(xRegister64(x86_dest_reg), rax);
+		}
+		else
+		{
+			x86_dest_reg = dest_reg_alloc ? dest_reg_alloc() : (_freeXMMreg(0), 0);
+			xMOVDZX(xRegisterSSE(x86_dest_reg), eax);
+		}
+	}
+	else if (!vmv.isHandler(addr_const))
 	{
 		auto ppf = vmv.assumePtr(addr_const);
 		if (!xmm)
@@ -590,7 +717,7 @@ int vtlb_DynGenReadQuad(u32 bits, int addr_reg, vtlb_ReadRegAllocCallback dest_r
 {
 	pxAssume(bits == 128);
 
-	if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+	if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 	{
 		iFlushCall(FLUSH_FULLVTLB);
 
@@ -633,7 +760,17 @@ int vtlb_DynGenReadQuad_Const(u32 bits, u32 addr_const, vtlb_ReadRegAllocCallbac
 
 	int reg;
 	auto vmv = vtlbdata.vmap[addr_const >> VTLB_PAGE_BITS];
-	if (!vmv.isHandler(addr_const))
+	if (!vmv.isHandler(addr_const) && CHECK_CACHE)
+	{
+		iFlushCall(FLUSH_FULLVTLB);
+		DynGen_PrepConstRegs(addr_const, vmv.assumePtr(addr_const));
+		DynGen_DirectRead(bits, false);
+
+		reg = dest_reg_alloc ? dest_reg_alloc() : (_freeXMMreg(0), 0);
+		if (reg >= 0)
+			xMOVAPS(xRegisterSSE(reg), xmm0);
+	}
+	else if (!vmv.isHandler(addr_const))
 	{
 		void* ppf = reinterpret_cast<void*>(vmv.assumePtr(addr_const));
 		reg = dest_reg_alloc ? dest_reg_alloc() : (_freeXMMreg(0), 0);
@@ -715,7 +852,7 @@ void vtlb_DynGenWrite(u32 sz, bool xmm, int addr_reg, int value_reg)
 	}
 #endif
 
-	if (!CHECK_FASTMEM || vtlb_IsFaultingPC(pc))
+	if (!CHECK_FASTMEM || CHECK_CACHE || vtlb_IsFaultingPC(pc))
 	{
 		iFlushCall(FLUSH_FULLVTLB);
 
@@ -837,7 +974,33 @@ void vtlb_DynGenWrite_Const(u32 bits, bool xmm, u32 addr_const, int value_reg)
 #endif
 
 	auto vmv = vtlbdata.vmap[addr_const >> VTLB_PAGE_BITS];
-	if (!vmv.isHandler(addr_const))
+	if (!vmv.isHandler(addr_const) && CHECK_CACHE)
+	{
+		iFlushCall(FLUSH_FULLVTLB);
+
+		if (bits == 128)
+		{
+			pxAssert(xmm);
+			const xRegisterSSE argreg(xRegisterSSE::GetArgRegister(1, 0));
+			_freeXMMreg(argreg.GetId());
+			xMOVAPS(argreg, xRegisterSSE(value_reg));
+		}
+		else if (xmm)
+		{
+			pxAssert(bits == 32);
+			_freeX86reg(arg2regd);
+			xMOVD(arg2regd, xRegisterSSE(value_reg));
+		}
+		else
+		{
+			_freeX86reg(arg2regd);
+			xMOV(arg2reg, xRegister64(value_reg));
+		}
+
+		DynGen_PrepConstRegs(addr_const, vmv.assumePtr(addr_const));
+		DynGen_DirectWrite(bits);
+	}
+	else if (!vmv.isHandler(addr_const))
 	{
 		auto ppf = vmv.assumePtr(addr_const);
 		if (!xmm)
@@ -17,6 +17,7 @@
 
 #include "PrecompiledHeader.h"
 #include "microVU.h"
+#include "TranslationCache.h"
 
 #include "common/AlignedMalloc.h"
 #include "common/Perf.h"
@@ -97,12 +98,22 @@ void mVUreset(microVU& mVU, bool resetReserve)
 	memset(&mVU.prog.lpState, 0, sizeof(mVU.prog.lpState));
 	mVU.profiler.Reset(mVU.index);
 
+	if (mVU.prog.stats.searches)
+		mVUprintCacheStats(mVU);
+
+	// Keep a record of what's about to be thrown away, so the next boot can compile it up front
+	if (TranslationCache::IsRecording())
+		mVUharvestTranslations(mVU.index);
+
 	// Program Variables
 	mVU.prog.cleared  =  1;
 	mVU.prog.isSame   = -1;
 	mVU.prog.cur      = NULL;
 	mVU.prog.total    =  0;
 	mVU.prog.curFrame =  0;
+	mVU.prog.searchCount = 0;
+	memzero(mVU.prog.stats);
+	memset(mVU.prog.memHashDirty, 0xff, sizeof(mVU.prog.memHashDirty));
 
 	// Setup Dynarec Cache Limits for Each Program
 	u8* z = mVU.cache;
@@ -115,8 +126,10 @@ void mVUreset(microVU& mVU, bool resetReserve)
 		if (!mVU.prog.prog[i])
 		{
 			mVU.prog.prog[i] = new std::deque<microProgram*>();
+			mVU.prog.index[i] = new microProgramIndex();
 			continue;
 		}
+		mVU.prog.index[i]->clear();
 		std::deque<microProgram*>::iterator it(mVU.prog.prog[i]->begin());
 		for (; it != mVU.prog.prog[i]->end(); ++it)
 		{
@@ -152,12 +165,24 @@ void mVUclose(microVU& mVU)
 			mVUdeleteProg(mVU, it[0]);
 		}
 		safe_delete(mVU.prog.prog[i]);
+		safe_delete(mVU.prog.index[i]);
 	}
 }
 
 // Clears Block Data in specified range
 __fi void mVUclear(mV, u32 addr, u32 size)
 {
+	// Writes happen after the clear, so the blocks are rehashed when the next search needs them
+	const u32 blockSize = mVUhashBlockWords * 8;
+	const u32 numBlocks = mVU.microMemSize / blockSize;
+	const u32 first = (addr / blockSize) % numBlocks;
+	const u32 count = std::min((addr % blockSize + size + blockSize - 1) / blockSize, numBlocks);
+	for (u32 i = 0; i < count; i++)
+	{
+		const u32 block = (first + i) % numBlocks;
+		mVU.prog.memHashDirty[block / 64] |= 1ULL << (block % 64);
+	}
+
 	if (!mVU.prog.cleared)
 	{
 		mVU.prog.cleared = 1; // Next execution searches/creates a new microprogram
@@ -193,6 +218,7 @@ __ri microProgram* mVUcreateProg(microVU& mVU, int startPC)
 	prog->idx = mVU.prog.total++;
 	prog->ranges = new std::deque<microRange>();
 	prog->startPC = startPC;
+	prog->indexDirty = true;
 	if(doWholeProgCompare)
 		mVUcacheProg(mVU, *prog); // Cache Micro Program
 	double cacheSize = (double)((uptr)mVU.prog.x86end - (uptr)mVU.prog.x86start);
@@ -219,6 +245,7 @@ __ri void mVUcacheProg(microVU& mVU, microProgram& prog)
 		else
 			memcpy(prog.data, mVU.regs().Micro, 0x4000);
 	}
+	prog.indexDirty = true;
 	mVUdumpProg(mVU, prog);
 }
 
@@ -270,6 +297,163 @@ void mVUprintUniqueRatio(microVU& mVU)
 	DevCon.WriteLn("%d / %d [%3.1f%%]", v.size(), total, 100. - (double)v.size() / (double)total * 100.);
 }
 
+//------------------------------------------------------------------
+// Micro VU - Program Cache Index
+//------------------------------------------------------------------
+
+// Hash of one 64bit word of micro memory at word index i. Range hashes are the sum of
+// these, so blocks can be summed up ahead of time and combined in any order.
+static __fi u64 mVUhashWord(u32 i, u64 word)
+{
+	u64 h = (word ^ (i * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+	return h ^ (h >> 29);
+}
+
+// Rehashes the blocks of micro memory which have been written since the last search
+static void mVUrefreshMemHash(microVU& mVU)
+{
+	const u64* words = (const u64*)mVU.regs().Micro;
+	const u32 numBlocks = mVU.microMemSize / (mVUhashBlockWords * 8);
+	for (u32 block = 0; block < numBlocks; block++)
+	{
+		u64& dirty = mVU.prog.memHashDirty[block / 64];
+		if (!dirty)
+		{
+			block |= 63; // Skip the clean word
+			continue;
+		}
+		if (!(dirty & (1ULL << (block % 64))))
+			continue;
+
+		dirty &= ~(1ULL << (block % 64));
+		u64 hash = 0;
+		for (u32 w = block * mVUhashBlockWords; w < (block + 1) * mVUhashBlockWords; w++)
+			hash += mVUhashWord(w, words[w]);
+		mVU.prog.memHash[block] = hash;
+	}
+}
+
+// Hash of micro memory over the ranges, using the block hashes where possible
+static u64 mVUhashMemRanges(microVU& mVU, const std::vector<microRange>& ranges)
+{
+	const u64* words = (const u64*)mVU.regs().Micro;
+	u64 hash = 0;
+	for (const microRange& range : ranges)
+	{
+		u32 i = range.start / 8;
+		const u32 end = range.end / 8;
+		for (; i < end && (i % mVUhashBlockWords); i++)
+			hash += mVUhashWord(i, words[i]);
+		for (; i + mVUhashBlockWords <= end; i += mVUhashBlockWords)
+			hash += mVU.prog.memHash[i / mVUhashBlockWords];
+		for (; i < end; i++)
+			hash += mVUhashWord(i, words[i]);
+	}
+	return hash;
+}
+
+// The ranges mVUcmpProg compares, normalized so programs with the same ranges share a group
+static void mVUgetCmpRanges(microVU& mVU, microProgram& prog, std::vector<microRange>& ranges)
+{
+	ranges.clear();
+	if (doWholeProgCompare)
+	{
+		ranges.push_back({0, static_cast<s32>(mVU.microMemSize)});
+		return;
+	}
+
+	for (const microRange& range : *prog.ranges)
+	{
+		// Ranges which are still being set up don't get compared
+		if (range.start >= 0 && range.end > range.start)
+			ranges.push_back(range);
+	}
+	std::sort(ranges.begin(), ranges.end(), [](const microRange& a, const microRange& b) { return a.start < b.start; });
+}
+
+static void mVUunindexProg(microVU& mVU, microProgram& prog)
+{
+	if (!prog.group)
+		return;
+
+	auto& progs = prog.group->progs;
+	const auto [begin, end] = progs.equal_range(prog.hash);
+	for (auto it = begin; it != end; ++it)
+	{
+		if (it->second == &prog)
+		{
+			progs.erase(it);
+			break;
+		}
+	}
+
+	if (progs.empty())
+	{
+		microProgramIndex& index = *mVU.prog.index[prog.startPC];
+		index.erase(std::find_if(index.begin(), index.end(),
+			[&prog](const std::unique_ptr<microProgramGroup>& group) { return group.get() == prog.group; }));
+	}
+	prog.group = nullptr;
+}
+
+// (Re)inserts a program into the index after its ranges have changed
+static void mVUindexProg(microVU& mVU, microProgram& prog)
+{
+	mVUunindexProg(mVU, prog);
+
+	std::vector<microRange> ranges;
+	mVUgetCmpRanges(mVU, prog, ranges);
+
+	microProgramIndex& index = *mVU.prog.index[prog.startPC];
+	auto group = std::find_if(index.begin(), index.end(), [&ranges](const std::unique_ptr<microProgramGroup>& group) {
+		return group->ranges.size() == ranges.size() &&
+			std::equal(ranges.begin(), ranges.end(), group->ranges.begin(),
+				[](const microRange& a, const microRange& b) { return a.start == b.start && a.end == b.end; });
+	});
+	if (group == index.end())
+	{
+		index.push_back(std::make_unique<microProgramGroup>());
+		group = index.end() - 1;
+		(*group)->ranges = std::move(ranges);
+	}
+
+	u64 hash = 0;
+	const u64* words = (const u64*)prog.data;
+	for (const microRange& range : (*group)->ranges)
+	{
+		for (int i = range.start / 8; i < range.end / 8; i++)
+			hash += mVUhashWord(i, words[i]);
+	}
+
+	prog.hash = hash;
+	prog.group = group->get();
+	prog.group->progs.emplace(hash, &prog);
+	prog.indexDirty = false;
+}
+
+// Prints program cache statistics
+void mVUprintCacheStats(microVU& mVU)
+{
+	const microProgStats& stats = mVU.prog.stats;
+	u32 buckets = 0, groups = 0, maxProgs = 0;
+	for (u32 pc = 0; pc < mVU.progSize / 2; pc++)
+	{
+		const u32 progs = mVU.prog.prog[pc] ? static_cast<u32>(mVU.prog.prog[pc]->size()) : 0;
+		if (!progs)
+			continue;
+		buckets++;
+		groups += static_cast<u32>(mVU.prog.index[pc]->size());
+		maxProgs = std::max(maxProgs, progs);
+	}
+
+	DevCon.WriteLn(mVU.index ? Color_Orange : Color_Magenta,
+		"microVU%d: Program cache: %llu searches, %3.1f%% hits, %llu compares (%llu mismatched), "
+		"%d programs over %u start PCs (avg %.1f, max %u per PC, %.1f range groups per PC)",
+		mVU.index, stats.searches, stats.searches ? 100.0 * stats.hits / stats.searches : 0.0, stats.compares,
+		stats.collisions, mVU.prog.total, buckets, buckets ? (double)mVU.prog.total / buckets : 0.0, maxProgs,
+		buckets ? (double)groups / buckets : 0.0);
+}
+
 // Compare Cached microProgram to mVU.regs().Micro
 __fi bool mVUcmpProg(microVU& mVU, microProgram& prog)
 {
@@ -292,12 +476,34 @@ __fi bool mVUcmpProg(microVU& mVU, microProgram& prog)
 				return false;
 		}
 	}
-	mVU.prog.cleared = 0;
-	mVU.prog.cur = &prog;
-	mVU.prog.isSame = doWholeProgCompare ? 1 : -1;
 	return true;
 }
 
+// Finds the most recently used cached program matching mVU.regs().Micro, or null
+static microProgram* mVUfindProg(microVU& mVU, u32 startPC)
+{
+	mVUrefreshMemHash(mVU);
+
+	microProgram* found = nullptr;
+	for (const std::unique_ptr<microProgramGroup>& group : *mVU.prog.index[startPC])
+	{
+		const auto [begin, end] = group->progs.equal_range(mVUhashMemRanges(mVU, group->ranges));
+		for (auto it = begin; it != end; ++it)
+		{
+			microProgram* prog = it->second;
+			if (found && found->lastUse > prog->lastUse)
+				continue;
+
+			mVU.prog.stats.compares++;
+			if (mVUcmpProg(mVU, *prog))
+				found = prog;
+			else
+				mVU.prog.stats.collisions++;
+		}
+	}
+	return found;
+}
+
 // Searches for Cached Micro Program and sets prog.cur to it (returns entry-point to program)
 _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState)
 {
@@ -305,34 +511,37 @@ _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState)
 	microProgramQuick& quick = mVU.prog.quick[mVU.regs().start_pc / 8];
 	microProgramList*  list  = mVU.prog.prog [mVU.regs().start_pc / 8];
 
+	// Programs only grow ranges while they're current, so catch up on the index before switching away
+	if (mVU.prog.cur && mVU.prog.cur->indexDirty)
+		mVUindexProg(mVU, *mVU.prog.cur);
+
 	if (!quick.prog) // If null, we need to search for new program
 	{
-		std::deque<microProgram*>::iterator it(list->begin());
-		for (; it != list->end(); ++it)
+		mVU.prog.stats.searches++;
+		if (microProgram* prog = mVUfindProg(mVU, mVU.regs().start_pc / 8))
 		{
-			bool b = mVUcmpProg(mVU, *it[0]);
-
-			if (b)
+			mVU.prog.stats.hits++;
+			prog->lastUse = ++mVU.prog.searchCount;
+			mVU.prog.cleared = 0;
+			mVU.prog.cur = prog;
+			mVU.prog.isSame = doWholeProgCompare ? 1 : -1;
+			quick.block = prog->block[startPC / 8];
+			quick.prog  = prog;
+
+			// Sanity check, in case for some reason the program compilation aborted half way through (JALR for example)
+			if (quick.block == nullptr)
 			{
-				quick.block = it[0]->block[startPC / 8];
-				quick.prog  = it[0];
-				list->erase(it);
-				list->push_front(quick.prog);
-
-				// Sanity check, in case for some reason the program compilation aborted half way through (JALR for example)
-				if (quick.block == nullptr)
-				{
-					void* entryPoint = mVUblockFetch(mVU, startPC, pState);
-					return entryPoint;
-				}
-				return mVUentryGet(mVU, quick.block, startPC, pState);
+				void* entryPoint = mVUblockFetch(mVU, startPC, pState);
+				return entryPoint;
 			}
+			return mVUentryGet(mVU, quick.block, startPC, pState);
 		}
 
 		// If cleared and program not found, make a new program instance
 		mVU.prog.cleared = 0;
 		mVU.prog.isSame  = 1;
 		mVU.prog.cur     = mVUcreateProg(mVU, mVU.regs().start_pc/8);
+		mVU.prog.cur->lastUse = ++mVU.prog.searchCount;
 		void* entryPoint = mVUblockFetch(mVU,  startPC, pState);
 		quick.block      = mVU.prog.cur->block[startPC/8];
 		quick.prog       = mVU.prog.cur;
@@ -357,6 +566,121 @@ _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState)
 	return mVUentryGet(mVU, quick.block, startPC, pState);
 }
 
+//------------------------------------------------------------------
+// Micro VU - Translation Cache
+//------------------------------------------------------------------
+
+static_assert(sizeof(microRegInfo) == sizeof(TranslationCache::MicroEntry::pState), "Recorded pipeline states are microRegInfo");
+
+// Records the cached programs of a VU: the micro memory they were compiled from, and the pipeline
+// states each of their blocks was entered with
+void mVUharvestTranslations(u32 vuIndex)
+{
+	microVU& mVU = vuIndex ? microVU1 : microVU0;
+	std::vector<microRange> ranges;
+	for (u32 pc = 0; pc < mVU.progSize / 2; pc++)
+	{
+		if (!mVU.prog.prog[pc])
+			continue;
+
+		for (microProgram* prog : *mVU.prog.prog[pc])
+		{
+			mVUgetCmpRanges(mVU, *prog, ranges);
+			if (ranges.empty())
+				continue;
+
+			TranslationCache::MicroProgram rec;
+			rec.vuIndex = mVU.index;
+			rec.startPC = prog->startPC;
+			for (const microRange& range : ranges) // Sorted by start, merge any overlaps
+			{
+				if (!rec.ranges.empty() && range.start <= rec.ranges.back().end)
+					rec.ranges.back().end = std::max(rec.ranges.back().end, range.end);
+				else
+					rec.ranges.push_back({range.start, range.end});
+			}
+			for (const TranslationCache::MicroRange& range : rec.ranges)
+				rec.data.insert(rec.data.end(), (u8*)prog->data + range.start, (u8*)prog->data + range.end);
+
+			for (u32 i = 0; i < mVU.progSize / 2; i++)
+			{
+				if (!prog->block[i])
+					continue;
+				prog->block[i]->forEach([&rec, i](const microBlock& block) {
+					TranslationCache::MicroEntry& entry = rec.entries.emplace_back();
+					entry.startPC = i * 8;
+					std::memcpy(entry.pState, &block.pState, sizeof(entry.pState));
+				});
+			}
+
+			if (!rec.entries.empty())
+				TranslationCache::AddMicroProgram(std::move(rec));
+		}
+	}
+}
+
+// Compiles a program recorded by mVUharvestTranslations, as if micro memory held what it was
+// compiled from. Micro memory and the current program are left as they were. Returns true if
+// any blocks had to be compiled.
+bool mVUprewarm(const TranslationCache::MicroProgram& rec)
+{
+	microVU& mVU = rec.vuIndex ? microVU1 : microVU0;
+	if (!mVU.prog.prog[rec.startPC])
+		return false;
+
+	// Leave most of the cache for what the game actually runs
+	if (mVU.prog.x86ptr > mVU.prog.x86start + (mVU.prog.x86end - mVU.prog.x86start) / 2)
+		return false;
+
+	alignas(16) static u8 microBackup[0x4000];
+	u8* micro = mVU.regs().Micro;
+	memcpy(microBackup, micro, mVU.microMemSize);
+	microProgram* const cur = mVU.prog.cur;
+	const int cleared = mVU.prog.cleared;
+	const int isSame = mVU.prog.isSame;
+	const microRegInfo lpState = mVU.prog.lpState;
+
+	const u8* data = rec.data.data();
+	for (const TranslationCache::MicroRange& range : rec.ranges)
+	{
+		memcpy(micro + range.start, data, range.end - range.start);
+		data += range.end - range.start;
+	}
+	memset(mVU.prog.memHashDirty, 0xff, sizeof(mVU.prog.memHashDirty));
+
+	microProgram* prog = mVUfindProg(mVU, rec.startPC);
+	if (!prog)
+	{
+		prog = mVUcreateProg(mVU, rec.startPC);
+		mVU.prog.prog[rec.startPC]->push_front(prog);
+	}
+	mVU.prog.cur = prog;
+	mVU.prog.cleared = 0;
+	mVU.prog.isSame = doWholeProgCompare ? 1 : -1;
+
+	u8* const startPtr = mVU.prog.x86ptr;
+	xSetPtr(startPtr);
+	for (const TranslationCache::MicroEntry& entry : rec.entries)
+	{
+		alignas(16) microRegInfo pState;
+		memcpy(&pState, entry.pState, sizeof(pState));
+		mVUblockFetch(mVU, entry.startPC, (uptr)&pState);
+		if (xGetPtr() > mVU.prog.x86end)
+			break;
+	}
+	mVU.prog.x86ptr = xGetPtr();
+	if (prog->indexDirty)
+		mVUindexProg(mVU, *prog);
+
+	memcpy(micro, microBackup, mVU.microMemSize);
+	memset(mVU.prog.memHashDirty, 0xff, sizeof(mVU.prog.memHashDirty));
+	mVU.prog.cur = cur;
+	mVU.prog.cleared = cleared;
+	mVU.prog.isSame = isSame;
+	mVU.prog.lpState = lpState;
+	return mVU.prog.x86ptr != startPtr;
+}
+
 //------------------------------------------------------------------
 // recMicroVU0 / recMicroVU1
 //------------------------------------------------------------------
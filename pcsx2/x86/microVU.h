@@ -23,6 +23,8 @@ using namespace x86Emitter;
 #include <deque>
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include "Common.h"
 #include "VU.h"
 #include "MTVU.h"
@@ -36,6 +38,7 @@ using namespace x86Emitter;
 #include "microVU_IR.h"
 #include "microVU_Profiler.h"
 #include "common/Perf.h"
+#include "BlockProfiler.h"
 
 struct microBlockLink
 {
@@ -154,6 +157,14 @@ public:
 		}
 		return nullptr;
 	}
+	template <typename F>
+	void forEach(F&& f) const
+	{
+		for (microBlockLink* linkI = qBlockList; linkI != nullptr; linkI = linkI->next)
+			f(linkI->block);
+		for (microBlockLink* linkI = fBlockList; linkI != nullptr; linkI = linkI->next)
+			f(linkI->block);
+	}
 	void printInfo(int pc, bool printQuick)
 	{
 		int listI = printQuick ? qListI : fListI;
@@ -184,6 +195,8 @@ struct microRange
 	s32 end;   // End PC   (The opcode the block ends with)
 };
 
+struct microProgramGroup;
+
 #define mProgSize (0x4000 / 4)
 struct microProgram
 {
@@ -192,10 +205,36 @@ struct microProgram
 	std::deque<microRange>* ranges;          // The ranges of the microProgram that have already been recompiled
 	u32 startPC; // Start PC of this program
 	int idx;     // Program index
+	u64 lastUse; // Search counter value when this program was last found (most recent wins when several match)
+	u64 hash;    // Hash of data over ranges, which the program is indexed by
+	microProgramGroup* group; // Index group the program is in (null if not indexed yet)
+	bool indexDirty;          // Ranges have changed since the program was indexed
 };
 
 typedef std::deque<microProgram*> microProgramList;
 
+// Programs for the same start PC which were recompiled over the same ranges, keyed by
+// their hash. Lookups hash micro memory over each group's ranges, then probe.
+struct microProgramGroup
+{
+	std::vector<microRange> ranges; // Sorted by start
+	std::unordered_multimap<u64, microProgram*> progs;
+};
+
+typedef std::vector<std::unique_ptr<microProgramGroup>> microProgramIndex;
+
+// Micro memory is hashed in blocks of this many 64bit words, blocks are rehashed when written
+static const uint mVUhashBlockWords = 8;
+static const uint mVUhashBlocks = (mProgSize / 2) / mVUhashBlockWords;
+
+struct microProgStats
+{
+	u64 searches;   // Full program searches (after micro memory was written to)
+	u64 hits;       // Searches which found a cached program
+	u64 compares;   // Candidates that were compared against micro memory
+	u64 collisions; // Compared candidates which didn't match
+};
+
 struct microProgramQuick
 {
 	microBlockManager* block; // Quick reference to valid microBlockManager for current startPC
@@ -206,6 +245,7 @@ struct microProgManager
 {
 	microIR<mProgSize> IRinfo;             // IR information
 	microProgramList*  prog [mProgSize/2]; // List of microPrograms indexed by startPC values
+	microProgramIndex* index[mProgSize/2]; // Hash index of the microPrograms in prog[], per startPC
 	microProgramQuick  quick[mProgSize/2]; // Quick reference to valid microPrograms for current execution
 	microProgram*      cur;                // Pointer to currently running MicroProgram
 	int                total;              // Total Number of valid MicroPrograms
@@ -216,6 +256,10 @@ struct microProgManager
 	u8*                x86start;           // Start of program's rec-cache
 	u8*                x86end;             // Limit of program's rec-cache
 	microRegInfo       lpState;            // Pipeline state from where program left off (useful for continuing execution)
+	u64                memHash[mVUhashBlocks];       // Hash of each block of mVU.regs().Micro
+	u64                memHashDirty[mVUhashBlocks / 64]; // Blocks written since they were last hashed
+	u64                searchCount;        // Counter for microProgram.lastUse
+	microProgStats     stats;              // Program cache statistics, since the last reset
 };
 
 static const uint mVUdispCacheSize = __pagesize; // Dispatcher Cache Size (in bytes)
@@ -300,6 +344,7 @@ mVUop(mVUopL);
 // Private Functions
 extern void mVUcacheProg(microVU& mVU, microProgram& prog);
 extern void mVUdeleteProg(microVU& mVU, microProgram*& prog);
+extern void mVUprintCacheStats(microVU& mVU);
 _mVUt extern void* mVUsearchProg(u32 startPC, uptr pState);
 extern void* mVUexecuteVU0(u32 startPC, u32 cycles);
 extern void* mVUexecuteVU1(u32 startPC, u32 cycles);
@@ -856,6 +856,12 @@ void* mVUcompile(microVU& mVU, u32 startPC, uptr pState)
 	mVUdebugPrintBlocks(mVU, false); // Prints Start/End PC of blocks executed, for debugging...
 	mVUtestCycles(mVU, mFC);         // Update VU Cycles and Exit Early if Necessary
 
+	// Counted past the early exit, which leaves without running the block
+	const BlockProfiler::Cpu profileCpu = isVU1 ? BlockProfiler::Cpu::VU1 : BlockProfiler::Cpu::VU0;
+	const s32 profileId = BlockProfiler::IsEnabled(profileCpu) ? BlockProfiler::EmitCounter(profileCpu) : -1;
+	const u32 profileCycles = mVUcycles;
+	const u32 profileSize = std::min(mVUcount * 8, mVU.microMemSize - startPC);
+
 	// Second Pass
 	iPC = mVUstartPC;
 	setCode();
@@ -998,6 +1004,8 @@ void* mVUcompile(microVU& mVU, u32 startPC, uptr pState)
 perf_and_return:
 
 	Perf::vu.map((uptr)thisPtr, x86Ptr - thisPtr, startPC);
+	BlockProfiler::AddBlock(profileId, profileCpu, startPC, mVU.regs().Micro + startPC, profileSize, profileCycles,
+		(uptr)thisPtr, static_cast<u32>(x86Ptr - thisPtr));
 
 	return thisPtr;
 }
@@ -20,6 +20,7 @@
 #include "PrecompiledHeader.h"
 #include "newVif_UnpackSSE.h"
 #include "MTVU.h"
+#include "TranslationCache.h"
 #include "common/Perf.h"
 #include "common/StringUtil.h"
 #include "fmt/core.h"
@@ -410,6 +411,9 @@ _vifT __fi void dVifUnpack(const u8* data, bool isFill)
 	if (unlikely(b == nullptr))
 	{
 		b = dVifCompile<idx>(block, isFill);
+
+		if (TranslationCache::IsRecording())
+			TranslationCache::AddVifBlock({idx, isFill, block.hash_key, block.key0, block.key1});
 	}
 
 	{ // Execute the block
@@ -435,3 +439,23 @@ _vifT __fi void dVifUnpack(const u8* data, bool isFill)
 
 template void dVifUnpack<0>(const u8* data, bool isFill);
 template void dVifUnpack<1>(const u8* data, bool isFill);
+
+// Compiles an unpack recorded by the translation cache, unless it's already been compiled.
+bool dVifPrewarm(const TranslationCache::VifBlock& rec)
+{
+	if (rec.idx > 1 || !nVif[rec.idx].recReserve)
+		return false;
+
+	nVifBlock block = {};
+	block.hash_key = rec.hash_key;
+	block.key0 = rec.key0;
+	block.key1 = rec.key1;
+	if (nVif[rec.idx].vifBlocks.find(block))
+		return false;
+
+	if (rec.idx)
+		dVifCompile<1>(block, rec.isFill);
+	else
+		dVifCompile<0>(block, rec.isFill);
+	return true;
+}
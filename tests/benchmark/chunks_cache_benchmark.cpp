@@ -0,0 +1,50 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "chunks_cache_trace.h"
+#include "common/Timer.h"
+#include <cstdio>
+
+// Usage: chunks_cache_benchmark [trace.log]
+// The trace is a log captured with "CDVD Verbose Reads" enabled, without one a synthetic trace is replayed.
+int main(int argc, char* argv[])
+{
+	const std::vector<TraceRead> trace = (argc > 1) ? LoadTrace(argv[1]) : SyntheticTrace();
+	if (trace.empty())
+	{
+		std::fprintf(stderr, "No reads in trace '%s'.\n", (argc > 1) ? argv[1] : "");
+		return EXIT_FAILURE;
+	}
+
+	static constexpr uint LIMIT_MB = 64;
+	ChunksCache cache(CHUNK_SIZE, LIMIT_MB);
+	ListChunksCache list(static_cast<s64>(LIMIT_MB) * 1024 * 1024);
+
+	Common::Timer timer;
+	const u64 cache_hits = ReplayTrace(
+		trace, [&cache](void* dst, s64 offset) { return cache.Read(dst, offset, CHUNK_SIZE); },
+		[&cache](const void* src, s64 offset) { cache.Insert(src, offset, CHUNK_SIZE, CHUNK_SIZE); });
+	const double cache_ms = timer.GetTimeMillisecondsAndReset();
+
+	const u64 list_hits = ReplayTrace(
+		trace, [&list](void* dst, s64 offset) { return list.Read(dst, offset, CHUNK_SIZE); },
+		[&list](const void* src, s64 offset) { ListTake(list, src, offset); });
+	const double list_ms = timer.GetTimeMilliseconds();
+
+	std::printf("%zu reads, %llu/%llu chunk hits: indexed cache %.2f ms, list cache %.2f ms\n", trace.size(),
+		static_cast<unsigned long long>(cache_hits), static_cast<unsigned long long>(list_hits), cache_ms, list_ms);
+	return (cache_hits == list_hits) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,237 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "common/Timer.h"
+#include "DEV9/net.h"
+#include "DEV9/PacketReader/EthernetFrame.h"
+#include "DEV9/PacketReader/IP/IP_Packet.h"
+#include "DEV9/PacketReader/IP/UDP/UDP_Packet.h"
+#include "DEV9/Sessions/UDP_Session/UDP_Session.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#include "common/RedtapeWindows.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace PacketReader;
+using namespace PacketReader::IP;
+using namespace PacketReader::IP::UDP;
+using namespace Sessions;
+
+// Pushes UDP datagrams from the PS2 side through a UDP_Session to an echo server on loopback, and
+// builds the frames of the replies, the same way SocketAdapter's send and RecvFromSession() do.
+// Reports throughput, and fails if round trips still allocate once the slab pool has warmed up.
+
+static std::atomic<u64> s_allocations{0};
+
+void* operator new(std::size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+static void CloseSocket(socket_t sock) { closesocket(sock); }
+#else
+using socket_t = int;
+static void CloseSocket(socket_t sock) { close(sock); }
+#endif
+
+static void EchoServer(socket_t sock, const std::atomic_bool* stop)
+{
+	char buffer[2048];
+	while (!stop->load(std::memory_order_relaxed))
+	{
+		sockaddr_in from{};
+		socklen_t fromlen = sizeof(from);
+		const int len = recvfrom(sock, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &fromlen);
+		if (len > 0)
+			sendto(sock, buffer, len, 0, reinterpret_cast<const sockaddr*>(&from), fromlen);
+	}
+}
+
+// Usage: dev9_udp_benchmark [packets] [payload bytes]
+// Exits with a failure if a round trip stalls, or if any allocate after the warm up.
+int main(int argc, char* argv[])
+{
+	const u32 packets = (argc > 1) ? static_cast<u32>(std::strtoul(argv[1], nullptr, 10)) : 200000;
+	const int payload_size = (argc > 2) ? std::clamp(std::atoi(argv[2]), 1, 1400) : 1024;
+	static constexpr u32 WINDOW = 16; // datagrams in flight, small enough that loopback doesn't drop them
+	static constexpr u16 PS2_PORT = 5000;
+	static constexpr u32 WARMUP = 1000; // round trips before allocations are counted, while the pool fills
+
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+		return EXIT_FAILURE;
+#endif
+
+	// echo server on an ephemeral port, with a timeout so it notices when we're done
+	const socket_t server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrlen = sizeof(addr);
+#ifdef _WIN32
+	const DWORD timeout = 100;
+#else
+	const timeval timeout = {0, 100000};
+#endif
+	if (bind(server, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+		getsockname(server, reinterpret_cast<sockaddr*>(&addr), &addrlen) != 0 ||
+		setsockopt(server, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout)) != 0)
+	{
+		std::fprintf(stderr, "Failed to set up the echo server.\n");
+		return EXIT_FAILURE;
+	}
+
+	std::atomic_bool stop{false};
+	std::thread echo(EchoServer, server, &stop);
+
+	IP_Address loopback;
+	loopback.integer = htonl(INADDR_LOOPBACK);
+	IP_Address ps2_ip;
+	ps2_ip.integer = htonl(0x0A000002); // 10.0.0.2
+	const MAC_Address ps2_mac = {{0x00, 0x04, 0x1F, 0x82, 0x30, 0x31}};
+	const MAC_Address internal_mac = {{0x76, 0x6D, 0x61, 0x63, 0x30, 0x31}};
+
+	// the frame the PS2 sends, built once
+	NetPacket tx;
+	{
+		PayloadData* data = new PayloadData(payload_size);
+		for (int i = 0; i < payload_size; i++)
+			data->data[i] = static_cast<u8>(i);
+
+		UDP_Packet* udp = new UDP_Packet(data);
+		udp->sourcePort = PS2_PORT;
+		udp->destinationPort = ntohs(addr.sin_port);
+
+		IP_Packet ip(udp);
+		ip.sourceIP = ps2_ip;
+		ip.destinationIP = loopback;
+		ip.timeToLive = 64;
+		EthernetFrame::WritePacket(&tx, internal_mac, ps2_mac, static_cast<u16>(EtherType::IPv4), &ip);
+	}
+
+	ConnectionKey key;
+	key.ip = loopback;
+	key.protocol = static_cast<u8>(IP_Type::UDP);
+	key.ps2Port = PS2_PORT;
+	key.srvPort = ntohs(addr.sin_port);
+
+	UDP_Session session(key, IP_Address{});
+	session.destIP = loopback;
+	session.sourceIP = ps2_ip;
+
+	NetPacket rx;
+	u32 sent = 0;
+	u32 received = 0;
+	u64 rx_bytes = 0;
+	bool failed = false;
+	Common::Timer timer;
+	Common::Timer idle;
+	u64 start_allocations = 0;
+	while (received < packets)
+	{
+		for (; sent < packets && (sent - received) < WINDOW; sent++)
+		{
+			EthernetFrame frame(&tx);
+			PayloadPtr* payload = static_cast<PayloadPtr*>(frame.GetPayload());
+			IP_Packet ip(payload->data, payload->GetLength());
+			if (!session.Send(ip.GetPayload()))
+			{
+				std::fprintf(stderr, "Send failed.\n");
+				failed = true;
+				break;
+			}
+		}
+
+		if (failed)
+			break;
+
+		IP_Payload* pl = session.Recv();
+		if (!pl)
+		{
+			if (idle.GetTimeSeconds() > 1.0)
+			{
+				std::fprintf(stderr, "No reply for a second, %u of %u datagrams came back.\n", received, sent);
+				failed = true;
+				break;
+			}
+
+			continue;
+		}
+
+		IP_Packet ip(pl);
+		ip.destinationIP = session.sourceIP;
+		ip.sourceIP = session.destIP;
+		EthernetFrame::WritePacket(&rx, ps2_mac, internal_mac, static_cast<u16>(EtherType::IPv4), &ip);
+		rx_bytes += rx.size;
+		received++;
+		if (received == WARMUP)
+			start_allocations = s_allocations.load(std::memory_order_relaxed);
+		idle.Reset();
+	}
+	const double seconds = timer.GetTimeSeconds();
+	const u64 allocations = (received > WARMUP) ? s_allocations.load(std::memory_order_relaxed) - start_allocations : 0;
+
+	stop.store(true, std::memory_order_relaxed);
+	echo.join();
+	CloseSocket(server);
+
+	if (received > 0)
+	{
+		std::printf("%u datagrams of %d bytes echoed in %.2f s: %.0f packets/s, %.1f MB/s received\n",
+			received, payload_size, seconds, received / seconds, rx_bytes / seconds / (1024.0 * 1024.0));
+	}
+
+	if (allocations != 0)
+	{
+		std::fprintf(stderr, "%llu heap allocations after the first %u round trips, expected none.\n",
+			static_cast<unsigned long long>(allocations), WARMUP);
+		failed = true;
+	}
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,35 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "event_scheduler_dispatch.h"
+#include "common/Timer.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Usage: event_scheduler_benchmark [event tests]
+int main(int argc, char* argv[])
+{
+	const u32 tests = (argc > 1) ? static_cast<u32>(std::strtoul(argv[1], nullptr, 10)) : 2000000;
+
+	Common::Timer timer;
+	const DispatchResult poll = RunPollingDispatch(tests);
+	const double poll_ms = timer.GetTimeMillisecondsAndReset();
+	const DispatchResult sched = RunSchedulerDispatch(tests);
+	const double sched_ms = timer.GetTimeMilliseconds();
+
+	std::printf("%u event tests, %llu/%llu events dispatched: polling %.2f ms, scheduler %.2f ms\n", tests,
+		static_cast<unsigned long long>(poll.dispatched), static_cast<unsigned long long>(sched.dispatched), poll_ms, sched_ms);
+	return (poll.dispatched == sched.dispatched && poll.next == sched.next) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,215 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/Pcsx2Defs.h"
+#include "common/DynamicLibrary.h"
+#include "common/Timer.h"
+#include "libretro.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Usage: state_load_benchmark <core library> <system dir> <game> [frames]
+// Drives the libretro core with the null renderer.  Once the game is running, the given number of
+// frames are timed as a baseline, then a state is taken and loaded again before each of as many
+// frames, like run-ahead does.  The loads are timed separately from the frames which follow them.
+
+static constexpr u32 WARMUP_FRAMES = 600;
+
+static const char* s_system_dir;
+
+struct FrameStats
+{
+	u64 frames = 0;
+	Common::Timer::Value total = 0;
+	Common::Timer::Value max = 0;
+
+	void Add(Common::Timer::Value time)
+	{
+		frames++;
+		total += time;
+		max = std::max(max, time);
+	}
+
+	void Print(const char* name) const
+	{
+		std::printf("%s: %llu, %.3f ms average, %.3f ms worst\n", name, static_cast<unsigned long long>(frames),
+			frames ? Common::Timer::ConvertValueToMilliseconds(total) / frames : 0.0,
+			Common::Timer::ConvertValueToMilliseconds(max));
+	}
+};
+
+static void RETRO_CALLCONV LogCallback(enum retro_log_level level, const char* fmt, ...)
+{
+	if (level < RETRO_LOG_WARN)
+		return;
+
+	std::va_list ap;
+	va_start(ap, fmt);
+	std::vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static bool RETRO_CALLCONV EnvironmentCallback(unsigned cmd, void* data)
+{
+	switch (cmd)
+	{
+		case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+		case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+			*static_cast<const char**>(data) = s_system_dir;
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+			static_cast<retro_log_callback*>(data)->log = LogCallback;
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_VARIABLE:
+		{
+			// Everything else keeps its default, the BIOS is the first one found in the system dir.
+			retro_variable* var = static_cast<retro_variable*>(data);
+			if (std::strcmp(var->key, "pcsx2_renderer") != 0)
+				return false;
+			var->value = "Null";
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
+static void RETRO_CALLCONV VideoCallback(const void*, unsigned, unsigned, size_t) {}
+static void RETRO_CALLCONV AudioCallback(int16_t, int16_t) {}
+static size_t RETRO_CALLCONV AudioBatchCallback(const int16_t*, size_t frames) { return frames; }
+static void RETRO_CALLCONV InputPollCallback() {}
+static int16_t RETRO_CALLCONV InputStateCallback(unsigned, unsigned, unsigned, unsigned) { return 0; }
+
+struct Core
+{
+	Common::DynamicLibrary library;
+	void (*set_environment)(retro_environment_t);
+	void (*set_video_refresh)(retro_video_refresh_t);
+	void (*set_audio_sample)(retro_audio_sample_t);
+	void (*set_audio_sample_batch)(retro_audio_sample_batch_t);
+	void (*set_input_poll)(retro_input_poll_t);
+	void (*set_input_state)(retro_input_state_t);
+	void (*init)();
+	void (*deinit)();
+	bool (*load_game)(const retro_game_info*);
+	void (*unload_game)();
+	void (*run)();
+	size_t (*serialize_size)();
+	bool (*serialize)(void*, size_t);
+	bool (*unserialize)(const void*, size_t);
+
+	bool Load(const char* path)
+	{
+		return library.Open(path) &&
+			   library.GetSymbol("retro_set_environment", &set_environment) &&
+			   library.GetSymbol("retro_set_video_refresh", &set_video_refresh) &&
+			   library.GetSymbol("retro_set_audio_sample", &set_audio_sample) &&
+			   library.GetSymbol("retro_set_audio_sample_batch", &set_audio_sample_batch) &&
+			   library.GetSymbol("retro_set_input_poll", &set_input_poll) &&
+			   library.GetSymbol("retro_set_input_state", &set_input_state) &&
+			   library.GetSymbol("retro_init", &init) &&
+			   library.GetSymbol("retro_deinit", &deinit) &&
+			   library.GetSymbol("retro_load_game", &load_game) &&
+			   library.GetSymbol("retro_unload_game", &unload_game) &&
+			   library.GetSymbol("retro_run", &run) &&
+			   library.GetSymbol("retro_serialize_size", &serialize_size) &&
+			   library.GetSymbol("retro_serialize", &serialize) &&
+			   library.GetSymbol("retro_unserialize", &unserialize);
+	}
+};
+
+static Common::Timer::Value TimeFrame(const Core& core)
+{
+	const Common::Timer::Value start = Common::Timer::GetCurrentValue();
+	core.run();
+	return Common::Timer::GetCurrentValue() - start;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		std::fprintf(stderr, "Usage: %s <core library> <system dir> <game> [frames]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	s_system_dir = argv[2];
+	const u32 frames = (argc > 4) ? static_cast<u32>(std::strtoul(argv[4], nullptr, 10)) : 1000;
+
+	Core core;
+	if (!core.Load(argv[1]))
+	{
+		std::fprintf(stderr, "Failed to load core '%s'.\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	core.set_environment(EnvironmentCallback);
+	core.set_video_refresh(VideoCallback);
+	core.set_audio_sample(AudioCallback);
+	core.set_audio_sample_batch(AudioBatchCallback);
+	core.set_input_poll(InputPollCallback);
+	core.set_input_state(InputStateCallback);
+	core.init();
+
+	retro_game_info game = {};
+	game.path = argv[3];
+	if (!core.load_game(&game))
+	{
+		std::fprintf(stderr, "Failed to load game '%s'.\n", argv[3]);
+		core.deinit();
+		return EXIT_FAILURE;
+	}
+
+	for (u32 i = 0; i < WARMUP_FRAMES; i++)
+		core.run();
+
+	FrameStats normal;
+	for (u32 i = 0; i < frames; i++)
+		normal.Add(TimeFrame(core));
+
+	std::vector<u8> state(core.serialize_size());
+	bool result = core.serialize(state.data(), state.size());
+
+	FrameStats loads, after_load;
+	for (u32 i = 0; result && i < frames; i++)
+	{
+		const Common::Timer::Value start = Common::Timer::GetCurrentValue();
+		result = core.unserialize(state.data(), state.size());
+		loads.Add(Common::Timer::GetCurrentValue() - start);
+		after_load.Add(TimeFrame(core));
+	}
+
+	core.unload_game();
+	core.deinit();
+
+	if (!result)
+	{
+		std::fprintf(stderr, "Saving or loading the state failed.\n");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("State is %zu bytes.\n", state.size());
+	normal.Print("Normal frames");
+	loads.Print("State loads");
+	after_load.Print("Frames after a state load");
+	return EXIT_SUCCESS;
+}
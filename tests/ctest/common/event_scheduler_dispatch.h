@@ -0,0 +1,139 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/Pcsx2Defs.h"
+#include "common/EventScheduler.h"
+#include <random>
+
+namespace
+{
+	// Mirrors how the CPUs keep their events: a pending mask plus start cycle and delta per slot.
+	struct EventState
+	{
+		u32 pending = 0;
+		u32 sCycle[32] = {};
+		u32 eCycle[32] = {};
+
+		u32 Deadline(u32 id) const { return sCycle[id] + eCycle[id]; }
+	};
+} // namespace
+
+// Event dispatch with a mix like the EE's: a few DMA channels which fire constantly on short deadlines,
+// and the rest rarely pending. Done by polling every slot like the CPUs used to, and with the scheduler.
+static constexpr u32 DISPATCH_EVENTS = 17;
+
+struct DispatchResult
+{
+	u64 dispatched = 0;
+	u32 next = 0; // next event test cycle after the last one
+};
+
+static u32 DispatchDelay(std::mt19937& rng, u32 id)
+{
+	return (id < 5) ? (rng() % 512 + 8) : (rng() % 65536 + 4096);
+}
+
+template <typename TestFn, typename ScheduleFn>
+static u64 RunDispatch(u32 tests, TestFn test_events, ScheduleFn on_schedule)
+{
+	std::mt19937 rng(1234);
+	EventState state;
+	u32 cycle = 0;
+	u64 dispatched = 0;
+
+	const auto schedule = [&](u32 id) {
+		state.pending |= 1u << id;
+		state.sCycle[id] = cycle;
+		state.eCycle[id] = DispatchDelay(rng, id);
+		on_schedule(state, id);
+	};
+
+	for (u32 i = 0; i < tests; i++)
+	{
+		// Most event tests come from the block dispatcher and find nothing due.
+		cycle += rng() % 64 + 1;
+		const u32 fired = test_events(state, cycle);
+		for (u32 id = 0; (fired >> id) != 0; id++)
+		{
+			if (!(fired & (1u << id)))
+				continue;
+
+			dispatched++;
+			if (id < 5 || (rng() & 7) == 0)
+				schedule(id);
+		}
+
+		if ((i & 1023) == 0)
+			schedule(rng() % DISPATCH_EVENTS);
+	}
+	return dispatched;
+}
+
+static DispatchResult RunPollingDispatch(u32 tests)
+{
+	DispatchResult result;
+	result.dispatched = RunDispatch(
+		tests,
+		[&result](EventState& state, u32 cycle) {
+			u32 fired = 0;
+			result.next = cycle + 3072;
+			for (u32 id = 0; id < DISPATCH_EVENTS; id++)
+			{
+				if (!(state.pending & (1u << id)))
+					continue;
+				if (static_cast<s32>(cycle - state.sCycle[id]) >= static_cast<s32>(state.eCycle[id]))
+				{
+					state.pending &= ~(1u << id);
+					fired |= 1u << id;
+				}
+				else if (static_cast<s32>(result.next - state.sCycle[id]) > static_cast<s32>(state.eCycle[id]))
+				{
+					result.next = state.Deadline(id);
+				}
+			}
+			return fired;
+		},
+		[](EventState&, u32) {});
+	return result;
+}
+
+static DispatchResult RunSchedulerDispatch(u32 tests)
+{
+	EventScheduler<32> sched;
+	DispatchResult result;
+	result.dispatched = RunDispatch(
+		tests,
+		[&sched, &result](EventState& state, u32 cycle) {
+			const auto deadline_of = [&state](u32 id) { return state.Deadline(id); };
+			sched.CollectDue(cycle, state.pending, deadline_of);
+			const u32 fired = sched.GetDueMask() & state.pending;
+			for (u32 id = 0; (fired >> id) != 0; id++)
+			{
+				if (fired & (1u << id))
+					sched.ClearDue(id);
+			}
+			state.pending &= ~fired;
+
+			result.next = cycle + 3072;
+			u32 deadline;
+			if (sched.PeekNext(state.pending, deadline_of, &deadline) && static_cast<s32>(result.next - deadline) > 0)
+				result.next = deadline;
+			return fired;
+		},
+		[&sched](EventState& state, u32 id) { sched.Schedule(id, state.Deadline(id)); });
+	return result;
+}
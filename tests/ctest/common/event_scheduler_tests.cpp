@@ -0,0 +1,170 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2022  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "event_scheduler_dispatch.h"
+#include <gtest/gtest.h>
+
+namespace
+{
+	class Events
+	{
+	public:
+		void Schedule(u32 id, u32 now, u32 delta)
+		{
+			state.pending |= 1u << id;
+			state.sCycle[id] = now;
+			state.eCycle[id] = delta;
+			sched.Schedule(id, state.Deadline(id));
+		}
+
+		auto Deadline() const
+		{
+			return [this](u32 id) { return state.Deadline(id); };
+		}
+
+		void Cancel(u32 id) { state.pending &= ~(1u << id); }
+
+		u32 CollectDue(u32 now)
+		{
+			sched.CollectDue(now, state.pending, Deadline());
+			return sched.GetDueMask() & state.pending;
+		}
+
+		bool PeekNext(u32* deadline) { return sched.PeekNext(state.pending, Deadline(), deadline); }
+
+		EventState state;
+		EventScheduler<32> sched;
+	};
+} // namespace
+
+TEST(EventScheduler, DueInDeadlineOrder)
+{
+	Events ev;
+	ev.Schedule(3, 0, 100);
+	ev.Schedule(1, 0, 50);
+	ev.Schedule(7, 10, 200);
+
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 50u);
+
+	ASSERT_EQ(ev.CollectDue(49), 0u);
+	ASSERT_EQ(ev.CollectDue(50), 1u << 1);
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 100u);
+
+	ASSERT_EQ(ev.CollectDue(1000), (1u << 1) | (1u << 3) | (1u << 7));
+	ASSERT_FALSE(ev.PeekNext(&next));
+}
+
+TEST(EventScheduler, RescheduleReplacesDeadline)
+{
+	Events ev;
+	ev.Schedule(2, 0, 100);
+	ev.Schedule(2, 0, 300);
+
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 300u);
+	ASSERT_EQ(ev.CollectDue(200), 0u);
+
+	// Earlier works too, and rescheduling a due event makes it not due.
+	ev.Schedule(2, 200, 10);
+	ASSERT_EQ(ev.CollectDue(210), 1u << 2);
+	ev.Schedule(2, 210, 50);
+	ASSERT_EQ(ev.CollectDue(210), 0u);
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 260u);
+}
+
+TEST(EventScheduler, CancelledEventsAreDropped)
+{
+	Events ev;
+	ev.Schedule(4, 0, 10);
+	ev.Schedule(5, 0, 20);
+	ev.Cancel(4);
+
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 20u);
+	ASSERT_EQ(ev.CollectDue(100), 1u << 5);
+}
+
+TEST(EventScheduler, PostponedInPlace)
+{
+	// The IPU pushes its deadline back by writing eCycle directly.
+	Events ev;
+	ev.Schedule(4, 0, 10);
+	ev.state.eCycle[4] = 0x9999;
+
+	ASSERT_EQ(ev.CollectDue(100), 0u);
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 0x9999u);
+}
+
+TEST(EventScheduler, DeadlinesWrap)
+{
+	Events ev;
+	ev.Schedule(0, 0xFFFFFF00u, 0x200);
+	ev.Schedule(1, 0xFFFFFF00u, 0x10);
+
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 0xFFFFFF10u);
+	ASSERT_EQ(ev.CollectDue(0xFFFFFFF0u), 1u << 1);
+	ASSERT_EQ(ev.CollectDue(0x50u), 1u << 1);
+	ASSERT_EQ(ev.CollectDue(0x100u), (1u << 0) | (1u << 1));
+}
+
+TEST(EventScheduler, StaysBoundedUnderReschedules)
+{
+	Events ev;
+	for (u32 i = 0; i < 10000; i++)
+		ev.Schedule(i % 3, i, 100000 - i);
+
+	ASSERT_LE(ev.sched.GetQueueSize(), 32u * 4);
+
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 100000u);
+}
+
+TEST(EventScheduler, RebuildFromState)
+{
+	Events ev;
+	ev.state.pending = (1u << 6) | (1u << 9);
+	ev.state.sCycle[6] = 100;
+	ev.state.eCycle[6] = 40;
+	ev.state.sCycle[9] = 100;
+	ev.state.eCycle[9] = 20;
+	ev.sched.Rebuild(ev.state.pending, ev.Deadline());
+
+	u32 next;
+	ASSERT_TRUE(ev.PeekNext(&next));
+	ASSERT_EQ(next, 120u);
+	ASSERT_EQ(ev.CollectDue(140), (1u << 6) | (1u << 9));
+}
+
+TEST(EventScheduler, DispatchMatchesPolling)
+{
+	static constexpr u32 TESTS = 200000;
+	const DispatchResult poll = RunPollingDispatch(TESTS);
+	const DispatchResult sched = RunSchedulerDispatch(TESTS);
+
+	// Same events on the same deadlines, so both must have fired the same ones.
+	ASSERT_EQ(poll.dispatched, sched.dispatched);
+	ASSERT_EQ(poll.next, sched.next);
+}
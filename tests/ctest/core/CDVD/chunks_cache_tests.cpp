@@ -0,0 +1,111 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "chunks_cache_trace.h"
+#include <gtest/gtest.h>
+
+TEST(ChunksCache, ReadBack)
+{
+	ChunksCache cache(CHUNK_SIZE, 1);
+	std::vector<u8> chunk(CHUNK_SIZE);
+	std::vector<u8> out(CHUNK_SIZE);
+
+	FillChunk(chunk.data(), CHUNK_SIZE * 3, CHUNK_SIZE);
+	cache.Insert(chunk.data(), CHUNK_SIZE * 3, CHUNK_SIZE, CHUNK_SIZE);
+
+	ASSERT_EQ(cache.Read(out.data(), CHUNK_SIZE * 3, CHUNK_SIZE), static_cast<int>(CHUNK_SIZE));
+	ASSERT_EQ(memcmp(out.data(), chunk.data(), CHUNK_SIZE), 0);
+
+	// Partial reads within the chunk
+	ASSERT_EQ(cache.Read(out.data(), CHUNK_SIZE * 3 + 2048, 2048), 2048);
+	ASSERT_EQ(memcmp(out.data(), chunk.data() + 2048, 2048), 0);
+
+	// Reads crossing into the next chunk or from other chunks miss
+	ASSERT_EQ(cache.Read(out.data(), CHUNK_SIZE * 4 - 2048, 4096), -1);
+	ASSERT_EQ(cache.Read(out.data(), CHUNK_SIZE * 2, 2048), -1);
+}
+
+TEST(ChunksCache, EvictsLeastRecentlyUsed)
+{
+	// 1MB of 16KB chunks is 64 entries
+	ChunksCache cache(CHUNK_SIZE, 1);
+	std::vector<u8> chunk(CHUNK_SIZE);
+	u8 out[2048];
+
+	for (s64 i = 0; i < 64; i++)
+	{
+		FillChunk(chunk.data(), i * CHUNK_SIZE, CHUNK_SIZE);
+		cache.Insert(chunk.data(), i * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE);
+	}
+
+	// Touch chunk 0 so chunk 1 becomes the oldest
+	ASSERT_EQ(cache.Read(out, 0, sizeof(out)), static_cast<int>(sizeof(out)));
+
+	FillChunk(chunk.data(), 64 * CHUNK_SIZE, CHUNK_SIZE);
+	cache.Insert(chunk.data(), 64 * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE);
+
+	ASSERT_EQ(cache.Read(out, 0, sizeof(out)), static_cast<int>(sizeof(out)));
+	ASSERT_EQ(cache.Read(out, CHUNK_SIZE, sizeof(out)), -1);
+	ASSERT_EQ(cache.Read(out, 64 * CHUNK_SIZE, sizeof(out)), static_cast<int>(sizeof(out)));
+	FillChunk(chunk.data(), 64 * CHUNK_SIZE, sizeof(out));
+	ASSERT_EQ(memcmp(out, chunk.data(), sizeof(out)), 0);
+}
+
+TEST(ChunksCache, ShortChunkAtEOF)
+{
+	ChunksCache cache(CHUNK_SIZE, 1);
+	std::vector<u8> chunk(CHUNK_SIZE);
+	u8 out[4096];
+
+	FillChunk(chunk.data(), 0, 1024);
+	cache.Insert(chunk.data(), 0, 1024, CHUNK_SIZE);
+
+	// Reads past the data but inside the coverage return what's available
+	ASSERT_EQ(cache.Read(out, 0, sizeof(out)), 1024);
+	ASSERT_EQ(cache.Read(out, 2048, sizeof(out)), 0);
+}
+
+TEST(ChunksCache, IgnoresUnalignedChunks)
+{
+	ChunksCache cache(CHUNK_SIZE, 1);
+	std::vector<u8> chunk(CHUNK_SIZE);
+	u8 out[16];
+
+	cache.Insert(chunk.data(), 2048, CHUNK_SIZE, CHUNK_SIZE);
+	ASSERT_EQ(cache.Read(out, 2048, sizeof(out)), -1);
+}
+
+TEST(ChunksCache, ReplayTraceMatchesList)
+{
+	// Set PCSX2_CDVD_TRACE to replay a real game, otherwise a synthetic trace of streaming reads mixed with seeks is used.
+	const char* trace_path = std::getenv("PCSX2_CDVD_TRACE");
+	const std::vector<TraceRead> trace = trace_path ? LoadTrace(trace_path) : SyntheticTrace();
+	ASSERT_FALSE(trace.empty());
+
+	static constexpr uint LIMIT_MB = 64;
+	ChunksCache cache(CHUNK_SIZE, LIMIT_MB);
+	ListChunksCache list(static_cast<s64>(LIMIT_MB) * 1024 * 1024);
+
+	const u64 cache_hits = ReplayTrace(
+		trace, [&cache](void* dst, s64 offset) { return cache.Read(dst, offset, CHUNK_SIZE); },
+		[&cache](const void* src, s64 offset) { cache.Insert(src, offset, CHUNK_SIZE, CHUNK_SIZE); });
+	const u64 list_hits = ReplayTrace(
+		trace, [&list](void* dst, s64 offset) { return list.Read(dst, offset, CHUNK_SIZE); },
+		[&list](const void* src, s64 offset) { ListTake(list, src, offset); });
+
+	// Both are LRU with the same budget, so they should agree on what's cached
+	ASSERT_EQ(cache_hits, list_hits);
+}
@@ -0,0 +1,164 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "pcsx2/CDVD/ChunksCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <random>
+#include <vector>
+
+inline constexpr u32 CHUNK_SIZE = 16 * 1024;
+
+inline void FillChunk(u8* data, s64 offset, int length)
+{
+	for (int i = 0; i < length; i++)
+		data[i] = static_cast<u8>((offset + i) * 31 >> 3);
+}
+
+// Sector access traces, replayed through the cache and through the previous linked list implementation,
+// which it should agree with. LoadTrace() reads a log captured with "CDVD Verbose Reads" enabled.
+struct TraceRead
+{
+	s64 offset;
+	int length;
+};
+
+class ListChunksCache
+{
+public:
+	explicit ListChunksCache(s64 limit)
+		: m_limit(limit)
+	{
+	}
+
+	~ListChunksCache()
+	{
+		for (Entry& e : m_entries)
+			free(e.data);
+	}
+
+	void Take(void* data, s64 offset, int length, int coverage)
+	{
+		m_entries.push_front({data, offset, length, coverage});
+		m_size += length;
+		while (!m_entries.empty() && m_size > m_limit)
+		{
+			m_size -= m_entries.back().size;
+			free(m_entries.back().data);
+			m_entries.pop_back();
+		}
+	}
+
+	int Read(void* dst, s64 offset, int length)
+	{
+		for (auto it = m_entries.begin(); it != m_entries.end(); it++)
+		{
+			if (offset >= it->offset && (offset + length) <= (it->offset + it->coverage))
+			{
+				if (it != m_entries.begin())
+					m_entries.splice(m_entries.begin(), m_entries, it);
+				return ChunksCache::CopyAvailable(it->data, it->offset, it->size, dst, offset, length);
+			}
+		}
+		return -1;
+	}
+
+private:
+	struct Entry
+	{
+		void* data;
+		s64 offset;
+		int size;
+		int coverage;
+	};
+
+	std::list<Entry> m_entries;
+	s64 m_size = 0;
+	s64 m_limit;
+};
+
+// Inserts copies of the chunk, like the gzip reader used to hand over.
+inline void ListTake(ListChunksCache& list, const void* src, s64 offset)
+{
+	void* copy = malloc(CHUNK_SIZE);
+	memcpy(copy, src, CHUNK_SIZE);
+	list.Take(copy, offset, CHUNK_SIZE, CHUNK_SIZE);
+}
+
+inline std::vector<TraceRead> LoadTrace(const char* path)
+{
+	std::vector<TraceRead> trace;
+	std::FILE* fp = std::fopen(path, "r");
+	if (!fp)
+		return trace;
+
+	char line[512];
+	while (std::fgets(line, sizeof(line), fp))
+	{
+		const char* read = std::strstr(line, "Reading Sector");
+		int sector, count, blocksize;
+		if (read && std::sscanf(read, "Reading Sector %d (%d Blocks of Size %d)", &sector, &count, &blocksize) == 3)
+			trace.push_back({static_cast<s64>(sector) * blocksize, count * blocksize});
+	}
+	std::fclose(fp);
+	return trace;
+}
+
+inline std::vector<TraceRead> SyntheticTrace()
+{
+	std::vector<TraceRead> trace;
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<s64> sector(0, 2 * 1024 * 1024);
+	std::uniform_int_distribution<int> stream(1, 64);
+	s64 pos = 0;
+	while (trace.size() < 5000)
+	{
+		// Stream a file for a while, then seek somewhere new (or back to a recently used area)
+		const int reads = stream(rng);
+		for (int i = 0; i < reads; i++)
+		{
+			trace.push_back({pos * 2048, 16 * 2048});
+			pos += 16;
+		}
+		pos = (rng() & 1) ? sector(rng) : std::max<s64>(pos - 256, 0);
+	}
+	return trace;
+}
+
+template <typename ReadFn, typename InsertFn>
+u64 ReplayTrace(const std::vector<TraceRead>& trace, ReadFn read, InsertFn insert)
+{
+	std::vector<u8> data(CHUNK_SIZE);
+	u64 hits = 0;
+	for (const TraceRead& r : trace)
+	{
+		// Readers fetch whole chunks, so split the request as the compressed readers do
+		for (s64 chunk = r.offset / CHUNK_SIZE * CHUNK_SIZE; chunk < r.offset + r.length; chunk += CHUNK_SIZE)
+		{
+			if (read(data.data(), chunk) >= 0)
+			{
+				hits++;
+				continue;
+			}
+			FillChunk(data.data(), chunk, 64);
+			insert(data.data(), chunk);
+		}
+	}
+	return hits;
+}
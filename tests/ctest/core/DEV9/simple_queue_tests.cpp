@@ -0,0 +1,114 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/DEV9/SimpleQueue.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(DEV9SimpleQueue, KeepsOrder)
+{
+	SimpleQueue<u32, 8> queue;
+	u32 value;
+
+	EXPECT_TRUE(queue.IsQueueEmpty());
+	EXPECT_FALSE(queue.Dequeue(&value));
+
+	// Several laps around the ring.
+	u32 next = 0;
+	for (u32 i = 0; i < 100; i++)
+	{
+		queue.Enqueue(i * 2);
+		queue.Enqueue(i * 2 + 1);
+		ASSERT_TRUE(queue.Dequeue(&value));
+		EXPECT_EQ(value, next++);
+	}
+	while (queue.Dequeue(&value))
+		EXPECT_EQ(value, next++);
+
+	EXPECT_EQ(next, 200u);
+	EXPECT_TRUE(queue.IsQueueEmpty());
+}
+
+TEST(DEV9SimpleQueue, OverflowKeepsOrder)
+{
+	SimpleQueue<u32, 8> queue;
+	u32 value;
+
+	// Fill past the ring, drain part of it, then queue more while still overflowing.
+	for (u32 i = 0; i < 20; i++)
+		queue.Enqueue(i);
+	for (u32 i = 0; i < 4; i++)
+	{
+		ASSERT_TRUE(queue.Dequeue(&value));
+		EXPECT_EQ(value, i);
+	}
+	for (u32 i = 20; i < 30; i++)
+		queue.Enqueue(i);
+
+	for (u32 i = 4; i < 30; i++)
+	{
+		ASSERT_TRUE(queue.Dequeue(&value));
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(queue.Dequeue(&value));
+	EXPECT_TRUE(queue.IsQueueEmpty());
+
+	// And back to the ring once the overflow is drained.
+	queue.Enqueue(30);
+	ASSERT_TRUE(queue.Dequeue(&value));
+	EXPECT_EQ(value, 30u);
+}
+
+TEST(DEV9SimpleQueue, MultipleProducers)
+{
+	static constexpr u32 PRODUCERS = 4;
+	static constexpr u32 PER_PRODUCER = 100000;
+
+	SimpleQueue<u32, 64> queue;
+	std::vector<std::thread> producers;
+	for (u32 p = 0; p < PRODUCERS; p++)
+	{
+		producers.emplace_back([&queue, p]() {
+			for (u32 i = 0; i < PER_PRODUCER; i++)
+				queue.Enqueue((p << 24) | i);
+		});
+	}
+
+	// Each producer's entries must come out in the order it queued them.
+	u32 expected[PRODUCERS] = {};
+	u32 received = 0;
+	while (received < PRODUCERS * PER_PRODUCER)
+	{
+		u32 value;
+		if (!queue.Dequeue(&value))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		const u32 p = value >> 24;
+		ASSERT_LT(p, PRODUCERS);
+		ASSERT_EQ(value & 0xFFFFFF, expected[p]);
+		expected[p]++;
+		received++;
+	}
+
+	for (std::thread& thread : producers)
+		thread.join();
+
+	EXPECT_TRUE(queue.IsQueueEmpty());
+}
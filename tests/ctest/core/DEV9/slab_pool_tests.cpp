@@ -0,0 +1,96 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/DEV9/SimpleQueue.h"
+#include "pcsx2/DEV9/SlabPool.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(DEV9SlabPool, ReusesFreedBlocks)
+{
+	// A freed block is the next one handed out for its size class
+	void* first = SlabPool::Allocate(1000);
+	SlabPool::Free(first, 1000);
+	void* second = SlabPool::Allocate(600);
+	EXPECT_EQ(first, second);
+	SlabPool::Free(second, 600);
+
+	// Blocks of other classes don't come from that free list
+	void* small = SlabPool::Allocate(SlabPool::MinBlockSize);
+	EXPECT_NE(small, first);
+	SlabPool::Free(small, SlabPool::MinBlockSize);
+}
+
+TEST(DEV9SlabPool, BlocksDontOverlap)
+{
+	static constexpr size_t SIZE = 200;
+	std::vector<u8*> blocks;
+	for (u32 i = 0; i < 1000; i++)
+	{
+		u8* block = static_cast<u8*>(SlabPool::Allocate(SIZE));
+		memset(block, static_cast<u8>(i), SIZE);
+		blocks.push_back(block);
+	}
+
+	for (u32 i = 0; i < blocks.size(); i++)
+	{
+		for (size_t j = 0; j < SIZE; j++)
+			ASSERT_EQ(blocks[i][j], static_cast<u8>(i));
+		SlabPool::Free(blocks[i], SIZE);
+	}
+}
+
+TEST(DEV9SlabPool, LargeSizesUseTheHeap)
+{
+	static constexpr size_t SIZE = SlabPool::MaxBlockSize + 1;
+	SlabPool::Buffer buffer = SlabPool::MakeBuffer(SIZE);
+	memset(buffer.get(), 0xcd, SIZE);
+	EXPECT_EQ(buffer[SIZE - 1], 0xcd);
+}
+
+TEST(DEV9SlabPool, FreeOnOtherThread)
+{
+	// Like packets, which are built on the RX thread and released after the PS2 has read them
+	static constexpr u32 COUNT = 10000;
+	SimpleQueue<u8*> queue;
+
+	std::thread consumer([&queue]() {
+		u32 received = 0;
+		while (received < COUNT)
+		{
+			u8* block;
+			if (!queue.Dequeue(&block))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			EXPECT_EQ(block[0], static_cast<u8>(received));
+			SlabPool::Free(block, 128);
+			received++;
+		}
+	});
+
+	for (u32 i = 0; i < COUNT; i++)
+	{
+		u8* block = static_cast<u8*>(SlabPool::Allocate(128));
+		block[0] = static_cast<u8>(i);
+		queue.Enqueue(block);
+	}
+
+	consumer.join();
+}
@@ -0,0 +1,201 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/GS/Renderers/SW/GSDrawScanline.h"
+#include "pcsx2/GS/Renderers/SW/GSDrawScanlineCodeGenerator.all.h"
+#include "pcsx2/GS/Renderers/SW/GSSetupPrimCodeGenerator.all.h"
+#include "pcsx2/GS/Renderers/SW/GSVertexSW.h"
+#include "multi_isa_test.h"
+#include <array>
+#include <vector>
+
+MULTI_ISA_UNSHARED_START
+
+// The frame buffer keeps the pixel grouping the jit expects of PSMCT32 (pixels 0,1 then 2,3 eight halfwords
+// further), but rows and 4 pixel columns are laid out linearly, so fzbr/fzbc can be built without GSLocalMemory.
+static constexpr int FB_WIDTH = 64;
+static constexpr int FB_HEIGHT = 8;
+static constexpr int FB_ROW_HALFWORDS = FB_WIDTH / 4 * 16;
+static constexpr int TEX_SIZE = 16;
+static constexpr u32 FB_CLEAR = 0xa5123456;
+
+static constexpr ProcessorFeatures::VectorISA GetTestISA()
+{
+#if _M_AVX512
+	return ProcessorFeatures::VectorISA::AVX512;
+#elif _M_SSE >= 0x501
+	return ProcessorFeatures::VectorISA::AVX2;
+#elif _M_SSE >= 0x500
+	return ProcessorFeatures::VectorISA::AVX;
+#else
+	return ProcessorFeatures::VectorISA::SSE4;
+#endif
+}
+
+static u32& FramePixel(std::vector<u32>& fb, int x, int y)
+{
+	static constexpr int group_offsets[4] = {0, 2, 8, 10};
+	return fb[(y * FB_ROW_HALFWORDS + (x >> 2) * 16 + group_offsets[x & 3]) / 2];
+}
+
+// The jit addresses g_const rip-relative, so its code has to live in the image like GSCodeReserve does
+alignas(__pagesize) static u8 s_jit_code[__pagesize * 8];
+
+struct ScanlineJit
+{
+	static constexpr size_t MAX_SIZE = sizeof(s_jit_code) / 2;
+
+	Xbyak::CodeGenerator sp_code{MAX_SIZE, s_jit_code};
+	Xbyak::CodeGenerator ds_code{MAX_SIZE, s_jit_code + MAX_SIZE};
+	GSDrawScanline::SetupPrimPtr setup_prim;
+	GSDrawScanline::DrawScanlinePtr draw_scanline;
+
+	explicit ScanlineJit(GSScanlineSelector sel)
+	{
+		HostSys::MemProtectStatic(s_jit_code, PageAccess_Any());
+
+		ProcessorFeatures cpu = g_cpu;
+		cpu.vectorISA = GetTestISA();
+		cpu.hasFMA = cpu.hasFMA && cpu.vectorISA >= ProcessorFeatures::VectorISA::AVX2;
+
+		GSSetupPrimCodeGenerator2(&sp_code, cpu, sel.key).Generate();
+		GSDrawScanlineCodeGenerator2(&ds_code, cpu, sel.key).Generate();
+		setup_prim = sp_code.getCode<GSDrawScanline::SetupPrimPtr>();
+		draw_scanline = ds_code.getCode<GSDrawScanline::DrawScanlinePtr>();
+	}
+};
+
+/// Draws a point sampled, 4-bit paletted sprite with its texels mapped 1:1 to [left, right) x [top, bottom),
+/// writing only rgb (FBMSK keeps the destination alpha), the same way GSRasterizer::DrawSprite drives the jit.
+static std::vector<u32> DrawClutSprite(bool tlu4, const u8* tex, const u32* clut, int left, int top, int right, int bottom)
+{
+	std::vector<u32> fb(FB_ROW_HALFWORDS * FB_HEIGHT / 2, FB_CLEAR);
+	std::array<GSVector2i, FB_HEIGHT> fzbr;
+	std::array<GSVector2i, FB_WIDTH / 4 + 2> fzbc;
+	for (int y = 0; y < FB_HEIGHT; y++)
+		fzbr[y] = GSVector2i(y * FB_ROW_HALFWORDS, 0);
+	for (size_t x = 0; x < fzbc.size(); x++)
+		fzbc[x] = GSVector2i(static_cast<int>(x) * 16, 0);
+
+	GSScanlineGlobalData global = {};
+	global.sel.key = 0;
+	global.sel.atst = ATST_ALWAYS;
+	global.sel.fwrite = 1;
+	global.sel.rfb = 1;
+	global.sel.tfx = TFX_DECAL;
+	global.sel.tcc = 1;
+	global.sel.fst = 1;
+	global.sel.tlu = 1;
+	global.sel.tlu4 = tlu4;
+	global.sel.wms = CLAMP_REPEAT;
+	global.sel.wmt = CLAMP_REPEAT;
+	global.sel.tw = 1; // log2(TEX_SIZE) - 3
+	global.sel.prim = GS_SPRITE_CLASS;
+
+	global.vm = fb.data();
+	global.tex[0] = tex;
+	global.clut = const_cast<u32*>(clut);
+	global.fzbr = fzbr.data();
+	global.fzbc = fzbc.data();
+
+	global.t.min.U16[0] = global.t.minmax.U16[0] = TEX_SIZE - 1;
+	global.t.max.U16[0] = global.t.minmax.U16[2] = 0;
+	global.t.mask.U32[0] = 0xffffffff;
+	global.t.min.U16[4] = global.t.minmax.U16[1] = TEX_SIZE - 1;
+	global.t.max.U16[4] = global.t.minmax.U16[3] = 0;
+	global.t.mask.U32[2] = 0xffffffff;
+	global.t.min = global.t.min.xxxxlh();
+	global.t.max = global.t.max.xxxxlh();
+	global.t.mask = global.t.mask.xxzz();
+	global.t.invmask = ~global.t.mask;
+
+#if _M_SSE >= 0x501
+	global.fm = 0xff000000;
+	global.zm = 0xffffffff;
+#else
+	global.fm = GSVector4i(0xff000000);
+	global.zm = GSVector4i::xffffffff();
+#endif
+
+	ScanlineJit jit(global.sel);
+
+	alignas(32) GSScanlineLocalData local = {};
+	local.gd = &global;
+
+	// fst texture coordinates are 16.16 fixed point, stored as floats
+	GSVertexSW vertex[2];
+	vertex[0] = GSVertexSW::zero();
+	vertex[1] = GSVertexSW::zero();
+	vertex[0].p = GSVector4(static_cast<float>(left), static_cast<float>(top));
+	vertex[1].p = GSVector4(static_cast<float>(right), static_cast<float>(bottom));
+	vertex[1].t = GSVector4(static_cast<float>((right - left) << 16), static_cast<float>((bottom - top) << 16));
+	const u32 index[2] = {0, 1};
+
+	const GSVector4 dt = (vertex[1].t - vertex[0].t) / (vertex[1].p - vertex[0].p);
+	GSVertexSW dscan = GSVertexSW::zero();
+	dscan.t = GSVector4::zero().insert32<0, 0>(dt);
+	const GSVector4 dedge_t = GSVector4::zero().insert32<1, 1>(dt);
+
+	jit.setup_prim(vertex, index, dscan, local);
+
+	GSVertexSW scan = vertex[0];
+	for (int y = top; y < bottom; y++)
+	{
+		jit.draw_scanline(right - left, left, y, scan, local);
+		scan.t += dedge_t;
+	}
+
+	return fb;
+}
+
+MULTI_ISA_TEST(DrawScanlineTest, Clut4Sprite)
+{
+	SKIP_IF_UNSUPPORTED();
+
+	alignas(32) u8 tex[TEX_SIZE * TEX_SIZE];
+	for (int v = 0; v < TEX_SIZE; v++)
+	{
+		for (int u = 0; u < TEX_SIZE; u++)
+			tex[v * TEX_SIZE + u] = static_cast<u8>((u * 3 + v * 5) & 15);
+	}
+
+	// Only 16 entries are meaningful, the rest is what the renderer leaves in the ring heap
+	alignas(32) u32 clut[256];
+	for (int i = 0; i < 256; i++)
+		clut[i] = (i < 16) ? (0x80000000u | (i * 0x0b0d11u)) : 0xcdcdcdcdu;
+
+	// Odd edges so the scanlines start and end partway through a vector
+	const int left = 3, top = 2, right = 32, bottom = 6;
+
+	std::vector<u32> expected(FB_ROW_HALFWORDS * FB_HEIGHT / 2, FB_CLEAR);
+	for (int y = top; y < bottom; y++)
+	{
+		for (int x = left; x < right; x++)
+		{
+			const u32 texel = clut[tex[((y - top) & (TEX_SIZE - 1)) * TEX_SIZE + ((x - left) & (TEX_SIZE - 1))]];
+			FramePixel(expected, x, y) = (texel & 0x00ffffff) | (FB_CLEAR & 0xff000000);
+		}
+	}
+
+	EXPECT_EQ(DrawClutSprite(false, tex, clut, left, top, right, bottom), expected);
+
+#if _M_AVX512
+	// Same draw with the palette held in registers
+	EXPECT_EQ(DrawClutSprite(true, tex, clut, left, top, right, bottom), expected);
+#endif
+}
+
+MULTI_ISA_UNSHARED_END
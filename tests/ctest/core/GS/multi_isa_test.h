@@ -0,0 +1,69 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "pcsx2/GS/MultiISA.h"
+#include <gtest/gtest.h>
+
+// For test sources that are compiled once per ISA, like the GS ones they test.
+
+#ifdef MULTI_ISA_UNSHARED_COMPILATION
+
+enum class TestISA
+{
+	isa_sse4,
+	isa_avx,
+	isa_avx2,
+	isa_avx512,
+	isa_native,
+};
+
+MULTI_ISA_UNSHARED_START
+
+// Lives in the ISA namespace, so the linker can't pick the AVX-512 copy for the SSE4 tests
+inline bool CheckCapabilities(TestISA required_caps)
+{
+	x86caps.Identify();
+	if (required_caps == TestISA::isa_avx && !x86caps.hasAVX)
+		return false;
+	if (required_caps == TestISA::isa_avx2 && !x86caps.hasAVX2)
+		return false;
+	if (required_caps == TestISA::isa_avx512 && !(x86caps.hasAVX512F && x86caps.hasAVX512BW && x86caps.hasAVX512DQ && x86caps.hasAVX512VL))
+		return false;
+
+	return true;
+}
+
+MULTI_ISA_UNSHARED_END
+
+#define MULTI_ISA_STRINGIZE_(x) #x
+#define MULTI_ISA_STRINGIZE(x) MULTI_ISA_STRINGIZE_(x)
+
+#define MULTI_ISA_CONCAT_(a, b) a##b
+#define MULTI_ISA_CONCAT(a, b) MULTI_ISA_CONCAT_(a, b)
+
+#define MULTI_ISA_TEST(group, name) TEST(MULTI_ISA_CONCAT(MULTI_ISA_CONCAT(MULTI_ISA_UNSHARED_COMPILATION, _), group), name)
+#define SKIP_IF_UNSUPPORTED() \
+	if (!CheckCapabilities(TestISA::MULTI_ISA_UNSHARED_COMPILATION)) { \
+		GTEST_SKIP() << "Host CPU does not support " MULTI_ISA_STRINGIZE(MULTI_ISA_UNSHARED_COMPILATION); \
+	}
+
+#else
+
+#define MULTI_ISA_TEST(group, name) TEST(group, name)
+#define SKIP_IF_UNSUPPORTED()
+
+#endif
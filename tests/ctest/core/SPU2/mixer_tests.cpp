@@ -0,0 +1,263 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/SPU2/Global.h"
+#include "pcsx2/SPU2/spu2.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Plays the same register trace through the SIMD voice mixer and the reference one, and
+// checks they agree on every sample, on the voice state, and on SPU2 RAM (voice write-back).
+
+static constexpr u32 TRACE_SAMPLES = 48000;
+
+// ADPCM waveforms, in 16 bit words of SPU2 RAM.
+static constexpr u32 WAVE_BASE = 0x10000;
+static constexpr u32 WAVE_BLOCKS = 24;
+static constexpr u32 NUM_WAVES = 16;
+
+struct RegWrite
+{
+	u32 sample;
+	u32 reg;
+	u16 value;
+};
+
+struct MixTrace
+{
+	std::vector<RegWrite> writes; // sorted by sample
+	std::vector<u16> noise; // noise generator output per sample
+};
+
+struct MixResult
+{
+	std::vector<s32> mix; // dry L/R, wet L/R, per core per sample
+	std::vector<s32> voices; // OutX, ADSR value, NextA, SP per voice per sample
+	std::vector<s16> ram;
+};
+
+static u32 CoreBase(u32 core)
+{
+	return core ? SPU2_CORE1 : SPU2_CORE0;
+}
+
+static void AddVoiceParam(MixTrace& trace, u32 sample, u32 core, u32 voice, u32 param, u16 value)
+{
+	trace.writes.push_back({sample, CoreBase(core) + SPU2_VP(voice) + param, value});
+}
+
+static void AddVoiceStart(MixTrace& trace, u32 sample, u32 core, u32 voice, u32 addr)
+{
+	const u32 reg = CoreBase(core) + REG_VA_SSA + SPU2_VA(voice);
+	trace.writes.push_back({sample, reg, static_cast<u16>(addr >> 16)});
+	trace.writes.push_back({sample, reg + 2, static_cast<u16>(addr)});
+}
+
+static void AddCoreMask(MixTrace& trace, u32 sample, u32 core, u32 reg, u32 mask)
+{
+	trace.writes.push_back({sample, CoreBase(core) + reg, static_cast<u16>(mask)});
+	trace.writes.push_back({sample, CoreBase(core) + reg + 2, static_cast<u16>(mask >> 16)});
+}
+
+static void WriteWaveforms(u32 seed)
+{
+	std::mt19937 rng(seed);
+	u16* const mem = reinterpret_cast<u16*>(_spu2mem);
+	for (u32 wave = 0; wave < NUM_WAVES; wave++)
+	{
+		for (u32 block = 0; block < WAVE_BLOCKS; block++)
+		{
+			u16* data = &mem[WAVE_BASE + (wave * WAVE_BLOCKS + block) * 8];
+
+			// Loop start on the first block, end on the last. Odd waves loop, even ones stop.
+			u16 flags = (block == 0) ? 4 : 0;
+			if (block == WAVE_BLOCKS - 1)
+				flags |= (wave & 1) ? 3 : 1;
+
+			data[0] = static_cast<u16>((flags << 8) | ((rng() % 5) << 4) | (rng() % 13));
+			for (u32 i = 1; i < 8; i++)
+				data[i] = static_cast<u16>(rng());
+		}
+	}
+}
+
+// Something in the shape of a game's sound driver: keys voices on and off, sweeps pitch and
+// volume, reroutes voices, switches some to noise, and uses pitch modulation for a while.
+static MixTrace MakeTrace(u32 seed)
+{
+	std::mt19937 rng(seed);
+	MixTrace trace;
+
+	for (u32 core = 0; core < 2; core++)
+	{
+		for (u32 voice = 0; voice < V_Core::NumVoices; voice++)
+		{
+			AddVoiceParam(trace, 0, core, voice, REG_VP_VOLL, static_cast<u16>(rng() & 0x7fff));
+			AddVoiceParam(trace, 0, core, voice, REG_VP_VOLR, static_cast<u16>(rng() & 0x7fff));
+			AddVoiceParam(trace, 0, core, voice, REG_VP_PITCH, static_cast<u16>(0x400 + rng() % 0x3c00));
+			AddVoiceParam(trace, 0, core, voice, REG_VP_ADSR1, static_cast<u16>(rng()));
+			AddVoiceParam(trace, 0, core, voice, REG_VP_ADSR2, static_cast<u16>(rng()));
+
+			// Voice 5 of core 0 plays core 0's voice 1 output area, which is written every sample.
+			const u32 start = (core == 0 && voice == 5) ? 0x400 : (WAVE_BASE + (rng() % NUM_WAVES) * WAVE_BLOCKS * 8);
+			AddVoiceStart(trace, 0, core, voice, start);
+		}
+
+		AddCoreMask(trace, 0, core, REG_S_VMIXL, rng() & 0xffffff);
+		AddCoreMask(trace, 0, core, REG_S_VMIXR, rng() & 0xffffff);
+		AddCoreMask(trace, 0, core, REG_S_VMIXEL, rng() & 0xffffff);
+		AddCoreMask(trace, 0, core, REG_S_VMIXER, rng() & 0xffffff);
+	}
+
+	for (u32 sample = 1; sample < TRACE_SAMPLES; sample += 1 + rng() % 200)
+	{
+		const u32 core = rng() & 1;
+		const u32 voice = rng() % V_Core::NumVoices;
+		switch (rng() % 10)
+		{
+			case 0:
+			case 1:
+				AddCoreMask(trace, sample, core, REG_S_KON, rng() & 0xffffff);
+				break;
+			case 2:
+				AddCoreMask(trace, sample, core, REG_S_KOFF, rng() & 0xffffff);
+				break;
+			case 3:
+				AddVoiceParam(trace, sample, core, voice, REG_VP_PITCH, static_cast<u16>(rng() % 0x4000));
+				break;
+			case 4:
+				// Fixed volumes mostly, with the odd slide.
+				AddVoiceParam(trace, sample, core, voice, (rng() & 1) ? REG_VP_VOLL : REG_VP_VOLR,
+					static_cast<u16>((rng() % 4) ? (rng() & 0x7fff) : (0x8000 | (rng() & 0x7f7f))));
+				break;
+			case 5:
+				AddVoiceParam(trace, sample, core, voice, (rng() & 1) ? REG_VP_ADSR1 : REG_VP_ADSR2, static_cast<u16>(rng()));
+				break;
+			case 6:
+				AddCoreMask(trace, sample, core, REG_S_VMIXL + (rng() % 4) * 4, rng() & 0xffffff);
+				break;
+			case 7:
+				AddCoreMask(trace, sample, core, REG_S_NON, (rng() % 3) ? 0 : (1u << voice));
+				break;
+			case 8:
+				AddVoiceStart(trace, sample, core, voice, WAVE_BASE + (rng() % NUM_WAVES) * WAVE_BLOCKS * 8);
+				break;
+			case 9:
+				// Pitch modulation only in the middle third of the trace.
+				AddCoreMask(trace, sample, core, REG_S_PMON,
+					(sample > TRACE_SAMPLES / 3 && sample < TRACE_SAMPLES * 2 / 3) ? (rng() & 0xfffffe) : 0);
+				break;
+		}
+	}
+
+	trace.noise.resize(TRACE_SAMPLES);
+	for (u16& noise : trace.noise)
+		noise = static_cast<u16>(rng());
+
+	return trace;
+}
+
+class SPU2MixerTest : public ::testing::Test
+{
+protected:
+	static void SetUpTestSuite()
+	{
+		ASSERT_TRUE(SPU2::Initialize());
+	}
+
+	static void TearDownTestSuite()
+	{
+		SPU2::Shutdown();
+	}
+
+	static MixResult Run(const MixTrace& trace, bool reference)
+	{
+		std::memset(spu2regs, 0, 0x010000);
+		std::memset(_spu2mem, 0, 0x200000);
+		std::memset(pcm_cache_data, 0, pcm_BlockCount * sizeof(PcmCacheEntry));
+		std::memset(reinterpret_cast<void*>(Cores), 0, sizeof(Cores));
+		Cores[0].Init(0);
+		Cores[1].Init(1);
+		Cycles = 0;
+		OutPos = 0;
+		WriteWaveforms(1234);
+
+		MixResult result;
+		auto write = trace.writes.begin();
+		for (u32 sample = 0; sample < TRACE_SAMPLES; sample++)
+		{
+			for (; write != trace.writes.end() && write->sample == sample; ++write)
+				SPU2_FastWrite(write->reg, write->value);
+
+			// As TimeUpdate does before mixing each sample.
+			Cycles++;
+			for (uint c = 0; c < 2; c++)
+			{
+				for (uint v = 0; v < V_Core::NumVoices; v++)
+				{
+					if ((Cores[c].KeyOn & (1 << v)) && StartQueuedVoice(c, v))
+						Cores[c].KeyOn &= ~(1 << v);
+				}
+				Cores[c].NoiseOut = trace.noise[sample];
+			}
+
+			VoiceMixSet mix[2] = {VoiceMixSet::Empty, VoiceMixSet::Empty};
+			for (uint c = 0; c < 2; c++)
+			{
+				if (reference)
+					MixCoreVoicesReference(mix[c], c);
+				else
+					MixCoreVoices(mix[c], c);
+
+				result.mix.insert(result.mix.end(), {mix[c].Dry.Left, mix[c].Dry.Right, mix[c].Wet.Left, mix[c].Wet.Right});
+				for (const V_Voice& vc : Cores[c].Voices)
+					result.voices.insert(result.voices.end(), {vc.OutX, vc.ADSR.Value, static_cast<s32>(vc.NextA), vc.SP});
+			}
+
+			OutPos = (OutPos + 1) & 0x1ff;
+		}
+
+		result.ram.assign(_spu2mem, _spu2mem + 0x100000);
+		return result;
+	}
+};
+
+TEST_F(SPU2MixerTest, SIMDMatchesReference)
+{
+	for (u32 seed = 1; seed <= 3; seed++)
+	{
+		SCOPED_TRACE(seed);
+		const MixTrace trace = MakeTrace(seed);
+		const MixResult expected = Run(trace, true);
+		const MixResult actual = Run(trace, false);
+
+		// Make sure the trace actually made some noise.
+		ASSERT_NE(std::count(expected.mix.begin(), expected.mix.end(), 0), static_cast<ptrdiff_t>(expected.mix.size()));
+
+		ASSERT_EQ(expected.mix.size(), actual.mix.size());
+		for (size_t i = 0; i < expected.mix.size(); i++)
+			ASSERT_EQ(expected.mix[i], actual.mix[i]) << "sample " << (i / 8) << " core " << ((i / 4) & 1) << " output " << (i & 3);
+
+		ASSERT_EQ(expected.voices.size(), actual.voices.size());
+		for (size_t i = 0; i < expected.voices.size(); i++)
+			ASSERT_EQ(expected.voices[i], actual.voices[i]) << "voice state " << (i & 3) << ", voice " << ((i / 4) % V_Core::NumVoices);
+
+		EXPECT_TRUE(expected.ram == actual.ram);
+	}
+}
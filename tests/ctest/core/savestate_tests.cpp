@@ -0,0 +1,66 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/SaveState.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+// A bit over two frames, so the last one is short.
+static constexpr int ENTRY_SIZE = 2 * _1mb + 12345;
+
+static std::vector<SaveStateFramedEntry> CompressTestEntry(std::vector<u8>* original)
+{
+	ArchiveDataBuffer* buffer = new ArchiveDataBuffer(ENTRY_SIZE, "SaveStateFramedTest");
+	for (int i = 0; i < ENTRY_SIZE; i++)
+		(*buffer)[i] = static_cast<u8>((i * 7) ^ (i >> 11));
+	original->assign(buffer->GetPtr(), buffer->GetPtr() + ENTRY_SIZE);
+
+	ArchiveEntryList list(buffer);
+	list.Add(ArchiveEntry("test.bin").SetDataIndex(0).SetDataSize(ENTRY_SIZE));
+
+	std::vector<SaveStateFramedEntry> entries;
+	EXPECT_TRUE(SaveState_CompressFramed(&list, &entries));
+	return entries;
+}
+
+TEST(SaveStateFramed, RoundTrip)
+{
+	std::vector<u8> original;
+	const std::vector<SaveStateFramedEntry> entries = CompressTestEntry(&original);
+	ASSERT_EQ(entries.size(), 1u);
+	EXPECT_EQ(entries[0].name, "test.bin");
+
+	std::vector<u8> data;
+	ASSERT_TRUE(SaveState_DecompressFramed(entries[0].data, &data));
+	EXPECT_EQ(data, original);
+}
+
+TEST(SaveStateFramed, TruncatedEntryFails)
+{
+	std::vector<u8> original;
+	const std::vector<SaveStateFramedEntry> entries = CompressTestEntry(&original);
+	ASSERT_EQ(entries.size(), 1u);
+
+	// Cut into the last frame, in the middle of the frames, and into the frame size table. The earlier
+	// frames are intact, so this also covers giving up on an entry after some of it was already readable.
+	const std::vector<u8>& full = entries[0].data;
+	for (const size_t size : {full.size() - 1, full.size() / 2, static_cast<size_t>(20), static_cast<size_t>(0)})
+	{
+		const std::vector<u8> truncated(full.begin(), full.begin() + size);
+		std::vector<u8> data;
+		EXPECT_FALSE(SaveState_DecompressFramed(truncated, &data)) << "truncated to " << size << " bytes";
+	}
+}
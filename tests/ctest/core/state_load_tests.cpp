@@ -0,0 +1,83 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2023 PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "pcsx2/System.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+static constexpr u32 PAGES = 16;
+static constexpr u32 SIZE = PAGES * GuestPageHashes::PageSize;
+
+static std::vector<u8> MakeMemory()
+{
+	std::vector<u8> mem(SIZE);
+	for (u32 i = 0; i < SIZE; i++)
+		mem[i] = static_cast<u8>((i * 13) ^ (i >> 9));
+	return mem;
+}
+
+static void HashAll(GuestPageHashes& hashes, const std::vector<u8>& mem)
+{
+	for (u32 i = 0; i < hashes.GetPageCount(); i++)
+		hashes.Hash(mem.data(), i);
+}
+
+TEST(GuestPageHashes, UnchangedMemory)
+{
+	const std::vector<u8> mem = MakeMemory();
+	GuestPageHashes hashes(SIZE);
+	ASSERT_EQ(hashes.GetPageCount(), PAGES);
+	HashAll(hashes, mem);
+
+	for (u32 i = 0; i < PAGES; i++)
+		EXPECT_FALSE(hashes.HasChanged(mem.data(), i)) << "page " << i;
+}
+
+TEST(GuestPageHashes, OnlyChangedPage)
+{
+	std::vector<u8> mem = MakeMemory();
+	GuestPageHashes hashes(SIZE);
+	HashAll(hashes, mem);
+
+	// A single byte at the end of the page, so the whole page has to be covered.
+	mem[6 * GuestPageHashes::PageSize - 1] ^= 1;
+	for (u32 i = 0; i < PAGES; i++)
+		EXPECT_EQ(hashes.HasChanged(mem.data(), i), i == 5) << "page " << i;
+}
+
+TEST(GuestPageHashes, UnhashedPagesNeverChange)
+{
+	// Like EE pages without any recompiled code in them.
+	std::vector<u8> mem = MakeMemory();
+	GuestPageHashes hashes(SIZE);
+	hashes.Hash(mem.data(), 2);
+
+	for (u8& byte : mem)
+		byte = ~byte;
+	for (u32 i = 0; i < PAGES; i++)
+		EXPECT_EQ(hashes.HasChanged(mem.data(), i), i == 2) << "page " << i;
+}
+
+TEST(GuestPageHashes, ResetForgetsHashes)
+{
+	std::vector<u8> mem = MakeMemory();
+	GuestPageHashes hashes(SIZE);
+	HashAll(hashes, mem);
+	hashes.Reset();
+
+	mem[0] ^= 1;
+	EXPECT_FALSE(hashes.HasChanged(mem.data(), 0));
+}